@@ -31,32 +31,36 @@
 *                       INCLUDES
 *********************************************************/
 
+#include <string.h>
 #include "canal.h"
 
 /*********************************************************
 *                       HELPERS
 *********************************************************/
 
-// This table exists as the there are multiple solutions for timing to the set of
-// parameters: {PCLK1_Freq, Baud}. There are are preferred solutions, which
-// can be found here: http://www.bittiming.can-wiki.info/
+#ifdef CANAL_PCLK1_HZ
+// With the clock known at build time every supported baud is solved by the
+// compiler and setTimingParams only has to look it up
 static const struct {
-	uint8_t pclk1Mhz;
-	uint16_t baudKb;
-	uint8_t prescaler;
-	uint32_t seg1;
-	uint32_t seg2;
-}CAN_BITRATE_TABLE[NUM_BITRATE_ENTRIES] = {
-	{16,    1000,    1,    CAN_BS1_13TQ,    CAN_BS2_2TQ},
-	{16,     500,    2,    CAN_BS1_13TQ,    CAN_BS2_2TQ},
-	{16,     250,    4,    CAN_BS1_13TQ,    CAN_BS2_2TQ},
-	{16,     100,   10,    CAN_BS1_13TQ,    CAN_BS2_2TQ},
-	{8,	    1000,    1,    CAN_BS1_6TQ,     CAN_BS2_1TQ},
-	{8,	     500,    1,    CAN_BS1_13TQ,    CAN_BS2_2TQ},
-	{8,	     250,    2,    CAN_BS1_13TQ,    CAN_BS2_2TQ},
-	{8,      100,    5,    CAN_BS1_13TQ,    CAN_BS2_2TQ},
+	TeCanALBaud baud;
+	TsCanALBitTiming timing;
+}BIT_TIMINGS[] = {
+	{CANAL_BAUD_100K,	CANAL_BT_TIMING(CANAL_PCLK1_HZ, 100000U, CANAL_SAMPLE_POINT)},
+	{CANAL_BAUD_250K,	CANAL_BT_TIMING(CANAL_PCLK1_HZ, 250000U, CANAL_SAMPLE_POINT)},
+	{CANAL_BAUD_500K,	CANAL_BT_TIMING(CANAL_PCLK1_HZ, 500000U, CANAL_SAMPLE_POINT)},
+	{CANAL_BAUD_1M,		CANAL_BT_TIMING(CANAL_PCLK1_HZ, 1000000U, CANAL_SAMPLE_POINT)},
 };
+#endif // CANAL_PCLK1_HZ
 
+// lastUpdateTick holds the HAL tick of the last successful unmarshal of every
+// message in CANAL_CODEC_TABLE. 32-bit ticks only wrap after ~49 days.
+static volatile uint32_t lastUpdateTick[CANAL_NUM_MESSAGES];
+// messageHandlers holds the CanAL_OnMessage handler of every message in
+// CANAL_CODEC_TABLE
+static CanALMessageHandler* volatile messageHandlers[CANAL_NUM_MESSAGES];
+// instances maps CANAL_INST_CAN_x - 1 to the TsCanAL last initialized on it
+static TsCanAL* instances[CANAL_NUM_INSTANCES];
+static bool lastUpdateTickValid = false;
 
 static TeCanALRet setInstance(CAN_HandleTypeDef* hcan, TeCanALInstance canNum){
 	switch (canNum) {
@@ -78,34 +82,47 @@ static TeCanALRet setInstance(CAN_HandleTypeDef* hcan, TeCanALInstance canNum){
 }
 
 static void setDefaults(CAN_HandleTypeDef* hcan) {
+#if CANAL_TIMESTAMP_MODE
+	// Time triggered mode latches the bit time counter at every start of frame
+	hcan->Init.TimeTriggeredMode = ENABLE;
+#else
 	hcan->Init.TimeTriggeredMode = DISABLE;
+#endif // CANAL_TIMESTAMP_MODE
 	hcan->Init.AutoBusOff = ENABLE;
 	hcan->Init.AutoWakeUp = DISABLE;
 	hcan->Init.AutoRetransmission = DISABLE;
 	hcan->Init.ReceiveFifoLocked = DISABLE;
-	hcan->Init.TransmitFifoPriority = DISABLE;
+	hcan->Init.TransmitFifoPriority = DEFAULT_TX_FIFO_PRIORITY;
 }
 
 
 static TeCanALRet setTimingParams(CAN_HandleTypeDef* hcan, TeCanALBaud baud) {
-    uint8_t freq = (HAL_RCC_GetPCLK1Freq() / FREQ_MHZ);
+	TeCanALRet ret;
+	TsCanALBitTiming timing = {0};
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+
+	if (!IS_CANAL_BAUDRATE(baud)) return CANAL_UNSUPPORTED_BAUD;
 
-    if (!IS_CANAL_BAUDRATE(baud)) return CANAL_UNSUPPORTED_BAUD;
+#ifdef CANAL_PCLK1_HZ
+	if (pclk1 == CANAL_PCLK1_HZ) {
+		for (uint8_t i = 0; i < (sizeof(BIT_TIMINGS) / sizeof(BIT_TIMINGS[0])); i++) {
+			if (BIT_TIMINGS[i].baud == baud) timing = BIT_TIMINGS[i].timing;
+		}
+	}
+#endif // CANAL_PCLK1_HZ
 
-    for (uint8_t i = 0; i < NUM_BITRATE_ENTRIES; i++) {
-        if (freq == CAN_BITRATE_TABLE[i].pclk1Mhz) {
-            if (baud == CAN_BITRATE_TABLE[i].baudKb){
-                hcan->Init.Prescaler  = CAN_BITRATE_TABLE[i].prescaler;
-                hcan->Init.TimeSeg1   = CAN_BITRATE_TABLE[i].seg1;
-                hcan->Init.TimeSeg2   = CAN_BITRATE_TABLE[i].seg2;
-                hcan->Init.SyncJumpWidth = DEFAULT_SYNC_JW;
+	// The clock tree is not the one the build was solved for
+	if ((timing.tq == 0U) && ((ret = CanAL_SolveBitTiming(pclk1, (uint32_t)baud * 1000U,
+			CANAL_SAMPLE_POINT, &timing)) != CANAL_OK)) {
+		return ret;
+	}
 
-                return CANAL_OK;
-            }
-        }
-    }
+	hcan->Init.Prescaler = timing.prescaler;
+	hcan->Init.TimeSeg1 = (uint32_t)(timing.bs1 - 1U) << CAN_BTR_TS1_Pos;
+	hcan->Init.TimeSeg2 = (uint32_t)(timing.bs2 - 1U) << CAN_BTR_TS2_Pos;
+	hcan->Init.SyncJumpWidth = (uint32_t)(timing.sjw - 1U) << CAN_BTR_SJW_Pos;
 
-    return CANAL_UNSUPPORTED_PCLK1_FREQ;
+	return CANAL_OK;
 }
 
 static TeCanALRet setMode(CAN_HandleTypeDef* hcan, TeCanALMode mode) {
@@ -116,21 +133,40 @@ static TeCanALRet setMode(CAN_HandleTypeDef* hcan, TeCanALMode mode) {
 	return CANAL_OK;
 }
 
-static TeCanALRet setFilters(CAN_HandleTypeDef* hcan) {
-	// TODO: Do we have any use for this?
+static uint32_t firstFilterBank(TeCanALInstance canNum) {
+	return (canNum == CANAL_INST_CAN_2) ? DEFAULT_FILTER_SLAVE_START_BANK : 0;
+}
+
+static TeCanALRet configFilterBank(CAN_HandleTypeDef* hcan, uint32_t bank,
+		const TsCanALFilterBank* cfg, uint32_t fifo, uint32_t activation) {
 	CAN_FilterTypeDef filterConfig = {
-		.FilterBank = DEFAULT_FILTER_BANK,
-		.FilterMode = DEFAULT_FILTER_MODE,
-		.FilterScale = DEFAULT_FILTER_SCALE,
-		.FilterIdHigh = DEFAULT_FILTER_ID_HIGH,
-		.FilterIdLow = DEFAULT_FILTER_ID_LOW,
-		.FilterMaskIdHigh = DEFAULT_FILTER_MASK_ID_HIGH,
-		.FilterMaskIdLow = DEFAULT_FILTER_MASK_ID_LOW,
-		.FilterFIFOAssignment = DEFAULT_RX_FIFO,
-		.FilterActivation = DEFAULT_FILTER_ACTIVATION,
+		.FilterBank = bank,
+		.FilterFIFOAssignment = (fifo == CAN_RX_FIFO1) ? CAN_FILTER_FIFO1 : CAN_FILTER_FIFO0,
+		.FilterActivation = activation,
 		.SlaveStartFilterBank = DEFAULT_FILTER_SLAVE_START_BANK,
 	};
 
+	if (cfg->mode == CANAL_FILTER_MODE_LIST) {
+		filterConfig.FilterMode = CAN_FILTERMODE_IDLIST;
+	} else {
+		filterConfig.FilterMode = CAN_FILTERMODE_IDMASK;
+	}
+
+	// The HAL splits FR1/FR2 differently depending on the scale
+	if (cfg->scale == CANAL_FILTER_SCALE_32) {
+		filterConfig.FilterScale = CAN_FILTERSCALE_32BIT;
+		filterConfig.FilterIdHigh = cfg->fr1 >> 16;
+		filterConfig.FilterIdLow = cfg->fr1 & 0xFFFFU;
+		filterConfig.FilterMaskIdHigh = cfg->fr2 >> 16;
+		filterConfig.FilterMaskIdLow = cfg->fr2 & 0xFFFFU;
+	} else {
+		filterConfig.FilterScale = CAN_FILTERSCALE_16BIT;
+		filterConfig.FilterIdLow = cfg->fr1 & 0xFFFFU;
+		filterConfig.FilterMaskIdLow = cfg->fr1 >> 16;
+		filterConfig.FilterIdHigh = cfg->fr2 & 0xFFFFU;
+		filterConfig.FilterMaskIdHigh = cfg->fr2 >> 16;
+	}
+
 	if (HAL_CAN_ConfigFilter(hcan, &filterConfig) != HAL_OK){
 		return CANAL_CONFIG_FILTER_FAILED;
 	}
@@ -138,103 +174,1399 @@ static TeCanALRet setFilters(CAN_HandleTypeDef* hcan) {
 	return CANAL_OK;
 }
 
-/*********************************************************
-*              PUBLIC FUNCTION DEFINITIONS
-*********************************************************/
+// setFilters compiles the subscribed IDs into this instance's filter banks and
+// disables the banks that are left over. The priority IDs take the first banks
+// and DEFAULT_RX_FIFO gets whatever is left.
+static TeCanALRet setFilters(TsCanAL* can) {
+	TeCanALRet ret;
+	TsCanALFilterBank banks[CANAL_FILTER_BANKS_PER_INSTANCE];
+	uint32_t ids[CANAL_NUM_RX_FIFOS][CANAL_MAX_RX_IDS];
+	bool extended[CANAL_NUM_RX_FIFOS][CANAL_MAX_RX_IDS];
+	uint16_t numIds[CANAL_NUM_RX_FIFOS] = {0};
+	uint8_t priorityBanks = 0;
+	uint8_t defaultBanks = 0;
+	uint32_t firstBank = firstFilterBank(can->canNum);
 
-// Can_Init initializes CAN hardware and must be called with successful return
-// before any other CAN functions
-TeCanALRet CanAL_Init(TsCanAL* can) {
-	TeCanALRet ret = CANAL_OK;
+	for (uint16_t i = 0; i < can->numRxIds; i++) {
+		uint8_t fifo = can->rxIdFifo[i];
 
-	if (can == NULL) return CANAL_NULL_REF;
+		extended[fifo][numIds[fifo]] = (can->rxIdIde[i] == CAN_ID_EXT);
+		ids[fifo][numIds[fifo]++] = can->rxIds[i];
+	}
 
-	if (can->hcan == NULL) return CANAL_CAN_HANDLE_NULL_REF;
+	// Exact 32-bit list banks win over any mask DEFAULT_RX_FIFO ends up with, so
+	// a priority ID can never be captured by a merged telemetry rule
+	if ((ret = CanAL_CompileListFilters(ids[CANAL_PRIORITY_RX_FIFO],
+			extended[CANAL_PRIORITY_RX_FIFO], numIds[CANAL_PRIORITY_RX_FIFO],
+			banks, CANAL_FILTER_BANKS_PER_INSTANCE - 1U, &priorityBanks)) != CANAL_OK) {
+		return ret;
+	}
 
-	if ((ret = setInstance(can->hcan, can->canNum)) != CANAL_OK) return ret;
+	if (can->numRxIds == 0) {
+		// Accept everything with a single 32-bit mask of zeros
+		banks[0] = (TsCanALFilterBank){CANAL_FILTER_MODE_MASK, CANAL_FILTER_SCALE_32, 0, 0};
+		defaultBanks = 1;
+	}
+	else if ((ret = CanAL_CompileFilters(ids[DEFAULT_RX_FIFO],
+			extended[DEFAULT_RX_FIFO], numIds[DEFAULT_RX_FIFO], &banks[priorityBanks],
+			CANAL_FILTER_BANKS_PER_INSTANCE - priorityBanks, &defaultBanks)) != CANAL_OK) {
+		return ret;
+	}
 
-	if ((ret = setTimingParams(can->hcan, can->baud)) != CANAL_OK) return ret;
+	for (uint32_t i = 0; i < CANAL_FILTER_BANKS_PER_INSTANCE; i++) {
+		if (i < priorityBanks) {
+			ret = configFilterBank(can->hcan, firstBank + i, &banks[i],
+				CANAL_PRIORITY_RX_FIFO, DEFAULT_FILTER_ACTIVATION);
+		} else if (i < (uint32_t)(priorityBanks + defaultBanks)) {
+			ret = configFilterBank(can->hcan, firstBank + i, &banks[i],
+				DEFAULT_RX_FIFO, DEFAULT_FILTER_ACTIVATION);
+		} else {
+			ret = configFilterBank(can->hcan, firstBank + i, &banks[0], DEFAULT_RX_FIFO, DISABLE);
+		}
 
-	if ((ret = setMode(can->hcan, can->mode)) != CANAL_OK) return ret;
+		if (ret != CANAL_OK) return ret;
+	}
 
-	setDefaults(can->hcan);
+	return CANAL_OK;
+}
 
-	if (HAL_CAN_Init(can->hcan) != HAL_OK) return CANAL_INIT_FAILED;
+// resetUpdateTicks treats every message as updated at the first CanAL_Init
+static void resetUpdateTicks(void) {
+	uint32_t now = HAL_GetTick();
 
-	if ((ret = setFilters(can->hcan)) != CANAL_OK) return ret;
+	if (lastUpdateTickValid) return;
 
-	if (HAL_CAN_Start(can->hcan) != HAL_OK) return CANAL_START_FAILED;
+	for (uint16_t i = 0; i < CANAL_NUM_MESSAGES; i++) lastUpdateTick[i] = now;
 
-	if (HAL_CAN_ActivateNotification(can->hcan, CAN_IT_RX_FIFO0_MSG_PENDING)
-		!= HAL_OK) return CANAL_ERROR;
+	lastUpdateTickValid = true;
+}
 
-	return ret;
+static uint16_t countRxIds(const TsCanAL* can, uint32_t fifo) {
+	uint16_t count = 0;
+
+	for (uint16_t i = 0; i < can->numRxIds; i++) {
+		if (can->rxIdFifo[i] == fifo) count++;
+	}
+
+	return count;
 }
 
+// initialRxFifo routes the IDs listed in CANAL_PRIORITY_RX_IDS to the priority
+// fifo while there is room for them
+static uint8_t initialRxFifo(const TsCanAL* can, uint32_t ID) {
+#ifdef CANAL_PRIORITY_RX_IDS
+	static const uint32_t PRIORITY_RX_IDS[] = { CANAL_PRIORITY_RX_IDS };
 
+	for (uint16_t i = 0; i < (sizeof(PRIORITY_RX_IDS) / sizeof(PRIORITY_RX_IDS[0])); i++) {
+		if (PRIORITY_RX_IDS[i] != ID) continue;
 
-TeCanALRet CanAL_Receive(TsCanAL* can) {
-	TeCanALRet ret;
-	CAN_RxHeaderTypeDef RxHeader = {0};
-	uint8_t RxData[8] = {0};
-	uint32_t ID;
+		if (countRxIds(can, CANAL_PRIORITY_RX_FIFO) < CANAL_MAX_PRIORITY_RX_IDS) {
+			return CANAL_PRIORITY_RX_FIFO;
+		}
+	}
+#else
+	(void)can;
+	(void)ID;
+#endif // CANAL_PRIORITY_RX_IDS
 
-	if (can == NULL) return CANAL_NULL_REF;
+	return DEFAULT_RX_FIFO;
+}
+
+// resetRxIds subscribes to every message flagged rx in the codec table
+static void resetRxIds(TsCanAL* can) {
+	can->numRxIds = 0;
+
+	for (uint16_t i = 0; i < CANAL_NUM_MESSAGES; i++) {
+		if (!CANAL_CODEC_TABLE[i].rx) continue;
+
+		// A partial set would silently lose messages, accept everything instead
+		if (can->numRxIds >= CANAL_MAX_RX_IDS) {
+			can->numRxIds = 0;
+			return;
+		}
 
-	// Get raw message
-	if (HAL_CAN_GetRxMessage(can->hcan, DEFAULT_RX_FIFO, &RxHeader, RxData) != HAL_OK) {
+		can->rxIdFifo[can->numRxIds] = initialRxFifo(can, CANAL_CODEC_TABLE[i].id);
+		can->rxIdIde[can->numRxIds] = CANAL_CODEC_TABLE[i].ide;
+		can->rxIds[can->numRxIds++] = CANAL_CODEC_TABLE[i].id;
+	}
+}
+
+static void resetRxRing(TsCanALRxRing* ring) {
+	ring->head = 0;
+	ring->tail = 0;
+	ring->highWaterMark = 0;
+	ring->dropped = 0;
+}
+
+static void resetRxFifos(TsCanAL* can) {
+	for (uint32_t fifo = 0; fifo < CANAL_NUM_RX_FIFOS; fifo++) {
+		resetRxRing(&can->rxRing[fifo]);
+		can->rxFifoStats[fifo] = (TsCanALRxFifoStats){0};
+	}
+}
+
+// readRxFrame pops the oldest frame in fifo straight from the FIFO mailbox
+// registers into frame and into the message's store slot, and returns the codec
+// index of the frame in index. The caller has already checked that fifo is not
+// empty.
+static TeCanALRet readRxFrame(TsCanAL* can, uint32_t fifo, TsCanALRawFrame* frame,
+		uint16_t* index) {
+	CAN_HandleTypeDef* hcan = can->hcan;
+	CAN_FIFOMailBox_TypeDef* mailbox;
+	TsCanALStoreEntry* entry;
+	uint32_t rir;
+	uint32_t rdtr;
+	uint32_t data[2];
+
+	if ((hcan->State != HAL_CAN_STATE_READY) && (hcan->State != HAL_CAN_STATE_LISTENING)) {
 		return CANAL_GET_RXMESSAGE_FAILED;
 	}
 
+	mailbox = &hcan->Instance->sFIFOMailBox[fifo];
+	rir = mailbox->RIR;
+
 	// Message ID can either be standard or extended
-	switch (RxHeader.IDE) {
-		case CAN_ID_STD:
-			ID = RxHeader.StdId;
-			break;
-		case CAN_ID_EXT:
-			ID = RxHeader.ExtId;
-			break;
-		default:
-			return CANAL_UNKOWN_IDE;
+	frame->ide = (uint8_t)(rir & CAN_RI0R_IDE);
+	if (frame->ide == CAN_ID_EXT) {
+		frame->id = rir >> CAN_RI0R_EXID_Pos;
+	} else {
+		frame->id = rir >> CAN_RI0R_STID_Pos;
 	}
 
-	if ((ret = UnmarshalBinary(&ID, RxData)) != CANAL_OK) return ret;
+	*index = CanAL_FindFrameCodec(frame->id, frame->ide);
+	// All rx interrupts run at one priority, so this is the only writer and
+	// the slot needs no critical section
+	entry = CanAL_Store_BeginWrite(*index);
 
-	return Print_Message(&ID);
+	data[0] = mailbox->RDLR;
+	data[1] = mailbox->RDHR;
+	rdtr = mailbox->RDTR;
+
+	frame->dlc = (uint8_t)(rdtr & CAN_RDT0R_DLC);
+	memcpy(frame->data, data, sizeof(frame->data));
+	// Only the raw 16-bit capture, CANAL_TIMESTAMP_RX extends it
+	frame->timestamp = (rdtr & CAN_RDT0R_TIME) >> CAN_RDT0R_TIME_Pos;
+
+	if (entry != NULL) {
+		memcpy(entry->data, data, sizeof(entry->data));
+		entry->dlc = frame->dlc;
+	}
+
+	// Release the mailbox so the next frame moves up
+	if (fifo == CAN_RX_FIFO0) {
+		SET_BIT(hcan->Instance->RF0R, CAN_RF0R_RFOM0);
+	} else {
+		SET_BIT(hcan->Instance->RF1R, CAN_RF1R_RFOM1);
+	}
+
+	CANAL_TIMESTAMP_RX(&can->timestamps, frame);
+
+	if (entry != NULL) CanAL_Store_EndWrite(entry, frame->timestamp, HAL_GetTick());
+
+	return CANAL_OK;
 }
 
-TeCanALRet CanAL_Transmit(TsCanAL* can, TeMessageID ID) {
-	CAN_TxHeaderTypeDef TxHeader;
-	uint8_t TxBuffer[8] = {0};
-	uint32_t TxMailbox = 0;
-	TeCanALRet ret;
-	uint32_t data_len;
+// rxRingSlot returns the slot the next received frame is written to, or NULL if
+// the ring is full. It is the producer side of the rx ring and must only be
+// called from the rx interrupt.
+static TsCanALRawFrame* rxRingSlot(TsCanALRxRing* ring) {
+	uint16_t head = ring->head;
+
+	if ((uint16_t)(head - ring->tail) >= CANAL_RX_RING_SIZE) return NULL;
+
+	return &ring->frames[head & (CANAL_RX_RING_SIZE - 1U)];
+}
+
+// rxRingCommit hands the frame written to the rxRingSlot to the consumer
+static void rxRingCommit(TsCanALRxRing* ring) {
+	uint16_t head = ring->head;
+	uint16_t pending = (uint16_t)(head - ring->tail) + 1U;
+
+	// The frame must be fully written before the consumer can see the new head
+	__DMB();
+	ring->head = ++head;
+
+	if (pending > ring->highWaterMark) ring->highWaterMark = pending;
+}
+
+// arbitrationKey orders frames the way bxCAN arbitration does: the 11 base ID
+// bits first, then IDE (a standard frame beats an extended frame with the same
+// base ID) and finally the 18 extension bits
+static uint32_t arbitrationKey(const TsCanALRawFrame* frame) {
+	if (frame->ide == CAN_ID_STD) return frame->id << 19;
+
+	return ((frame->id >> 18) << 19) | (1U << 18) | (frame->id & 0x3FFFFU);
+}
+
+static bool txEntryBefore(const TsCanALTxEntry* a, const TsCanALTxEntry* b) {
+	if (a->key != b->key) return a->key < b->key;
+
+	return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void txSwap(TsCanALTxEntry* a, TsCanALTxEntry* b) {
+	TsCanALTxEntry tmp = *a;
+
+	*a = *b;
+	*b = tmp;
+}
+
+static void txSiftUp(TsCanALTxQueue* queue, uint16_t i) {
+	while (i > 0) {
+		uint16_t parent = (i - 1U) / 2U;
+
+		if (!txEntryBefore(&queue->entries[i], &queue->entries[parent])) break;
+
+		txSwap(&queue->entries[i], &queue->entries[parent]);
+		i = parent;
+	}
+}
+
+static void txSiftDown(TsCanALTxQueue* queue, uint16_t i) {
+	for (;;) {
+		uint16_t left = (2U * i) + 1U;
+		uint16_t right = left + 1U;
+		uint16_t best = i;
+
+		if ((left < queue->count) &&
+			txEntryBefore(&queue->entries[left], &queue->entries[best])) best = left;
+		if ((right < queue->count) &&
+			txEntryBefore(&queue->entries[right], &queue->entries[best])) best = right;
+
+		if (best == i) break;
+
+		txSwap(&queue->entries[i], &queue->entries[best]);
+		i = best;
+	}
+}
 
-	if ((ret = GetTxDataLength(&ID, &data_len)) != CANAL_OK) return ret;
+// txStatsSlot is the first slot probed for ID in the tx stats table
+static inline uint32_t txStatsSlot(uint32_t ID) {
+	return ((ID * 2654435761U) >> 16) & (CANAL_TX_STATS_SIZE - 1U);
+}
+
+// txStatsFor returns the counters for ID, claiming a free slot on first use.
+// NULL is returned once every slot is claimed by other IDs.
+static TsCanALTxIdStats* txStatsFor(TsCanAL* can, uint32_t ID) {
+	uint32_t slot = txStatsSlot(ID);
 
-	TxHeader.DLC = data_len;
+	for (uint32_t i = 0; i < CANAL_TX_STATS_SIZE; i++) {
+		TsCanALTxIdStats* stats = &can->txStats[(slot + i) & (CANAL_TX_STATS_SIZE - 1U)];
 
-	if (IS_CAN_STDID(ID)) {
-		TxHeader.IDE = CAN_ID_STD;
-		TxHeader.StdId = ID;
+		if (stats->id == ID) return stats;
+
+		if (stats->id == CANAL_TX_STATS_EMPTY_ID) {
+			stats->id = ID;
+			return stats;
+		}
 	}
-	else if(IS_CAN_EXTID(ID)) {
-		TxHeader.IDE = CAN_ID_EXT;
-		TxHeader.ExtId = ID;
+
+	return NULL;
+}
+
+static void countTx(TsCanAL* can, uint32_t ID, uint32_t enqueued, uint32_t sent, uint32_t dropped) {
+	TsCanALTxIdStats* stats = txStatsFor(can, ID);
+
+	if (stats == NULL) return;
+
+	stats->enqueued += enqueued;
+	stats->sent += sent;
+	stats->dropped += dropped;
+}
+
+static void resetTxQueue(TsCanAL* can) {
+	can->txQueue.count = 0;
+	can->txQueue.seq = 0;
+
+	for (uint32_t i = 0; i < CANAL_TX_STATS_SIZE; i++) {
+		can->txStats[i].id = CANAL_TX_STATS_EMPTY_ID;
+		can->txStats[i].enqueued = 0;
+		can->txStats[i].sent = 0;
+		can->txStats[i].dropped = 0;
+		can->txStats[i].failed = 0;
+		can->txStats[i].timestamp = 0;
 	}
-	else {
-		return CANAL_UNSUPPORTED_TX_MESSAGE;
+
+	for (uint32_t i = 0; i < CANAL_NUM_TX_MAILBOXES; i++) {
+		can->txMailboxIds[i] = CANAL_TX_STATS_EMPTY_ID;
 	}
+}
+
+// TX_MAILBOX_ERRORS are the HAL error bits of a frame in each tx mailbox that
+// was not sent
+static const uint32_t TX_MAILBOX_ERRORS[CANAL_NUM_TX_MAILBOXES] = {
+	HAL_CAN_ERROR_TX_ALST0 | HAL_CAN_ERROR_TX_TERR0,
+	HAL_CAN_ERROR_TX_ALST1 | HAL_CAN_ERROR_TX_TERR1,
+	HAL_CAN_ERROR_TX_ALST2 | HAL_CAN_ERROR_TX_TERR2,
+};
+
+// txMailboxIndex maps a CAN_TX_MAILBOXx to 0..2
+static uint32_t txMailboxIndex(uint32_t mailbox) {
+	if (mailbox == CAN_TX_MAILBOX0) return 0;
+	if (mailbox == CAN_TX_MAILBOX1) return 1;
+
+	return 2;
+}
+
+// loadMailbox hands a frame to a free tx mailbox. submitted is the
+// CANAL_TIMESTAMP_NOW() of the frame entering txSubmit.
+static TeCanALRet loadMailbox(TsCanAL* can, TsCanALRawFrame* frame, uint32_t submitted) {
+	CAN_TxHeaderTypeDef TxHeader = {0};
+	uint32_t TxMailbox = 0;
+
+	TxHeader.IDE = frame->ide;
+	TxHeader.StdId = frame->id;
+	TxHeader.ExtId = frame->id;
+	TxHeader.DLC = frame->dlc;
 
 	// Data frame
 	TxHeader.RTR = CAN_RTR_DATA;
 	TxHeader.TransmitGlobalTime = DISABLE;
 
-	MarshalBinary(&ID, TxBuffer);
+	if (HAL_CAN_AddTxMessage(can->hcan, &TxHeader, frame->data, &TxMailbox) != HAL_OK) {
+		return CANAL_ERROR;
+	}
+
+	can->txMailboxIds[txMailboxIndex(TxMailbox)] = frame->id;
+
+	CANAL_STATS_TX(&can->stats, frame);
+	CANAL_TIMESTAMP_TX_LOADED(&can->timestamps, TxMailbox, frame, submitted);
 
-	HAL_CAN_AddTxMessage(can->hcan, &TxHeader, TxBuffer, &TxMailbox);
+	if (can->trace != NULL) CanAL_Trace_Record(can->trace, frame, can->canNum, true);
 
 	return CANAL_OK;
 }
 
+// txQueuePush inserts a frame in priority order. A full queue rejects the new
+// frame: every queued frame was already reported as accepted to its sender, so
+// none of them may be dropped in its place.
+static TeCanALRet txQueuePush(TsCanAL* can, const TsCanALRawFrame* frame, uint32_t submitted) {
+	TsCanALTxQueue* queue = &can->txQueue;
+	TsCanALTxEntry entry = {
+		.frame = *frame,
+		.key = arbitrationKey(frame),
+		.seq = queue->seq,
+		.submitted = submitted,
+	};
+
+	if (queue->count >= CANAL_TX_QUEUE_SIZE) {
+		countTx(can, frame->id, 0, 0, 1);
+		return CANAL_TX_QUEUE_FULL;
+	}
+
+	queue->seq++;
+	queue->entries[queue->count] = entry;
+	txSiftUp(queue, queue->count++);
+	countTx(can, frame->id, 1, 0, 0);
+
+	return CANAL_OK;
+}
+
+// txRefill moves frames from the head of the software queue into every free
+// mailbox. Must be called with interrupts masked.
+static void txRefill(TsCanAL* can) {
+	TsCanALTxQueue* queue = &can->txQueue;
+
+	while ((queue->count > 0) && (HAL_CAN_GetTxMailboxesFreeLevel(can->hcan) > 0)) {
+		if (loadMailbox(can, &queue->entries[0].frame, queue->entries[0].submitted) != CANAL_OK) {
+			break;
+		}
+
+		countTx(can, queue->entries[0].frame.id, 0, 1, 0);
+
+		queue->entries[0] = queue->entries[--queue->count];
+		txSiftDown(queue, 0);
+	}
+}
+
+// txSubmitLocked sends a frame straight to a mailbox when nothing is waiting
+// ahead of it, otherwise it queues the frame behind the mailboxes. Must be
+// called with interrupts masked.
+static TeCanALRet txSubmitLocked(TsCanAL* can, TsCanALRawFrame* frame, uint32_t submitted) {
+	if (HAL_CAN_GetTxMailboxesFreeLevel(can->hcan) == 0U) {
+		CANAL_STATS_MAILBOX_FULL(&can->stats);
+	} else if ((can->txQueue.count == 0) && (loadMailbox(can, frame, submitted) == CANAL_OK)) {
+		countTx(can, frame->id, 0, 1, 0);
+
+		return CANAL_OK;
+	}
+
+	return txQueuePush(can, frame, submitted);
+}
+
+static TeCanALRet txSubmit(TsCanAL* can, TsCanALRawFrame* frame) {
+	TeCanALRet ret;
+	uint32_t submitted = CANAL_TIMESTAMP_NOW();
+	uint32_t primask = CanAL_EnterCritical();
+
+	ret = txSubmitLocked(can, frame, submitted);
+	txRefill(can);
+
+	CanAL_ExitCritical(primask);
+
+	return ret;
+}
+
+// decodeFrame unmarshals a raw frame into its global message struct
+static TeCanALRet decodeFrame(TsCanALRawFrame* frame) {
+	TeCanALRet ret;
+	uint32_t ID = frame->id;
+#if CANAL_LEGACY_CODECS
+	// Without a codec table the generated code finds the message itself
+	if ((ret = UnmarshalBinary(&ID, frame->data)) != CANAL_OK) return ret;
+#else
+	uint16_t index = CanAL_FindFrameCodec(ID, frame->ide);
+
+	if ((index == CANAL_NO_CODEC) || (CANAL_CODEC_TABLE[index].unmarshal == NULL)) {
+		return CANAL_UNSUPPORTED_RX_MESSAGE;
+	}
+
+	if ((ret = CANAL_CODEC_TABLE[index].unmarshal(frame->data)) != CANAL_OK) return ret;
+
+	lastUpdateTick[index] = HAL_GetTick();
+
+	if (messageHandlers[index] != NULL) messageHandlers[index](ID);
+
+	CanAL_Handler_Dispatch(index, frame->data, frame->dlc);
+#endif // CANAL_LEGACY_CODECS
+
+#if CANAL_DEBUG_MODE
+	return Print_Message(&ID);
+#else
+	return CANAL_OK;
+#endif // CANAL_DEBUG_MODE
+}
+
+// marshalFrame fills frame with the current contents of message ID
+static TeCanALRet marshalFrame(uint32_t ID, TsCanALRawFrame* frame) {
+#if CANAL_LEGACY_CODECS
+	uint32_t len;
+	TeCanALRet ret;
+
+	if ((ret = GetTxDataLength(&ID, &len)) != CANAL_OK) return ret;
+
+	if (!IS_CAN_EXTID(ID)) return CANAL_UNSUPPORTED_TX_MESSAGE;
+
+	frame->id = ID;
+	frame->ide = IS_CAN_STDID(ID) ? CAN_ID_STD : CAN_ID_EXT;
+	frame->dlc = (uint8_t)len;
+
+	return MarshalBinary(&ID, frame->data);
+#else
+	// IDE and DLC come precomputed from the codec table
+	const TsCanALCodec* codec = CanAL_GetCodec(ID);
+
+	if ((codec == NULL) || (codec->marshal == NULL)) return CANAL_UNSUPPORTED_TX_MESSAGE;
+
+	frame->id = ID;
+	frame->ide = codec->ide;
+	frame->dlc = codec->dlc;
+
+	return codec->marshal(frame->data);
+#endif // CANAL_LEGACY_CODECS
+}
+
+// runRxHooks shows frame to every rx hook of can and returns true if any of
+// them passed it on
+static bool runRxHooks(TsCanAL* can, const TsCanALRawFrame* frame) {
+	TsCanALRxHookNode* node = can->rxHooks;
+	bool passedOn = false;
+
+	while (node != NULL) {
+		if (node->hook(node->ctx, frame)) passedOn = true;
+
+		// The hook may have changed the list. Removing keeps next, so a hook
+		// that removed itself still leads on; skip any removed after it.
+		node = node->next;
+		while ((node != NULL) && !node->added) node = node->next;
+	}
+
+	return passedOn;
+}
+
+// acceptRxFrame runs everything that happens to a frame once it has been read
+// and stored: stats, trace, rx hook and then decoding or, in deferred mode,
+// handing it to CanAL_ProcessRx. index is the codec index of the frame and
+// inRing is true when frame is the rxRingSlot of ring.
+static TeCanALRet acceptRxFrame(TsCanAL* can, TsCanALRxRing* ring, TsCanALRawFrame* frame,
+		uint16_t index, bool inRing) {
+	CANAL_STATS_RX(&can->stats, frame);
+
+	if (can->trace != NULL) CanAL_Trace_Record(can->trace, frame, can->canNum, false);
+
+	// Frames a hook passed on are only decoded if this board has a codec
+	// for them. Legacy generated code can only tell by trying.
+	if (runRxHooks(can, frame) && !CANAL_LEGACY_CODECS && (index == CANAL_NO_CODEC)) {
+		return CANAL_OK;
+	}
+
+	if (can->rxMode != CANAL_RX_MODE_DEFERRED) return decodeFrame(frame);
+
+	if (!inRing) {
+		ring->dropped++;
+		return CANAL_RX_RING_FULL;
+	}
+
+	rxRingCommit(ring);
+
+	return CANAL_OK;
+}
+
+// receiveFifo drains every frame pending in fifo. The fill level is read again
+// on each pass so frames that arrive while earlier ones are handled are picked
+// up without another interrupt entry.
+static TeCanALRet receiveFifo(TsCanAL* can, uint32_t fifo) {
+	TeCanALRet ret = CANAL_OK;
+	TeCanALRet frameRet;
+	TsCanALRawFrame scratch;
+	TsCanALRawFrame* frame;
+	TsCanALRxRing* ring = &can->rxRing[fifo];
+	volatile TsCanALRxFifoStats* stats = &can->rxFifoStats[fifo];
+	bool deferred = (can->rxMode == CANAL_RX_MODE_DEFERRED);
+	uint32_t burst = 0;
+	uint16_t index;
+
+	CANAL_STATS_ISR_LATENCY(&can->stats);
+	CANAL_STATS_START(start);
+
+	while (HAL_CAN_GetRxFifoFillLevel(can->hcan, fifo) > 0U) {
+		// Deferred mode reads straight into the ring, decoding happens in
+		// CanAL_ProcessRx. A full ring still has to release the frame from the
+		// FIFO or it will overrun.
+		frame = deferred ? rxRingSlot(ring) : NULL;
+		if (frame == NULL) frame = &scratch;
+
+		frameRet = readRxFrame(can, fifo, frame, &index);
+
+		// The frame was not released, so the fill level would never drop
+		if (frameRet == CANAL_GET_RXMESSAGE_FAILED) {
+			ret = frameRet;
+			break;
+		}
+
+		burst++;
+
+		frameRet = acceptRxFrame(can, ring, frame, index, frame != &scratch);
+		if (frameRet != CANAL_OK) ret = frameRet;
+	}
+
+	stats->interrupts++;
+	stats->frames += burst;
+	if (burst > stats->maxBurst) stats->maxBurst = burst;
+
+	CANAL_STATS_STOP(&can->stats.totals.rxCycles, start);
+
+	return ret;
+}
+
+// drainRxRing decodes frames from ring until it is empty or processed reaches
+// budget
+static TeCanALRet drainRxRing(TsCanALRxRing* ring, uint16_t budget, uint16_t* processed) {
+	TeCanALRet ret = CANAL_OK;
+	TeCanALRet frameRet;
+	uint16_t tail = ring->tail;
+
+	while (tail != ring->head) {
+		if ((budget != 0) && (*processed >= budget)) break;
+
+		// The slot must not be read before the producer's head update is seen
+		__DMB();
+
+		// The slot is owned by the consumer until tail moves past it, so decode in place
+		frameRet = decodeFrame(&ring->frames[tail & (CANAL_RX_RING_SIZE - 1U)]);
+		if (frameRet != CANAL_OK) ret = frameRet;
+
+		// Finish reading the slot before handing it back to the producer
+		__DMB();
+		ring->tail = ++tail;
+		(*processed)++;
+	}
+
+	return ret;
+}
+
+// AUTOBAUD_CANDIDATES are the supported bauds, most common on the car first
+static const uint16_t AUTOBAUD_CANDIDATES[] = {
+	CANAL_BAUD_500K, CANAL_BAUD_250K, CANAL_BAUD_1M, CANAL_BAUD_100K,
+};
+
+// waitInitAck waits for bxCAN to acknowledge entering (ack) or leaving
+// initialization mode
+static TeCanALRet waitInitAck(CAN_HandleTypeDef* hcan, bool ack) {
+	uint32_t start = HAL_GetTick();
+
+	while ((READ_BIT(hcan->Instance->MSR, CAN_MSR_INAK) != 0U) != ack) {
+		if ((HAL_GetTick() - start) > CANAL_INIT_TIMEOUT_MS) return CANAL_TIMEOUT;
+	}
+
+	return CANAL_OK;
+}
+
+// writeBitTiming switches a started controller to baud and mode. BTR can only
+// be written in initialization mode, which leaves the filters and interrupt
+// enables as HAL_CAN_Init and CanAL_Init configured them.
+static TeCanALRet writeBitTiming(CAN_HandleTypeDef* hcan, TeCanALBaud baud, TeCanALMode mode) {
+	TeCanALRet ret;
+
+	if ((ret = setTimingParams(hcan, baud)) != CANAL_OK) return ret;
+
+	if ((ret = setMode(hcan, mode)) != CANAL_OK) return ret;
+
+	SET_BIT(hcan->Instance->MCR, CAN_MCR_INRQ);
+	if ((ret = waitInitAck(hcan, true)) != CANAL_OK) return ret;
+
+	WRITE_REG(hcan->Instance->BTR, (uint32_t)(hcan->Init.Mode | hcan->Init.SyncJumpWidth |
+		hcan->Init.TimeSeg1 | hcan->Init.TimeSeg2 | (hcan->Init.Prescaler - 1U)));
+
+	CLEAR_BIT(hcan->Instance->MCR, CAN_MCR_INRQ);
+
+	return waitInitAck(hcan, false);
+}
+
+static uint32_t countRxFrames(const TsCanAL* can) {
+	return can->rxFifoStats[CAN_RX_FIFO0].frames + can->rxFifoStats[CAN_RX_FIFO1].frames;
+}
+
+// startSample takes the counters the next sampleBus is relative to
+static void startSample(TsCanAL* can, uint32_t* frames, uint32_t* rec) {
+	*frames = countRxFrames(can);
+	*rec = (READ_REG(can->hcan->Instance->ESR) & CAN_ESR_REC) >> CAN_ESR_REC_Pos;
+
+	MODIFY_REG(can->hcan->Instance->ESR, CAN_ESR_LEC, CAN_ESR_LEC);
+}
+
+// sampleBus reports what the controller saw since the previous sample. The
+// filters only pass subscribed IDs, so a clean frame of any other ID is seen
+// through the last error code, which the hardware clears to 0 after every
+// frame received without error and which is set back to 7 here. A code the
+// hardware writes between the read and the write back is lost, so the bus is
+// sampled once a millisecond rather than in a spin; the receive error counter
+// still catches errors that fall in that window.
+static void sampleBus(TsCanAL* can, uint32_t* frames, uint32_t* rec, TsCanALAutobaudSample* sample) {
+	uint32_t esr = READ_REG(can->hcan->Instance->ESR);
+	uint32_t newFrames = countRxFrames(can);
+	uint32_t newRec = (esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos;
+	uint32_t lec = (esr & CAN_ESR_LEC) >> CAN_ESR_LEC_Pos;
+
+	sample->rxFrames = newFrames - *frames;
+	if ((sample->rxFrames == 0U) && (lec == 0U)) sample->rxFrames = 1U;
+	sample->rxError = (newRec > *rec) || ((lec != 0U) && (lec != 7U));
+
+	*frames = newFrames;
+	*rec = newRec;
+
+	MODIFY_REG(can->hcan->Instance->ESR, CAN_ESR_LEC, CAN_ESR_LEC);
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+// Can_Init initializes CAN hardware and must be called with successful return
+// before any other CAN functions
+TeCanALRet CanAL_Init(TsCanAL* can) {
+	TeCanALRet ret = CANAL_OK;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (can->hcan == NULL) return CANAL_CAN_HANDLE_NULL_REF;
+
+	CanAL_InitDispatch();
+	CanAL_Store_Init();
+
+	resetUpdateTicks();
+
+	if ((ret = setInstance(can->hcan, can->canNum)) != CANAL_OK) return ret;
+
+	instances[can->canNum - CANAL_INST_CAN_1] = can;
+
+	if ((ret = setTimingParams(can->hcan, can->baud)) != CANAL_OK) return ret;
+
+	if ((ret = setMode(can->hcan, can->mode)) != CANAL_OK) return ret;
+
+	if (!IS_CANAL_RX_MODE(can->rxMode)) return CANAL_UNSUPPORTED_MODE;
+
+	resetRxFifos(can);
+
+	resetTxQueue(can);
+
+	CANAL_STATS_RESET(&can->stats, HAL_GetTick());
+	CANAL_TIMESTAMP_RESET(&can->timestamps, (uint32_t)can->baud);
+
+	setDefaults(can->hcan);
+
+	if (HAL_CAN_Init(can->hcan) != HAL_OK) return CANAL_INIT_FAILED;
+
+	resetRxIds(can);
+
+	if ((ret = setFilters(can)) != CANAL_OK) return ret;
+
+	if (HAL_CAN_Start(can->hcan) != HAL_OK) return CANAL_START_FAILED;
+
+	if (HAL_CAN_ActivateNotification(can->hcan,
+		CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO0_FULL | CAN_IT_RX_FIFO0_OVERRUN |
+		CAN_IT_RX_FIFO1_MSG_PENDING | CAN_IT_RX_FIFO1_FULL | CAN_IT_RX_FIFO1_OVERRUN |
+		CAN_IT_TX_MAILBOX_EMPTY) != HAL_OK) return CANAL_ERROR;
+
+	return ret;
+}
+
+TeCanALRet CanAL_InitAutobaud(TsCanAL* can, uint32_t timeoutMs) {
+	TeCanALRet ret;
+	TeCanALMode mode;
+	TsCanALAutobaud autobaud;
+	TsCanALAutobaudSample sample;
+	TeCanALAutobaudAction action = CANAL_AUTOBAUD_LISTEN;
+	uint32_t frames;
+	uint32_t rec;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (!IS_CANAL_MODE(can->mode)) return CANAL_UNSUPPORTED_MODE;
+
+	if ((ret = CanAL_Autobaud_Start(&autobaud, AUTOBAUD_CANDIDATES,
+			(uint8_t)(sizeof(AUTOBAUD_CANDIDATES) / sizeof(AUTOBAUD_CANDIDATES[0])),
+			CANAL_AUTOBAUD_DWELL_MS, timeoutMs, HAL_GetTick())) != CANAL_OK) {
+		return ret;
+	}
+
+	// Listening silently keeps a wrong bitrate from destroying frames on the
+	// bus with error flags
+	mode = can->mode;
+	can->mode = CANAL_MODE_SILENT;
+	can->baud = (TeCanALBaud)CanAL_Autobaud_Current(&autobaud);
+	ret = CanAL_Init(can);
+	can->mode = mode;
+	if (ret != CANAL_OK) return ret;
+
+	startSample(can, &frames, &rec);
+
+	while ((action != CANAL_AUTOBAUD_LOCKED) && (action != CANAL_AUTOBAUD_FAILED)) {
+		HAL_Delay(1);
+		sampleBus(can, &frames, &rec, &sample);
+
+		action = CanAL_Autobaud_Step(&autobaud, HAL_GetTick(), &sample);
+
+		if (action == CANAL_AUTOBAUD_SWITCH) {
+			can->baud = (TeCanALBaud)CanAL_Autobaud_Current(&autobaud);
+			if ((ret = writeBitTiming(can->hcan, can->baud, CANAL_MODE_SILENT)) != CANAL_OK) return ret;
+
+			// Errors seen at the previous candidate must not count against this one
+			startSample(can, &frames, &rec);
+		}
+	}
+
+	if (action == CANAL_AUTOBAUD_FAILED) return CANAL_TIMEOUT;
+
+	if ((ret = writeBitTiming(can->hcan, can->baud, can->mode)) != CANAL_OK) return ret;
+
+	CANAL_STATS_RESET(&can->stats, HAL_GetTick());
+	CANAL_TIMESTAMP_RESET(&can->timestamps, (uint32_t)can->baud);
+
+	return CANAL_OK;
+}
+
+
+
+TeCanALRet CanAL_Receive(TsCanAL* can) {
+	if (can == NULL) return CANAL_NULL_REF;
+
+	return receiveFifo(can, CAN_RX_FIFO0);
+}
+
+TeCanALRet CanAL_ReceiveFifo1(TsCanAL* can) {
+	if (can == NULL) return CANAL_NULL_REF;
+
+	return receiveFifo(can, CAN_RX_FIFO1);
+}
+
+TeCanALRet CanAL_RxFifoFull(TsCanAL* can, uint32_t fifo) {
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (!IS_CANAL_RX_FIFO(fifo)) return CANAL_ERROR;
+
+	can->rxFifoStats[fifo].full++;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Error(TsCanAL* can) {
+	uint32_t error;
+	uint32_t txErrors = 0;
+	uint32_t primask;
+	TsCanALTxIdStats* stats;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (can->hcan == NULL) return CANAL_CAN_HANDLE_NULL_REF;
+
+	error = HAL_CAN_GetError(can->hcan);
+
+	if ((error & HAL_CAN_ERROR_RX_FOV0) != 0U) can->rxFifoStats[CAN_RX_FIFO0].overrun++;
+	if ((error & HAL_CAN_ERROR_RX_FOV1) != 0U) can->rxFifoStats[CAN_RX_FIFO1].overrun++;
+
+	// Without automatic retransmission a frame that loses arbitration or hits a
+	// bus error frees its mailbox through this callback rather than the tx
+	// complete one, so the queue behind it has to be moved on from here
+	primask = CanAL_EnterCritical();
+
+	for (uint32_t i = 0; i < CANAL_NUM_TX_MAILBOXES; i++) {
+		if ((error & TX_MAILBOX_ERRORS[i]) == 0U) continue;
+
+		txErrors |= TX_MAILBOX_ERRORS[i];
+
+		if ((can->txMailboxIds[i] != CANAL_TX_STATS_EMPTY_ID) &&
+			((stats = txStatsFor(can, can->txMailboxIds[i])) != NULL)) {
+			stats->failed++;
+		}
+
+#if CANAL_TIMESTAMP_MODE
+		CanAL_Timestamp_TxAbort(&can->timestamps, CAN_TX_MAILBOX0 << i);
+#endif // CANAL_TIMESTAMP_MODE
+	}
+
+	if (txErrors != 0U) txRefill(can);
+
+	CanAL_ExitCritical(primask);
+
+	// The HAL accumulates error bits, clear ours so the next error counts once
+	can->hcan->ErrorCode &= ~(HAL_CAN_ERROR_RX_FOV0 | HAL_CAN_ERROR_RX_FOV1 | txErrors);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_ProcessRx(TsCanAL* can, uint16_t budget) {
+	TeCanALRet ret;
+	TeCanALRet fifoRet;
+	uint16_t processed = 0;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	// Priority frames first so a telemetry burst cannot delay them
+	ret = drainRxRing(&can->rxRing[CANAL_PRIORITY_RX_FIFO], budget, &processed);
+
+	fifoRet = drainRxRing(&can->rxRing[DEFAULT_RX_FIFO], budget, &processed);
+	if (fifoRet != CANAL_OK) ret = fifoRet;
+
+	return ret;
+}
+
+TeCanALRet CanAL_InjectRx(TsCanAL* can, uint32_t fifo, const TsCanALRawFrame* frame) {
+	TeCanALRet ret;
+	TsCanALRawFrame copy;
+	TsCanALRawFrame* slot;
+	TsCanALRxRing* ring;
+	uint32_t primask;
+	uint16_t index;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if ((frame == NULL) || !IS_CANAL_RX_FIFO(fifo)) return CANAL_ERROR;
+
+	ring = &can->rxRing[fifo];
+	index = CanAL_FindFrameCodec(frame->id, frame->ide);
+	CanAL_Store_Write(index, frame, HAL_GetTick());
+
+	if (can->rxMode != CANAL_RX_MODE_DEFERRED) {
+		// The decoders take a mutable buffer
+		copy = *frame;
+		return acceptRxFrame(can, ring, &copy, index, false);
+	}
+
+	// The rx interrupt is the only other producer of the ring, so keep it out
+	// until the frame is committed
+	primask = CanAL_EnterCritical();
+	slot = rxRingSlot(ring);
+	if (slot == NULL) {
+		copy = *frame;
+		slot = &copy;
+	} else {
+		*slot = *frame;
+	}
+	ret = acceptRxFrame(can, ring, slot, index, slot != &copy);
+	CanAL_ExitCritical(primask);
+
+	return ret;
+}
+
+TeCanALRet CanAL_GetRxRingStats(TsCanAL* can, uint32_t fifo, TsCanALRxRingStats* stats) {
+	TsCanALRxRing* ring;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if ((stats == NULL) || !IS_CANAL_RX_FIFO(fifo)) return CANAL_ERROR;
+
+	ring = &can->rxRing[fifo];
+	stats->pending = (uint16_t)(ring->head - ring->tail);
+	stats->highWaterMark = ring->highWaterMark;
+	stats->dropped = ring->dropped;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_GetRxFifoStats(TsCanAL* can, uint32_t fifo, TsCanALRxFifoStats* stats) {
+	uint32_t primask;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if ((stats == NULL) || !IS_CANAL_RX_FIFO(fifo)) return CANAL_ERROR;
+
+	// The counters are updated from the rx interrupts, copy them in one piece
+	primask = CanAL_EnterCritical();
+	*stats = can->rxFifoStats[fifo];
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Transmit(TsCanAL* can, TeMessageID ID) {
+	TsCanALRawFrame frame = {0};
+	TeCanALRet ret;
+	// txCycles covers marshalling too, it is part of what a send costs
+	CANAL_STATS_START(start);
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if ((ret = marshalFrame(ID, &frame)) != CANAL_OK) return ret;
+
+	ret = txSubmit(can, &frame);
+	CANAL_STATS_STOP(&can->stats.totals.txCycles, start);
+
+	return ret;
+}
+
+TeCanALRet CanAL_TransmitBatch(TsCanAL* can, const TeMessageID* IDs, uint16_t n) {
+	TsCanALRawFrame frames[CANAL_TX_BATCH_MAX];
+	TsCanALRawFrame frame;
+	TeCanALRet ret;
+	uint32_t room;
+	uint32_t submitted;
+	uint32_t primask;
+	uint16_t j;
+	CANAL_STATS_START(start);
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if ((IDs == NULL) || (n > CANAL_TX_BATCH_MAX)) return CANAL_ERROR;
+
+	// Marshal everything first so the critical section only moves frames, and
+	// sort them into arbitration order so the mailboxes get the most urgent
+	// ones. Equal IDs keep the order they were given in.
+	for (uint16_t i = 0; i < n; i++) {
+		frame.timestamp = 0;
+		memset(frame.data, 0, sizeof(frame.data));
+
+		if ((ret = marshalFrame(IDs[i], &frame)) != CANAL_OK) return ret;
+
+		for (j = i; (j > 0U) && (arbitrationKey(&frames[j - 1U]) > arbitrationKey(&frame)); j--) {
+			frames[j] = frames[j - 1U];
+		}
+		frames[j] = frame;
+	}
+
+	submitted = CANAL_TIMESTAMP_NOW();
+	primask = CanAL_EnterCritical();
+
+	// With the queue drained into every free mailbox, the frames that fit are
+	// the free mailboxes plus the free queue entries
+	txRefill(can);
+	room = HAL_CAN_GetTxMailboxesFreeLevel(can->hcan) + (CANAL_TX_QUEUE_SIZE - can->txQueue.count);
+
+	if (n > room) {
+		for (uint16_t i = 0; i < n; i++) countTx(can, frames[i].id, 0, 0, 1);
+
+		ret = CANAL_TX_QUEUE_FULL;
+	} else {
+		for (uint16_t i = 0; i < n; i++) txSubmitLocked(can, &frames[i], submitted);
+
+		ret = CANAL_OK;
+	}
+
+	CanAL_ExitCritical(primask);
+
+	CANAL_STATS_STOP(&can->stats.totals.txCycles, start);
+
+	return ret;
+}
+
+TeCanALRet CanAL_TransmitRaw(TsCanAL* can, TsCanALRawFrame* frame) {
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (frame == NULL) return CANAL_ERROR;
+
+	if (frame->dlc > 8U) return CANAL_UNSUPPORTED_TX_MESSAGE;
+
+	switch (frame->ide) {
+		case CAN_ID_STD:
+			if (!IS_CAN_STDID(frame->id)) return CANAL_UNSUPPORTED_TX_MESSAGE;
+			break;
+		case CAN_ID_EXT:
+			if (!IS_CAN_EXTID(frame->id)) return CANAL_UNSUPPORTED_TX_MESSAGE;
+			break;
+		default:
+			return CANAL_UNKOWN_IDE;
+	}
+
+	return txSubmit(can, frame);
+}
+
+TeCanALRet CanAL_TxMailboxComplete(TsCanAL* can, uint32_t mailbox) {
+	uint32_t primask;
+#if CANAL_TIMESTAMP_MODE
+	uint32_t cycles = CANAL_STATS_CYCLES();
+	uint32_t ID;
+	uint32_t timestamp;
+	TsCanALTxIdStats* stats;
+#endif // CANAL_TIMESTAMP_MODE
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	primask = CanAL_EnterCritical();
+
+#if CANAL_TIMESTAMP_MODE
+	if (CanAL_Timestamp_TxComplete(&can->timestamps, mailbox,
+			(uint16_t)HAL_CAN_GetTxTimestamp(can->hcan, mailbox), HAL_GetTick(), cycles,
+			&ID, &timestamp)) {
+		if ((stats = txStatsFor(can, ID)) != NULL) stats->timestamp = timestamp;
+	}
+#else
+	(void)mailbox;
+#endif // CANAL_TIMESTAMP_MODE
+
+	txRefill(can);
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_TxMailboxAbort(TsCanAL* can, uint32_t mailbox) {
+	uint32_t primask;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	primask = CanAL_EnterCritical();
+
+#if CANAL_TIMESTAMP_MODE
+	CanAL_Timestamp_TxAbort(&can->timestamps, mailbox);
+#else
+	(void)mailbox;
+#endif // CANAL_TIMESTAMP_MODE
+
+	txRefill(can);
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Subscribe(TsCanAL* can, uint32_t ID, uint8_t ide, uint32_t fifo) {
+	uint16_t index;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	switch (ide) {
+		case CAN_ID_STD:
+			if (!IS_CAN_STDID(ID)) return CANAL_UNSUPPORTED_RX_MESSAGE;
+			break;
+		case CAN_ID_EXT:
+			if (!IS_CAN_EXTID(ID)) return CANAL_UNSUPPORTED_RX_MESSAGE;
+			break;
+		default:
+			return CANAL_UNKOWN_IDE;
+	}
+
+	if (!IS_CANAL_RX_FIFO(fifo)) return CANAL_ERROR;
+
+	index = can->numRxIds;
+
+	for (uint16_t i = 0; i < can->numRxIds; i++) {
+		if ((can->rxIds[i] != ID) || (can->rxIdIde[i] != ide)) continue;
+
+		if (can->rxIdFifo[i] == fifo) return CANAL_OK;
+
+		index = i;
+		break;
+	}
+
+	if ((fifo == CANAL_PRIORITY_RX_FIFO) &&
+		(countRxIds(can, CANAL_PRIORITY_RX_FIFO) >= CANAL_MAX_PRIORITY_RX_IDS)) {
+		return CANAL_FILTER_TABLE_FULL;
+	}
+
+	if (index == can->numRxIds) {
+		if (can->numRxIds >= CANAL_MAX_RX_IDS) return CANAL_FILTER_TABLE_FULL;
+
+		can->rxIdIde[can->numRxIds] = ide;
+		can->rxIds[can->numRxIds++] = ID;
+	}
+
+	can->rxIdFifo[index] = (uint8_t)fifo;
+
+	return setFilters(can);
+}
+
+TeCanALRet CanAL_Unsubscribe(TsCanAL* can, uint32_t ID, uint8_t ide) {
+	if (can == NULL) return CANAL_NULL_REF;
+
+	for (uint16_t i = 0; i < can->numRxIds; i++) {
+		if ((can->rxIds[i] == ID) && (can->rxIdIde[i] == ide)) {
+			can->numRxIds--;
+			can->rxIds[i] = can->rxIds[can->numRxIds];
+			can->rxIdIde[i] = can->rxIdIde[can->numRxIds];
+			can->rxIdFifo[i] = can->rxIdFifo[can->numRxIds];
+			return setFilters(can);
+		}
+	}
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_AddRxHook(TsCanAL* can, TsCanALRxHookNode* node, CanALRxHook* hook, void* ctx) {
+	TeCanALRet ret = CANAL_OK;
+	TsCanALRxHookNode* volatile* link;
+	uint32_t primask;
+
+	if ((can == NULL) || (node == NULL) || (hook == NULL)) return CANAL_NULL_REF;
+
+	// The rx interrupt may walk the list at any time, so link it in one store
+	primask = CanAL_EnterCritical();
+
+	link = &can->rxHooks;
+	while ((*link != NULL) && (*link != node)) link = &(*link)->next;
+
+	if (*link == NULL) {
+		if (node->added) {
+			ret = CANAL_ERROR;
+		} else {
+			node->hook = hook;
+			node->ctx = ctx;
+			node->next = NULL;
+			node->added = true;
+			*link = node;
+		}
+	}
+
+	CanAL_ExitCritical(primask);
+
+	return ret;
+}
+
+TeCanALRet CanAL_RemoveRxHook(TsCanAL* can, TsCanALRxHookNode* node) {
+	TsCanALRxHookNode* volatile* link;
+	uint32_t primask;
+
+	if ((can == NULL) || (node == NULL)) return CANAL_NULL_REF;
+
+	primask = CanAL_EnterCritical();
+
+	link = &can->rxHooks;
+	while ((*link != NULL) && (*link != node)) link = &(*link)->next;
+
+	// node->next stays as it is, a frame in progress moves on through it
+	if (*link != NULL) {
+		*link = node->next;
+		node->added = false;
+	}
+
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_SetTrace(TsCanAL* can, TsCanALTrace* trace) {
+	if (can == NULL) return CANAL_NULL_REF;
+
+	can->trace = trace;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_OnMessage(uint32_t ID, CanALMessageHandler* handler) {
+	uint16_t index = CanAL_FindCodec(ID);
+
+	if ((index == CANAL_NO_CODEC) || (CANAL_CODEC_TABLE[index].unmarshal == NULL)) {
+		return CANAL_UNSUPPORTED_RX_MESSAGE;
+	}
+
+	messageHandlers[index] = handler;
+
+	return CANAL_OK;
+}
+
+TsCanAL* CanAL_FromHandle(CAN_HandleTypeDef* hcan) {
+	for (uint8_t i = 0; i < CANAL_NUM_INSTANCES; i++) {
+		if ((instances[i] != NULL) && (instances[i]->hcan == hcan)) return instances[i];
+	}
+
+	return NULL;
+}
+
+TeCanALRet CanAL_GetStats(TsCanAL* can, TsCanALStats* stats) {
+#if CANAL_STATS_MODE
+	uint32_t primask;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (stats == NULL) return CANAL_ERROR;
+
+	// Only the copy has to be consistent with the rx interrupt, the window math
+	// runs on the snapshot with interrupts enabled
+	primask = CanAL_EnterCritical();
+	*stats = can->stats.totals;
+	CanAL_ExitCritical(primask);
+
+	CanAL_Stats_CloseWindow(&can->stats, stats, HAL_GetTick(), (uint32_t)can->baud * 1000U);
+
+	return CANAL_OK;
+#else
+	(void)can;
+	(void)stats;
+
+	return CANAL_UNSUPPORTED_MODE;
+#endif // CANAL_STATS_MODE
+}
+
+TeCanALRet CanAL_GetIdStats(TsCanAL* can, uint32_t ID, TsCanALIdRate* rate) {
+#if CANAL_STATS_MODE
+	uint16_t index = CanAL_FindCodec(ID);
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (rate == NULL) return CANAL_ERROR;
+
+	if (index == CANAL_NO_CODEC) return CANAL_UNSUPPORTED_RX_MESSAGE;
+
+	rate->frames = can->stats.idFrames[index];
+	rate->rateHz = can->stats.idRate[index];
+
+	return CANAL_OK;
+#else
+	(void)can;
+	(void)ID;
+	(void)rate;
+
+	return CANAL_UNSUPPORTED_MODE;
+#endif // CANAL_STATS_MODE
+}
+
+TeCanALRet CanAL_GetLatency(TsCanAL* can, TsCanALLatency* latency) {
+#if CANAL_TIMESTAMP_MODE
+	uint32_t primask;
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (latency == NULL) return CANAL_ERROR;
+
+	primask = CanAL_EnterCritical();
+	*latency = can->timestamps.latency;
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+#else
+	(void)can;
+	(void)latency;
+
+	return CANAL_UNSUPPORTED_MODE;
+#endif // CANAL_TIMESTAMP_MODE
+}
+
+uint32_t CanAL_Time_Since_Updated(TeMessageID messageID) {
+	uint32_t tick;
+
+	if (CanAL_Last_Update_Tick(messageID, &tick) != CANAL_OK) return CANAL_NEVER_UPDATED;
+
+	return HAL_GetTick() - tick;
+}
+
+TeCanALRet CanAL_Last_Update_Tick(uint32_t ID, uint32_t* tick) {
+	uint16_t index = CanAL_FindCodec(ID);
+
+	if (tick == NULL) return CANAL_ERROR;
+
+	if ((index == CANAL_NO_CODEC) || (CANAL_CODEC_TABLE[index].unmarshal == NULL)) {
+		return CANAL_UNSUPPORTED_RX_MESSAGE;
+	}
+
+	*tick = lastUpdateTick[index];
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_GetTxStats(TsCanAL* can, uint32_t ID, TsCanALTxIdStats* stats) {
+	uint32_t slot = txStatsSlot(ID);
+
+	if (can == NULL) return CANAL_NULL_REF;
+
+	if (stats == NULL) return CANAL_ERROR;
+
+	stats->id = ID;
+	stats->enqueued = 0;
+	stats->sent = 0;
+	stats->dropped = 0;
+	stats->failed = 0;
+	stats->timestamp = 0;
+
+	for (uint32_t i = 0; i < CANAL_TX_STATS_SIZE; i++) {
+		TsCanALTxIdStats* entry = &can->txStats[(slot + i) & (CANAL_TX_STATS_SIZE - 1U)];
+
+		if (entry->id == CANAL_TX_STATS_EMPTY_ID) break;
+
+		if (entry->id == ID) {
+			*stats = *entry;
+			break;
+		}
+	}
+
+	return CANAL_OK;
+}
+
+#ifdef CANAL_HAL_CALLBACKS
+
+/*********************************************************
+*                    HAL CALLBACKS
+*********************************************************/
+
+void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_Receive(CanAL_FromHandle(hcan));
+}
+
+void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_ReceiveFifo1(CanAL_FromHandle(hcan));
+}
+
+void HAL_CAN_RxFifo0FullCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_RxFifoFull(CanAL_FromHandle(hcan), CAN_RX_FIFO0);
+}
+
+void HAL_CAN_RxFifo1FullCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_RxFifoFull(CanAL_FromHandle(hcan), CAN_RX_FIFO1);
+}
+
+void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_TxMailboxComplete(CanAL_FromHandle(hcan), CAN_TX_MAILBOX0);
+}
+
+void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_TxMailboxComplete(CanAL_FromHandle(hcan), CAN_TX_MAILBOX1);
+}
+
+void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_TxMailboxComplete(CanAL_FromHandle(hcan), CAN_TX_MAILBOX2);
+}
+
+void HAL_CAN_TxMailbox0AbortCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_TxMailboxAbort(CanAL_FromHandle(hcan), CAN_TX_MAILBOX0);
+}
+
+void HAL_CAN_TxMailbox1AbortCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_TxMailboxAbort(CanAL_FromHandle(hcan), CAN_TX_MAILBOX1);
+}
+
+void HAL_CAN_TxMailbox2AbortCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_TxMailboxAbort(CanAL_FromHandle(hcan), CAN_TX_MAILBOX2);
+}
+
+void HAL_CAN_ErrorCallback(CAN_HandleTypeDef* hcan) {
+	CanAL_Error(CanAL_FromHandle(hcan));
+}
 
+#endif // CANAL_HAL_CALLBACKS
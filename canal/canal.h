@@ -38,21 +38,58 @@
 #include <stdbool.h>
 #include "main.h"
 #include "canal_types.h"
-
-// This is a file that must be auto-generated by the canalgen tool in the
-// can_dbc repo.
-#include "canal_messages.h"
+#include "canal_filter.h"
+#include "canal_bittiming.h"
+#include "canal_stats.h"
+#include "canal_store.h"
+#include "canal_dispatch.h"
+#include "canal_trace.h"
+#include "canal_timestamp.h"
+#include "canal_handler.h"
+#include "canal_autobaud.h"
 
 /*********************************************************
 *                       MACROS
 *********************************************************/
 
-#define FREQ_MHZ						(1000000U)
-#define NUM_SUPPORTED_PCKL1_FREQ 		(2U)
-#define NUM_SUPPORTED_CAN_BITRATES		(4U)
-#define NUM_BITRATE_ENTRIES				(NUM_SUPPORTED_CAN_BITRATES * NUM_SUPPORTED_PCKL1_FREQ)
-#define DEFAULT_SYNC_JW 				(CAN_SJW_1TQ)
+// CANAL_SAMPLE_POINT is the bit timing sample point in permille. 87.5% is the
+// CANopen / can-wiki default.
+#ifndef CANAL_SAMPLE_POINT
+#define CANAL_SAMPLE_POINT				(875U)
+#endif // CANAL_SAMPLE_POINT
+
+// Define CANAL_PCLK1_HZ (e.g. in the build flags) to solve the bit timing at
+// compile time. A different clock found at runtime is still solved by
+// CanAL_SolveBitTiming.
+
 #define DEFAULT_RX_FIFO					(CAN_RX_FIFO0)
+// CANAL_PRIORITY_RX_FIFO gets its own interrupt so that critical frames never
+// wait behind telemetry in DEFAULT_RX_FIFO
+#define CANAL_PRIORITY_RX_FIFO			(CAN_RX_FIFO1)
+#define CANAL_NUM_RX_FIFOS				(2U)
+
+// CANAL_RX_RING_SIZE is the number of raw frames that can be buffered between
+// CanAL_Receive and CanAL_ProcessRx in CANAL_RX_MODE_DEFERRED. Must be a power of 2.
+#define CANAL_RX_RING_SIZE				(32U)
+
+// CANAL_TX_QUEUE_SIZE is the number of frames that can wait in software for one
+// of the three tx mailboxes to free up
+#define CANAL_TX_QUEUE_SIZE				(16U)
+// CANAL_TX_BATCH_MAX is the most frames CanAL_TransmitBatch takes at once: the
+// three tx mailboxes plus an empty software queue
+#define CANAL_TX_BATCH_MAX				(CANAL_TX_QUEUE_SIZE + 3U)
+// CANAL_TX_STATS_SIZE is the number of distinct IDs that tx counters are kept
+// for. Must be a power of 2.
+#define CANAL_TX_STATS_SIZE				(32U)
+#define CANAL_TX_STATS_EMPTY_ID			(0xFFFFFFFFU)
+// CANAL_NUM_TX_MAILBOXES is the number of bxCAN tx mailboxes
+#define CANAL_NUM_TX_MAILBOXES			(3U)
+
+// With fifo priority disabled bxCAN picks the pending mailbox with the lowest
+// identifier. The software tx queue uses the same arbitration order, so a low
+// priority frame can never hold back a higher priority one for longer than a
+// single frame time.
+#define DEFAULT_TX_FIFO_PRIORITY		(DISABLE)
 
 // #define DEFAULT_FILTER_BANK				(13)
 // #define DEFAULT_FILTER_MODE				(CAN_FILTERMODE_IDMASK)
@@ -65,15 +102,38 @@
 // #define DEFAULT_FILTER_ACTIVATION 		(ENABLE)
 // #define DEFAULT_FILTER_SLAVE_START_BANK (0)
 
-#define DEFAULT_FILTER_BANK             (13)
-#define DEFAULT_FILTER_MODE             (CAN_FILTERMODE_IDMASK)
-#define DEFAULT_FILTER_SCALE            (CAN_FILTERSCALE_32BIT)
-#define DEFAULT_FILTER_ID_HIGH          (0x0000)
-#define DEFAULT_FILTER_ID_LOW           (0x0000)
-#define DEFAULT_FILTER_MASK_ID_HIGH     (0x0000)
-#define DEFAULT_FILTER_MASK_ID_LOW      (0x0000)
+// CAN1 and CAN2 share 28 filter banks split at DEFAULT_FILTER_SLAVE_START_BANK,
+// CAN3 has 14 banks of its own. Each instance owns 14 banks.
 #define DEFAULT_FILTER_ACTIVATION       (ENABLE)
-#define DEFAULT_FILTER_SLAVE_START_BANK (0)
+#define DEFAULT_FILTER_SLAVE_START_BANK (14)
+#define CANAL_FILTER_BANKS_PER_INSTANCE (14U)
+
+// CANAL_MAX_RX_IDS is the number of IDs that the hardware filters can be asked
+// to accept. Every message flagged rx in CANAL_MESSAGE_LIST is
+// subscribed on init. With no IDs subscribed (or more receive messages than
+// fit) the filters accept every frame.
+#define CANAL_MAX_RX_IDS                (CANAL_FILTER_MAX_IDS)
+// CANAL_MAX_PRIORITY_RX_IDS is how many of the subscribed IDs can be routed to
+// CANAL_PRIORITY_RX_FIFO. They take one filter bank per two IDs.
+#define CANAL_MAX_PRIORITY_RX_IDS		(8U)
+
+// CANAL_AUTOBAUD_DWELL_MS is how long CanAL_InitAutobaud listens at a bitrate
+// before locking it or moving on to the next one
+#ifndef CANAL_AUTOBAUD_DWELL_MS
+#define CANAL_AUTOBAUD_DWELL_MS			(50U)
+#endif // CANAL_AUTOBAUD_DWELL_MS
+
+// CANAL_INIT_TIMEOUT_MS bounds the wait for bxCAN to enter or leave
+// initialization mode when the bit timing is changed after CanAL_Init
+#define CANAL_INIT_TIMEOUT_MS			(10U)
+
+// CANAL_NUM_INSTANCES is the number of bxCAN peripherals, CAN1 to CAN3
+#define CANAL_NUM_INSTANCES				(3U)
+
+// Define CANAL_HAL_CALLBACKS to let canal implement the HAL_CAN_*Callback
+// functions and route them to the right TsCanAL with CanAL_FromHandle
+
+#define CANAL_NEVER_UPDATED				(0xFFFFFFFFU)
 
 #define IS_CANAL_BAUDRATE(__baud__) ((__baud__ == CANAL_BAUD_100K) || \
 									 (__baud__ == CANAL_BAUD_250K) || \
@@ -85,6 +145,20 @@
 									 (__mode__ == CANAL_MODE_SILENT_LOOPBACK) 	|| \
 									 (__mode__ == CANAL_MODE_SILENT))
 
+#define IS_CANAL_RX_FIFO(__fifo__)	((__fifo__ == CAN_RX_FIFO0)	|| \
+									 (__fifo__ == CAN_RX_FIFO1))
+
+#define IS_CANAL_RX_MODE(__mode__)	((__mode__ == CANAL_RX_MODE_IMMEDIATE)		|| \
+									 (__mode__ == CANAL_RX_MODE_DEFERRED))
+
+#if (CANAL_RX_RING_SIZE & (CANAL_RX_RING_SIZE - 1U)) != 0U
+#error "CANAL_RX_RING_SIZE must be a power of 2"
+#endif
+
+#if (CANAL_TX_STATS_SIZE & (CANAL_TX_STATS_SIZE - 1U)) != 0U
+#error "CANAL_TX_STATS_SIZE must be a power of 2"
+#endif
+
 /*********************************************************
 *                       TYPES
 *********************************************************/
@@ -125,27 +199,264 @@ typedef enum {
 	CANAL_INST_CAN_3,
 }TeCanALInstance;
 
+// TeCanALRxMode selects where received frames are decoded
+typedef enum {
+	// CANAL_RX_MODE_IMMEDIATE decodes every frame inside CanAL_Receive, i.e. in
+	// interrupt context. This is the default. The generated global structs are
+	// written from the interrupt, use CanAL_Store_Read for a consistent frame.
+	CANAL_RX_MODE_IMMEDIATE = 0,
+	// CANAL_RX_MODE_DEFERRED only copies the raw frame into the rx ring inside
+	// CanAL_Receive. Frames are decoded when the main loop calls CanAL_ProcessRx.
+	CANAL_RX_MODE_DEFERRED,
+}TeCanALRxMode;
+
+// TsCanALRxRing is a lock-free single-producer (ISR) / single-consumer (main
+// loop) queue of raw frames. head is only written by CanAL_Receive and tail is
+// only written by CanAL_ProcessRx. Both are free running and wrap naturally.
+typedef struct {
+	volatile uint16_t head;
+	volatile uint16_t tail;
+	// highWaterMark is the largest number of frames that have been pending at once
+	volatile uint16_t highWaterMark;
+	// dropped counts the frames that were discarded because the ring was full
+	volatile uint32_t dropped;
+	TsCanALRawFrame frames[CANAL_RX_RING_SIZE];
+}TsCanALRxRing;
+
+// TsCanALRxRingStats is a snapshot of the rx ring counters
+typedef struct {
+	uint16_t pending;
+	uint16_t highWaterMark;
+	uint32_t dropped;
+}TsCanALRxRingStats;
+
+// TsCanALRxFifoStats holds the counters of one hardware rx FIFO
+typedef struct {
+	// frames counts every frame read out of the FIFO
+	uint32_t frames;
+	// interrupts counts the rx pending interrupts. frames / interrupts is the
+	// average number of frames drained per interrupt entry.
+	uint32_t interrupts;
+	// maxBurst is the largest number of frames drained by a single interrupt
+	uint32_t maxBurst;
+	// full counts the times all three FIFO slots were occupied
+	uint32_t full;
+	// overrun counts the times a frame was lost because the FIFO was full
+	uint32_t overrun;
+}TsCanALRxFifoStats;
+
+// TsCanALTxEntry is a frame waiting in the software tx queue
+typedef struct {
+	TsCanALRawFrame frame;
+	// key is the bus arbitration order of the frame, lower values win
+	uint32_t key;
+	// seq keeps frames with the same key in submission order
+	uint32_t seq;
+	// submitted is the CANAL_TIMESTAMP_NOW() of the frame being sent
+	uint32_t submitted;
+}TsCanALTxEntry;
+
+// TsCanALTxQueue is a binary min-heap of pending frames ordered by key then seq
+typedef struct {
+	TsCanALTxEntry entries[CANAL_TX_QUEUE_SIZE];
+	uint16_t count;
+	uint32_t seq;
+}TsCanALTxQueue;
+
+// TsCanALTxIdStats holds the tx counters of a single CAN ID.
+// enqueued counts frames that had to wait in the software queue, sent counts
+// frames handed to a mailbox and dropped counts frames that were discarded.
+// failed counts sent frames that lost arbitration or hit a bus error; with
+// automatic retransmission off they are not retried.
+// With CANAL_TIMESTAMP_MODE timestamp is the bus time of the last frame sent.
+typedef struct {
+	uint32_t id;
+	uint32_t enqueued;
+	uint32_t sent;
+	uint32_t dropped;
+	uint32_t failed;
+	uint32_t timestamp;
+}TsCanALTxIdStats;
+
+// CanALMessageHandler is called right after ID has been unmarshalled, in the
+// context that decoded it (the rx interrupt or CanAL_ProcessRx)
+typedef void CanALMessageHandler(uint32_t ID);
+
+typedef struct TsCanALRxHookNode TsCanALRxHookNode;
+
+// TsCanALRxHookNode links one CanALRxHook into an instance. Nodes are owned by
+// the caller, usually embedded in the module the hook belongs to, so any
+// number of modules can watch the same instance without allocating. A node
+// must stay valid while it is added.
+struct TsCanALRxHookNode {
+	CanALRxHook* hook;
+	void* ctx;
+	bool added;
+	TsCanALRxHookNode* next;
+};
+
 typedef struct {
 	CAN_HandleTypeDef* hcan;
 	TeCanALInstance canNum;
 	TeCanALBaud baud;
 	TeCanALMode mode;
+	TeCanALRxMode rxMode;
+	// rxRing and rxFifoStats are owned by canal and must not be modified by the
+	// application. Both are indexed by CAN_RX_FIFOx.
+	TsCanALRxRing rxRing[CANAL_NUM_RX_FIFOS];
+	volatile TsCanALRxFifoStats rxFifoStats[CANAL_NUM_RX_FIFOS];
+	// txQueue and txStats are owned by canal and must not be modified by the
+	// application
+	TsCanALTxQueue txQueue;
+	TsCanALTxIdStats txStats[CANAL_TX_STATS_SIZE];
+	// txMailboxIds is the ID of the frame last loaded into each tx mailbox
+	uint32_t txMailboxIds[CANAL_NUM_TX_MAILBOXES];
+	// rxIds is the set of IDs the hardware filters are programmed to accept. Use
+	// CanAL_Subscribe / CanAL_Unsubscribe to change it. rxIdIde holds the
+	// CAN_ID_STD or CAN_ID_EXT of each ID and rxIdFifo the
+	// CAN_RX_FIFOx each ID is routed to.
+	uint32_t rxIds[CANAL_MAX_RX_IDS];
+	uint8_t rxIdIde[CANAL_MAX_RX_IDS];
+	uint8_t rxIdFifo[CANAL_MAX_RX_IDS];
+	uint16_t numRxIds;
+	// rxHooks is the list of hooks added with CanAL_AddRxHook
+	TsCanALRxHookNode* volatile rxHooks;
+	// trace is set with CanAL_SetTrace
+	TsCanALTrace* trace;
+#if CANAL_STATS_MODE
+	TsCanALStatsState stats;
+#endif // CANAL_STATS_MODE
+#if CANAL_TIMESTAMP_MODE
+	TsCanALTimestampState timestamps;
+#endif // CANAL_TIMESTAMP_MODE
 }TsCanAL;
 
 /*********************************************************
 *               PUBLIC FUNCTION DECLARATIONS
 *********************************************************/
 
+// CanAL_EnterCritical masks interrupts and returns the previous mask, which must
+// be handed back to CanAL_ExitCritical
+static inline uint32_t CanAL_EnterCritical(void) {
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	return primask;
+}
+
+static inline void CanAL_ExitCritical(uint32_t primask) {
+	__set_PRIMASK(primask);
+}
+
 // CanAL_Init initializes CAN hardware and must be called with successful return
 // before any other CAN functions
 TeCanALRet CanAL_Init(TsCanAL* can);
-// CanAL_Receive is meant to be called in HAL_CAN_RxFifo0MsgPendingCallback
+// CanAL_InitAutobaud initializes can like CanAL_Init without knowing the baud.
+// It listens in CANAL_MODE_SILENT at every supported baud in turn until one
+// receives frames without errors for CANAL_AUTOBAUD_DWELL_MS, then sets
+// can->baud and switches to can->mode by rewriting the bit timing register,
+// without another HAL_CAN_Init. Returns CANAL_TIMEOUT, leaving the controller
+// silent, if no baud locked within timeoutMs. Blocks, so it must be called
+// from the main loop.
+TeCanALRet CanAL_InitAutobaud(TsCanAL* can, uint32_t timeoutMs);
+// CanAL_Receive is meant to be called in HAL_CAN_RxFifo0MsgPendingCallback. It
+// drains every frame pending in FIFO0, not just the one that raised the interrupt.
 TeCanALRet CanAL_Receive(TsCanAL* can);
-// TODO: CanAL_Transmit will send the global message struct associated with the
-// messageID provided
+// CanAL_ReceiveFifo1 is meant to be called in HAL_CAN_RxFifo1MsgPendingCallback
+// and drains every frame pending in FIFO1
+TeCanALRet CanAL_ReceiveFifo1(TsCanAL* can);
+// CanAL_RxFifoFull is meant to be called in HAL_CAN_RxFifo{0,1}FullCallback
+// with the matching CAN_RX_FIFOx
+TeCanALRet CanAL_RxFifoFull(TsCanAL* can, uint32_t fifo);
+// CanAL_Error is meant to be called in HAL_CAN_ErrorCallback. It counts and
+// clears the FIFO overrun errors and the tx errors of frames that lost
+// arbitration or failed, refilling the mailboxes they freed. The other error
+// bits are left to the application.
+TeCanALRet CanAL_Error(TsCanAL* can);
+// CanAL_ProcessRx decodes up to budget frames queued by CanAL_Receive and
+// CanAL_ReceiveFifo1 when rxMode is CANAL_RX_MODE_DEFERRED, FIFO1 frames first.
+// A budget of 0 drains every pending frame. It is meant to be called from the
+// main loop.
+TeCanALRet CanAL_ProcessRx(TsCanAL* can, uint16_t budget);
+// CanAL_InjectRx hands frame to can as if it had just been read from fifo: it
+// goes through the same stats, trace, store, rx hook and decode path as a frame
+// from the hardware, without touching the CAN peripheral. It is meant for
+// replaying captures (see canal_replay.h).
+TeCanALRet CanAL_InjectRx(TsCanAL* can, uint32_t fifo, const TsCanALRawFrame* frame);
+// CanAL_GetRxRingStats copies the occupancy, high-water-mark and drop counters
+// of the rx ring fed by fifo into stats
+TeCanALRet CanAL_GetRxRingStats(TsCanAL* can, uint32_t fifo, TsCanALRxRingStats* stats);
+// CanAL_GetRxFifoStats copies the hardware FIFO counters of fifo into stats
+TeCanALRet CanAL_GetRxFifoStats(TsCanAL* can, uint32_t fifo, TsCanALRxFifoStats* stats);
+// CanAL_Transmit sends the global message struct associated with the messageID
+// provided. If every mailbox is busy the frame waits in the software tx queue.
 TeCanALRet CanAL_Transmit(TsCanAL* can, TeMessageID messageID);
-// TODO: CanAL_Time_Since_Updated returns the amount of time since the message
-// associated with messageID provided was last updated in milliseconds
-uint8_t CanAL_Time_Since_Updated(TeMessageID messageID);
+// CanAL_TransmitRaw sends an already marshalled frame through the same mailbox
+// and software queue path as CanAL_Transmit. It is safe to call from the rx
+// interrupt of another instance.
+TeCanALRet CanAL_TransmitRaw(TsCanAL* can, TsCanALRawFrame* frame);
+// CanAL_TransmitBatch marshals the n (at most CANAL_TX_BATCH_MAX) messages of
+// IDs and then hands them to the mailboxes and software queue in arbitration
+// order inside one critical section, so no other frame from this node can get
+// in between them. The batch is sent whole or not at all: a message that cannot
+// be marshalled returns its error and a batch that does not fit the free
+// mailboxes and queue returns CANAL_TX_QUEUE_FULL, counting every frame of it as
+// dropped.
+TeCanALRet CanAL_TransmitBatch(TsCanAL* can, const TeMessageID* IDs, uint16_t n);
+// CanAL_TxMailboxComplete refills the freed mailbox from the software tx queue.
+// It is meant to be called in HAL_CAN_TxMailbox{0,1,2}CompleteCallback with the
+// matching CAN_TX_MAILBOXx.
+TeCanALRet CanAL_TxMailboxComplete(TsCanAL* can, uint32_t mailbox);
+// CanAL_TxMailboxAbort does the same for a frame that was not sent and is meant
+// to be called in HAL_CAN_TxMailbox{0,1,2}AbortCallback
+TeCanALRet CanAL_TxMailboxAbort(TsCanAL* can, uint32_t mailbox);
+// CanAL_Subscribe adds ID with ide (CAN_ID_STD or CAN_ID_EXT) to the set of IDs
+// accepted by the hardware filters, routed to fifo (DEFAULT_RX_FIFO or
+// CANAL_PRIORITY_RX_FIFO), and reprograms them. Subscribing an ID again moves
+// it to the new fifo. It must be called from the main loop after CanAL_Init.
+TeCanALRet CanAL_Subscribe(TsCanAL* can, uint32_t ID, uint8_t ide, uint32_t fifo);
+// CanAL_Unsubscribe removes ID with ide from the set of IDs accepted by the
+// hardware filters and reprograms them. Removing the last ID accepts every
+// frame again.
+TeCanALRet CanAL_Unsubscribe(TsCanAL* can, uint32_t ID, uint8_t ide);
+// CanAL_GetTxStats copies the tx counters of ID into stats. IDs that were never
+// transmitted report all zeros.
+TeCanALRet CanAL_GetTxStats(TsCanAL* can, uint32_t ID, TsCanALTxIdStats* stats);
+// CanAL_AddRxHook links node to can so that hook is called with ctx for every
+// frame can receives, after the hooks added before it. Adding a node again to
+// the same instance does nothing; returns CANAL_ERROR if node is linked to
+// another instance.
+TeCanALRet CanAL_AddRxHook(TsCanAL* can, TsCanALRxHookNode* node, CanALRxHook* hook, void* ctx);
+// CanAL_RemoveRxHook unlinks node from can, leaving every other hook in place.
+// A hook may remove itself or another hook from its callback.
+TeCanALRet CanAL_RemoveRxHook(TsCanAL* can, TsCanALRxHookNode* node);
+// CanAL_SetTrace records every frame can receives or loads into a tx mailbox
+// into trace. Several instances may share one trace. Pass NULL to detach it.
+TeCanALRet CanAL_SetTrace(TsCanAL* can, TsCanALTrace* trace);
+// CanAL_OnMessage sets the handler called every time ID is received, before the
+// handlers registered with CanAL_Handler_Register. Pass NULL to remove it.
+TeCanALRet CanAL_OnMessage(uint32_t ID, CanALMessageHandler* handler);
+// CanAL_FromHandle returns the initialized TsCanAL that owns hcan, or NULL. It is
+// meant for routing HAL_CAN_*Callback functions that only get the handle.
+TsCanAL* CanAL_FromHandle(CAN_HandleTypeDef* hcan);
+// CanAL_GetStats copies the counters and cycle histograms of can into stats and
+// starts a new bus load / rate window. Returns CANAL_UNSUPPORTED_MODE unless
+// CANAL_STATS_MODE is enabled.
+TeCanALRet CanAL_GetStats(TsCanAL* can, TsCanALStats* stats);
+// CanAL_GetLatency copies the rx/tx latency histograms of can into latency.
+// Returns CANAL_UNSUPPORTED_MODE unless CANAL_TIMESTAMP_MODE is enabled.
+TeCanALRet CanAL_GetLatency(TsCanAL* can, TsCanALLatency* latency);
+// CanAL_GetIdStats copies the receive count of ID and its rate over the window
+// closed by the last CanAL_GetStats call into rate
+TeCanALRet CanAL_GetIdStats(TsCanAL* can, uint32_t ID, TsCanALIdRate* rate);
+// CanAL_Time_Since_Updated returns the amount of time since the message
+// associated with messageID provided was last updated in milliseconds. Messages
+// that were never received count from the first CanAL_Init. Returns
+// CANAL_NEVER_UPDATED for IDs that this board does not receive.
+uint32_t CanAL_Time_Since_Updated(TeMessageID messageID);
+// CanAL_Last_Update_Tick gets the HAL tick at which the message associated with
+// ID was last unmarshalled
+TeCanALRet CanAL_Last_Update_Tick(uint32_t ID, uint32_t* tick);
 
 #endif /* INC_CAN_H_ */
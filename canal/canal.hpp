@@ -0,0 +1,165 @@
+/*
+ * canal.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_HPP_
+#define INC_CANAL_HPP_
+
+// canal.hpp is a header-only C++ layer over canal. The ID, IDE, DLC and codec
+// of every message come from CANAL_MESSAGE_LIST as constexpr traits, so
+// canal::send<MSG>(bus) compiles down to the marshaller call and
+// CanAL_TransmitRaw with no codec table lookup. Using a message in the wrong
+// direction is a compile error.
+//
+// Handler<ID, T> is a canal_handler registration that calls back with a T&
+// instead of a void* context. It adds one indirect call to the C registry.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+
+extern "C" {
+#include "canal.h"
+}
+
+namespace canal {
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// Message<ID> only exists for the IDs in CANAL_MESSAGE_LIST
+template <uint32_t ID>
+struct Message;
+
+#define CANAL_MESSAGE_TRAITS(__id__, __ide__, __dlc__, __rx__, __unmarshaller__, __marshaller__) \
+	template <> \
+	struct Message<(__id__)> { \
+		static constexpr uint32_t id = (__id__); \
+		static constexpr uint8_t ide = (__ide__); \
+		static constexpr uint8_t dlc = (__dlc__); \
+		static constexpr BinaryUnmarshaller* unmarshal = (__unmarshaller__); \
+		static constexpr BinaryMarshaller* marshal = (__marshaller__); \
+	};
+
+CANAL_MESSAGE_LIST(CANAL_MESSAGE_TRAITS)
+
+#undef CANAL_MESSAGE_TRAITS
+
+// Handler<ID, T> calls callback(target, value) for ID through the canal_handler
+// registry. It unregisters itself when it goes out of scope, and like
+// TsCanALHandler it must not move while it is registered.
+template <uint32_t ID, typename T>
+class Handler {
+	static_assert(Message<ID>::unmarshal != nullptr, "message has no unmarshaller, it is not received by this board");
+
+public:
+	typedef void Callback(T& target, float value);
+
+	Handler(T& target, Callback* callback, uint8_t priority = CANAL_HANDLER_PRIORITY_DEFAULT)
+		: target(target), callback(callback) {
+		CanAL_Handler_Init(&handler, ID, &Handler::dispatch, this, priority);
+	}
+
+	~Handler() {
+		CanAL_Handler_Unregister(&handler);
+	}
+
+	Handler(const Handler&) = delete;
+	Handler& operator=(const Handler&) = delete;
+
+	// watch restricts the handler to changes of signal, see
+	// CanAL_Handler_WatchSignal
+	TeCanALRet watch(const TsCanALSignal& signal, float deadband) {
+		return CanAL_Handler_WatchSignal(&handler, &signal, deadband);
+	}
+
+private:
+	template <uint32_t OnID, typename OnT>
+	friend TeCanALRet on(Handler<OnID, OnT>& handler);
+	template <uint32_t OffID, typename OffT>
+	friend TeCanALRet off(Handler<OffID, OffT>& handler);
+
+	static void dispatch(void* ctx, uint32_t, float value) {
+		Handler* self = static_cast<Handler*>(ctx);
+
+		self->callback(self->target, value);
+	}
+
+	TsCanALHandler handler;
+	T& target;
+	Callback* callback;
+};
+
+/*********************************************************
+*               PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+// send marshals the global message struct of ID and queues it on bus
+template <uint32_t ID>
+inline TeCanALRet send(TsCanAL& bus) {
+	using Msg = Message<ID>;
+	static_assert(Msg::marshal != nullptr, "message has no marshaller, it is not transmitted by this board");
+
+	TsCanALRawFrame frame = {};
+	TeCanALRet ret;
+
+	frame.id = Msg::id;
+	frame.ide = Msg::ide;
+	frame.dlc = Msg::dlc;
+
+	if ((ret = Msg::marshal(frame.data)) != CANAL_OK) return ret;
+
+	return CanAL_TransmitRaw(&bus, &frame);
+}
+
+// on adds handler to the registry of its message, see CanAL_Handler_Register
+template <uint32_t ID, typename T>
+inline TeCanALRet on(Handler<ID, T>& handler) {
+	return CanAL_Handler_Register(&handler.handler);
+}
+
+// off removes handler from the registry again
+template <uint32_t ID, typename T>
+inline TeCanALRet off(Handler<ID, T>& handler) {
+	return CanAL_Handler_Unregister(&handler.handler);
+}
+
+// read copies the latest raw payload of ID from the message store
+template <uint32_t ID>
+inline TeCanALRet read(TsCanALStoreSnapshot& snapshot) {
+	static_assert(Message<ID>::unmarshal != nullptr, "message has no unmarshaller, it is not received by this board");
+
+	return CanAL_Store_Read(ID, &snapshot);
+}
+
+} // namespace canal
+
+#endif /* INC_CANAL_HPP_ */
@@ -0,0 +1,109 @@
+/*
+ * canal_autobaud.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stddef.h>
+#include "canal_autobaud.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+static TeCanALAutobaudAction nextCandidate(TsCanALAutobaud* autobaud, uint32_t nowMs) {
+	autobaud->current = (uint8_t)((autobaud->current + 1U) % autobaud->numCandidates);
+	autobaud->candidateStartMs = nowMs;
+	autobaud->frames = 0;
+	autobaud->errors = 0;
+	autobaud->switches++;
+
+	// A single candidate has nothing to switch to
+	return (autobaud->numCandidates > 1U) ? CANAL_AUTOBAUD_SWITCH : CANAL_AUTOBAUD_LISTEN;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Autobaud_Start(TsCanALAutobaud* autobaud, const uint16_t* candidates,
+		uint8_t n, uint32_t dwellMs, uint32_t timeoutMs, uint32_t nowMs) {
+	if (autobaud == NULL) return CANAL_NULL_REF;
+
+	if ((candidates == NULL) || (n == 0U) || (n > CANAL_AUTOBAUD_MAX_CANDIDATES) ||
+		(dwellMs == 0U)) {
+		return CANAL_ERROR;
+	}
+
+	*autobaud = (TsCanALAutobaud){
+		.numCandidates = n,
+		.dwellMs = dwellMs,
+		.timeoutMs = timeoutMs,
+		.startMs = nowMs,
+		.candidateStartMs = nowMs,
+		.state = CANAL_AUTOBAUD_LISTEN,
+	};
+
+	for (uint8_t i = 0; i < n; i++) autobaud->candidates[i] = candidates[i];
+
+	return CANAL_OK;
+}
+
+uint16_t CanAL_Autobaud_Current(const TsCanALAutobaud* autobaud) {
+	return autobaud->candidates[autobaud->current];
+}
+
+TeCanALAutobaudAction CanAL_Autobaud_Step(TsCanALAutobaud* autobaud, uint32_t nowMs,
+		const TsCanALAutobaudSample* sample) {
+	if ((autobaud->state == CANAL_AUTOBAUD_LOCKED) || (autobaud->state == CANAL_AUTOBAUD_FAILED)) {
+		return autobaud->state;
+	}
+
+	autobaud->frames += sample->rxFrames;
+	if (sample->rxError) autobaud->errors++;
+
+	if ((nowMs - autobaud->startMs) >= autobaud->timeoutMs) {
+		autobaud->state = CANAL_AUTOBAUD_FAILED;
+	} else if (autobaud->errors >= CANAL_AUTOBAUD_MAX_ERRORS) {
+		autobaud->state = nextCandidate(autobaud, nowMs);
+	} else if ((nowMs - autobaud->candidateStartMs) >= autobaud->dwellMs) {
+		// Frames only pass the CRC at the right bitrate, and a glitch may have
+		// hidden among them
+		if ((autobaud->frames >= CANAL_AUTOBAUD_LOCK_FRAMES) && (autobaud->frames > autobaud->errors)) {
+			autobaud->state = CANAL_AUTOBAUD_LOCKED;
+		} else {
+			autobaud->state = nextCandidate(autobaud, nowMs);
+		}
+	} else {
+		autobaud->state = CANAL_AUTOBAUD_LISTEN;
+	}
+
+	return autobaud->state;
+}
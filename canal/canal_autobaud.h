@@ -0,0 +1,126 @@
+/*
+ * canal_autobaud.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_AUTOBAUD_H_
+#define INC_CANAL_AUTOBAUD_H_
+
+// canal_autobaud decides which of a list of candidate bitrates a bus runs at.
+// The controller listens silently at one candidate at a time and the decision
+// is fed a sample of what it saw every millisecond. Receive errors reject a
+// candidate at once; otherwise it is judged when its dwell time is up, locking
+// if it received frames and moving on if it did not. The search gives up
+// after a total timeout.
+//
+// The decision logic has no HAL dependencies so that it can be built and
+// tested on the host against a simulated bus; CanAL_InitAutobaud in canal.h
+// drives it with the bxCAN counters.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+#define CANAL_AUTOBAUD_MAX_CANDIDATES	(8U)
+
+// CANAL_AUTOBAUD_LOCK_FRAMES frames within the dwell time lock a candidate
+#ifndef CANAL_AUTOBAUD_LOCK_FRAMES
+#define CANAL_AUTOBAUD_LOCK_FRAMES		(2U)
+#endif // CANAL_AUTOBAUD_LOCK_FRAMES
+
+// CANAL_AUTOBAUD_MAX_ERRORS samples with receive errors reject a candidate.
+// Samples are a millisecond apart, so this does not depend on how fast the
+// caller polls.
+#ifndef CANAL_AUTOBAUD_MAX_ERRORS
+#define CANAL_AUTOBAUD_MAX_ERRORS		(2U)
+#endif // CANAL_AUTOBAUD_MAX_ERRORS
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+typedef enum {
+	// CANAL_AUTOBAUD_LISTEN keeps listening at the current candidate
+	CANAL_AUTOBAUD_LISTEN = 0,
+	// CANAL_AUTOBAUD_SWITCH moves the controller to the current candidate
+	CANAL_AUTOBAUD_SWITCH,
+	CANAL_AUTOBAUD_LOCKED,
+	CANAL_AUTOBAUD_FAILED,
+}TeCanALAutobaudAction;
+
+// TsCanALAutobaudSample is what the controller saw since the previous sample
+typedef struct {
+	uint32_t rxFrames;
+	// rxError is set when a receive error was flagged (the receive error
+	// counter rose or the last error code was set)
+	bool rxError;
+}TsCanALAutobaudSample;
+
+typedef struct {
+	// candidates are bitrates in kbit/s, tried in order
+	uint16_t candidates[CANAL_AUTOBAUD_MAX_CANDIDATES];
+	uint8_t numCandidates;
+	uint8_t current;
+	uint32_t dwellMs;
+	uint32_t timeoutMs;
+	uint32_t startMs;
+	uint32_t candidateStartMs;
+	// Counters of the current candidate
+	uint32_t frames;
+	uint32_t errors;
+	// switches counts candidate changes, for reporting how long a lock took
+	uint32_t switches;
+	TeCanALAutobaudAction state;
+}TsCanALAutobaud;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Autobaud_Start begins a search over n candidates (kbit/s). Each is
+// listened to for at most dwellMs and the search fails after timeoutMs.
+TeCanALRet CanAL_Autobaud_Start(TsCanALAutobaud* autobaud, const uint16_t* candidates,
+		uint8_t n, uint32_t dwellMs, uint32_t timeoutMs, uint32_t nowMs);
+// CanAL_Autobaud_Current returns the candidate the controller should listen at
+uint16_t CanAL_Autobaud_Current(const TsCanALAutobaud* autobaud);
+// CanAL_Autobaud_Step feeds the sample of the millisecond up to nowMs and
+// returns what to do next. After
+// CANAL_AUTOBAUD_SWITCH the controller must be moved to
+// CanAL_Autobaud_Current before the next sample is taken; after
+// CANAL_AUTOBAUD_LOCKED it is the detected bitrate.
+TeCanALAutobaudAction CanAL_Autobaud_Step(TsCanALAutobaud* autobaud, uint32_t nowMs,
+		const TsCanALAutobaudSample* sample);
+
+#endif /* INC_CANAL_AUTOBAUD_H_ */
@@ -0,0 +1,69 @@
+/*
+ * canal_bittiming.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal_bittiming.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+#define TQ_ENTRY(tq, clk, rate, sp)		(tq),
+
+static const uint8_t TQ_ORDER[] = { CANAL_BT_TQ_ORDER(TQ_ENTRY, 0, 0, 0) };
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_SolveBitTiming(uint32_t clkHz, uint32_t bitrate, uint16_t samplePoint,
+		TsCanALBitTiming* timing) {
+	if (timing == NULL) return CANAL_NULL_REF;
+
+	if ((bitrate == 0U) || (samplePoint >= 1000U)) return CANAL_UNSUPPORTED_BAUD;
+
+	for (uint8_t i = 0; i < sizeof(TQ_ORDER); i++) {
+		uint32_t tq = TQ_ORDER[i];
+
+		if (!CANAL_BT_FITS(tq, clkHz, bitrate, (uint32_t)samplePoint)) continue;
+
+		timing->tq = (uint8_t)tq;
+		timing->prescaler = (uint16_t)CANAL_BT_PRESCALER_OF(clkHz, bitrate, tq);
+		timing->bs1 = (uint8_t)CANAL_BT_BS1(tq, (uint32_t)samplePoint);
+		timing->bs2 = (uint8_t)CANAL_BT_BS2(tq, (uint32_t)samplePoint);
+		timing->sjw = (uint8_t)CANAL_BT_SJW(tq, (uint32_t)samplePoint);
+
+		return CANAL_OK;
+	}
+
+	return CANAL_UNSUPPORTED_PCLK1_FREQ;
+}
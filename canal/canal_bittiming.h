@@ -0,0 +1,137 @@
+/*
+ * canal_bittiming.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_BITTIMING_H_
+#define INC_CANAL_BITTIMING_H_
+
+// canal_bittiming finds the bxCAN prescaler and segment lengths for any
+// peripheral clock, bitrate and sample point. The same rules are available as
+// constant expressions (CANAL_BT_*) so that a known clock is solved at compile
+// time, and as CanAL_SolveBitTiming for clocks that are only known at runtime.
+// It has no HAL dependencies so that it can be built and tested on the host.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "canal_types.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// bxCAN limits, in time quanta (tq). A bit is 1 sync tq + BS1 + BS2.
+#define CANAL_BT_MAX_PRESCALER			(1024U)
+#define CANAL_BT_MAX_BS1				(16U)
+#define CANAL_BT_MAX_BS2				(8U)
+#define CANAL_BT_MAX_SJW				(4U)
+
+// CANAL_BT_SP_TOLERANCE is how far (in permille) the sample point may end up
+// from the requested one
+#ifndef CANAL_BT_SP_TOLERANCE
+#define CANAL_BT_SP_TOLERANCE			(25U)
+#endif // CANAL_BT_SP_TOLERANCE
+
+// CANAL_BT_TQ_ORDER lists the bit lengths that are tried, best first. 16 tq is
+// what the can-wiki reference tables use; longer bits give a finer sample point
+// and shorter bits allow slower clocks at high bitrates.
+#define CANAL_BT_TQ_ORDER(X, clk, rate, sp) \
+	X(16, clk, rate, sp) X(17, clk, rate, sp) X(15, clk, rate, sp) X(18, clk, rate, sp) \
+	X(14, clk, rate, sp) X(19, clk, rate, sp) X(13, clk, rate, sp) X(20, clk, rate, sp) \
+	X(12, clk, rate, sp) X(21, clk, rate, sp) X(11, clk, rate, sp) X(22, clk, rate, sp) \
+	X(10, clk, rate, sp) X(23, clk, rate, sp) X(9, clk, rate, sp) X(24, clk, rate, sp) \
+	X(8, clk, rate, sp) X(25, clk, rate, sp)
+
+#define CANAL_BT_MIN(a, b)				(((a) < (b)) ? (a) : (b))
+#define CANAL_BT_MAX(a, b)				(((a) > (b)) ? (a) : (b))
+#define CANAL_BT_ABS_DIFF(a, b)			(((a) > (b)) ? ((a) - (b)) : ((b) - (a)))
+
+// CANAL_BT_BS1 places the sample point as close to sp (permille) as the
+// segment limits allow in a bit of tq time quanta
+#define CANAL_BT_BS1(tq, sp) \
+	(CANAL_BT_MIN(CANAL_BT_MAX((((tq) * (sp)) + 500U) / 1000U, \
+		CANAL_BT_MAX((tq) - CANAL_BT_MAX_BS2, 2U)), \
+		CANAL_BT_MIN(CANAL_BT_MAX_BS1 + 1U, (tq) - 1U)) - 1U)
+#define CANAL_BT_BS2(tq, sp)			((tq) - 1U - CANAL_BT_BS1(tq, sp))
+// CANAL_BT_SJW is as wide as BS2 allows, which tolerates the most clock drift
+#define CANAL_BT_SJW(tq, sp)			CANAL_BT_MIN(CANAL_BT_BS2(tq, sp), CANAL_BT_MAX_SJW)
+#define CANAL_BT_PRESCALER_OF(clk, rate, tq) ((clk) / ((rate) * (tq)))
+
+// CANAL_BT_FITS is true when a bit of tq time quanta gives exactly rate at clk
+// with a sample point within CANAL_BT_SP_TOLERANCE of sp
+#define CANAL_BT_FITS(tq, clk, rate, sp) \
+	((((clk) % ((rate) * (tq))) == 0U) && \
+	 (CANAL_BT_PRESCALER_OF(clk, rate, tq) >= 1U) && \
+	 (CANAL_BT_PRESCALER_OF(clk, rate, tq) <= CANAL_BT_MAX_PRESCALER) && \
+	 (CANAL_BT_ABS_DIFF((CANAL_BT_BS1(tq, sp) + 1U) * 1000U, (sp) * (tq)) <= (CANAL_BT_SP_TOLERANCE * (tq))))
+
+#define CANAL_BT_PICK(tq, clk, rate, sp) CANAL_BT_FITS(tq, clk, rate, sp) ? (tq) :
+
+// CANAL_BT_TQ is the first bit length in CANAL_BT_TQ_ORDER that fits, or 0 if
+// there is none. With constant arguments it is a constant expression.
+#define CANAL_BT_TQ(clk, rate, sp)		(CANAL_BT_TQ_ORDER(CANAL_BT_PICK, clk, rate, sp) 0U)
+
+// CANAL_BT_TIMING is an initializer for TsCanALBitTiming. Check .tq for 0
+// before using it.
+#define CANAL_BT_TIMING(clk, rate, sp) { \
+	.tq = CANAL_BT_TQ(clk, rate, sp), \
+	.prescaler = (CANAL_BT_TQ(clk, rate, sp) == 0U) ? 0U : \
+		CANAL_BT_PRESCALER_OF(clk, rate, CANAL_BT_TQ(clk, rate, sp)), \
+	.bs1 = CANAL_BT_BS1(CANAL_BT_TQ(clk, rate, sp), sp), \
+	.bs2 = CANAL_BT_BS2(CANAL_BT_TQ(clk, rate, sp), sp), \
+	.sjw = CANAL_BT_SJW(CANAL_BT_TQ(clk, rate, sp), sp), \
+}
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// TsCanALBitTiming holds segment lengths in time quanta, not register values
+typedef struct {
+	uint16_t prescaler;
+	uint8_t tq;
+	uint8_t bs1;
+	uint8_t bs2;
+	uint8_t sjw;
+}TsCanALBitTiming;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_SolveBitTiming finds the timing for bitrate (bit/s) at clkHz with the
+// sample point closest to samplePoint (permille). It gives the same result as
+// CANAL_BT_TIMING. Returns CANAL_UNSUPPORTED_PCLK1_FREQ when the bitrate cannot
+// be reached exactly.
+TeCanALRet CanAL_SolveBitTiming(uint32_t clkHz, uint32_t bitrate, uint16_t samplePoint,
+		TsCanALBitTiming* timing);
+
+#endif /* INC_CANAL_BITTIMING_H_ */
@@ -0,0 +1,115 @@
+/*
+ * canal_dispatch.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal.h"
+#include "canal_dispatch.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+// The index is kept at most half full so that probe chains stay short
+#define CODEC_INDEX_SIZE				((2U * CANAL_NUM_MESSAGES) + 1U)
+#define CODEC_INDEX_EMPTY				(CANAL_NO_CODEC)
+
+#define CANAL_CODEC_ENTRY(__id__, __ide__, __dlc__, __rx__, __unmarshal__, __marshal__) \
+	{ .id = (__id__), .unmarshal = (__unmarshal__), .marshal = (__marshal__), \
+	  .ide = (__ide__), .dlc = (__dlc__), .rx = ((__rx__) ? 1U : 0U) },
+
+const TsCanALCodec CANAL_CODEC_TABLE[CANAL_NUM_MESSAGES] = {
+	CANAL_MESSAGE_LIST(CANAL_CODEC_ENTRY)
+};
+
+static uint16_t codecIndex[CODEC_INDEX_SIZE];
+static bool codecIndexBuilt = false;
+
+static inline uint32_t codecSlot(uint32_t ID) {
+	return ((ID * 2654435761U) >> 8) % CODEC_INDEX_SIZE;
+}
+
+// findCodec walks the probe chain of ID. Entries with the same ID but another
+// IDE share the chain, so matchIde selects whether ide has to match too.
+static uint16_t findCodec(uint32_t ID, uint8_t ide, bool matchIde) {
+	uint32_t slot = codecSlot(ID);
+	uint16_t i;
+
+	if (!codecIndexBuilt) CanAL_InitDispatch();
+
+	while ((i = codecIndex[slot]) != CODEC_INDEX_EMPTY) {
+		if ((CANAL_CODEC_TABLE[i].id == ID) && (!matchIde || (CANAL_CODEC_TABLE[i].ide == ide))) {
+			return i;
+		}
+
+		slot = (slot + 1U) % CODEC_INDEX_SIZE;
+	}
+
+	return CANAL_NO_CODEC;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+void CanAL_InitDispatch(void) {
+	if (codecIndexBuilt) return;
+
+	for (uint32_t i = 0; i < CODEC_INDEX_SIZE; i++) codecIndex[i] = CODEC_INDEX_EMPTY;
+
+	for (uint16_t i = 0; i < CANAL_NUM_MESSAGES; i++) {
+		uint32_t slot = codecSlot(CANAL_CODEC_TABLE[i].id);
+
+		while (codecIndex[slot] != CODEC_INDEX_EMPTY) {
+			slot = (slot + 1U) % CODEC_INDEX_SIZE;
+		}
+
+		codecIndex[slot] = i;
+	}
+
+	codecIndexBuilt = true;
+}
+
+uint16_t CanAL_FindCodec(uint32_t ID) {
+	return findCodec(ID, CAN_ID_STD, false);
+}
+
+uint16_t CanAL_FindFrameCodec(uint32_t ID, uint8_t ide) {
+	return findCodec(ID, ide, true);
+}
+
+const TsCanALCodec* CanAL_GetCodec(uint32_t ID) {
+	uint16_t i = CanAL_FindCodec(ID);
+
+	if (i == CANAL_NO_CODEC) return NULL;
+
+	return &CANAL_CODEC_TABLE[i];
+}
@@ -0,0 +1,118 @@
+/*
+ * canal_dispatch.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_DISPATCH_H_
+#define INC_CANAL_DISPATCH_H_
+
+// canal_dispatch maps a raw CAN ID to the codec of its message in constant time
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "canal_types.h"
+
+// This is a file that must be auto-generated by the canalgen tool in the
+// can_dbc repo.
+#include "canal_messages.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// canal_messages.h describes every message with CANAL_MESSAGE_LIST(X), which
+// expands X(id, ide, dlc, rx, unmarshaller, marshaller) once per message. ide
+// is CAN_ID_STD or CAN_ID_EXT and rx is 1 for messages this board receives and
+// 0 for those it only transmits, whose unmarshaller is NULL. The marshaller is
+// NULL for messages it only receives.
+//
+// Files generated before canalgen emitted CANAL_MESSAGE_LIST only provide
+// UnmarshalBinary, MarshalBinary and GetTxDataLength. With those the codec
+// table is empty and CANAL_LEGACY_CODECS routes every frame through the three
+// functions instead, so everything keyed by table position (the message store,
+// handlers, update ticks and per-message stats) sees no messages.
+#ifdef CANAL_MESSAGE_LIST
+#define CANAL_LEGACY_CODECS				(0)
+#else
+#define CANAL_LEGACY_CODECS				(1)
+#define CANAL_MESSAGE_LIST(X)
+#endif // CANAL_MESSAGE_LIST
+
+#define CANAL_COUNT_MESSAGE(...)		+ 1
+#define CANAL_COUNT_RX_MESSAGE(__id__, __ide__, __dlc__, __rx__, __unmarshal__, __marshal__) \
+	+ ((__rx__) ? 1 : 0)
+
+// CANAL_NO_CODEC is returned by CanAL_FindCodec for IDs that are not in the table
+#define CANAL_NO_CODEC					(0xFFFFU)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// CANAL_NUM_MESSAGES is the number of messages in canal_messages.h
+enum { CANAL_NUM_MESSAGES = 0 CANAL_MESSAGE_LIST(CANAL_COUNT_MESSAGE) };
+// CANAL_NUM_RX_MESSAGES is the number of those messages this board receives
+enum { CANAL_NUM_RX_MESSAGES = 0 CANAL_MESSAGE_LIST(CANAL_COUNT_RX_MESSAGE) };
+
+// TsCanALCodec holds everything needed to send or receive one message
+typedef struct {
+	uint32_t id;
+	BinaryUnmarshaller* unmarshal;
+	BinaryMarshaller* marshal;
+	uint8_t ide;
+	uint8_t dlc;
+	// rx is set for messages this board receives, which get a store slot
+	uint8_t rx;
+}TsCanALCodec;
+
+// CANAL_CODEC_TABLE is generated from CANAL_MESSAGE_LIST and lives in flash
+extern const TsCanALCodec CANAL_CODEC_TABLE[CANAL_NUM_MESSAGES];
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_InitDispatch builds the ID index over CANAL_CODEC_TABLE. It is called by
+// CanAL_Init and only does work the first time.
+void CanAL_InitDispatch(void);
+// CanAL_FindCodec returns the position of ID in CANAL_CODEC_TABLE, or
+// CANAL_NO_CODEC. The index is a half-full open-addressed hash table, so a
+// lookup costs one or two probes regardless of how many messages there are.
+// It matches on ID alone, the way the application names messages.
+uint16_t CanAL_FindCodec(uint32_t ID);
+// CanAL_FindFrameCodec is CanAL_FindCodec for a frame on the bus, which also
+// has to match ide: a standard and an extended frame with the same ID are
+// different messages.
+uint16_t CanAL_FindFrameCodec(uint32_t ID, uint8_t ide);
+// CanAL_GetCodec returns the codec of ID, or NULL if ID is not in the table
+const TsCanALCodec* CanAL_GetCodec(uint32_t ID);
+
+#endif /* INC_CANAL_DISPATCH_H_ */
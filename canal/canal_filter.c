@@ -0,0 +1,404 @@
+/*
+ * canal_filter.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal_filter.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+// 16-bit scale: STID[10:0] RTR IDE EXID[17:15]
+#define FILTER16_STID_POS				(5U)
+#define FILTER16_RTR_IDE_BITS			(0x18U)
+// 32-bit scale: STID[10:0] EXID[17:0] IDE RTR 0
+#define FILTER32_ID_POS					(3U)
+#define FILTER32_STID_POS				(21U)
+#define FILTER32_IDE_BIT				(0x4U)
+#define FILTER32_RTR_IDE_BITS			(0x6U)
+
+// TsFilterRule accepts every ID that equals id on the bits that are set in mask
+typedef struct {
+	uint32_t id;
+	uint32_t mask;
+	bool extended;
+}TsFilterRule;
+
+// isExtended is extended[i] if the caller passed IDE flags, otherwise the old
+// guess that only IDs above 0x7FF are extended
+static bool isExtended(const uint32_t* ids, const bool* extended, uint16_t i) {
+	return (extended != NULL) ? extended[i] : (ids[i] > CANAL_FILTER_STD_ID_MASK);
+}
+
+static uint32_t fullMask(bool extended) {
+	return extended ? CANAL_FILTER_EXT_ID_MASK : CANAL_FILTER_STD_ID_MASK;
+}
+
+static bool isSingle(const TsFilterRule* rule) {
+	return rule->mask == fullMask(rule->extended);
+}
+
+static bool ruleBefore(const TsFilterRule* a, const TsFilterRule* b) {
+	if (a->extended != b->extended) return !a->extended;
+
+	return a->id < b->id;
+}
+
+static void sortRules(TsFilterRule* rules, uint16_t n) {
+	for (uint16_t i = 1; i < n; i++) {
+		TsFilterRule rule = rules[i];
+		uint16_t j = i;
+
+		while ((j > 0) && ruleBefore(&rule, &rules[j - 1U])) {
+			rules[j] = rules[j - 1U];
+			j--;
+		}
+		rules[j] = rule;
+	}
+}
+
+static uint16_t removeRule(TsFilterRule* rules, uint16_t n, uint16_t i) {
+	for (uint16_t j = i; j + 1U < n; j++) rules[j] = rules[j + 1U];
+
+	return n - 1U;
+}
+
+// ruleCovers is true when every ID accepted by inner is also accepted by outer
+static bool ruleCovers(const TsFilterRule* outer, const TsFilterRule* inner) {
+	return (outer->extended == inner->extended) &&
+		((outer->mask & inner->mask) == outer->mask) &&
+		(((outer->id ^ inner->id) & outer->mask) == 0);
+}
+
+// mergeExact combines rules with equal masks whose IDs differ in one masked bit.
+// The merged rule accepts exactly the union of both, so nothing extra gets in.
+static uint16_t mergeExact(TsFilterRule* rules, uint16_t n) {
+	bool merged = true;
+
+	while (merged) {
+		merged = false;
+
+		for (uint16_t i = 0; (i < n) && !merged; i++) {
+			for (uint16_t j = i + 1U; (j < n) && !merged; j++) {
+				uint32_t diff = (rules[i].id ^ rules[j].id) & rules[i].mask;
+
+				if ((rules[i].extended != rules[j].extended) ||
+					(rules[i].mask != rules[j].mask)) continue;
+
+				// diff == 0 is a duplicate, more than one bit would accept extra IDs
+				if ((diff & (diff - 1U)) != 0) continue;
+
+				rules[i].mask &= ~diff;
+				rules[i].id &= rules[i].mask;
+				n = removeRule(rules, n, j);
+				merged = true;
+			}
+		}
+	}
+
+	return n;
+}
+
+// mergeClosest replaces the two rules that share the most masked bits with a
+// single wider rule, then drops any rule the new one already covers. Returns n
+// unchanged if no two rules of the same ID type are left.
+static uint16_t mergeClosest(TsFilterRule* rules, uint16_t n) {
+	TsFilterRule best = {0};
+	uint16_t bestI = 0;
+	uint16_t bestJ = 0;
+	int bestBits = -1;
+
+	for (uint16_t i = 0; i < n; i++) {
+		for (uint16_t j = i + 1U; j < n; j++) {
+			uint32_t mask;
+			int bits;
+
+			if (rules[i].extended != rules[j].extended) continue;
+
+			mask = rules[i].mask & rules[j].mask & ~(rules[i].id ^ rules[j].id);
+			bits = __builtin_popcount(mask);
+
+			if (bits > bestBits) {
+				bestBits = bits;
+				bestI = i;
+				bestJ = j;
+				best.id = rules[i].id & mask;
+				best.mask = mask;
+				best.extended = rules[i].extended;
+			}
+		}
+	}
+
+	if (bestBits < 0) return n;
+
+	rules[bestI] = best;
+	n = removeRule(rules, n, bestJ);
+
+	for (uint16_t i = 0; i < n; ) {
+		if ((i != bestI) && ruleCovers(&best, &rules[i])) {
+			n = removeRule(rules, n, i);
+			if (i < bestI) bestI--;
+		} else {
+			i++;
+		}
+	}
+
+	return n;
+}
+
+// stdBanks is the number of banks needed for standard ID rules: lone IDs go four
+// to a 16-bit list bank and masks two to a 16-bit mask bank. An odd mask bank
+// has a free half that can take a lone ID (with a full mask).
+static uint16_t stdBanks(uint16_t singles, uint16_t masks) {
+	if (((masks % 2U) == 1U) && ((singles % 4U) == 1U)) {
+		singles--;
+		masks++;
+	}
+
+	return ((masks + 1U) / 2U) + ((singles + 3U) / 4U);
+}
+
+// countBanks is the number of banks needed for a set of rules. Extended lone
+// IDs go two to a 32-bit list bank and extended masks take a full 32-bit bank.
+static uint16_t countBanks(const TsFilterRule* rules, uint16_t n, uint16_t* stdSingles, uint16_t* stdMasks) {
+	uint16_t extSingles = 0;
+	uint16_t extMasks = 0;
+
+	*stdSingles = 0;
+	*stdMasks = 0;
+
+	for (uint16_t i = 0; i < n; i++) {
+		if (rules[i].extended) {
+			if (isSingle(&rules[i])) extSingles++;
+			else extMasks++;
+		} else {
+			if (isSingle(&rules[i])) (*stdSingles)++;
+			else (*stdMasks)++;
+		}
+	}
+
+	return stdBanks(*stdSingles, *stdMasks) + ((extSingles + 1U) / 2U) + extMasks;
+}
+
+static void emit(TsCanALFilterBank* banks, uint8_t* count, TeCanALFilterMode mode,
+		TeCanALFilterScale scale, uint32_t fr1, uint32_t fr2) {
+	banks[*count].mode = mode;
+	banks[*count].scale = scale;
+	banks[*count].fr1 = fr1;
+	banks[*count].fr2 = fr2;
+	(*count)++;
+}
+
+static uint32_t std16Id(const TsFilterRule* rule) {
+	return (rule->id & CANAL_FILTER_STD_ID_MASK) << FILTER16_STID_POS;
+}
+
+static uint32_t std16Mask(const TsFilterRule* rule) {
+	return (rule->mask << FILTER16_STID_POS) | FILTER16_RTR_IDE_BITS;
+}
+
+static uint32_t std32Id(const TsFilterRule* rule) {
+	return (rule->id & CANAL_FILTER_STD_ID_MASK) << FILTER32_STID_POS;
+}
+
+static uint32_t ext32Id(const TsFilterRule* rule) {
+	return (rule->id << FILTER32_ID_POS) | FILTER32_IDE_BIT;
+}
+
+static uint32_t ext32Mask(const TsFilterRule* rule) {
+	return (rule->mask << FILTER32_ID_POS) | FILTER32_RTR_IDE_BITS;
+}
+
+// emitBanks writes the register images for the rules. Unused halves of a bank
+// repeat the previous rule so they never widen what the bank accepts.
+static void emitBanks(const TsFilterRule* rules, uint16_t n, uint16_t stdSingles,
+		uint16_t stdMasks, TsCanALFilterBank* banks, uint8_t* count) {
+	const TsFilterRule* list[4];
+	const TsFilterRule* pair[2];
+	uint8_t listLen = 0;
+	uint8_t pairLen = 0;
+	// Move a lone standard ID into the spare half of the last mask bank
+	bool singleToMask = ((stdMasks % 2U) == 1U) && ((stdSingles % 4U) == 1U);
+
+	// Standard lone IDs: 16-bit list banks of four
+	for (uint16_t i = 0; i < n; i++) {
+		if (rules[i].extended || !isSingle(&rules[i])) continue;
+
+		if (singleToMask) {
+			singleToMask = false;
+			pair[pairLen++] = &rules[i];
+			continue;
+		}
+
+		list[listLen++] = &rules[i];
+		if (listLen == 4U) {
+			emit(banks, count, CANAL_FILTER_MODE_LIST, CANAL_FILTER_SCALE_16,
+				(std16Id(list[1]) << 16) | std16Id(list[0]),
+				(std16Id(list[3]) << 16) | std16Id(list[2]));
+			listLen = 0;
+		}
+	}
+	if (listLen > 0) {
+		while (listLen < 4U) { list[listLen] = list[listLen - 1U]; listLen++; }
+		emit(banks, count, CANAL_FILTER_MODE_LIST, CANAL_FILTER_SCALE_16,
+			(std16Id(list[1]) << 16) | std16Id(list[0]),
+			(std16Id(list[3]) << 16) | std16Id(list[2]));
+	}
+
+	// Standard masks: 16-bit mask banks of two
+	for (uint16_t i = 0; i < n; i++) {
+		if (rules[i].extended || isSingle(&rules[i])) continue;
+
+		pair[pairLen++] = &rules[i];
+		if (pairLen == 2U) {
+			emit(banks, count, CANAL_FILTER_MODE_MASK, CANAL_FILTER_SCALE_16,
+				(std16Mask(pair[0]) << 16) | std16Id(pair[0]),
+				(std16Mask(pair[1]) << 16) | std16Id(pair[1]));
+			pairLen = 0;
+		}
+	}
+	if (pairLen > 0) {
+		emit(banks, count, CANAL_FILTER_MODE_MASK, CANAL_FILTER_SCALE_16,
+			(std16Mask(pair[0]) << 16) | std16Id(pair[0]),
+			(std16Mask(pair[0]) << 16) | std16Id(pair[0]));
+		pairLen = 0;
+	}
+
+	// Extended lone IDs: 32-bit list banks of two
+	for (uint16_t i = 0; i < n; i++) {
+		if (!rules[i].extended || !isSingle(&rules[i])) continue;
+
+		pair[pairLen++] = &rules[i];
+		if (pairLen == 2U) {
+			emit(banks, count, CANAL_FILTER_MODE_LIST, CANAL_FILTER_SCALE_32,
+				ext32Id(pair[0]), ext32Id(pair[1]));
+			pairLen = 0;
+		}
+	}
+	if (pairLen > 0) {
+		emit(banks, count, CANAL_FILTER_MODE_LIST, CANAL_FILTER_SCALE_32,
+			ext32Id(pair[0]), ext32Id(pair[0]));
+	}
+
+	// Extended masks: one 32-bit mask bank each
+	for (uint16_t i = 0; i < n; i++) {
+		if (!rules[i].extended || isSingle(&rules[i])) continue;
+
+		emit(banks, count, CANAL_FILTER_MODE_MASK, CANAL_FILTER_SCALE_32,
+			ext32Id(&rules[i]), ext32Mask(&rules[i]));
+	}
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_CompileFilters(const uint32_t* ids, const bool* extended, uint16_t numIds,
+		TsCanALFilterBank* banks, uint8_t maxBanks, uint8_t* numBanks) {
+	TsFilterRule rules[CANAL_FILTER_MAX_IDS];
+	uint16_t n = numIds;
+	uint16_t stdSingles;
+	uint16_t stdMasks;
+	uint16_t needed;
+
+	if ((banks == NULL) || (numBanks == NULL)) return CANAL_NULL_REF;
+
+	if ((numIds > 0) && (ids == NULL)) return CANAL_NULL_REF;
+
+	if (numIds > CANAL_FILTER_MAX_IDS) return CANAL_FILTER_TABLE_FULL;
+
+	*numBanks = 0;
+
+	if (numIds == 0) return CANAL_OK;
+
+	if (maxBanks == 0) return CANAL_FILTER_TABLE_FULL;
+
+	for (uint16_t i = 0; i < numIds; i++) {
+		rules[i].extended = isExtended(ids, extended, i);
+		rules[i].mask = fullMask(rules[i].extended);
+		rules[i].id = ids[i] & rules[i].mask;
+	}
+
+	sortRules(rules, n);
+	n = mergeExact(rules, n);
+	needed = countBanks(rules, n, &stdSingles, &stdMasks);
+
+	while (needed > maxBanks) {
+		uint16_t before = n;
+
+		n = mergeClosest(rules, n);
+		if (n == before) break;
+
+		needed = countBanks(rules, n, &stdSingles, &stdMasks);
+	}
+
+	// Only one standard and one extended rule are left for a single bank, so
+	// fall back to accepting everything and filtering in software
+	if (needed > maxBanks) {
+		emit(banks, numBanks, CANAL_FILTER_MODE_MASK, CANAL_FILTER_SCALE_32, 0, 0);
+		return CANAL_OK;
+	}
+
+	sortRules(rules, n);
+	emitBanks(rules, n, stdSingles, stdMasks, banks, numBanks);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_CompileListFilters(const uint32_t* ids, const bool* extended, uint16_t numIds,
+		TsCanALFilterBank* banks, uint8_t maxBanks, uint8_t* numBanks) {
+	uint32_t fr[2];
+
+	if ((banks == NULL) || (numBanks == NULL)) return CANAL_NULL_REF;
+
+	if ((numIds > 0) && (ids == NULL)) return CANAL_NULL_REF;
+
+	*numBanks = 0;
+
+	if (((numIds + 1U) / 2U) > maxBanks) return CANAL_FILTER_TABLE_FULL;
+
+	for (uint16_t i = 0; i < numIds; i += 2U) {
+		// An odd ID out repeats itself in the second register
+		for (uint16_t j = 0; j < 2U; j++) {
+			uint16_t k = ((i + j) < numIds) ? (i + j) : i;
+			TsFilterRule rule = {.extended = isExtended(ids, extended, k)};
+
+			rule.mask = fullMask(rule.extended);
+			rule.id = ids[k] & rule.mask;
+			fr[j] = rule.extended ? ext32Id(&rule) : std32Id(&rule);
+		}
+
+		emit(banks, numBanks, CANAL_FILTER_MODE_LIST, CANAL_FILTER_SCALE_32, fr[0], fr[1]);
+	}
+
+	return CANAL_OK;
+}
@@ -0,0 +1,102 @@
+/*
+ * canal_filter.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_FILTER_H_
+#define INC_CANAL_FILTER_H_
+
+// canal_filter compiles a set of CAN IDs into bxCAN acceptance filter banks. It
+// has no HAL dependencies so that it can be built and tested on the host.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_FILTER_MAX_IDS is the largest number of IDs a single compile accepts
+#define CANAL_FILTER_MAX_IDS			(64U)
+
+#define CANAL_FILTER_STD_ID_MASK		(0x7FFU)
+#define CANAL_FILTER_EXT_ID_MASK		(0x1FFFFFFFU)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// TeCanALFilterMode mirrors CAN_FILTERMODE_IDLIST / CAN_FILTERMODE_IDMASK
+typedef enum {
+	CANAL_FILTER_MODE_LIST = 0,
+	CANAL_FILTER_MODE_MASK,
+}TeCanALFilterMode;
+
+// TeCanALFilterScale mirrors CAN_FILTERSCALE_16BIT / CAN_FILTERSCALE_32BIT
+typedef enum {
+	CANAL_FILTER_SCALE_16 = 0,
+	CANAL_FILTER_SCALE_32,
+}TeCanALFilterScale;
+
+// TsCanALFilterBank is the register image of a single filter bank. In 16-bit
+// scale each register holds two halves: the first rule in the low half and the
+// second in the high half (list: id/id, mask: id/mask).
+typedef struct {
+	TeCanALFilterMode mode;
+	TeCanALFilterScale scale;
+	uint32_t fr1;
+	uint32_t fr2;
+}TsCanALFilterBank;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_CompileFilters packs the IDs into as few banks as possible. extended[i]
+// says whether ids[i] is an extended ID; if extended is NULL, IDs above 0x7FF
+// are treated as extended and the rest as standard. Runs of IDs that differ in a few bits share a
+// mask rule; lone standard IDs go four to a 16-bit list bank and lone extended
+// IDs two to a 32-bit list bank. If the result still needs more than maxBanks,
+// the closest rules are merged into wider masks that let a few extra IDs
+// through, which are then rejected in software by UnmarshalBinary.
+TeCanALRet CanAL_CompileFilters(const uint32_t* ids, const bool* extended, uint16_t numIds,
+		TsCanALFilterBank* banks, uint8_t maxBanks, uint8_t* numBanks);
+// CanAL_CompileListFilters packs the IDs two to a 32-bit list bank without any
+// merging, reading extended as CanAL_CompileFilters does. When a frame matches
+// several banks bxCAN picks 32-bit list banks over every other kind, so these
+// IDs can never be captured by a wider mask compiled by CanAL_CompileFilters. Returns CANAL_FILTER_TABLE_FULL if the IDs
+// need more than maxBanks.
+TeCanALRet CanAL_CompileListFilters(const uint32_t* ids, const bool* extended, uint16_t numIds,
+		TsCanALFilterBank* banks, uint8_t maxBanks, uint8_t* numBanks);
+
+#endif /* INC_CANAL_FILTER_H_ */
@@ -0,0 +1,262 @@
+/*
+ * canal_gateway.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal_gateway.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+// routeKey orders routes by ID and then IDE, a standard and an extended frame
+// with the same ID are different messages
+static uint32_t routeKey(uint32_t ID, uint8_t ide) {
+	return (ID << 1) | ((ide == CAN_ID_EXT) ? 1U : 0U);
+}
+
+// lowerBound returns the index of the first route with a key of at least key
+static uint8_t lowerBound(const TsCanALGateway* gw, uint32_t key) {
+	uint8_t lo = 0;
+	uint8_t hi = gw->numRoutes;
+
+	while (lo < hi) {
+		uint8_t mid = lo + ((hi - lo) / 2U);
+
+		if (routeKey(gw->routes[mid].id, gw->routes[mid].ide) < key) {
+			lo = mid + 1U;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static bool routeMatches(const TsCanALRoute* route, uint32_t ID, uint8_t ide) {
+	return (route->id == ID) && (route->ide == ide);
+}
+
+static void forwardRoute(TsCanALRoute* route, const TsCanALRawFrame* frame, uint32_t now) {
+	TsCanALRawFrame out;
+
+	if ((route->minIntervalMs != 0U) && route->hasForwarded &&
+		((now - route->lastForwardTick) < route->minIntervalMs)) {
+		route->stats.limited++;
+		return;
+	}
+
+	out = *frame;
+	if (route->remapId != CANAL_GATEWAY_NO_REMAP) {
+		out.id = route->remapId;
+		if (out.id > CANAL_FILTER_STD_ID_MASK) out.ide = CAN_ID_EXT;
+	}
+
+	if (CanAL_TransmitRaw(route->dest, &out) != CANAL_OK) {
+		route->stats.dropped++;
+		return;
+	}
+
+	route->stats.forwarded++;
+	route->lastForwardTick = now;
+	route->hasForwarded = true;
+}
+
+// forwardFrame is the rx hook of the source instance
+static bool forwardFrame(void* ctx, const TsCanALRawFrame* frame) {
+	TsCanALGateway* gw = ctx;
+	uint8_t i = lowerBound(gw, routeKey(frame->id, frame->ide));
+	uint32_t now;
+
+	if ((i >= gw->numRoutes) || !routeMatches(&gw->routes[i], frame->id, frame->ide)) return false;
+
+	now = HAL_GetTick();
+
+	for (; (i < gw->numRoutes) && routeMatches(&gw->routes[i], frame->id, frame->ide); i++) {
+		forwardRoute(&gw->routes[i], frame, now);
+	}
+
+	return true;
+}
+
+static bool isSubscribed(const TsCanAL* can, uint32_t ID, uint8_t ide) {
+	for (uint16_t i = 0; i < can->numRxIds; i++) {
+		if ((can->rxIds[i] == ID) && (can->rxIdIde[i] == ide)) return true;
+	}
+
+	return false;
+}
+
+// subscribeRoute subscribes src to the route's ID unless src already accepts it
+static TeCanALRet subscribeRoute(TsCanAL* src, TsCanALRoute* route) {
+	TeCanALRet ret;
+
+	// With no IDs subscribed src already accepts every frame
+	if ((src->numRxIds == 0) || isSubscribed(src, route->id, route->ide)) return CANAL_OK;
+
+	if ((ret = CanAL_Subscribe(src, route->id, route->ide, DEFAULT_RX_FIFO)) != CANAL_OK) {
+		return ret;
+	}
+
+	route->subscribed = true;
+
+	return CANAL_OK;
+}
+
+// unsubscribeRoutes undoes every subscription made by subscribeRoute
+static TeCanALRet unsubscribeRoutes(TsCanALGateway* gw, TsCanAL* src) {
+	TeCanALRet ret = CANAL_OK;
+	TeCanALRet routeRet;
+
+	for (uint8_t i = 0; i < gw->numRoutes; i++) {
+		TsCanALRoute* route = &gw->routes[i];
+
+		if (!route->subscribed) continue;
+
+		route->subscribed = false;
+		if ((routeRet = CanAL_Unsubscribe(src, route->id, route->ide)) != CANAL_OK) ret = routeRet;
+	}
+
+	return ret;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Gateway_Init(TsCanALGateway* gw) {
+	if (gw == NULL) return CANAL_NULL_REF;
+
+	gw->numRoutes = 0;
+	gw->src = NULL;
+	gw->rxHook = (TsCanALRxHookNode){0};
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Gateway_AddRoute(TsCanALGateway* gw, uint32_t ID, uint8_t ide, TsCanAL* dest,
+		uint32_t remapID, uint32_t minIntervalMs) {
+	TeCanALRet ret = CANAL_OK;
+	uint32_t primask;
+	uint8_t i;
+
+	if ((gw == NULL) || (dest == NULL)) return CANAL_NULL_REF;
+
+	if ((ide != CAN_ID_STD) && (ide != CAN_ID_EXT)) return CANAL_UNKOWN_IDE;
+
+	if ((ide == CAN_ID_STD) ? !IS_CAN_STDID(ID) : !IS_CAN_EXTID(ID)) {
+		return CANAL_UNSUPPORTED_RX_MESSAGE;
+	}
+
+	if ((remapID != CANAL_GATEWAY_NO_REMAP) && !IS_CAN_EXTID(remapID)) {
+		return CANAL_UNSUPPORTED_TX_MESSAGE;
+	}
+
+	if (gw->numRoutes >= CANAL_GATEWAY_MAX_ROUTES) return CANAL_FILTER_TABLE_FULL;
+
+	// The rx interrupt may be searching the table while it is shifted
+	primask = CanAL_EnterCritical();
+
+	i = lowerBound(gw, routeKey(ID, ide) + 1U);
+	for (uint8_t j = gw->numRoutes; j > i; j--) gw->routes[j] = gw->routes[j - 1U];
+
+	gw->routes[i] = (TsCanALRoute){
+		.id = ID,
+		.ide = ide,
+		.remapId = remapID,
+		.dest = dest,
+		.minIntervalMs = minIntervalMs,
+	};
+	gw->numRoutes++;
+
+	CanAL_ExitCritical(primask);
+
+	if (gw->src != NULL) ret = subscribeRoute(gw->src, &gw->routes[i]);
+
+	return ret;
+}
+
+TeCanALRet CanAL_Gateway_Attach(TsCanALGateway* gw, TsCanAL* src) {
+	TeCanALRet ret;
+
+	if ((gw == NULL) || (src == NULL)) return CANAL_NULL_REF;
+
+	if ((ret = CanAL_AddRxHook(src, &gw->rxHook, forwardFrame, gw)) != CANAL_OK) return ret;
+
+	for (uint8_t i = 0; i < gw->numRoutes; i++) {
+		if ((ret = subscribeRoute(src, &gw->routes[i])) != CANAL_OK) {
+			unsubscribeRoutes(gw, src);
+			CanAL_RemoveRxHook(src, &gw->rxHook);
+			return ret;
+		}
+	}
+
+	gw->src = src;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Gateway_Detach(TsCanALGateway* gw) {
+	TeCanALRet ret;
+
+	if (gw == NULL) return CANAL_NULL_REF;
+
+	if (gw->src == NULL) return CANAL_OK;
+
+	if ((ret = CanAL_RemoveRxHook(gw->src, &gw->rxHook)) != CANAL_OK) return ret;
+
+	ret = unsubscribeRoutes(gw, gw->src);
+	gw->src = NULL;
+
+	return ret;
+}
+
+TeCanALRet CanAL_Gateway_GetRouteStats(TsCanALGateway* gw, uint32_t ID, uint8_t ide,
+		TsCanAL* dest, TsCanALRouteStats* stats) {
+	uint32_t primask;
+
+	if (gw == NULL) return CANAL_NULL_REF;
+
+	if (stats == NULL) return CANAL_ERROR;
+
+	for (uint8_t i = lowerBound(gw, routeKey(ID, ide));
+		(i < gw->numRoutes) && routeMatches(&gw->routes[i], ID, ide); i++) {
+		if (gw->routes[i].dest != dest) continue;
+
+		primask = CanAL_EnterCritical();
+		*stats = gw->routes[i].stats;
+		CanAL_ExitCritical(primask);
+
+		return CANAL_OK;
+	}
+
+	return CANAL_UNSUPPORTED_RX_MESSAGE;
+}
@@ -0,0 +1,120 @@
+/*
+ * canal_gateway.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_GATEWAY_H_
+#define INC_CANAL_GATEWAY_H_
+
+// canal_gateway forwards raw frames from one bus to another without going
+// through the unmarshallers and the global message structs. Routes are kept
+// sorted by source ID and IDE so the rx interrupt finds them with a binary search.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_GATEWAY_MAX_ROUTES is the number of routes a single gateway can hold
+#define CANAL_GATEWAY_MAX_ROUTES		(32U)
+// CANAL_GATEWAY_NO_REMAP forwards a frame with its original ID
+#define CANAL_GATEWAY_NO_REMAP			(0xFFFFFFFFU)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// TsCanALRouteStats counts what happened to the frames matching a route.
+// limited counts frames skipped by the rate limit and dropped counts frames
+// the destination tx queue had no room for.
+typedef struct {
+	uint32_t forwarded;
+	uint32_t limited;
+	uint32_t dropped;
+}TsCanALRouteStats;
+
+typedef struct {
+	uint32_t id;
+	// ide is CAN_ID_STD or CAN_ID_EXT, only frames of that kind match the route
+	uint8_t ide;
+	// remapId replaces the ID on the destination bus. The frame keeps its IDE
+	// unless remapId is above 0x7FF, which is always sent as extended.
+	uint32_t remapId;
+	TsCanAL* dest;
+	// minIntervalMs is the shortest time between two forwarded frames, 0
+	// forwards every frame
+	uint32_t minIntervalMs;
+	uint32_t lastForwardTick;
+	bool hasForwarded;
+	// subscribed is set when the gateway subscribed the source to id itself,
+	// CanAL_Gateway_Detach unsubscribes it again
+	bool subscribed;
+	TsCanALRouteStats stats;
+}TsCanALRoute;
+
+// TsCanALGateway must be initialized with CanAL_Gateway_Init. One gateway is
+// attached to each source instance, several gateways may share a destination.
+typedef struct {
+	TsCanALRoute routes[CANAL_GATEWAY_MAX_ROUTES];
+	uint8_t numRoutes;
+	TsCanAL* src;
+	// rxHook links the gateway into the rx hooks of src while attached
+	TsCanALRxHookNode rxHook;
+}TsCanALGateway;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+TeCanALRet CanAL_Gateway_Init(TsCanALGateway* gw);
+// CanAL_Gateway_AddRoute forwards every frame with ID and ide (CAN_ID_STD or
+// CAN_ID_EXT) received by the attached instance to dest. An ID may be routed to
+// more than one destination.
+TeCanALRet CanAL_Gateway_AddRoute(TsCanALGateway* gw, uint32_t ID, uint8_t ide, TsCanAL* dest,
+		uint32_t remapID, uint32_t minIntervalMs);
+// CanAL_Gateway_Attach starts forwarding the frames received by src. It must be
+// called from the main loop after CanAL_Init(src); route IDs that src does not
+// already accept are subscribed on DEFAULT_RX_FIFO. The gateway adds its own rx
+// hook, so it can share src with ISO-TP, SLCAN or application hooks.
+TeCanALRet CanAL_Gateway_Attach(TsCanALGateway* gw, TsCanAL* src);
+// CanAL_Gateway_Detach stops forwarding, removes the gateway's rx hook from src
+// (leaving every other hook in place) and unsubscribes the IDs the gateway
+// subscribed
+TeCanALRet CanAL_Gateway_Detach(TsCanALGateway* gw);
+// CanAL_Gateway_GetRouteStats copies the counters of the route from ID and ide
+// to dest
+TeCanALRet CanAL_Gateway_GetRouteStats(TsCanALGateway* gw, uint32_t ID, uint8_t ide,
+		TsCanAL* dest, TsCanALRouteStats* stats);
+
+#endif /* INC_CANAL_GATEWAY_H_ */
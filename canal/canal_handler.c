@@ -0,0 +1,212 @@
+/*
+ * canal_handler.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+// handlers holds the first handler of every message in CANAL_CODEC_TABLE
+static TsCanALHandler* volatile handlers[CANAL_NUM_MESSAGES];
+
+// signalBytes returns how many payload bytes sig reaches into
+static uint8_t signalBytes(const TsCanALSignal* sig) {
+	uint32_t msb;
+
+	if (sig->endianness == CANAL_LITTLE_ENDIAN) {
+		return (uint8_t)((((uint32_t)sig->startBit + sig->length - 1U) / 8U) + 1U);
+	}
+
+	// Motorola bit positions counted from the LSB of the byte-swapped word,
+	// where byte 7 is the least significant
+	msb = ((7U - (sig->startBit / 8U)) * 8U) + (sig->startBit % 8U);
+
+	return (uint8_t)(8U - ((msb + 1U - sig->length) / 8U));
+}
+
+// hasChanged decides whether a signal handler fires for the new value and
+// remembers the value it fires with
+static bool hasChanged(TsCanALHandler* handler, const TsCanALPayload* payload, float* value) {
+	int64_t raw = CanAL_Signal_GetRaw(handler->signal, payload);
+	float diff;
+
+	*value = ((float)raw * handler->signal->scale) + handler->signal->offset;
+
+	if (handler->fired) {
+		if (handler->deadband == 0.0f) {
+			if (raw == handler->lastRaw) return false;
+		} else {
+			diff = *value - handler->lastValue;
+			if (diff < 0.0f) diff = -diff;
+			if (diff <= handler->deadband) return false;
+		}
+	}
+
+	handler->lastRaw = raw;
+	handler->lastValue = *value;
+	handler->fired = true;
+
+	return true;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Handler_Init(TsCanALHandler* handler, uint32_t ID, CanALSignalHandler* fn,
+		void* ctx, uint8_t priority) {
+	if (handler == NULL) return CANAL_NULL_REF;
+
+	if (fn == NULL) return CANAL_ERROR;
+
+	*handler = (TsCanALHandler){
+		.id = ID,
+		.handler = fn,
+		.ctx = ctx,
+		.priority = priority,
+	};
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Handler_WatchSignal(TsCanALHandler* handler, const TsCanALSignal* signal,
+		float deadband) {
+	TeCanALRet ret;
+
+	if (handler == NULL) return CANAL_NULL_REF;
+
+	if (handler->registered || !(deadband >= 0.0f)) return CANAL_ERROR;
+
+	if ((ret = CanAL_Signal_Validate(signal)) != CANAL_OK) return ret;
+
+	handler->signal = signal;
+	handler->deadband = deadband;
+	handler->signalBytes = signalBytes(signal);
+	handler->fired = false;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Handler_Register(TsCanALHandler* handler) {
+	TsCanALHandler* volatile* link;
+	uint16_t index;
+	uint32_t primask;
+
+	if (handler == NULL) return CANAL_NULL_REF;
+
+	if (handler->registered) return CANAL_ERROR;
+
+	index = CanAL_FindCodec(handler->id);
+	if ((index == CANAL_NO_CODEC) || (CANAL_CODEC_TABLE[index].unmarshal == NULL)) {
+		return CANAL_UNSUPPORTED_RX_MESSAGE;
+	}
+
+	// The rx path may walk the list at any time, so link it in one store
+	primask = CanAL_EnterCritical();
+
+	link = &handlers[index];
+	while ((*link != NULL) && ((*link)->priority <= handler->priority)) link = &(*link)->next;
+
+	handler->next = *link;
+	handler->registered = true;
+	*link = handler;
+
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Handler_Unregister(TsCanALHandler* handler) {
+	TsCanALHandler* volatile* link;
+	uint16_t index;
+	uint32_t primask;
+
+	if (handler == NULL) return CANAL_NULL_REF;
+
+	if (!handler->registered) return CANAL_OK;
+
+	index = CanAL_FindCodec(handler->id);
+
+	primask = CanAL_EnterCritical();
+
+	link = &handlers[index];
+	while ((*link != NULL) && (*link != handler)) link = &(*link)->next;
+
+	// handler->next stays as it is, a dispatch in progress moves on through it
+	if (*link != NULL) *link = handler->next;
+
+	handler->registered = false;
+
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+void CanAL_Handler_Dispatch(uint16_t index, const uint8_t* data, uint8_t dlc) {
+	TsCanALHandler* handler = handlers[index];
+	TsCanALPayload payload;
+	bool loaded = false;
+	float value;
+
+	while (handler != NULL) {
+		value = 0.0f;
+
+		if (handler->signal != NULL) {
+			// The rest of data is left over from an earlier frame
+			if (dlc < handler->signalBytes) {
+				handler = handler->next;
+				continue;
+			}
+
+			// Every signal handler of the message shares one payload load
+			if (!loaded) {
+				CanAL_Signal_Load(data, &payload);
+				loaded = true;
+			}
+
+			if (!hasChanged(handler, &payload, &value)) {
+				handler = handler->next;
+				continue;
+			}
+		}
+
+		handler->handler(handler->ctx, handler->id, value);
+
+		// The callback may have changed the list. Unregistering keeps next, so
+		// a handler that removed itself still leads on; skip any that were
+		// removed after it.
+		handler = handler->next;
+		while ((handler != NULL) && !handler->registered) handler = handler->next;
+	}
+}
@@ -0,0 +1,118 @@
+/*
+ * canal_handler.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_HANDLER_H_
+#define INC_CANAL_HANDLER_H_
+
+// canal_handler keeps a registry of handlers per received message, so the
+// application is told what changed instead of scanning every message struct.
+// A handler either fires on every frame of its message or watches one signal
+// and only fires when it changes by more than a deadband. The handlers of a
+// message run in priority order right after it has been unmarshalled, in the
+// context that decoded it (the rx interrupt or CanAL_ProcessRx).
+//
+// The deadband state of a handler is not guarded, so each message must only be
+// decoded from one context: do not CanAL_InjectRx a message that is also
+// received by the rx interrupt in CANAL_RX_MODE_IMMEDIATE. A handler may
+// register or unregister handlers, itself included, from its callback.
+//
+// Handlers are owned by the caller and linked into the registry, so there is
+// no limit on their number and nothing is allocated.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+#include "canal_signal.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+#define CANAL_HANDLER_PRIORITY_HIGHEST	(0U)
+#define CANAL_HANDLER_PRIORITY_DEFAULT	(128U)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// CanALSignalHandler is called with the physical value of the watched signal,
+// or 0 for handlers that do not watch one
+typedef void CanALSignalHandler(void* ctx, uint32_t ID, float value);
+
+typedef struct TsCanALHandler TsCanALHandler;
+
+// TsCanALHandler must be set up with CanAL_Handler_Init and must not be
+// modified while it is registered
+struct TsCanALHandler {
+	uint32_t id;
+	CanALSignalHandler* handler;
+	void* ctx;
+	// priority orders the handlers of a message, lower values run first and
+	// equal ones in registration order
+	uint8_t priority;
+	// signal is NULL for handlers that fire on every frame. Otherwise the
+	// handler fires on the first frame and then whenever the value moves more
+	// than deadband away from the value it last fired with; a deadband of 0
+	// fires on any change of the raw value.
+	const TsCanALSignal* signal;
+	float deadband;
+	// signalBytes is the DLC a frame needs to carry all of signal, shorter
+	// frames do not fire the handler
+	uint8_t signalBytes;
+	int64_t lastRaw;
+	float lastValue;
+	bool fired;
+	bool registered;
+	TsCanALHandler* next;
+};
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+TeCanALRet CanAL_Handler_Init(TsCanALHandler* handler, uint32_t ID, CanALSignalHandler* fn,
+		void* ctx, uint8_t priority);
+// CanAL_Handler_WatchSignal restricts handler to changes of signal. It must be
+// called before CanAL_Handler_Register.
+TeCanALRet CanAL_Handler_WatchSignal(TsCanALHandler* handler, const TsCanALSignal* signal,
+		float deadband);
+// CanAL_Handler_Register adds handler to the registry. Returns
+// CANAL_UNSUPPORTED_RX_MESSAGE if its ID is not received by this board.
+TeCanALRet CanAL_Handler_Register(TsCanALHandler* handler);
+TeCanALRet CanAL_Handler_Unregister(TsCanALHandler* handler);
+// CanAL_Handler_Dispatch runs the handlers of the message at index in
+// CANAL_CODEC_TABLE for a frame carrying dlc bytes of data. It is called by
+// canal.
+void CanAL_Handler_Dispatch(uint16_t index, const uint8_t* data, uint8_t dlc);
+
+#endif /* INC_CANAL_HANDLER_H_ */
@@ -0,0 +1,583 @@
+/*
+ * canal_isotp.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <string.h>
+#include "canal_isotp.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+#define PCI_SINGLE					(0x0U)
+#define PCI_FIRST					(0x1U)
+#define PCI_CONSECUTIVE				(0x2U)
+#define PCI_FLOW_CONTROL			(0x3U)
+
+#define FC_CONTINUE					(0x0U)
+#define FC_WAIT						(0x1U)
+#define FC_OVERFLOW					(0x2U)
+
+#define SF_MAX_LEN					(7U)
+#define CF_MAX_LEN					(7U)
+
+// idIde is ide unless ID only fits in an extended frame
+static inline uint8_t idIde(uint32_t ID, uint8_t ide) {
+	return ((ide == CAN_ID_EXT) || (ID > CANAL_FILTER_STD_ID_MASK)) ? CAN_ID_EXT : CAN_ID_STD;
+}
+
+static uint32_t nowUs(const TsCanALIsoTp* isotp) {
+	if (isotp->clockUs != NULL) return isotp->clockUs();
+
+	return HAL_GetTick() * 1000U;
+}
+
+static inline bool tickReached(uint32_t deadline) {
+	return (int32_t)(HAL_GetTick() - deadline) >= 0;
+}
+
+// stMinUs decodes an STmin byte. Reserved values mean the longest gap.
+static uint32_t stMinUs(uint8_t stMin) {
+	if (stMin <= 0x7FU) return (uint32_t)stMin * 1000U;
+
+	if ((stMin >= 0xF1U) && (stMin <= 0xF9U)) return (uint32_t)(stMin - 0xF0U) * 100U;
+
+	return 0x7FU * 1000U;
+}
+
+// txHasRoom keeps our frames from pushing application frames out of the tx queue
+static inline bool txHasRoom(const TsCanAL* can) {
+	return can->txQueue.count < (CANAL_TX_QUEUE_SIZE - CANAL_ISOTP_TX_RESERVE);
+}
+
+static TeCanALRet sendFrame(TsCanALIsoTpSession* session, TsCanALRawFrame* frame, uint8_t used) {
+	frame->id = session->config.txId;
+	frame->ide = session->txIde;
+	frame->dlc = 8U;
+	memset(&frame->data[used], CANAL_ISOTP_PAD_BYTE, 8U - used);
+
+	return CanAL_TransmitRaw(session->owner->can, frame);
+}
+
+static TeCanALRet sendFlowControl(TsCanALIsoTpSession* session, uint8_t status) {
+	TsCanALRawFrame frame;
+
+	frame.data[0] = (uint8_t)((PCI_FLOW_CONTROL << 4) | status);
+	frame.data[1] = session->config.blockSize;
+	frame.data[2] = session->config.stMin;
+
+	return sendFrame(session, &frame, 3U);
+}
+
+static void finishRx(TsCanALIsoTpSession* session, TeCanALRet result) {
+	if (result == CANAL_OK) {
+		session->stats.rxPayloads++;
+		session->stats.rxBytes += session->rxLen;
+	} else {
+		session->stats.rxErrors++;
+	}
+
+	session->rxResult = result;
+	session->rxState = CANAL_ISOTP_RX_DONE;
+}
+
+static void finishTx(TsCanALIsoTpSession* session, TeCanALRet result) {
+	if (result == CANAL_OK) {
+		session->stats.txPayloads++;
+		session->stats.txBytes += session->txLen;
+	} else {
+		session->stats.txErrors++;
+	}
+
+	session->txResult = result;
+	session->txState = CANAL_ISOTP_TX_DONE;
+}
+
+static void receiveSingle(TsCanALIsoTpSession* session, const TsCanALRawFrame* frame) {
+	uint8_t len = frame->data[0] & 0x0FU;
+
+	// A single frame replaces a reception in progress, but not one the
+	// application has yet to be told about
+	if (session->rxState == CANAL_ISOTP_RX_DONE) return;
+
+	if ((len == 0U) || (len > SF_MAX_LEN) || ((uint8_t)(len + 1U) > frame->dlc)) return;
+
+	if (len > session->rxSize) {
+		session->rxState = CANAL_ISOTP_RX_IDLE;
+		session->stats.rxErrors++;
+		return;
+	}
+
+	memcpy(session->rxBuf, &frame->data[1], len);
+	session->rxLen = len;
+	finishRx(session, CANAL_OK);
+}
+
+static void receiveFirst(TsCanALIsoTpSession* session, const TsCanALRawFrame* frame) {
+	const uint8_t* data = frame->data;
+	uint32_t len = ((uint32_t)(data[0] & 0x0FU) << 8) | data[1];
+	uint8_t offset = 2U;
+
+	if ((session->rxState == CANAL_ISOTP_RX_DONE) || (frame->dlc < 8U)) return;
+
+	if (len == 0U) {
+		len = ((uint32_t)data[2] << 24) | ((uint32_t)data[3] << 16) |
+			((uint32_t)data[4] << 8) | data[5];
+		offset = 6U;
+		if (len <= CANAL_ISOTP_FF_MAX_SHORT) return;
+	} else if (len <= SF_MAX_LEN) {
+		return;
+	}
+
+	if (len > session->rxSize) {
+		session->rxState = CANAL_ISOTP_RX_IDLE;
+		session->stats.rxErrors++;
+		sendFlowControl(session, FC_OVERFLOW);
+		return;
+	}
+
+	memcpy(session->rxBuf, &data[offset], 8U - offset);
+	session->rxLen = len;
+	session->rxReceived = 8U - offset;
+	session->rxSeq = 1U;
+	session->rxBlockCount = 0;
+	session->rxDeadline = HAL_GetTick() + session->config.timeoutMs;
+	session->rxState = CANAL_ISOTP_RX_RECEIVING;
+
+	sendFlowControl(session, FC_CONTINUE);
+}
+
+static void receiveConsecutive(TsCanALIsoTpSession* session, const TsCanALRawFrame* frame) {
+	uint32_t len;
+
+	if (session->rxState != CANAL_ISOTP_RX_RECEIVING) return;
+
+	if ((frame->data[0] & 0x0FU) != session->rxSeq) {
+		finishRx(session, CANAL_ERROR);
+		return;
+	}
+
+	len = session->rxLen - session->rxReceived;
+	if (len > CF_MAX_LEN) len = CF_MAX_LEN;
+
+	if ((len + 1U) > frame->dlc) {
+		finishRx(session, CANAL_ERROR);
+		return;
+	}
+
+	// Straight into the caller's buffer
+	memcpy(&session->rxBuf[session->rxReceived], &frame->data[1], len);
+	session->rxReceived += len;
+	session->rxSeq = (session->rxSeq + 1U) & 0x0FU;
+
+	if (session->rxReceived == session->rxLen) {
+		finishRx(session, CANAL_OK);
+		return;
+	}
+
+	session->rxDeadline = HAL_GetTick() + session->config.timeoutMs;
+
+	if ((session->config.blockSize != 0U) &&
+		(++session->rxBlockCount >= session->config.blockSize)) {
+		session->rxBlockCount = 0;
+		sendFlowControl(session, FC_CONTINUE);
+	}
+}
+
+static void receiveFlowControl(TsCanALIsoTpSession* session, const TsCanALRawFrame* frame) {
+	if ((session->txState != CANAL_ISOTP_TX_WAIT_FC) || (frame->dlc < 3U)) return;
+
+	switch (frame->data[0] & 0x0FU) {
+		case FC_CONTINUE:
+			session->txBlockLeft = frame->data[1];
+			session->txBlockLimited = (frame->data[1] != 0U);
+			session->txStMinUs = stMinUs(frame->data[2]);
+			session->txWaits = 0;
+			// The first consecutive frame is due straight away
+			session->txLastCfUs = nowUs(session->owner) - session->txStMinUs;
+			session->txState = CANAL_ISOTP_TX_SENDING;
+			break;
+		case FC_WAIT:
+			if (++session->txWaits > CANAL_ISOTP_MAX_WAIT) {
+				finishTx(session, CANAL_TIMEOUT);
+			} else {
+				session->txDeadline = HAL_GetTick() + session->config.timeoutMs;
+			}
+			break;
+		case FC_OVERFLOW:
+			finishTx(session, CANAL_BUFFER_OVERFLOW);
+			break;
+		default:
+			finishTx(session, CANAL_ERROR);
+			break;
+	}
+}
+
+// sendConsecutive sends the consecutive frames that are due, up to
+// CANAL_ISOTP_MAX_CF_PER_POLL. With an STmin the next one is left for a later
+// poll. The rx hook leaves a session alone while it is SENDING, so this runs
+// with interrupts enabled.
+static void sendConsecutive(TsCanALIsoTpSession* session) {
+	TsCanALRawFrame frame;
+	TeCanALRet ret;
+	uint32_t primask;
+	uint32_t now;
+	uint32_t len;
+	uint8_t sent = 0;
+	bool last;
+
+	while ((session->txState == CANAL_ISOTP_TX_SENDING) &&
+		(sent < CANAL_ISOTP_MAX_CF_PER_POLL) && txHasRoom(session->owner->can)) {
+		now = nowUs(session->owner);
+		if ((now - session->txLastCfUs) < session->txStMinUs) break;
+
+		len = session->txLen - session->txSent;
+		if (len > CF_MAX_LEN) len = CF_MAX_LEN;
+
+		frame.data[0] = (uint8_t)((PCI_CONSECUTIVE << 4) | session->txSeq);
+		memcpy(&frame.data[1], &session->txData[session->txSent], len);
+
+		session->txLastCfUs = now;
+		session->txSent += len;
+		session->txSeq = (session->txSeq + 1U) & 0x0FU;
+		last = (session->txSent == session->txLen);
+
+		// The peer may answer the last frame of a block before sendFrame
+		// returns, so wait for its flow control first
+		if (!last && session->txBlockLimited && (--session->txBlockLeft == 0U)) {
+			session->txDeadline = HAL_GetTick() + session->config.timeoutMs;
+			session->txState = CANAL_ISOTP_TX_WAIT_FC;
+		}
+
+		if ((ret = sendFrame(session, &frame, (uint8_t)(len + 1U))) != CANAL_OK) {
+			primask = CanAL_EnterCritical();
+			finishTx(session, ret);
+			CanAL_ExitCritical(primask);
+			break;
+		}
+
+		if (last) finishTx(session, CANAL_OK);
+
+		sent++;
+
+		if (session->txStMinUs != 0U) break;
+	}
+}
+
+static void pollSession(TsCanALIsoTpSession* session) {
+	TeCanALRet result;
+	uint32_t primask;
+
+	// The rx hook updates both sides from interrupt context
+	primask = CanAL_EnterCritical();
+
+	if ((session->rxState == CANAL_ISOTP_RX_RECEIVING) && tickReached(session->rxDeadline)) {
+		finishRx(session, CANAL_TIMEOUT);
+	}
+
+	if ((session->txState == CANAL_ISOTP_TX_WAIT_FC) && tickReached(session->txDeadline)) {
+		finishTx(session, CANAL_TIMEOUT);
+	}
+
+	CanAL_ExitCritical(primask);
+
+	sendConsecutive(session);
+
+	// The rx hook leaves both sides alone until they are idle again
+	if (session->rxState == CANAL_ISOTP_RX_DONE) {
+		result = session->rxResult;
+		if (session->rxDone != NULL) {
+			session->rxDone(session->ctx, result, session->rxBuf,
+				(result == CANAL_OK) ? session->rxLen : session->rxReceived);
+		}
+		session->rxState = CANAL_ISOTP_RX_IDLE;
+	}
+
+	if (session->txState == CANAL_ISOTP_TX_DONE) {
+		result = session->txResult;
+		session->txState = CANAL_ISOTP_TX_IDLE;
+		if (session->txDone != NULL) session->txDone(session->ctx, result);
+	}
+}
+
+static TsCanALIsoTpSession* findSession(const TsCanALIsoTp* isotp, const TsCanALRawFrame* frame) {
+	TsCanALIsoTpSession* session;
+
+	for (uint8_t i = 0; i < isotp->numSessions; i++) {
+		session = isotp->sessions[i];
+		if ((session->config.rxId == frame->id) && (session->rxIde == frame->ide)) return session;
+	}
+
+	return NULL;
+}
+
+static bool isSubscribed(const TsCanAL* can, uint32_t ID, uint8_t ide) {
+	for (uint16_t i = 0; i < can->numRxIds; i++) {
+		if ((can->rxIds[i] == ID) && (can->rxIdIde[i] == ide)) return true;
+	}
+
+	return false;
+}
+
+static TeCanALRet subscribeSession(TsCanAL* can, TsCanALIsoTpSession* session) {
+	TeCanALRet ret;
+
+	// With no IDs subscribed can already accepts every frame
+	if ((can->numRxIds == 0U) || isSubscribed(can, session->config.rxId, session->rxIde)) {
+		return CANAL_OK;
+	}
+
+	ret = CanAL_Subscribe(can, session->config.rxId, session->rxIde, DEFAULT_RX_FIFO);
+	if (ret == CANAL_OK) session->rxSubscribed = true;
+
+	return ret;
+}
+
+// unsubscribeSessions undoes every subscription made by subscribeSession
+static TeCanALRet unsubscribeSessions(TsCanALIsoTp* isotp, TsCanAL* can) {
+	TeCanALRet ret = CANAL_OK;
+	TeCanALRet sessionRet;
+
+	for (uint8_t i = 0; i < isotp->numSessions; i++) {
+		TsCanALIsoTpSession* session = isotp->sessions[i];
+
+		if (!session->rxSubscribed) continue;
+
+		session->rxSubscribed = false;
+		sessionRet = CanAL_Unsubscribe(can, session->config.rxId, session->rxIde);
+		if (sessionRet != CANAL_OK) ret = sessionRet;
+	}
+
+	return ret;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_IsoTp_Init(TsCanALIsoTp* isotp, CanALClockUs* clockUs) {
+	if (isotp == NULL) return CANAL_NULL_REF;
+
+	memset(isotp, 0, sizeof(*isotp));
+	isotp->clockUs = clockUs;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_IsoTp_Open(TsCanALIsoTp* isotp, TsCanALIsoTpSession* session,
+		const TsCanALIsoTpConfig* config, uint8_t* rxBuf, uint32_t rxSize,
+		CanALIsoTpRxDone* rxDone, CanALIsoTpTxDone* txDone, void* ctx) {
+	TeCanALRet ret;
+	uint32_t primask;
+
+	if ((isotp == NULL) || (session == NULL)) return CANAL_NULL_REF;
+
+	if ((config == NULL) || ((rxBuf == NULL) && (rxSize != 0U))) return CANAL_ERROR;
+
+	if (!IS_CAN_EXTID(config->txId) || !IS_CAN_EXTID(config->rxId)) {
+		return CANAL_UNSUPPORTED_RX_MESSAGE;
+	}
+
+	if (isotp->numSessions >= CANAL_ISOTP_MAX_SESSIONS) return CANAL_FILTER_TABLE_FULL;
+
+	memset(session, 0, sizeof(*session));
+	session->config = *config;
+	if (session->config.timeoutMs == 0U) session->config.timeoutMs = CANAL_ISOTP_TIMEOUT_MS;
+	session->owner = isotp;
+	session->txIde = idIde(config->txId, config->txIde);
+	session->rxIde = idIde(config->rxId, config->rxIde);
+	session->rxBuf = rxBuf;
+	session->rxSize = rxSize;
+	session->rxDone = rxDone;
+	session->txDone = txDone;
+	session->ctx = ctx;
+
+	if ((isotp->can != NULL) && ((ret = subscribeSession(isotp->can, session)) != CANAL_OK)) {
+		return ret;
+	}
+
+	// The rx interrupt may be searching the sessions
+	primask = CanAL_EnterCritical();
+	isotp->sessions[isotp->numSessions++] = session;
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_IsoTp_Attach(TsCanALIsoTp* isotp, TsCanAL* can) {
+	TeCanALRet ret;
+
+	if ((isotp == NULL) || (can == NULL)) return CANAL_NULL_REF;
+
+	if ((ret = CanAL_AddRxHook(can, &isotp->rxHook, CanAL_IsoTp_RxHook, isotp)) != CANAL_OK) {
+		return ret;
+	}
+
+	for (uint8_t i = 0; i < isotp->numSessions; i++) {
+		if ((ret = subscribeSession(can, isotp->sessions[i])) != CANAL_OK) {
+			unsubscribeSessions(isotp, can);
+			CanAL_RemoveRxHook(can, &isotp->rxHook);
+			return ret;
+		}
+	}
+
+	isotp->can = can;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_IsoTp_Detach(TsCanALIsoTp* isotp) {
+	TeCanALRet ret;
+
+	if (isotp == NULL) return CANAL_NULL_REF;
+
+	if (isotp->can == NULL) return CANAL_OK;
+
+	if ((ret = CanAL_RemoveRxHook(isotp->can, &isotp->rxHook)) != CANAL_OK) return ret;
+
+	ret = unsubscribeSessions(isotp, isotp->can);
+	isotp->can = NULL;
+
+	return ret;
+}
+
+bool CanAL_IsoTp_RxHook(void* ctx, const TsCanALRawFrame* frame) {
+	TsCanALIsoTpSession* session = findSession((const TsCanALIsoTp*)ctx, frame);
+
+	if (session == NULL) return false;
+
+	if (frame->dlc == 0U) return true;
+
+	switch (frame->data[0] >> 4) {
+		case PCI_SINGLE:
+			receiveSingle(session, frame);
+			break;
+		case PCI_FIRST:
+			receiveFirst(session, frame);
+			break;
+		case PCI_CONSECUTIVE:
+			receiveConsecutive(session, frame);
+			break;
+		case PCI_FLOW_CONTROL:
+			receiveFlowControl(session, frame);
+			break;
+		default:
+			break;
+	}
+
+	return true;
+}
+
+TeCanALRet CanAL_IsoTp_Send(TsCanALIsoTpSession* session, const uint8_t* data, uint32_t len) {
+	TsCanALRawFrame frame;
+	TeCanALRet ret;
+	uint32_t primask;
+	uint8_t header;
+	uint8_t copied;
+
+	if (session == NULL) return CANAL_NULL_REF;
+
+	if ((data == NULL) || (len == 0U) || (session->owner->can == NULL)) return CANAL_ERROR;
+
+	if (len <= SF_MAX_LEN) {
+		frame.data[0] = (uint8_t)((PCI_SINGLE << 4) | len);
+		header = 1U;
+		copied = (uint8_t)len;
+	} else if (len <= CANAL_ISOTP_FF_MAX_SHORT) {
+		frame.data[0] = (uint8_t)((PCI_FIRST << 4) | (len >> 8));
+		frame.data[1] = (uint8_t)len;
+		header = 2U;
+		copied = 6U;
+	} else {
+		frame.data[0] = (uint8_t)(PCI_FIRST << 4);
+		frame.data[1] = 0;
+		frame.data[2] = (uint8_t)(len >> 24);
+		frame.data[3] = (uint8_t)(len >> 16);
+		frame.data[4] = (uint8_t)(len >> 8);
+		frame.data[5] = (uint8_t)len;
+		header = 6U;
+		copied = 2U;
+	}
+
+	memcpy(&frame.data[header], data, copied);
+
+	primask = CanAL_EnterCritical();
+
+	if (session->txState != CANAL_ISOTP_TX_IDLE) {
+		CanAL_ExitCritical(primask);
+		return CANAL_BUSY;
+	}
+
+	session->txData = data;
+	session->txLen = len;
+	session->txSent = copied;
+	session->txSeq = 1U;
+	session->txWaits = 0;
+	session->txDeadline = HAL_GetTick() + session->config.timeoutMs;
+	// Claims the session, and the peer may answer the first frame before
+	// sendFrame returns
+	session->txState = CANAL_ISOTP_TX_WAIT_FC;
+
+	CanAL_ExitCritical(primask);
+
+	ret = sendFrame(session, &frame, header + copied);
+
+	primask = CanAL_EnterCritical();
+	if (ret != CANAL_OK) {
+		session->txState = CANAL_ISOTP_TX_IDLE;
+	} else if (len <= SF_MAX_LEN) {
+		finishTx(session, CANAL_OK);
+	}
+	CanAL_ExitCritical(primask);
+
+	return ret;
+}
+
+TeCanALRet CanAL_IsoTp_Poll(TsCanALIsoTp* isotp) {
+	if (isotp == NULL) return CANAL_NULL_REF;
+
+	if (isotp->can == NULL) return CANAL_OK;
+
+	for (uint8_t i = 0; i < isotp->numSessions; i++) pollSession(isotp->sessions[i]);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_IsoTp_GetStats(const TsCanALIsoTpSession* session, TsCanALIsoTpStats* stats) {
+	if (session == NULL) return CANAL_NULL_REF;
+
+	if (stats == NULL) return CANAL_ERROR;
+
+	*stats = session->stats;
+
+	return CANAL_OK;
+}
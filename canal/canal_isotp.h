@@ -0,0 +1,232 @@
+/*
+ * canal_isotp.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_ISOTP_H_
+#define INC_CANAL_ISOTP_H_
+
+// canal_isotp carries payloads longer than one frame over ISO 15765-2 (ISO-TP)
+// single, first, consecutive and flow control frames. Consecutive frames are
+// copied straight from the received frame into the caller's buffer and sent
+// straight from the caller's data, so nothing is staged in between.
+//
+// Frames are received in the rx hook of the TsCanAL (so in the rx interrupt, or
+// in CanAL_InjectRx for injected frames), which also answers with flow control
+// right away. CanAL_IsoTp_Poll must be called from the main loop to pace
+// consecutive frames, time out stalled transfers and report finished ones.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_ISOTP_MAX_SESSIONS is the number of sessions a TsCanALIsoTp can run
+#define CANAL_ISOTP_MAX_SESSIONS		(8U)
+
+// CANAL_ISOTP_PAD_BYTE fills every frame up to 8 bytes
+#ifndef CANAL_ISOTP_PAD_BYTE
+#define CANAL_ISOTP_PAD_BYTE			(0xCCU)
+#endif // CANAL_ISOTP_PAD_BYTE
+
+// CANAL_ISOTP_TIMEOUT_MS is the default N_Bs / N_Cr timeout
+#define CANAL_ISOTP_TIMEOUT_MS			(1000U)
+
+// CANAL_ISOTP_MAX_WAIT is the number of flow control WAIT frames accepted in a
+// row before the transfer is aborted (N_WFTmax)
+#define CANAL_ISOTP_MAX_WAIT			(8U)
+
+// CANAL_ISOTP_TX_RESERVE tx queue entries are left to the application:
+// consecutive frames wait for a later poll rather than fill them
+#ifndef CANAL_ISOTP_TX_RESERVE
+#define CANAL_ISOTP_TX_RESERVE			(4U)
+#endif // CANAL_ISOTP_TX_RESERVE
+
+// CANAL_ISOTP_MAX_CF_PER_POLL bounds the consecutive frames one session sends
+// in one CanAL_IsoTp_Poll, so a transfer without STmin cannot hold the main
+// loop for a whole block
+#ifndef CANAL_ISOTP_MAX_CF_PER_POLL
+#define CANAL_ISOTP_MAX_CF_PER_POLL		(4U)
+#endif // CANAL_ISOTP_MAX_CF_PER_POLL
+
+#if CANAL_ISOTP_TX_RESERVE >= CANAL_TX_QUEUE_SIZE
+#error "CANAL_ISOTP_TX_RESERVE must leave room in the tx queue"
+#endif
+
+// First frames above CANAL_ISOTP_FF_MAX_SHORT use the 32-bit length escape
+#define CANAL_ISOTP_FF_MAX_SHORT		(4095U)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// CanALIsoTpRxDone is called from CanAL_IsoTp_Poll when a payload has been
+// received into the session buffer (result CANAL_OK) or the reception failed.
+// The buffer is not written again until it returns.
+typedef void CanALIsoTpRxDone(void* ctx, TeCanALRet result, const uint8_t* data, uint32_t len);
+// CanALIsoTpTxDone is called from CanAL_IsoTp_Poll when CanAL_IsoTp_Send has
+// finished. The data handed to CanAL_IsoTp_Send may be reused from then on.
+typedef void CanALIsoTpTxDone(void* ctx, TeCanALRet result);
+
+typedef struct {
+	// txId carries this node's data and flow control frames, rxId the peer's.
+	// txIde and rxIde are CAN_ID_STD or CAN_ID_EXT; IDs above 0x7FF are always
+	// extended, so a zeroed config only needs them for extended IDs <= 0x7FF.
+	uint32_t txId;
+	uint32_t rxId;
+	uint8_t txIde;
+	uint8_t rxIde;
+	// blockSize and stMin are asked of the peer in our flow control frames:
+	// blockSize consecutive frames between flow control frames (0 sends them
+	// all at once) and stMin the ISO-TP encoded gap between them (0x00-0x7F ms,
+	// 0xF1-0xF9 100-900 us)
+	uint8_t blockSize;
+	uint8_t stMin;
+	// timeoutMs bounds the wait for a flow control or consecutive frame
+	uint32_t timeoutMs;
+}TsCanALIsoTpConfig;
+
+typedef enum {
+	CANAL_ISOTP_RX_IDLE = 0,
+	CANAL_ISOTP_RX_RECEIVING,
+	// CANAL_ISOTP_RX_DONE waits for CanAL_IsoTp_Poll to report rxResult
+	CANAL_ISOTP_RX_DONE,
+}TeCanALIsoTpRxState;
+
+typedef enum {
+	CANAL_ISOTP_TX_IDLE = 0,
+	CANAL_ISOTP_TX_WAIT_FC,
+	CANAL_ISOTP_TX_SENDING,
+	// CANAL_ISOTP_TX_DONE waits for CanAL_IsoTp_Poll to report txResult
+	CANAL_ISOTP_TX_DONE,
+}TeCanALIsoTpTxState;
+
+// TsCanALIsoTpStats counts payloads and bytes moved and transfers that failed
+typedef struct {
+	uint32_t rxPayloads;
+	uint32_t rxBytes;
+	uint32_t rxErrors;
+	uint32_t txPayloads;
+	uint32_t txBytes;
+	uint32_t txErrors;
+}TsCanALIsoTpStats;
+
+typedef struct TsCanALIsoTp TsCanALIsoTp;
+
+typedef struct {
+	TsCanALIsoTpConfig config;
+	// owner is the TsCanALIsoTp the session was opened on
+	TsCanALIsoTp* owner;
+	uint8_t txIde;
+	uint8_t rxIde;
+	// rxSubscribed is set when the session subscribed the instance to rxId
+	// itself, CanAL_IsoTp_Detach unsubscribes it again
+	bool rxSubscribed;
+	CanALIsoTpRxDone* rxDone;
+	CanALIsoTpTxDone* txDone;
+	void* ctx;
+
+	// Receive side, written by the rx hook
+	volatile TeCanALIsoTpRxState rxState;
+	uint8_t* rxBuf;
+	uint32_t rxSize;
+	uint32_t rxLen;
+	uint32_t rxReceived;
+	uint8_t rxSeq;
+	uint8_t rxBlockCount;
+	uint32_t rxDeadline;
+	TeCanALRet rxResult;
+
+	// Transmit side
+	volatile TeCanALIsoTpTxState txState;
+	const uint8_t* txData;
+	uint32_t txLen;
+	uint32_t txSent;
+	uint8_t txSeq;
+	// txBlockLeft counts down the peer's block size when txBlockLimited
+	uint8_t txBlockLeft;
+	bool txBlockLimited;
+	uint8_t txWaits;
+	uint32_t txStMinUs;
+	uint32_t txLastCfUs;
+	uint32_t txDeadline;
+	TeCanALRet txResult;
+
+	TsCanALIsoTpStats stats;
+}TsCanALIsoTpSession;
+
+// TsCanALIsoTp holds the sessions running on one TsCanAL. It must be
+// initialized with CanAL_IsoTp_Init.
+struct TsCanALIsoTp {
+	TsCanAL* can;
+	// rxHook links CanAL_IsoTp_RxHook into the rx hooks of can while attached
+	TsCanALRxHookNode rxHook;
+	TsCanALIsoTpSession* sessions[CANAL_ISOTP_MAX_SESSIONS];
+	uint8_t numSessions;
+	// clockUs times STmin below a millisecond, without it HAL_GetTick is used
+	CanALClockUs* clockUs;
+};
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+TeCanALRet CanAL_IsoTp_Init(TsCanALIsoTp* isotp, CanALClockUs* clockUs);
+// CanAL_IsoTp_Open adds session to isotp. Received payloads are reassembled
+// into rxBuf, which must stay valid while the session is open. A config
+// timeoutMs of 0 uses CANAL_ISOTP_TIMEOUT_MS.
+TeCanALRet CanAL_IsoTp_Open(TsCanALIsoTp* isotp, TsCanALIsoTpSession* session,
+		const TsCanALIsoTpConfig* config, uint8_t* rxBuf, uint32_t rxSize,
+		CanALIsoTpRxDone* rxDone, CanALIsoTpTxDone* txDone, void* ctx);
+// CanAL_IsoTp_Attach starts receiving on can. It must be called from the main
+// loop after CanAL_Init(can) and adds CanAL_IsoTp_RxHook to the rx hooks of
+// can; session rxIds that can does not already accept are subscribed on
+// DEFAULT_RX_FIFO.
+TeCanALRet CanAL_IsoTp_Attach(TsCanALIsoTp* isotp, TsCanAL* can);
+// CanAL_IsoTp_Detach stops receiving, removes its rx hook (leaving every other
+// hook of can in place) and unsubscribes the rxIds that attaching or opening
+// sessions subscribed.
+TeCanALRet CanAL_IsoTp_Detach(TsCanALIsoTp* isotp);
+// CanAL_IsoTp_RxHook is the CanALRxHook added by CanAL_IsoTp_Attach
+bool CanAL_IsoTp_RxHook(void* ctx, const TsCanALRawFrame* frame);
+// CanAL_IsoTp_Send starts sending len bytes of data, which must stay valid
+// until the txDone callback. Returns CANAL_BUSY while a send is in progress.
+TeCanALRet CanAL_IsoTp_Send(TsCanALIsoTpSession* session, const uint8_t* data, uint32_t len);
+// CanAL_IsoTp_Poll sends the consecutive frames that are due, times out stalled
+// transfers and calls the rxDone / txDone callbacks. It never waits for STmin,
+// so it should be called as often as the main loop allows.
+TeCanALRet CanAL_IsoTp_Poll(TsCanALIsoTp* isotp);
+TeCanALRet CanAL_IsoTp_GetStats(const TsCanALIsoTpSession* session, TsCanALIsoTpStats* stats);
+
+#endif /* INC_CANAL_ISOTP_H_ */
@@ -0,0 +1,189 @@
+/*
+ * canal_monitor.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal_monitor.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+// Ticks wrap, so deadlines are compared by signed distance
+static inline bool tickBefore(uint32_t a, uint32_t b) {
+	return (int32_t)(a - b) < 0;
+}
+
+static bool heapBefore(const TsCanALMonitor* mon, uint8_t a, uint8_t b) {
+	return tickBefore(mon->watches[mon->heap[a]].deadline, mon->watches[mon->heap[b]].deadline);
+}
+
+static void heapSwap(TsCanALMonitor* mon, uint8_t a, uint8_t b) {
+	uint8_t tmp = mon->heap[a];
+
+	mon->heap[a] = mon->heap[b];
+	mon->heap[b] = tmp;
+}
+
+static void heapSiftUp(TsCanALMonitor* mon, uint8_t i) {
+	while (i > 0) {
+		uint8_t parent = (i - 1U) / 2U;
+
+		if (!heapBefore(mon, i, parent)) break;
+
+		heapSwap(mon, i, parent);
+		i = parent;
+	}
+}
+
+static void heapSiftDown(TsCanALMonitor* mon, uint8_t i) {
+	for (;;) {
+		uint8_t left = (2U * i) + 1U;
+		uint8_t right = left + 1U;
+		uint8_t best = i;
+
+		if ((left < mon->heapSize) && heapBefore(mon, left, best)) best = left;
+		if ((right < mon->heapSize) && heapBefore(mon, right, best)) best = right;
+
+		if (best == i) break;
+
+		heapSwap(mon, i, best);
+		i = best;
+	}
+}
+
+static void heapPush(TsCanALMonitor* mon, uint8_t watch) {
+	mon->heap[mon->heapSize] = watch;
+	heapSiftUp(mon, mon->heapSize++);
+}
+
+static void heapPopTop(TsCanALMonitor* mon) {
+	mon->heap[0] = mon->heap[--mon->heapSize];
+	heapSiftDown(mon, 0);
+}
+
+// reviveStale moves watches whose message arrived again back into the heap
+static void reviveStale(TsCanALMonitor* mon) {
+	for (uint8_t i = 0; i < mon->numStale; ) {
+		uint8_t index = mon->staleList[i];
+		TsCanALWatch* watch = &mon->watches[index];
+		uint32_t tick;
+
+		if ((CanAL_Last_Update_Tick(watch->id, &tick) == CANAL_OK) && (tick != watch->staleSince)) {
+			watch->stale = false;
+			watch->deadline = tick + watch->timeoutMs;
+			heapPush(mon, index);
+			mon->staleList[i] = mon->staleList[--mon->numStale];
+		} else {
+			i++;
+		}
+	}
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Monitor_Init(TsCanALMonitor* mon) {
+	if (mon == NULL) return CANAL_NULL_REF;
+
+	mon->numWatches = 0;
+	mon->heapSize = 0;
+	mon->numStale = 0;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Monitor_Watch(TsCanALMonitor* mon, uint32_t ID, uint32_t timeoutMs,
+		CanALStaleHandler* onStale, uint8_t* handle) {
+	TeCanALRet ret;
+	TsCanALWatch* watch;
+	uint32_t tick;
+
+	if ((mon == NULL) || (handle == NULL)) return CANAL_NULL_REF;
+
+	if (mon->numWatches >= CANAL_MONITOR_MAX_WATCHES) return CANAL_ERROR;
+
+	if ((ret = CanAL_Last_Update_Tick(ID, &tick)) != CANAL_OK) return ret;
+
+	*handle = mon->numWatches++;
+	watch = &mon->watches[*handle];
+	watch->id = ID;
+	watch->timeoutMs = timeoutMs;
+	watch->deadline = tick + timeoutMs;
+	watch->staleSince = 0;
+	watch->onStale = onStale;
+	watch->stale = false;
+
+	heapPush(mon, *handle);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Monitor_Poll(TsCanALMonitor* mon) {
+	uint32_t now = HAL_GetTick();
+
+	if (mon == NULL) return CANAL_NULL_REF;
+
+	reviveStale(mon);
+
+	while (mon->heapSize > 0) {
+		uint8_t index = mon->heap[0];
+		TsCanALWatch* watch = &mon->watches[index];
+		uint32_t tick;
+
+		if (tickBefore(now, watch->deadline)) break;
+
+		// The stored deadline has passed, but the message may have been received
+		// since it was computed
+		CanAL_Last_Update_Tick(watch->id, &tick);
+		if (tickBefore(now, tick + watch->timeoutMs)) {
+			watch->deadline = tick + watch->timeoutMs;
+			heapSiftDown(mon, 0);
+			continue;
+		}
+
+		heapPopTop(mon);
+		watch->stale = true;
+		watch->staleSince = tick;
+		mon->staleList[mon->numStale++] = index;
+
+		if (watch->onStale != NULL) watch->onStale(watch->id);
+	}
+
+	return CANAL_OK;
+}
+
+bool CanAL_Monitor_IsStale(const TsCanALMonitor* mon, uint8_t handle) {
+	if ((mon == NULL) || (handle >= mon->numWatches)) return true;
+
+	return mon->watches[handle].stale;
+}
@@ -0,0 +1,99 @@
+/*
+ * canal_monitor.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_MONITOR_H_
+#define INC_CANAL_MONITOR_H_
+
+// canal_monitor reports received messages that stop arriving. Each watched
+// message has a deadline kept in a min-heap, so a poll only looks at the
+// deadlines that have actually passed instead of scanning every message.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_MONITOR_MAX_WATCHES is the number of messages a monitor can watch
+#define CANAL_MONITOR_MAX_WATCHES		(48U)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// CanALStaleHandler is called once when a watched message goes stale
+typedef void CanALStaleHandler(uint32_t ID);
+
+typedef struct {
+	uint32_t id;
+	uint32_t timeoutMs;
+	// deadline is the tick at which the message goes stale unless it is received
+	uint32_t deadline;
+	// staleSince is the last update tick seen when the message went stale
+	uint32_t staleSince;
+	CanALStaleHandler* onStale;
+	bool stale;
+}TsCanALWatch;
+
+// TsCanALMonitor must be initialized with CanAL_Monitor_Init. The rx path only
+// stores a timestamp per message; deadlines are refreshed lazily in
+// CanAL_Monitor_Poll when they reach the top of the heap.
+typedef struct {
+	TsCanALWatch watches[CANAL_MONITOR_MAX_WATCHES];
+	// heap holds the indices of the fresh watches ordered by deadline
+	uint8_t heap[CANAL_MONITOR_MAX_WATCHES];
+	// staleList holds the indices of the stale watches
+	uint8_t staleList[CANAL_MONITOR_MAX_WATCHES];
+	uint8_t numWatches;
+	uint8_t heapSize;
+	uint8_t numStale;
+}TsCanALMonitor;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+TeCanALRet CanAL_Monitor_Init(TsCanALMonitor* mon);
+// CanAL_Monitor_Watch starts watching ID. The message goes stale when it has
+// not been received for timeoutMs. handle is used with CanAL_Monitor_IsStale.
+TeCanALRet CanAL_Monitor_Watch(TsCanALMonitor* mon, uint32_t ID, uint32_t timeoutMs,
+		CanALStaleHandler* onStale, uint8_t* handle);
+// CanAL_Monitor_Poll updates the stale state of every watch and fires the stale
+// handlers. It is meant to be called once per control cycle from the main loop.
+TeCanALRet CanAL_Monitor_Poll(TsCanALMonitor* mon);
+// CanAL_Monitor_IsStale returns the stale state as of the last poll
+bool CanAL_Monitor_IsStale(const TsCanALMonitor* mon, uint8_t handle);
+
+#endif /* INC_CANAL_MONITOR_H_ */
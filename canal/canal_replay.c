@@ -0,0 +1,223 @@
+/*
+ * canal_replay.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <string.h>
+#include "canal_replay.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+// loadNext decodes the record at pos. A truncated capture ends the replay.
+static TeCanALRet loadNext(TsCanALReplay* replay) {
+	if (replay->pos >= replay->len) {
+		replay->nextLen = 0;
+		return CANAL_OK;
+	}
+
+	replay->nextLen = CanAL_Trace_DecodeRecord(&replay->data[replay->pos],
+		replay->len - replay->pos, &replay->next);
+
+	if (replay->nextLen == 0U) {
+		replay->pos = replay->len;
+		return CANAL_ERROR;
+	}
+
+	replay->traceUs += replay->next.deltaUs;
+
+	return CANAL_OK;
+}
+
+// advanceClock adds the time since the last call to wallUs
+static void advanceClock(TsCanALReplay* replay) {
+	uint32_t now;
+
+	if (replay->clockUs == NULL) return;
+
+	now = replay->clockUs();
+
+	if (replay->started) replay->wallUs += now - replay->lastClockUs;
+
+	replay->lastClockUs = now;
+	replay->started = true;
+}
+
+// isDue compares the capture time of the next record, scaled by speed, with
+// the time played so far
+static bool isDue(const TsCanALReplay* replay) {
+	if (replay->speed == CANAL_REPLAY_AS_FAST_AS_POSSIBLE) return true;
+
+	return (replay->traceUs / replay->speed) <= replay->wallUs;
+}
+
+static void injectNext(TsCanALReplay* replay) {
+	TsCanALReplayReport* report = &replay->report;
+	TsCanAL* target = NULL;
+	TeCanALRet ret;
+	uint32_t cycles;
+
+	if ((replay->next.bus >= 1U) && (replay->next.bus <= CANAL_NUM_INSTANCES)) {
+		target = replay->targets[replay->next.bus - 1U];
+	}
+
+	if ((target == NULL) || (replay->next.tx && !replay->includeTx)) {
+		report->skipped++;
+		return;
+	}
+
+	cycles = CANAL_STATS_CYCLES();
+
+	ret = CanAL_InjectRx(target, replay->fifo, &replay->next.frame);
+	if ((ret == CANAL_OK) && (target->rxMode == CANAL_RX_MODE_DEFERRED)) {
+		ret = CanAL_ProcessRx(target, 0);
+	}
+
+	cycles = CANAL_STATS_CYCLES() - cycles;
+
+	report->frames++;
+	if (ret != CANAL_OK) report->failed++;
+	report->decodeCycles += cycles;
+	if (cycles > report->decodeCyclesMax) report->decodeCyclesMax = cycles;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Replay_Init(TsCanALReplay* replay, const uint8_t* data, uint32_t len,
+		TsCanAL* target, uint32_t fifo, uint32_t speed, CanALClockUs* clockUs) {
+	TeCanALRet ret;
+
+	if (replay == NULL) return CANAL_NULL_REF;
+
+	if ((data == NULL) || !IS_CANAL_RX_FIFO(fifo)) return CANAL_ERROR;
+
+	if ((clockUs == NULL) && (speed != CANAL_REPLAY_AS_FAST_AS_POSSIBLE)) {
+		return CANAL_ERROR;
+	}
+
+	memset(replay, 0, sizeof(*replay));
+
+	replay->data = data;
+	replay->len = len;
+	replay->fifo = fifo;
+	replay->speed = speed;
+	replay->clockUs = clockUs;
+
+	for (uint8_t i = 0; i < CANAL_NUM_INSTANCES; i++) replay->targets[i] = target;
+
+	ret = loadNext(replay);
+
+	// The first delta is the time from CanAL_Trace_Start to the first record,
+	// which includes the whole wait for a trigger. Play from the first record.
+	replay->traceUs = 0;
+
+	return ret;
+}
+
+TeCanALRet CanAL_Replay_SetTarget(TsCanALReplay* replay, uint8_t bus, TsCanAL* target) {
+	if (replay == NULL) return CANAL_NULL_REF;
+
+	if ((bus < 1U) || (bus > CANAL_NUM_INSTANCES)) return CANAL_UNSUPPORTED_INSTANCE;
+
+	replay->targets[bus - 1U] = target;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Replay_IncludeTx(TsCanALReplay* replay, bool includeTx) {
+	if (replay == NULL) return CANAL_NULL_REF;
+
+	replay->includeTx = includeTx;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Replay_Poll(TsCanALReplay* replay, uint16_t budget) {
+	TeCanALRet ret = CANAL_OK;
+	uint16_t injected = 0;
+
+	if (replay == NULL) return CANAL_NULL_REF;
+
+	advanceClock(replay);
+
+	while ((replay->nextLen != 0U) && isDue(replay)) {
+		if ((budget != 0U) && (injected >= budget)) break;
+
+		injectNext(replay);
+		injected++;
+
+		replay->pos += replay->nextLen;
+		if ((ret = loadNext(replay)) != CANAL_OK) break;
+	}
+
+	// Catch the time spent injecting so the report covers it
+	advanceClock(replay);
+
+	return ret;
+}
+
+TeCanALRet CanAL_Replay_Run(TsCanALReplay* replay) {
+	TeCanALRet ret;
+
+	if (replay == NULL) return CANAL_NULL_REF;
+
+	while (!CanAL_Replay_Finished(replay)) {
+		if ((ret = CanAL_Replay_Poll(replay, 0)) != CANAL_OK) return ret;
+	}
+
+	return CANAL_OK;
+}
+
+bool CanAL_Replay_Finished(const TsCanALReplay* replay) {
+	return (replay == NULL) || (replay->nextLen == 0U);
+}
+
+TeCanALRet CanAL_Replay_GetReport(const TsCanALReplay* replay, TsCanALReplayReport* report) {
+	if (replay == NULL) return CANAL_NULL_REF;
+
+	if (report == NULL) return CANAL_ERROR;
+
+	*report = replay->report;
+	report->elapsedUs = (uint32_t)replay->wallUs;
+
+	if (replay->wallUs != 0U) {
+		report->framesPerSec = (uint32_t)(((uint64_t)report->frames * 1000000U) / replay->wallUs);
+	}
+
+	if (report->frames != 0U) {
+		report->decodeCyclesAvg = (uint32_t)(report->decodeCycles / report->frames);
+	}
+
+	return CANAL_OK;
+}
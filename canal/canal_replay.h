@@ -0,0 +1,124 @@
+/*
+ * canal_replay.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_REPLAY_H_
+#define INC_CANAL_REPLAY_H_
+
+// canal_replay plays a stream drained from a TsCanALTrace back into one or more
+// TsCanAL through CanAL_InjectRx, so recorded bus captures exercise the same
+// store, hooks, unmarshallers and handlers as live traffic (the hardware
+// filters are bypassed, so the capture should only hold wanted IDs). It never
+// touches the CAN peripheral, so it runs on the host against a HAL stand-in as
+// well as on the target, and reports the decode throughput and cost.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_REPLAY_AS_FAST_AS_POSSIBLE and CANAL_REPLAY_REAL_TIME are the special
+// speeds; any other speed N plays the capture N times faster than it was
+// recorded
+#define CANAL_REPLAY_AS_FAST_AS_POSSIBLE	(0U)
+#define CANAL_REPLAY_REAL_TIME				(1U)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+typedef struct {
+	// frames were injected, failed is how many of them did not return CANAL_OK
+	// (e.g. IDs missing from the DBC) and skipped were tx records or records of
+	// a bus without a target
+	uint32_t frames;
+	uint32_t failed;
+	uint32_t skipped;
+	// elapsedUs is the wall time from the first record to the last poll
+	uint32_t elapsedUs;
+	uint32_t framesPerSec;
+	// decodeCycles are CANAL_STATS_CYCLES() spent in CanAL_InjectRx, plus
+	// CanAL_ProcessRx in CANAL_RX_MODE_DEFERRED
+	uint64_t decodeCycles;
+	uint32_t decodeCyclesAvg;
+	uint32_t decodeCyclesMax;
+}TsCanALReplayReport;
+
+typedef struct {
+	const uint8_t* data;
+	uint32_t len;
+	uint32_t pos;
+	// targets are indexed by TeCanALInstance - 1 of the recorded bus
+	TsCanAL* targets[CANAL_NUM_INSTANCES];
+	uint32_t fifo;
+	uint32_t speed;
+	bool includeTx;
+	CanALClockUs* clockUs;
+	// traceUs is the capture time of the next record and wallUs the time played
+	// so far, both from the first record
+	uint64_t traceUs;
+	uint64_t wallUs;
+	uint32_t lastClockUs;
+	bool started;
+	TsCanALTraceRecord next;
+	uint32_t nextLen;
+	TsCanALReplayReport report;
+}TsCanALReplay;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Replay_Init prepares replay to play the len bytes of trace records in
+// data into target, whatever bus they were recorded on, through fifo. clockUs
+// paces the replay and times it; it may only be NULL at
+// CANAL_REPLAY_AS_FAST_AS_POSSIBLE, in which case the frame rate is not reported.
+TeCanALRet CanAL_Replay_Init(TsCanALReplay* replay, const uint8_t* data, uint32_t len,
+		TsCanAL* target, uint32_t fifo, uint32_t speed, CanALClockUs* clockUs);
+// CanAL_Replay_SetTarget sends the records of bus (a TeCanALInstance) to target
+// instead. Pass NULL to skip them.
+TeCanALRet CanAL_Replay_SetTarget(TsCanALReplay* replay, uint8_t bus, TsCanAL* target);
+// CanAL_Replay_IncludeTx also plays the frames the recording board transmitted,
+// as if they had been received
+TeCanALRet CanAL_Replay_IncludeTx(TsCanALReplay* replay, bool includeTx);
+// CanAL_Replay_Poll injects up to budget records that are due (0 for no limit).
+// It is meant to be called from the main loop.
+TeCanALRet CanAL_Replay_Poll(TsCanALReplay* replay, uint16_t budget);
+// CanAL_Replay_Run polls until the whole capture has been played
+TeCanALRet CanAL_Replay_Run(TsCanALReplay* replay);
+bool CanAL_Replay_Finished(const TsCanALReplay* replay);
+TeCanALRet CanAL_Replay_GetReport(const TsCanALReplay* replay, TsCanALReplayReport* report);
+
+#endif /* INC_CANAL_REPLAY_H_ */
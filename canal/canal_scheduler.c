@@ -0,0 +1,235 @@
+/*
+ * canal_scheduler.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal_scheduler.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+	while (b != 0) {
+		uint32_t t = a % b;
+
+		a = b;
+		b = t;
+	}
+
+	return a;
+}
+
+// bestPhase returns the phase in [0, period) that shares the fewest ticks with
+// the messages already scheduled. Two periodic messages release on the same
+// tick iff their phases are equal modulo gcd(periods), which happens on
+// gcd / otherPeriod of this message's releases.
+static uint32_t bestPhase(const TsCanALScheduler* sched, uint32_t period) {
+	uint32_t best = 0;
+	uint32_t bestCost = UINT32_MAX;
+
+	for (uint32_t phase = 0; phase < period; phase++) {
+		uint32_t cost = 0;
+
+		for (uint8_t i = 0; i < sched->numEntries; i++) {
+			const TsCanALSchedEntry* entry = &sched->entries[i];
+			uint32_t g = gcd(period, entry->periodTicks);
+
+			if ((phase % g) == (entry->phaseTicks % g)) {
+				cost += (g * 1024U) / entry->periodTicks;
+			}
+		}
+
+		if (cost < bestCost) {
+			bestCost = cost;
+			best = phase;
+			if (cost == 0) break;
+		}
+	}
+
+	return best;
+}
+
+static void wheelInsert(TsCanALScheduler* sched, uint8_t index) {
+	uint32_t slot = sched->entries[index].nextRelease & (CANAL_SCHED_WHEEL_SLOTS - 1U);
+
+	sched->entries[index].next = sched->wheel[slot];
+	sched->wheel[slot] = index;
+}
+
+static void recordJitter(TsCanALScheduler* sched, TsCanALSchedEntry* entry) {
+	uint32_t nowUs;
+	int32_t jitter;
+
+	if (sched->clockUs == NULL) return;
+
+	nowUs = sched->clockUs();
+
+	if (entry->releases > 0) {
+		jitter = (int32_t)((nowUs - entry->lastReleaseUs) - (entry->periodTicks * sched->tickUs));
+
+		if ((entry->jitterSamples == 0) || (jitter < entry->minJitterUs)) entry->minJitterUs = jitter;
+		if ((entry->jitterSamples == 0) || (jitter > entry->maxJitterUs)) entry->maxJitterUs = jitter;
+		entry->sumJitterUs += jitter;
+		entry->jitterSamples++;
+	}
+
+	entry->lastReleaseUs = nowUs;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Scheduler_Init(TsCanALScheduler* sched, TsCanAL* can, uint32_t tickUs,
+		CanALClockUs* clockUs) {
+	if ((sched == NULL) || (can == NULL)) return CANAL_NULL_REF;
+
+	sched->can = can;
+	sched->tickUs = tickUs;
+	sched->clockUs = clockUs;
+	sched->now = 0;
+	sched->numEntries = 0;
+
+	for (uint32_t i = 0; i < CANAL_SCHED_WHEEL_SLOTS; i++) sched->wheel[i] = CANAL_SCHED_NONE;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Scheduler_Add(TsCanALScheduler* sched, TeMessageID ID, uint32_t periodTicks,
+		uint32_t phaseTicks) {
+	TsCanALSchedEntry* entry;
+	uint32_t primask;
+	uint32_t now;
+	uint8_t index;
+
+	if (sched == NULL) return CANAL_NULL_REF;
+
+	if (periodTicks == 0) return CANAL_ERROR;
+
+	if (sched->numEntries >= CANAL_SCHED_MAX_MESSAGES) return CANAL_ERROR;
+
+	if (phaseTicks == CANAL_SCHED_AUTO_PHASE) phaseTicks = bestPhase(sched, periodTicks);
+	else phaseTicks %= periodTicks;
+
+	index = sched->numEntries;
+	entry = &sched->entries[index];
+	entry->id = ID;
+	entry->periodTicks = periodTicks;
+	entry->phaseTicks = phaseTicks;
+	entry->lastReleaseUs = 0;
+	entry->minJitterUs = 0;
+	entry->maxJitterUs = 0;
+	entry->sumJitterUs = 0;
+	entry->jitterSamples = 0;
+	entry->releases = 0;
+	entry->failures = 0;
+
+	// The timer interrupt walks the wheel, so link the entry in atomically
+	primask = CanAL_EnterCritical();
+
+	now = sched->now;
+	entry->nextRelease = now + ((phaseTicks + periodTicks - (now % periodTicks)) % periodTicks);
+	wheelInsert(sched, index);
+	sched->numEntries++;
+
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Scheduler_Tick(TsCanALScheduler* sched) {
+	uint32_t now;
+	uint32_t slot;
+	uint8_t due = CANAL_SCHED_NONE;
+	uint8_t* link;
+
+	if (sched == NULL) return CANAL_NULL_REF;
+
+	now = sched->now;
+	slot = now & (CANAL_SCHED_WHEEL_SLOTS - 1U);
+	link = &sched->wheel[slot];
+
+	// Unlink the entries that are due this lap, the rest wait for a later lap
+	while (*link != CANAL_SCHED_NONE) {
+		TsCanALSchedEntry* entry = &sched->entries[*link];
+
+		if (entry->nextRelease == now) {
+			uint8_t index = *link;
+
+			*link = entry->next;
+			entry->next = due;
+			due = index;
+		} else {
+			link = &entry->next;
+		}
+	}
+
+	while (due != CANAL_SCHED_NONE) {
+		TsCanALSchedEntry* entry = &sched->entries[due];
+		uint8_t index = due;
+
+		due = entry->next;
+
+		recordJitter(sched, entry);
+		if (CanAL_Transmit(sched->can, (TeMessageID)entry->id) != CANAL_OK) entry->failures++;
+		entry->releases++;
+
+		entry->nextRelease += entry->periodTicks;
+		wheelInsert(sched, index);
+	}
+
+	sched->now = now + 1U;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Scheduler_GetJitter(const TsCanALScheduler* sched, uint32_t ID,
+		TsCanALJitterStats* stats) {
+	if ((sched == NULL) || (stats == NULL)) return CANAL_NULL_REF;
+
+	for (uint8_t i = 0; i < sched->numEntries; i++) {
+		const TsCanALSchedEntry* entry = &sched->entries[i];
+
+		if (entry->id != ID) continue;
+
+		stats->minUs = entry->minJitterUs;
+		stats->maxUs = entry->maxJitterUs;
+		stats->meanUs = (entry->jitterSamples > 0) ?
+			(int32_t)(entry->sumJitterUs / (int64_t)entry->jitterSamples) : 0;
+		stats->releases = entry->releases;
+		stats->failures = entry->failures;
+
+		return CANAL_OK;
+	}
+
+	return CANAL_UNSUPPORTED_TX_MESSAGE;
+}
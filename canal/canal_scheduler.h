@@ -0,0 +1,124 @@
+/*
+ * canal_scheduler.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_SCHEDULER_H_
+#define INC_CANAL_SCHEDULER_H_
+
+// canal_scheduler releases periodic messages from a single timer tick. Messages
+// are kept in a hashed timing wheel so a tick only visits the slot that is due,
+// and phases can be chosen automatically to spread releases across ticks.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_SCHED_MAX_MESSAGES is the number of periodic messages per scheduler
+#define CANAL_SCHED_MAX_MESSAGES		(32U)
+// CANAL_SCHED_WHEEL_SLOTS is the number of wheel slots. Must be a power of 2;
+// periods longer than the wheel simply take more than one lap.
+#define CANAL_SCHED_WHEEL_SLOTS			(64U)
+// CANAL_SCHED_AUTO_PHASE lets the scheduler pick the least crowded phase
+#define CANAL_SCHED_AUTO_PHASE			(0xFFFFFFFFU)
+#define CANAL_SCHED_NONE				(0xFFU)
+
+#if (CANAL_SCHED_WHEEL_SLOTS & (CANAL_SCHED_WHEEL_SLOTS - 1U)) != 0U
+#error "CANAL_SCHED_WHEEL_SLOTS must be a power of 2"
+#endif
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+typedef struct {
+	uint32_t id;
+	uint32_t periodTicks;
+	uint32_t phaseTicks;
+	// nextRelease is the absolute tick of the next transmission
+	uint32_t nextRelease;
+	// next links entries that share a wheel slot
+	uint8_t next;
+	// Release jitter is the actual time between two releases minus the period
+	uint32_t lastReleaseUs;
+	int32_t minJitterUs;
+	int32_t maxJitterUs;
+	int64_t sumJitterUs;
+	uint32_t jitterSamples;
+	uint32_t releases;
+	// failures counts releases that CanAL_Transmit did not accept
+	uint32_t failures;
+}TsCanALSchedEntry;
+
+// TsCanALScheduler must be initialized with CanAL_Scheduler_Init
+typedef struct {
+	TsCanAL* can;
+	// tickUs is the nominal time between two calls of CanAL_Scheduler_Tick
+	uint32_t tickUs;
+	// clockUs is used for jitter statistics, NULL disables them
+	CanALClockUs* clockUs;
+	volatile uint32_t now;
+	uint8_t wheel[CANAL_SCHED_WHEEL_SLOTS];
+	TsCanALSchedEntry entries[CANAL_SCHED_MAX_MESSAGES];
+	uint8_t numEntries;
+}TsCanALScheduler;
+
+// TsCanALJitterStats is a snapshot of the release jitter of one message
+typedef struct {
+	int32_t minUs;
+	int32_t maxUs;
+	int32_t meanUs;
+	uint32_t releases;
+	uint32_t failures;
+}TsCanALJitterStats;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+TeCanALRet CanAL_Scheduler_Init(TsCanALScheduler* sched, TsCanAL* can, uint32_t tickUs,
+		CanALClockUs* clockUs);
+// CanAL_Scheduler_Add transmits ID every periodTicks, on ticks where
+// tick % periodTicks == phaseTicks. Pass CANAL_SCHED_AUTO_PHASE to pick the
+// phase that collides least with the messages already scheduled.
+TeCanALRet CanAL_Scheduler_Add(TsCanALScheduler* sched, TeMessageID ID, uint32_t periodTicks,
+		uint32_t phaseTicks);
+// CanAL_Scheduler_Tick releases every message due on this tick. It is meant to
+// be called from a single hardware timer interrupt every tickUs.
+TeCanALRet CanAL_Scheduler_Tick(TsCanALScheduler* sched);
+TeCanALRet CanAL_Scheduler_GetJitter(const TsCanALScheduler* sched, uint32_t ID,
+		TsCanALJitterStats* stats);
+
+#endif /* INC_CANAL_SCHEDULER_H_ */
@@ -0,0 +1,165 @@
+/*
+ * canal_signal.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <string.h>
+#include "canal_signal.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+#define PAYLOAD_BITS					(64U)
+
+static inline uint64_t lengthMask(uint8_t length) {
+	return (length >= PAYLOAD_BITS) ? UINT64_MAX : ((1ULL << length) - 1U);
+}
+
+// lsbPosition returns the position of the least significant bit of sig in the
+// word of its endianness. Motorola bits are numbered from the MSB of byte 0 in
+// the byte-swapped word.
+static inline uint8_t lsbPosition(const TsCanALSignal* sig) {
+	if (sig->endianness != CANAL_BIG_ENDIAN) return sig->startBit;
+
+	return (uint8_t)(((7U - (sig->startBit / 8U)) * 8U) + (sig->startBit % 8U) + 1U - sig->length);
+}
+
+static inline uint64_t* signalWord(const TsCanALSignal* sig, TsCanALPayload* payload) {
+	return (sig->endianness == CANAL_BIG_ENDIAN) ? &payload->be : &payload->le;
+}
+
+static int64_t signExtend(uint64_t raw, uint8_t length) {
+	uint8_t unused = PAYLOAD_BITS - length;
+
+	return (int64_t)(raw << unused) >> unused;
+}
+
+// saturate rounds value to the nearest raw value that length bits can hold
+static int64_t saturate(const TsCanALSignal* sig, float value) {
+	float scaled = (value - sig->offset) / sig->scale;
+	float rounded = (scaled < 0.0f) ? (scaled - 0.5f) : (scaled + 0.5f);
+	uint8_t valueBits = sig->isSigned ? (sig->length - 1U) : sig->length;
+	int64_t max = (valueBits >= 63U) ? INT64_MAX : (int64_t)((1ULL << valueBits) - 1U);
+	int64_t min = sig->isSigned ? (-max - 1) : 0;
+
+	if (rounded <= (float)min) return min;
+	if (rounded >= (float)max) return max;
+
+	return (int64_t)rounded;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Signal_Validate(const TsCanALSignal* sig) {
+	uint32_t msb;
+
+	if (sig == NULL) return CANAL_ERROR;
+
+	if ((sig->length == 0U) || (sig->length > PAYLOAD_BITS) || (sig->startBit >= PAYLOAD_BITS)) {
+		return CANAL_ERROR;
+	}
+
+	switch (sig->endianness) {
+		case CANAL_LITTLE_ENDIAN:
+			if (((uint32_t)sig->startBit + sig->length) > PAYLOAD_BITS) return CANAL_ERROR;
+			break;
+		case CANAL_BIG_ENDIAN:
+			msb = ((7U - (sig->startBit / 8U)) * 8U) + (sig->startBit % 8U);
+			if ((msb + 1U) < sig->length) return CANAL_ERROR;
+			break;
+		default:
+			return CANAL_INVALID_ENDIANNESS;
+	}
+
+	if (sig->scale == 0.0f) return CANAL_ERROR;
+
+	return CANAL_OK;
+}
+
+void CanAL_Signal_Load(const uint8_t* data, TsCanALPayload* payload) {
+	// A single unaligned 64-bit load on the Cortex-M7
+	memcpy(&payload->le, data, sizeof(payload->le));
+	payload->be = __builtin_bswap64(payload->le);
+}
+
+void CanAL_Signal_Store(const TsCanALPayload* payload, uint8_t* data) {
+	uint64_t word = payload->le | __builtin_bswap64(payload->be);
+
+	memcpy(data, &word, sizeof(word));
+}
+
+int64_t CanAL_Signal_GetRaw(const TsCanALSignal* sig, const TsCanALPayload* payload) {
+	uint64_t word = (sig->endianness == CANAL_BIG_ENDIAN) ? payload->be : payload->le;
+	uint64_t raw = (word >> lsbPosition(sig)) & lengthMask(sig->length);
+
+	return sig->isSigned ? signExtend(raw, sig->length) : (int64_t)raw;
+}
+
+void CanAL_Signal_SetRaw(const TsCanALSignal* sig, TsCanALPayload* payload, int64_t raw) {
+	uint64_t* word = signalWord(sig, payload);
+	uint8_t pos = lsbPosition(sig);
+	uint64_t mask = lengthMask(sig->length) << pos;
+
+	*word = (*word & ~mask) | (((uint64_t)raw << pos) & mask);
+}
+
+TeCanALRet CanAL_Signal_Unpack(const TsCanALSignal* sigs, uint8_t numSigs,
+		const uint8_t* data, float* values) {
+	TsCanALPayload payload;
+
+	if ((sigs == NULL) || (data == NULL) || (values == NULL)) return CANAL_ERROR;
+
+	CanAL_Signal_Load(data, &payload);
+
+	for (uint8_t i = 0; i < numSigs; i++) {
+		values[i] = ((float)CanAL_Signal_GetRaw(&sigs[i], &payload) * sigs[i].scale) + sigs[i].offset;
+	}
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Signal_Pack(const TsCanALSignal* sigs, uint8_t numSigs,
+		const float* values, uint8_t* data) {
+	TsCanALPayload payload = {0};
+
+	if ((sigs == NULL) || (data == NULL) || (values == NULL)) return CANAL_ERROR;
+
+	for (uint8_t i = 0; i < numSigs; i++) {
+		CanAL_Signal_SetRaw(&sigs[i], &payload, saturate(&sigs[i], values[i]));
+	}
+
+	CanAL_Signal_Store(&payload, data);
+
+	return CANAL_OK;
+}
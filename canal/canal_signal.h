@@ -0,0 +1,95 @@
+/*
+ * canal_signal.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_SIGNAL_H_
+#define INC_CANAL_SIGNAL_H_
+
+// canal_signal packs and unpacks signals described by a const table instead of
+// per-message generated code. The 8 byte payload is loaded once as a 64-bit
+// word (and byte-swapped once for Motorola signals), so every signal is a
+// single shift and mask. It has no HAL dependencies so that it can be built
+// and tested on the host; like the Cortex-M7 the host must be little-endian.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// TsCanALSignal follows the DBC conventions. startBit is the position of the
+// least significant bit for CANAL_LITTLE_ENDIAN (Intel) signals and of the most
+// significant bit for CANAL_BIG_ENDIAN (Motorola) signals, where bit 0 is the
+// LSB of byte 0 and bit 7 its MSB. physical = raw * scale + offset.
+typedef struct {
+	uint8_t startBit;
+	uint8_t length;
+	TeCanALEndianness endianness;
+	bool isSigned;
+	float scale;
+	float offset;
+}TsCanALSignal;
+
+// TsCanALPayload holds a payload loaded as both words so that every signal of a
+// message can be read without touching the bytes again
+typedef struct {
+	uint64_t le;
+	uint64_t be;
+}TsCanALPayload;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Signal_Validate checks that sig fits in an 8 byte payload
+TeCanALRet CanAL_Signal_Validate(const TsCanALSignal* sig);
+void CanAL_Signal_Load(const uint8_t* data, TsCanALPayload* payload);
+// CanAL_Signal_Store ORs both words together, so every signal must have been
+// set in the word of its own endianness
+void CanAL_Signal_Store(const TsCanALPayload* payload, uint8_t* data);
+// CanAL_Signal_GetRaw returns the raw value of sig, sign extended if it is signed
+int64_t CanAL_Signal_GetRaw(const TsCanALSignal* sig, const TsCanALPayload* payload);
+// CanAL_Signal_SetRaw replaces the bits of sig with the low length bits of raw
+void CanAL_Signal_SetRaw(const TsCanALSignal* sig, TsCanALPayload* payload, int64_t raw);
+// CanAL_Signal_Unpack decodes every signal in sigs from data into the physical
+// values in values
+TeCanALRet CanAL_Signal_Unpack(const TsCanALSignal* sigs, uint8_t numSigs,
+		const uint8_t* data, float* values);
+// CanAL_Signal_Pack encodes the physical values into data. Values outside the
+// range of a signal saturate.
+TeCanALRet CanAL_Signal_Pack(const TsCanALSignal* sigs, uint8_t numSigs,
+		const float* values, uint8_t* data);
+
+#endif /* INC_CANAL_SIGNAL_H_ */
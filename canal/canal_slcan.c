@@ -0,0 +1,340 @@
+/*
+ * canal_slcan.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <string.h>
+#include "canal_slcan.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+#define TX_MASK							(CANAL_SLCAN_TX_SIZE - 1U)
+
+// 'V' and 'N' responses
+static const uint8_t versionResponse[] = "V1013\r";
+static const uint8_t serialResponse[] = "NCA01\r";
+
+// slcanBauds maps the n of the Sn command to a bit rate in kbit/s
+static const uint16_t slcanBauds[] = { 10, 20, 50, 100, 125, 250, 500, 800, 1000 };
+
+// queueBytes appends len bytes to the tx ring, or counts a drop if they do not
+// all fit. The rx hooks of both FIFOs and the main loop all write the ring.
+static bool queueBytes(TsCanALSlcan* slcan, const uint8_t* data, uint8_t len) {
+	uint32_t primask = CanAL_EnterCritical();
+	uint32_t head = slcan->txHead;
+	uint32_t first;
+
+	if ((CANAL_SLCAN_TX_SIZE - (head - slcan->txTail)) < len) {
+		slcan->overrun = true;
+		slcan->stats.dropped++;
+		CanAL_ExitCritical(primask);
+
+		return false;
+	}
+
+	first = CANAL_SLCAN_TX_SIZE - (head & TX_MASK);
+	if (first > len) first = len;
+
+	memcpy(&slcan->tx[head & TX_MASK], data, first);
+	memcpy(slcan->tx, &data[first], len - first);
+
+	slcan->txHead = head + len;
+
+	CanAL_ExitCritical(primask);
+
+	return true;
+}
+
+static void respond(TsCanALSlcan* slcan, bool ok) {
+	uint8_t response = ok ? CANAL_SLCAN_OK : CANAL_SLCAN_BELL;
+
+	if (!ok) slcan->stats.cmdErrors++;
+
+	queueBytes(slcan, &response, 1);
+}
+
+static bool setBaud(TsCanALSlcan* slcan, const uint8_t* line, uint8_t len) {
+	uint8_t n;
+
+	if ((len != 2U) || (line[1] < '0') || (line[1] > '8')) return false;
+
+	n = line[1] - '0';
+
+	// The bit rate belongs to CanAL_Init, so only the one in use is accepted
+	return (slcan->state == CANAL_SLCAN_CLOSED) &&
+		(slcan->can != NULL) && ((uint16_t)slcan->can->baud == slcanBauds[n]);
+}
+
+static void sendStatus(TsCanALSlcan* slcan) {
+	static const uint8_t hexDigits[] = "0123456789ABCDEF";
+	uint8_t flags = 0;
+	uint8_t response[4];
+
+	if (slcan->overrun) flags |= CANAL_SLCAN_STATUS_OVERRUN;
+	if ((slcan->can != NULL) && (slcan->can->txQueue.count >= CANAL_TX_QUEUE_SIZE)) {
+		flags |= CANAL_SLCAN_STATUS_TX_FULL;
+	}
+
+	slcan->overrun = false;
+
+	response[0] = 'F';
+	response[1] = hexDigits[flags >> 4];
+	response[2] = hexDigits[flags & 0xFU];
+	response[3] = CANAL_SLCAN_OK;
+
+	queueBytes(slcan, response, sizeof(response));
+}
+
+static void sendFrame(TsCanALSlcan* slcan, const uint8_t* line, uint8_t len) {
+	TsCanALRawFrame frame;
+	// The Lawicel acknowledgement of a queued frame
+	uint8_t response[2] = { (line[0] == 'T') ? 'Z' : 'z', CANAL_SLCAN_OK };
+
+	if ((slcan->state != CANAL_SLCAN_OPEN) ||
+		(CanAL_Slcan_DecodeFrame(line, len, &frame) != CANAL_OK)) {
+		respond(slcan, false);
+		return;
+	}
+
+	if (CanAL_TransmitRaw(slcan->can, &frame) != CANAL_OK) {
+		slcan->stats.txFailed++;
+		respond(slcan, false);
+		return;
+	}
+
+	slcan->stats.txFrames++;
+	queueBytes(slcan, response, sizeof(response));
+}
+
+// runCommand handles one line from the host, without its '\r'
+static void runCommand(TsCanALSlcan* slcan, const uint8_t* line, uint8_t len) {
+	bool closed = (slcan->state == CANAL_SLCAN_CLOSED);
+
+	// An empty line is how hosts flush a half sent command
+	if (len == 0U) {
+		respond(slcan, true);
+		return;
+	}
+
+	switch (line[0]) {
+		case 'O':
+			if (closed && (slcan->can != NULL)) slcan->state = CANAL_SLCAN_OPEN;
+			respond(slcan, closed && (slcan->can != NULL));
+			break;
+		case 'L':
+			if (closed && (slcan->can != NULL)) slcan->state = CANAL_SLCAN_LISTEN;
+			respond(slcan, closed && (slcan->can != NULL));
+			break;
+		case 'C':
+			slcan->state = CANAL_SLCAN_CLOSED;
+			respond(slcan, !closed);
+			break;
+		case 'S':
+			respond(slcan, setBaud(slcan, line, len));
+			break;
+		case 'Z':
+			if (closed && (len == 2U) && ((line[1] == '0') || (line[1] == '1'))) {
+				slcan->timestamps = (line[1] == '1');
+				respond(slcan, true);
+			} else {
+				respond(slcan, false);
+			}
+			break;
+		case 'M':
+		case 'm':
+			// Acceptance filtering is done by the hardware filters
+			respond(slcan, closed);
+			break;
+		case 'V':
+			queueBytes(slcan, versionResponse, sizeof(versionResponse) - 1U);
+			break;
+		case 'N':
+			queueBytes(slcan, serialResponse, sizeof(serialResponse) - 1U);
+			break;
+		case 'F':
+			sendStatus(slcan);
+			break;
+		case 't':
+		case 'T':
+			sendFrame(slcan, line, len);
+			break;
+		default:
+			respond(slcan, false);
+			break;
+	}
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Slcan_Init(TsCanALSlcan* slcan, UART_st* uart) {
+	if (slcan == NULL) return CANAL_NULL_REF;
+
+	if (uart == NULL) return CANAL_ERROR;
+
+	memset(slcan, 0, sizeof(*slcan));
+
+	slcan->uart = uart;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Slcan_Attach(TsCanALSlcan* slcan, TsCanAL* can) {
+	TeCanALRet ret;
+
+	if ((slcan == NULL) || (can == NULL)) return CANAL_NULL_REF;
+
+	if ((ret = CanAL_AddRxHook(can, &slcan->rxHook, CanAL_Slcan_RxHook, slcan)) != CANAL_OK) {
+		return ret;
+	}
+
+	slcan->can = can;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Slcan_Detach(TsCanALSlcan* slcan) {
+	TeCanALRet ret;
+
+	if (slcan == NULL) return CANAL_NULL_REF;
+
+	if (slcan->can == NULL) return CANAL_OK;
+
+	if ((ret = CanAL_RemoveRxHook(slcan->can, &slcan->rxHook)) != CANAL_OK) return ret;
+
+	slcan->state = CANAL_SLCAN_CLOSED;
+	slcan->can = NULL;
+
+	return CANAL_OK;
+}
+
+bool CanAL_Slcan_RxHook(void* ctx, const TsCanALRawFrame* frame) {
+	TsCanALSlcan* slcan = (TsCanALSlcan*)ctx;
+	uint8_t line[CANAL_SLCAN_MAX_LINE];
+	uint8_t len;
+
+	if ((slcan == NULL) || (slcan->state == CANAL_SLCAN_CLOSED)) return false;
+
+	len = CanAL_Slcan_EncodeFrame(frame, slcan->timestamps,
+		(uint16_t)(HAL_GetTick() % CANAL_SLCAN_TIMESTAMP_WRAP), line);
+
+	if (queueBytes(slcan, line, len)) slcan->stats.rxFrames++;
+
+	// The frame is only copied, so it is still decoded on this board
+	return false;
+}
+
+TeCanALRet CanAL_Slcan_Input(TsCanALSlcan* slcan, const uint8_t* data, uint16_t len) {
+	if (slcan == NULL) return CANAL_NULL_REF;
+
+	if ((data == NULL) && (len != 0U)) return CANAL_ERROR;
+
+	for (uint16_t i = 0; i < len; i++) {
+		uint8_t c = data[i];
+
+		if (c == '\n') continue;
+
+		if (c != '\r') {
+			if (slcan->lineLen < CANAL_SLCAN_MAX_LINE) {
+				slcan->line[slcan->lineLen++] = c;
+			} else {
+				slcan->lineOverflow = true;
+			}
+			continue;
+		}
+
+		if (slcan->lineOverflow) {
+			respond(slcan, false);
+		} else {
+			runCommand(slcan, slcan->line, slcan->lineLen);
+		}
+
+		slcan->lineLen = 0;
+		slcan->lineOverflow = false;
+	}
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Slcan_Poll(TsCanALSlcan* slcan) {
+	uint32_t tail;
+	uint32_t chunk;
+	uint32_t space;
+	TeUART_Return ret;
+
+	if (slcan == NULL) return CANAL_NULL_REF;
+
+	tail = slcan->txTail;
+
+	while (tail != slcan->txHead) {
+		// Copy straight from the ring, one contiguous span at a time
+		chunk = slcan->txHead - tail;
+		if (chunk > (CANAL_SLCAN_TX_SIZE - (tail & TX_MASK))) {
+			chunk = CANAL_SLCAN_TX_SIZE - (tail & TX_MASK);
+		}
+
+		if (UART_Tx_Space(slcan->uart, &space) != UART_OK) {
+			slcan->stats.uartErrors++;
+			return CANAL_ERROR;
+		}
+
+		// Whatever the uart ring has no room for waits for the next poll
+		if (chunk > space) chunk = space;
+		if (chunk == 0U) break;
+
+		// The span is consumed even if another writer of the uart crowded part
+		// of it out of the ring
+		ret = UART_Transmit_Async(slcan->uart, &slcan->tx[tail & TX_MASK], chunk);
+
+		tail += chunk;
+		slcan->txTail = tail;
+
+		if (ret != UART_OK) {
+			slcan->stats.uartErrors++;
+			return CANAL_ERROR;
+		}
+	}
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Slcan_GetStats(const TsCanALSlcan* slcan, TsCanALSlcanStats* stats) {
+	if (slcan == NULL) return CANAL_NULL_REF;
+
+	if (stats == NULL) return CANAL_ERROR;
+
+	*stats = slcan->stats;
+
+	return CANAL_OK;
+}
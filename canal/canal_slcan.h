@@ -0,0 +1,157 @@
+/*
+ * canal_slcan.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_SLCAN_H_
+#define INC_CANAL_SLCAN_H_
+
+// canal_slcan turns a board into an SLCAN (Lawicel) adapter: frames received
+// by a TsCanAL are sent to a host over a UART_st port, and frames the host
+// sends are put on the bus, so e.g. slcand / python-can can log the bus.
+//
+// The rx hook encodes each frame into a byte ring instead of writing to the
+// UART; CanAL_Slcan_Poll later copies whole contiguous spans of it to the tx
+// ring of the UART, which the DMA sends in the background. Bytes from the host
+// are handed to CanAL_Slcan_Input from wherever the application receives
+// them. Frames that do not fit the ring are dropped, counted, and reported to
+// the host as a data overrun by the 'F' command.
+//
+// A standard 8 byte frame takes 22 bytes (26 with timestamps), so a fully
+// loaded 500 kbit/s bus of them needs about 1 Mbit/s of UART bandwidth (1.2
+// with timestamps).
+//
+// Supported commands: O, L, C, Sn (must match the TsCanAL baud), V, N, F,
+// Z0/Z1, M/m (accepted, use CanAL_Subscribe to filter), t, T. Remote frames
+// (r, R) and BTR timing (s) answer with a bell.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal.h"
+#include "canal_slcan_codec.h"
+#include "uart_lib.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_SLCAN_TX_SIZE is the size in bytes of the ring holding encoded frames
+// and command responses. It must be a power of 2.
+#ifndef CANAL_SLCAN_TX_SIZE
+#define CANAL_SLCAN_TX_SIZE				(4096U)
+#endif // CANAL_SLCAN_TX_SIZE
+
+#if (CANAL_SLCAN_TX_SIZE & (CANAL_SLCAN_TX_SIZE - 1U)) != 0U
+#error "CANAL_SLCAN_TX_SIZE must be a power of 2"
+#endif
+
+// Flags of the 'F' status response
+#define CANAL_SLCAN_STATUS_TX_FULL		(0x02U)
+#define CANAL_SLCAN_STATUS_OVERRUN		(0x08U)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+typedef enum {
+	CANAL_SLCAN_CLOSED = 0,
+	CANAL_SLCAN_OPEN,
+	// CANAL_SLCAN_LISTEN forwards received frames but refuses host frames
+	CANAL_SLCAN_LISTEN,
+}TeCanALSlcanState;
+
+typedef struct {
+	// rxFrames counts frames queued to the host and dropped the frames and
+	// responses that did not fit the ring
+	uint32_t rxFrames;
+	uint32_t dropped;
+	// txFrames counts host frames accepted by CanAL_TransmitRaw and txFailed
+	// those it refused
+	uint32_t txFrames;
+	uint32_t txFailed;
+	// cmdErrors counts commands answered with a bell
+	uint32_t cmdErrors;
+	// uartErrors counts polls that found no uart tx ring or lost bytes to it
+	uint32_t uartErrors;
+}TsCanALSlcanStats;
+
+// TsCanALSlcan is one SLCAN channel. It must be initialized with
+// CanAL_Slcan_Init.
+typedef struct {
+	TsCanAL* can;
+	// rxHook links CanAL_Slcan_RxHook into the rx hooks of can while attached
+	TsCanALRxHookNode rxHook;
+	UART_st* uart;
+	volatile TeCanALSlcanState state;
+	volatile bool timestamps;
+	// tx is written by the rx hook and by CanAL_Slcan_Input, and emptied by
+	// CanAL_Slcan_Poll
+	uint8_t tx[CANAL_SLCAN_TX_SIZE];
+	volatile uint32_t txHead;
+	volatile uint32_t txTail;
+	// line collects the command being received, lineOverflow discards the rest
+	// of a command that is too long
+	uint8_t line[CANAL_SLCAN_MAX_LINE];
+	uint8_t lineLen;
+	bool lineOverflow;
+	// overrun is reported and cleared by the next 'F' command
+	volatile bool overrun;
+	TsCanALSlcanStats stats;
+}TsCanALSlcan;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Slcan_Init sets up slcan to talk to the host over uart, which must
+// already be initialized with UART_Init and given a tx ring with
+// UART_Tx_Ring_Init before the first CanAL_Slcan_Poll
+TeCanALRet CanAL_Slcan_Init(TsCanALSlcan* slcan, UART_st* uart);
+// CanAL_Slcan_Attach bridges slcan to can. It must be called from the main loop
+// after CanAL_Init(can) and adds CanAL_Slcan_RxHook to the rx hooks of can.
+TeCanALRet CanAL_Slcan_Attach(TsCanALSlcan* slcan, TsCanAL* can);
+// CanAL_Slcan_Detach closes the channel and removes its rx hook, leaving every
+// other hook of can in place
+TeCanALRet CanAL_Slcan_Detach(TsCanALSlcan* slcan);
+// CanAL_Slcan_RxHook is the CanALRxHook added by CanAL_Slcan_Attach. Frames are
+// still decoded locally.
+bool CanAL_Slcan_RxHook(void* ctx, const TsCanALRawFrame* frame);
+// CanAL_Slcan_Input parses len bytes received from the host and queues the
+// responses. It must be called from the main loop.
+TeCanALRet CanAL_Slcan_Input(TsCanALSlcan* slcan, const uint8_t* data, uint16_t len);
+// CanAL_Slcan_Poll hands what is queued for the host to the uart tx ring and
+// returns without waiting for the DMA. Bytes the ring has no room for stay
+// queued for the next poll. It must be called from the main loop. CANAL_ERROR
+// is returned if uart has no tx ring or bytes were lost to it.
+TeCanALRet CanAL_Slcan_Poll(TsCanALSlcan* slcan);
+TeCanALRet CanAL_Slcan_GetStats(const TsCanALSlcan* slcan, TsCanALSlcanStats* stats);
+
+#endif /* INC_CANAL_SLCAN_H_ */
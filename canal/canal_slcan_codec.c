@@ -0,0 +1,155 @@
+/*
+ * canal_slcan_codec.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stddef.h>
+#include "canal_slcan_codec.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+#define STD_ID_DIGITS					(3U)
+#define EXT_ID_DIGITS					(8U)
+
+static const uint8_t hexDigits[] = "0123456789ABCDEF";
+
+static inline uint8_t* putHex(uint8_t* out, uint32_t value, uint8_t digits) {
+	while (digits > 0U) {
+		digits--;
+		*out++ = hexDigits[(value >> (4U * digits)) & 0xFU];
+	}
+
+	return out;
+}
+
+// getHex parses digits hex characters. Either case is accepted.
+static bool getHex(const uint8_t* in, uint8_t digits, uint32_t* value) {
+	uint32_t result = 0;
+
+	for (uint8_t i = 0; i < digits; i++) {
+		uint8_t c = in[i];
+
+		if ((c >= '0') && (c <= '9')) {
+			c -= '0';
+		} else if ((c >= 'A') && (c <= 'F')) {
+			c -= 'A' - 10U;
+		} else if ((c >= 'a') && (c <= 'f')) {
+			c -= 'a' - 10U;
+		} else {
+			return false;
+		}
+
+		result = (result << 4) | c;
+	}
+
+	*value = result;
+
+	return true;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+uint8_t CanAL_Slcan_EncodeFrame(const TsCanALRawFrame* frame, bool withTimestamp,
+		uint16_t timestampMs, uint8_t* out) {
+	uint8_t* start = out;
+	uint8_t dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+
+	if (frame->ide == CAN_ID_EXT) {
+		*out++ = 'T';
+		out = putHex(out, frame->id, EXT_ID_DIGITS);
+	} else {
+		*out++ = 't';
+		out = putHex(out, frame->id, STD_ID_DIGITS);
+	}
+
+	*out++ = hexDigits[dlc];
+
+	for (uint8_t i = 0; i < dlc; i++) out = putHex(out, frame->data[i], 2);
+
+	if (withTimestamp) out = putHex(out, timestampMs, 4);
+
+	*out++ = CANAL_SLCAN_OK;
+
+	return (uint8_t)(out - start);
+}
+
+TeCanALRet CanAL_Slcan_DecodeFrame(const uint8_t* line, uint8_t len, TsCanALRawFrame* frame) {
+	uint8_t idDigits;
+	uint32_t value;
+	uint8_t pos;
+
+	if ((line == NULL) || (frame == NULL) || (len == 0U)) return CANAL_ERROR;
+
+	switch (line[0]) {
+		case 't':
+			idDigits = STD_ID_DIGITS;
+			frame->ide = CAN_ID_STD;
+			break;
+		case 'T':
+			idDigits = EXT_ID_DIGITS;
+			frame->ide = CAN_ID_EXT;
+			break;
+		default:
+			return CANAL_ERROR;
+	}
+
+	pos = 1;
+
+	if (len < (pos + idDigits + 1U)) return CANAL_ERROR;
+
+	if (!getHex(&line[pos], idDigits, &frame->id)) return CANAL_ERROR;
+	pos += idDigits;
+
+	if ((frame->ide == CAN_ID_STD) ? (frame->id > 0x7FFU) : (frame->id > 0x1FFFFFFFU)) {
+		return CANAL_ERROR;
+	}
+
+	if (!getHex(&line[pos++], 1, &value) || (value > 8U)) return CANAL_ERROR;
+	frame->dlc = (uint8_t)value;
+
+	if (len != (pos + (2U * frame->dlc))) return CANAL_ERROR;
+
+	for (uint8_t i = 0; i < 8U; i++) {
+		value = 0;
+
+		if ((i < frame->dlc) && !getHex(&line[pos + (2U * i)], 2, &value)) return CANAL_ERROR;
+
+		frame->data[i] = (uint8_t)value;
+	}
+
+	frame->timestamp = 0;
+
+	return CANAL_OK;
+}
@@ -0,0 +1,84 @@
+/*
+ * canal_slcan_codec.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_SLCAN_CODEC_H_
+#define INC_CANAL_SLCAN_CODEC_H_
+
+// canal_slcan_codec converts frames to and from SLCAN (Lawicel) text lines:
+//   tiiildd..[ssss]\r          standard ID, 3 hex digits
+//   Tiiiiiiiildd..[ssss]\r     extended ID, 8 hex digits
+// where l is the DLC, dd the payload bytes and ssss the optional millisecond
+// timestamp (0-59999). It only depends on canal_types.h so it can be built and
+// tested on the host; canal_slcan.h bridges it to a TsCanAL and a UART.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// Host builds have no HAL, so give the codec the HAL values of the IDE field
+#ifndef CAN_ID_STD
+#define CAN_ID_STD						(0x00000000U)
+#endif // CAN_ID_STD
+#ifndef CAN_ID_EXT
+#define CAN_ID_EXT						(0x00000004U)
+#endif // CAN_ID_EXT
+
+// CANAL_SLCAN_MAX_LINE fits the longest line: 'T', 8 ID digits, DLC, 16 data
+// digits, 4 timestamp digits and '\r'
+#define CANAL_SLCAN_MAX_LINE			(31U)
+
+// Timestamps wrap every minute as in the Lawicel protocol
+#define CANAL_SLCAN_TIMESTAMP_WRAP		(60000U)
+
+#define CANAL_SLCAN_OK					('\r')
+#define CANAL_SLCAN_BELL				('\a')
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Slcan_EncodeFrame writes frame as an SLCAN line ending in '\r' to out,
+// which must hold CANAL_SLCAN_MAX_LINE bytes, and returns its length. The
+// timestamp is only appended when withTimestamp is set.
+uint8_t CanAL_Slcan_EncodeFrame(const TsCanALRawFrame* frame, bool withTimestamp,
+		uint16_t timestampMs, uint8_t* out);
+// CanAL_Slcan_DecodeFrame parses a 't' or 'T' command of len bytes, without
+// its '\r', into frame. Returns CANAL_ERROR if the line is malformed or the ID
+// does not fit its format.
+TeCanALRet CanAL_Slcan_DecodeFrame(const uint8_t* line, uint8_t len, TsCanALRawFrame* frame);
+
+#endif /* INC_CANAL_SLCAN_CODEC_H_ */
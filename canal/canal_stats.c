@@ -0,0 +1,142 @@
+/*
+ * canal_stats.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal_stats.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+// Bits outside the data field that can be stuffed (SOF to CRC) and the fixed
+// form bits after it (CRC delimiter, ACK, EOF, interframe space)
+#define STD_STUFFED_BITS				(34U)
+#define EXT_STUFFED_BITS				(54U)
+#define FIXED_FORM_BITS					(13U)
+
+static uint8_t histBucket(uint32_t cycles) {
+	uint8_t bucket = 0;
+
+	while ((cycles > 1U) && (bucket < (CANAL_STATS_HIST_BUCKETS - 1U))) {
+		cycles >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+static void countFrame(TsCanALStatsState* state, const TsCanALRawFrame* frame) {
+	state->totals.busBits += CanAL_Stats_FrameBits(frame->ide, frame->dlc);
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+uint32_t CanAL_Stats_FrameBits(uint8_t ide, uint8_t dlc) {
+	uint32_t dataBits = 8U * ((dlc > 8U) ? 8U : dlc);
+	// ide is CAN_ID_STD (0) or CAN_ID_EXT
+	uint32_t stuffed = ((ide == 0U) ? STD_STUFFED_BITS : EXT_STUFFED_BITS) + dataBits;
+
+	// A stuff bit can follow every 4 bits after the first 5 equal ones
+	return stuffed + FIXED_FORM_BITS + ((stuffed - 1U) / 4U);
+}
+
+void CanAL_Stats_Reset(TsCanALStatsState* state, uint32_t nowMs) {
+	*state = (TsCanALStatsState){0};
+	state->totals.rxCycles.min = UINT32_MAX;
+	state->totals.txCycles.min = UINT32_MAX;
+	state->totals.isrLatency.min = UINT32_MAX;
+	state->windowStartTick = nowMs;
+}
+
+void CanAL_Stats_Record(TsCanALCycleHist* hist, uint32_t cycles) {
+	hist->buckets[histBucket(cycles)]++;
+	hist->count++;
+	if (cycles < hist->min) hist->min = cycles;
+	if (cycles > hist->max) hist->max = cycles;
+}
+
+void CanAL_Stats_Rx(TsCanALStatsState* state, const TsCanALRawFrame* frame) {
+	uint16_t index = CanAL_FindFrameCodec(frame->id, frame->ide);
+
+	state->totals.rxFrames++;
+	state->totals.rxBytes += frame->dlc;
+	countFrame(state, frame);
+
+	if (index != CANAL_NO_CODEC) state->idFrames[index]++;
+}
+
+void CanAL_Stats_Tx(TsCanALStatsState* state, const TsCanALRawFrame* frame) {
+	state->totals.txFrames++;
+	state->totals.txBytes += frame->dlc;
+	countFrame(state, frame);
+}
+
+void CanAL_Stats_IsrEntry(TsCanALStatsState* state) {
+	state->isrEntry = CANAL_STATS_CYCLES();
+	state->isrEntryValid = true;
+}
+
+void CanAL_Stats_IsrLatency(TsCanALStatsState* state) {
+	if (!state->isrEntryValid) return;
+
+	CanAL_Stats_Record(&state->totals.isrLatency, CANAL_STATS_CYCLES() - state->isrEntry);
+	state->isrEntryValid = false;
+}
+
+void CanAL_Stats_CloseWindow(TsCanALStatsState* state, TsCanALStats* snapshot, uint32_t nowMs,
+		uint32_t bitrate) {
+	uint32_t elapsed = nowMs - state->windowStartTick;
+	uint64_t bits = snapshot->busBits - state->windowStartBits;
+
+	if (elapsed == 0U) return;
+
+	// bits * 1000 permille / (bitrate bit/s * elapsed / 1000 s)
+	snapshot->busLoad = (bitrate == 0U) ? 0U :
+		(uint16_t)((bits * 1000000ULL) / ((uint64_t)bitrate * elapsed));
+	snapshot->windowMs = elapsed;
+	state->totals.busLoad = snapshot->busLoad;
+	state->totals.windowMs = elapsed;
+
+	// Each counter is a single word the rx interrupt only increments, so it
+	// can be read on its own without masking
+	for (uint16_t i = 0; i < CANAL_NUM_MESSAGES; i++) {
+		uint32_t frames = state->idFrames[i];
+
+		state->idRate[i] = ((frames - state->idWindowStart[i]) * 1000U) / elapsed;
+		state->idWindowStart[i] = frames;
+	}
+
+	state->windowStartBits = snapshot->busBits;
+	state->windowStartTick = nowMs;
+}
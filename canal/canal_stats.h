@@ -0,0 +1,161 @@
+/*
+ * canal_stats.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_STATS_H_
+#define INC_CANAL_STATS_H_
+
+// canal_stats keeps the bus-load, rate and timing counters of an instance. The
+// hooks canal places in its rx/tx paths compile to nothing unless
+// CANAL_STATS_MODE is enabled in canal_types.h. Cycle counts come from the DWT
+// cycle counter; define CANAL_STATS_CYCLES() before including canal to supply
+// another clock, e.g. on the host.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+#include "canal_dispatch.h"
+
+#ifndef CANAL_STATS_CYCLES
+#include "main.h"
+#define CANAL_STATS_CYCLES()			(DWT->CYCCNT)
+#endif // CANAL_STATS_CYCLES
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_STATS_HIST_BUCKETS is the number of log2 buckets in a cycle histogram.
+// Bucket i counts durations of [2^i, 2^(i+1)) cycles, the last one everything
+// longer.
+#define CANAL_STATS_HIST_BUCKETS		(16U)
+
+#if CANAL_STATS_MODE
+// CANAL_STATS_ISR_ENTRY stamps the start of the CAN rx interrupt. Place it first
+// in CANx_RX0_IRQHandler / CANx_RX1_IRQHandler to measure how long the HAL takes
+// to reach CanAL_Receive.
+#define CANAL_STATS_ISR_ENTRY(__can__)	CanAL_Stats_IsrEntry(&(__can__)->stats)
+#define CANAL_STATS_START(__var__)		uint32_t __var__ = CANAL_STATS_CYCLES()
+#define CANAL_STATS_STOP(__hist__, __var__) \
+	CanAL_Stats_Record((__hist__), CANAL_STATS_CYCLES() - (__var__))
+#define CANAL_STATS_RX(__state__, __frame__) CanAL_Stats_Rx((__state__), (__frame__))
+#define CANAL_STATS_TX(__state__, __frame__) CanAL_Stats_Tx((__state__), (__frame__))
+#define CANAL_STATS_MAILBOX_FULL(__state__) ((__state__)->totals.mailboxFull++)
+#define CANAL_STATS_ISR_LATENCY(__state__) CanAL_Stats_IsrLatency(__state__)
+#define CANAL_STATS_RESET(__state__, __now__) CanAL_Stats_Reset((__state__), (__now__))
+#else
+#define CANAL_STATS_ISR_ENTRY(__can__)
+#define CANAL_STATS_START(__var__)
+#define CANAL_STATS_STOP(__hist__, __var__)
+#define CANAL_STATS_RX(__state__, __frame__)
+#define CANAL_STATS_TX(__state__, __frame__)
+#define CANAL_STATS_MAILBOX_FULL(__state__)
+#define CANAL_STATS_ISR_LATENCY(__state__)
+#define CANAL_STATS_RESET(__state__, __now__)
+#endif // CANAL_STATS_MODE
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+typedef struct {
+	uint32_t buckets[CANAL_STATS_HIST_BUCKETS];
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+}TsCanALCycleHist;
+
+// TsCanALStats is the snapshot returned by CanAL_GetStats. Frames are counted
+// when they are read from a FIFO or loaded into a mailbox, so the bus load
+// only covers what this node sends and accepts through its filters.
+typedef struct {
+	uint32_t rxFrames;
+	uint32_t rxBytes;
+	uint32_t txFrames;
+	uint32_t txBytes;
+	// busBits is the worst case number of bits on the wire, stuff bits included
+	uint64_t busBits;
+	// mailboxFull counts the frames that found every tx mailbox busy
+	uint32_t mailboxFull;
+	// busLoad is the permille of the bitrate used during the last window
+	uint16_t busLoad;
+	// windowMs is the length of the last window, i.e. the time between the last
+	// two CanAL_GetStats calls
+	uint32_t windowMs;
+	// rxCycles and txCycles time CanAL_Receive and CanAL_Transmit, isrLatency
+	// times CANAL_STATS_ISR_ENTRY to CanAL_Receive
+	TsCanALCycleHist rxCycles;
+	TsCanALCycleHist txCycles;
+	TsCanALCycleHist isrLatency;
+}TsCanALStats;
+
+// TsCanALIdRate is the receive count and rate of a single message
+typedef struct {
+	uint32_t frames;
+	// rateHz is the receive rate over the last window
+	uint32_t rateHz;
+}TsCanALIdRate;
+
+// TsCanALStatsState is owned by canal and must not be modified by the application
+typedef struct {
+	TsCanALStats totals;
+	uint64_t windowStartBits;
+	uint32_t windowStartTick;
+	uint32_t isrEntry;
+	bool isrEntryValid;
+	// idFrames, idWindowStart and idRate are indexed like CANAL_CODEC_TABLE
+	uint32_t idFrames[CANAL_NUM_MESSAGES];
+	uint32_t idWindowStart[CANAL_NUM_MESSAGES];
+	uint32_t idRate[CANAL_NUM_MESSAGES];
+}TsCanALStatsState;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Stats_FrameBits returns the worst case length in bits of a data frame
+// with dlc bytes, including stuff bits and the 3 bit interframe space
+uint32_t CanAL_Stats_FrameBits(uint8_t ide, uint8_t dlc);
+void CanAL_Stats_Reset(TsCanALStatsState* state, uint32_t nowMs);
+void CanAL_Stats_Record(TsCanALCycleHist* hist, uint32_t cycles);
+void CanAL_Stats_Rx(TsCanALStatsState* state, const TsCanALRawFrame* frame);
+void CanAL_Stats_Tx(TsCanALStatsState* state, const TsCanALRawFrame* frame);
+void CanAL_Stats_IsrEntry(TsCanALStatsState* state);
+void CanAL_Stats_IsrLatency(TsCanALStatsState* state);
+// CanAL_Stats_CloseWindow updates busLoad and the per message rates from the
+// traffic since the previous call and starts a new window. snapshot is a copy
+// of state->totals taken with interrupts masked; its busLoad and windowMs are
+// filled in. It is called from the main loop with interrupts enabled.
+void CanAL_Stats_CloseWindow(TsCanALStatsState* state, TsCanALStats* snapshot, uint32_t nowMs,
+		uint32_t bitrate);
+
+#endif /* INC_CANAL_STATS_H_ */
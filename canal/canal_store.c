@@ -0,0 +1,134 @@
+/*
+ * canal_store.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <string.h>
+#include "canal.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+#define CANAL_NO_SLOT					(0xFFFFU)
+
+// The slots are laid out contiguously in CANAL_CODEC_TABLE order, skipping
+// the messages that are only sent
+static TsCanALStoreEntry store[CANAL_NUM_RX_MESSAGES];
+static uint16_t storeSlot[CANAL_NUM_MESSAGES];
+static bool storeSlotsBuilt = false;
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+void CanAL_Store_Init(void) {
+	uint16_t slot = 0;
+
+	for (uint16_t i = 0; i < CANAL_NUM_MESSAGES; i++) {
+		storeSlot[i] = CANAL_CODEC_TABLE[i].rx ? slot++ : CANAL_NO_SLOT;
+	}
+
+	storeSlotsBuilt = true;
+}
+
+TsCanALStoreEntry* CanAL_Store_BeginWrite(uint16_t index) {
+	TsCanALStoreEntry* entry;
+
+	if ((index >= CANAL_NUM_MESSAGES) || (storeSlot[index] == CANAL_NO_SLOT)) return NULL;
+
+	entry = &store[storeSlot[index]];
+	entry->seq++;
+	// Readers must see the odd sequence before any of the new payload
+	__DMB();
+
+	return entry;
+}
+
+void CanAL_Store_EndWrite(TsCanALStoreEntry* entry, uint32_t timestamp, uint32_t tick) {
+	entry->tick = tick;
+	entry->timestamp = timestamp;
+
+	__DMB();
+	entry->seq++;
+}
+
+void CanAL_Store_Write(uint16_t index, const TsCanALRawFrame* frame, uint32_t tick) {
+	TsCanALStoreEntry* entry;
+	// The rx interrupt writes the same slots without masking, so it must not
+	// run in the middle of this write
+	uint32_t primask = CanAL_EnterCritical();
+
+	entry = CanAL_Store_BeginWrite(index);
+	if (entry != NULL) {
+		memcpy(entry->data, frame->data, sizeof(entry->data));
+		entry->dlc = frame->dlc;
+		CanAL_Store_EndWrite(entry, frame->timestamp, tick);
+	}
+
+	CanAL_ExitCritical(primask);
+}
+
+TeCanALRet CanAL_Store_Read(uint32_t ID, TsCanALStoreSnapshot* snapshot) {
+	uint16_t index = CanAL_FindCodec(ID);
+	const TsCanALStoreEntry* entry;
+	uint32_t seq;
+
+	if (snapshot == NULL) return CANAL_ERROR;
+
+	if (!storeSlotsBuilt) CanAL_Store_Init();
+
+	if ((index == CANAL_NO_CODEC) || (storeSlot[index] == CANAL_NO_SLOT)) {
+		return CANAL_UNSUPPORTED_RX_MESSAGE;
+	}
+
+	entry = &store[storeSlot[index]];
+
+	// Retry until no write started or finished while the slot was copied
+	do {
+		do {
+			seq = entry->seq;
+		} while ((seq & 1U) != 0U);
+
+		__DMB();
+		memcpy(snapshot->data, entry->data, sizeof(snapshot->data));
+		snapshot->dlc = entry->dlc;
+		snapshot->tick = entry->tick;
+		snapshot->timestamp = entry->timestamp;
+		__DMB();
+	} while (entry->seq != seq);
+
+	snapshot->generation = seq / 2U;
+
+	if (snapshot->generation == 0U) return CANAL_STORE_EMPTY;
+
+	return CANAL_OK;
+}
@@ -0,0 +1,109 @@
+/*
+ * canal_store.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_STORE_H_
+#define INC_CANAL_STORE_H_
+
+// canal_store keeps the latest raw payload of every message in
+// CANAL_CODEC_TABLE that this board receives. The rx interrupt reads each frame
+// from the FIFO mailbox registers straight into the message's slot and readers
+// get a consistent copy through a per-slot sequence counter (seqlock). Neither
+// side masks interrupts. Slots are one D-cache line each so a hot message never
+// shares a line with the slot being written, and messages that are only sent
+// have no slot.
+//
+// The store only covers the raw payload. In CANAL_RX_MODE_IMMEDIATE the
+// generated global structs are still written by the unmarshallers from the rx
+// interrupt, so a main loop reading a multi-signal struct can see half of one
+// frame and half of the next. Read through CanAL_Store_Read (or decode in
+// CANAL_RX_MODE_DEFERRED) wherever signals must come from the same frame.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include "canal_types.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_STORE_LINE_SIZE is the Cortex-M7 D-cache line size
+#define CANAL_STORE_LINE_SIZE			(32U)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// TsCanALStoreEntry is odd while a frame is being written to it
+typedef struct {
+	volatile uint32_t seq;
+	uint32_t tick;
+	uint32_t timestamp;
+	uint8_t data[8];
+	uint8_t dlc;
+}__attribute__((aligned(CANAL_STORE_LINE_SIZE))) TsCanALStoreEntry;
+
+// TsCanALStoreSnapshot is a consistent copy of a store slot. generation counts
+// the frames received for the message, so a reader can tell that nothing new
+// has arrived since its last read. timestamp is the bus time of the frame, see
+// TsCanALRawFrame.
+typedef struct {
+	uint8_t data[8];
+	uint8_t dlc;
+	uint32_t tick;
+	uint32_t timestamp;
+	uint32_t generation;
+}TsCanALStoreSnapshot;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Store_Init gives every message in CANAL_CODEC_TABLE with the rx flag
+// a slot. Called by CanAL_Init.
+void CanAL_Store_Init(void);
+// CanAL_Store_BeginWrite returns the slot of the message at index in
+// CANAL_CODEC_TABLE with its sequence made odd, or NULL if the message has no
+// slot. The caller fills data and dlc and then calls CanAL_Store_EndWrite.
+// Writers of one slot must not preempt each other: the rx interrupts of every
+// instance that receives the same message need the same priority, and writers
+// outside them use CanAL_Store_Write.
+TsCanALStoreEntry* CanAL_Store_BeginWrite(uint16_t index);
+void CanAL_Store_EndWrite(TsCanALStoreEntry* entry, uint32_t timestamp, uint32_t tick);
+// CanAL_Store_Write copies a whole frame into the slot of index with
+// interrupts masked, for writers that the rx interrupt can preempt
+void CanAL_Store_Write(uint16_t index, const TsCanALRawFrame* frame, uint32_t tick);
+// CanAL_Store_Read copies the latest payload of ID into snapshot. Returns
+// CANAL_STORE_EMPTY if the message has not been received yet and
+// CANAL_UNSUPPORTED_RX_MESSAGE if this board does not receive it.
+TeCanALRet CanAL_Store_Read(uint32_t ID, TsCanALStoreSnapshot* snapshot);
+
+#endif /* INC_CANAL_STORE_H_ */
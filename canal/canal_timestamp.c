@@ -0,0 +1,175 @@
+/*
+ * canal_timestamp.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include "canal.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+#define CAPTURE_RANGE				(0x10000U)
+
+// frameEndBits is the unstuffed length of a data frame from start of frame to
+// the end of EOF
+static inline uint32_t frameEndBits(uint8_t ide, uint8_t dlc) {
+	if (dlc > 8U) dlc = 8U;
+
+	return ((ide == CAN_ID_EXT) ? 64U : 44U) + (8U * dlc);
+}
+
+static inline uint8_t mailboxIndex(uint32_t mailbox) {
+	if (mailbox == CAN_TX_MAILBOX0) return 0;
+	if (mailbox == CAN_TX_MAILBOX1) return 1;
+
+	return 2;
+}
+
+// cyclesAt maps a bus time onto the cycle counter through the reference pair
+static inline uint32_t cyclesAt(const TsCanALTimestampState* state, uint32_t bits) {
+	return state->refCycles + ((bits - state->refBits) * state->cyclesPerBit);
+}
+
+// sinceCycles returns how many cycles after the bus time bits the cycle count
+// cycles is, clamped at 0
+static inline uint32_t sinceCycles(const TsCanALTimestampState* state, uint32_t bits,
+		uint32_t cycles) {
+	int32_t delta = (int32_t)(cycles - cyclesAt(state, bits));
+
+	return (delta > 0) ? (uint32_t)delta : 0U;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+void CanAL_Timestamp_Reset(TsCanALTimestampState* state, uint32_t baudKbps, uint32_t coreHz) {
+	*state = (TsCanALTimestampState){0};
+	state->baudKbps = baudKbps;
+	state->cyclesPerBit = (baudKbps != 0U) ? (coreHz / (baudKbps * 1000U)) : 0U;
+	state->latency.rxIsrDelay.min = UINT32_MAX;
+	state->latency.txQueueDelay.min = UINT32_MAX;
+	state->latency.txBusTime.min = UINT32_MAX;
+	state->latency.txIsrDelay.min = UINT32_MAX;
+}
+
+uint32_t CanAL_Timestamp_Extend(TsCanALTimestampState* state, uint16_t capture, uint32_t tickMs) {
+	uint32_t expected;
+	uint32_t extended;
+	// Both rx FIFOs and the tx mailboxes may have their own interrupt priority
+	uint32_t primask = CanAL_EnterCritical();
+
+	if (!state->valid) {
+		extended = capture;
+		state->valid = true;
+	} else {
+		// Put the capture in the counter period closest to where the tick says
+		// the bus should be by now
+		expected = state->last + ((tickMs - state->lastTick) * state->baudKbps);
+		extended = (expected & ~(CAPTURE_RANGE - 1U)) | capture;
+
+		if ((int32_t)(extended - expected) > (int32_t)(CAPTURE_RANGE / 2U)) {
+			extended -= CAPTURE_RANGE;
+		} else if ((int32_t)(expected - extended) > (int32_t)(CAPTURE_RANGE / 2U)) {
+			extended += CAPTURE_RANGE;
+		}
+	}
+
+	state->last = extended;
+	state->lastTick = tickMs;
+
+	CanAL_ExitCritical(primask);
+
+	return extended;
+}
+
+void CanAL_Timestamp_Rx(TsCanALTimestampState* state, TsCanALRawFrame* frame,
+		uint32_t tickMs, uint32_t cycles) {
+	uint32_t end;
+	int32_t delay;
+
+	frame->timestamp = CanAL_Timestamp_Extend(state, (uint16_t)frame->timestamp, tickMs);
+	end = frame->timestamp + frameEndBits(frame->ide, frame->dlc);
+
+	// A frame read quicker than the reference becomes the new reference. Both
+	// counters wrap modulo 2^32, so the distance to the reference never matters.
+	delay = (int32_t)(cycles - cyclesAt(state, end));
+	if (!state->refValid || (delay < 0)) {
+		state->refBits = end;
+		state->refCycles = cycles;
+		state->refValid = true;
+		delay = 0;
+	}
+
+	CanAL_Stats_Record(&state->latency.rxIsrDelay, (uint32_t)delay);
+}
+
+void CanAL_Timestamp_TxLoaded(TsCanALTimestampState* state, uint32_t mailbox,
+		const TsCanALRawFrame* frame, uint32_t submitted, uint32_t cycles) {
+	TsCanALTxInFlight* inFlight = &state->mailboxes[mailboxIndex(mailbox)];
+
+	inFlight->id = frame->id;
+	inFlight->ide = frame->ide;
+	inFlight->dlc = frame->dlc;
+	inFlight->submitted = submitted;
+	inFlight->loaded = cycles;
+	inFlight->busy = true;
+
+	CanAL_Stats_Record(&state->latency.txQueueDelay, cycles - submitted);
+}
+
+bool CanAL_Timestamp_TxComplete(TsCanALTimestampState* state, uint32_t mailbox,
+		uint16_t capture, uint32_t tickMs, uint32_t cycles, uint32_t* ID, uint32_t* timestamp) {
+	TsCanALTxInFlight* inFlight = &state->mailboxes[mailboxIndex(mailbox)];
+	uint32_t end;
+
+	if (!inFlight->busy) return false;
+
+	inFlight->busy = false;
+
+	*ID = inFlight->id;
+	*timestamp = CanAL_Timestamp_Extend(state, capture, tickMs);
+
+	// Without a received frame the bus time cannot be placed on the cycle counter
+	if (!state->refValid) return true;
+
+	end = *timestamp + frameEndBits(inFlight->ide, inFlight->dlc);
+
+	CanAL_Stats_Record(&state->latency.txBusTime, cyclesAt(state, end) - inFlight->loaded);
+	CanAL_Stats_Record(&state->latency.txIsrDelay, sinceCycles(state, end, cycles));
+
+	return true;
+}
+
+void CanAL_Timestamp_TxAbort(TsCanALTimestampState* state, uint32_t mailbox) {
+	state->mailboxes[mailboxIndex(mailbox)].busy = false;
+}
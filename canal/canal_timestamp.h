@@ -0,0 +1,147 @@
+/*
+ * canal_timestamp.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_TIMESTAMP_H_
+#define INC_CANAL_TIMESTAMP_H_
+
+// canal_timestamp turns the 16-bit bxCAN time-triggered counter, which counts
+// bit times and is captured at the start of frame of every received and sent
+// frame, into a 32-bit bus time, and breaks the path of a frame down into
+// latencies. The hooks canal places in its rx/tx paths compile to nothing
+// unless CANAL_TIMESTAMP_MODE is enabled in canal_types.h.
+//
+// The counter wraps every 65536 bit times (65.5 ms at 1 Mbit/s), so each
+// capture is extended against the time HAL_GetTick says has passed since the
+// previous one. Latencies are measured in CANAL_STATS_CYCLES(); the bus time is
+// tied to the cycle counter by the received frame that was read the quickest,
+// so the rx ISR delay is the delay beyond the fastest one seen. The frame end
+// is taken as the start of frame plus the unstuffed frame length, so stuff
+// bits show up in the ISR delays.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+#include "canal_stats.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+#define CANAL_TIMESTAMP_MAILBOXES		(3U)
+
+#if CANAL_TIMESTAMP_MODE
+#define CANAL_TIMESTAMP_NOW()			CANAL_STATS_CYCLES()
+#define CANAL_TIMESTAMP_RX(__state__, __frame__) \
+	CanAL_Timestamp_Rx((__state__), (__frame__), HAL_GetTick(), CANAL_STATS_CYCLES())
+#define CANAL_TIMESTAMP_TX_LOADED(__state__, __mailbox__, __frame__, __submitted__) \
+	CanAL_Timestamp_TxLoaded((__state__), (__mailbox__), (__frame__), (__submitted__), \
+		CANAL_STATS_CYCLES())
+#define CANAL_TIMESTAMP_RESET(__state__, __baud__) \
+	CanAL_Timestamp_Reset((__state__), (__baud__), SystemCoreClock)
+#else
+#define CANAL_TIMESTAMP_NOW()			(0U)
+#define CANAL_TIMESTAMP_RX(__state__, __frame__)
+#define CANAL_TIMESTAMP_TX_LOADED(__state__, __mailbox__, __frame__, __submitted__) \
+	((void)(__submitted__))
+#define CANAL_TIMESTAMP_RESET(__state__, __baud__)
+#endif // CANAL_TIMESTAMP_MODE
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// TsCanALLatency is the report returned by CanAL_GetLatency, in CPU cycles
+typedef struct {
+	// rxIsrDelay is the end of a received frame to canal reading it
+	TsCanALCycleHist rxIsrDelay;
+	// txQueueDelay is CanAL_Transmit to the frame entering a tx mailbox
+	TsCanALCycleHist txQueueDelay;
+	// txBusTime is the frame entering a tx mailbox to the end of the frame on
+	// the bus, i.e. lost arbitration plus the frame itself
+	TsCanALCycleHist txBusTime;
+	// txIsrDelay is the end of a sent frame to CanAL_TxMailboxComplete
+	TsCanALCycleHist txIsrDelay;
+}TsCanALLatency;
+
+// TsCanALTxInFlight remembers the frame sitting in a tx mailbox
+typedef struct {
+	uint32_t id;
+	uint8_t ide;
+	uint8_t dlc;
+	bool busy;
+	uint32_t submitted;
+	uint32_t loaded;
+}TsCanALTxInFlight;
+
+// TsCanALTimestampState is owned by canal and must not be modified by the
+// application
+typedef struct {
+	// last is the latest extended capture and lastTick when it was taken
+	uint32_t last;
+	uint32_t lastTick;
+	bool valid;
+	// refBits and refCycles pair a bus time with the cycle counter
+	uint32_t refBits;
+	uint32_t refCycles;
+	bool refValid;
+	uint32_t baudKbps;
+	uint32_t cyclesPerBit;
+	TsCanALTxInFlight mailboxes[CANAL_TIMESTAMP_MAILBOXES];
+	TsCanALLatency latency;
+}TsCanALTimestampState;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+void CanAL_Timestamp_Reset(TsCanALTimestampState* state, uint32_t baudKbps, uint32_t coreHz);
+// CanAL_Timestamp_Extend returns the 32-bit bus time of a 16-bit capture taken
+// at tickMs
+uint32_t CanAL_Timestamp_Extend(TsCanALTimestampState* state, uint16_t capture, uint32_t tickMs);
+// CanAL_Timestamp_Rx replaces the raw capture in frame->timestamp with the
+// extended one and records the rx ISR delay
+void CanAL_Timestamp_Rx(TsCanALTimestampState* state, TsCanALRawFrame* frame,
+		uint32_t tickMs, uint32_t cycles);
+// CanAL_Timestamp_TxLoaded records the frame loaded into mailbox
+// (CAN_TX_MAILBOXx) and its queue delay
+void CanAL_Timestamp_TxLoaded(TsCanALTimestampState* state, uint32_t mailbox,
+		const TsCanALRawFrame* frame, uint32_t submitted, uint32_t cycles);
+// CanAL_Timestamp_TxComplete records the bus time and ISR delay of the frame
+// that left mailbox with the given capture. It returns false if no frame was
+// recorded for the mailbox, otherwise the ID and extended bus time are set.
+bool CanAL_Timestamp_TxComplete(TsCanALTimestampState* state, uint32_t mailbox,
+		uint16_t capture, uint32_t tickMs, uint32_t cycles, uint32_t* ID, uint32_t* timestamp);
+// CanAL_Timestamp_TxAbort forgets the frame in mailbox
+void CanAL_Timestamp_TxAbort(TsCanALTimestampState* state, uint32_t mailbox);
+
+#endif /* INC_CANAL_TIMESTAMP_H_ */
@@ -0,0 +1,330 @@
+/*
+ * canal_trace.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <string.h>
+#include "canal.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+#define TRACE_MASK					(CANAL_TRACE_SIZE - 1U)
+
+static inline uint8_t traceByte(const TsCanALTrace* trace, uint32_t pos) {
+	return trace->buffer[pos & TRACE_MASK];
+}
+
+// recordLength walks the record starting at pos
+static uint32_t recordLength(const TsCanALTrace* trace, uint32_t pos) {
+	uint8_t header = traceByte(trace, pos);
+	uint8_t dlc = header & CANAL_TRACE_DLC_MASK;
+	uint32_t len = 1U;
+
+	while ((traceByte(trace, pos + len) & 0x80U) != 0U) len++;
+	len++;
+
+	len += ((header & CANAL_TRACE_FLAG_EXT) != 0U) ? 4U : 2U;
+	len += (dlc > 8U) ? 8U : dlc;
+
+	return len;
+}
+
+// readRecord copies the record at pos out of the ring and decodes it
+static uint32_t readRecord(const TsCanALTrace* trace, uint32_t pos, TsCanALTraceRecord* record) {
+	uint8_t bytes[CANAL_TRACE_MAX_RECORD];
+	uint32_t len = recordLength(trace, pos);
+
+	for (uint32_t i = 0; i < len; i++) bytes[i] = traceByte(trace, pos + i);
+
+	return CanAL_Trace_DecodeRecord(bytes, len, record);
+}
+
+static void writeBytes(TsCanALTrace* trace, uint32_t pos, const uint8_t* data, uint32_t len) {
+	uint32_t first = CANAL_TRACE_SIZE - (pos & TRACE_MASK);
+
+	if (first > len) first = len;
+	memcpy(&trace->buffer[pos & TRACE_MASK], data, first);
+	memcpy(trace->buffer, &data[first], len - first);
+}
+
+// evictOldest drops the record at tail. Its delta is added to the record after
+// it, which is rewritten to end where it did; a longer delta encoding starts it
+// inside the space of the evicted record, which is always large enough. If the
+// ring is left empty the delta is returned for the record being added instead.
+static uint32_t evictOldest(TsCanALTrace* trace) {
+	TsCanALTraceRecord evicted;
+	TsCanALTraceRecord next;
+	uint8_t bytes[CANAL_TRACE_MAX_RECORD];
+	uint32_t pos = trace->tail + readRecord(trace, trace->tail, &evicted);
+	uint32_t end;
+	uint32_t len;
+
+	if (pos == trace->head) {
+		trace->tail = pos;
+		return evicted.deltaUs;
+	}
+
+	end = pos + readRecord(trace, pos, &next);
+	next.deltaUs += evicted.deltaUs;
+	len = CanAL_Trace_EncodeRecord(&next, bytes);
+
+	writeBytes(trace, end - len, bytes, len);
+	trace->tail = end - len;
+
+	return 0;
+}
+
+// makeRoom frees len bytes, evicting the oldest records in overwrite mode.
+// carried is the delta of evicted records that must be added to the new one.
+static bool makeRoom(TsCanALTrace* trace, uint32_t len, uint32_t* carried) {
+	*carried = 0;
+
+	if ((CANAL_TRACE_SIZE - (trace->head - trace->tail)) >= len) return true;
+
+	// The drain is reading from tail, so nothing can be evicted until it is done
+	if ((trace->mode != CANAL_TRACE_OVERWRITE) || trace->draining) return false;
+
+	while ((CANAL_TRACE_SIZE - (trace->head - trace->tail)) < len) {
+		*carried += evictOldest(trace);
+	}
+
+	return true;
+}
+
+static uint32_t traceNow(const TsCanALTrace* trace) {
+	if (trace->clockUs != NULL) return trace->clockUs();
+
+	return HAL_GetTick() * 1000U;
+}
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+TeCanALRet CanAL_Trace_Init(TsCanALTrace* trace, TeCanALTraceMode mode,
+		CanALClockUs* clockUs) {
+	if (trace == NULL) return CANAL_NULL_REF;
+
+	if ((mode != CANAL_TRACE_STOP_ON_FULL) && (mode != CANAL_TRACE_OVERWRITE)) {
+		return CANAL_UNSUPPORTED_MODE;
+	}
+
+	trace->head = 0;
+	trace->tail = 0;
+	trace->state = CANAL_TRACE_STOPPED;
+	trace->draining = false;
+	trace->mode = mode;
+	trace->triggerId = CANAL_TRACE_NO_TRIGGER;
+	trace->triggerIde = CAN_ID_STD;
+	trace->postTrigger = 0;
+	trace->remaining = 0;
+	trace->triggered = false;
+	trace->clockUs = clockUs;
+	trace->lastTimestamp = 0;
+	trace->recorded = 0;
+	trace->dropped = 0;
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Trace_SetTrigger(TsCanALTrace* trace, uint32_t ID, uint8_t ide,
+		uint32_t postTrigger) {
+	uint32_t primask;
+
+	if (trace == NULL) return CANAL_NULL_REF;
+
+	primask = CanAL_EnterCritical();
+	trace->triggerId = ID;
+	trace->triggerIde = ide;
+	trace->postTrigger = postTrigger;
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Trace_Start(TsCanALTrace* trace) {
+	uint32_t primask;
+
+	if (trace == NULL) return CANAL_NULL_REF;
+
+	// A drain in progress would advance tail past the emptied ring
+	if (trace->draining) return CANAL_ERROR;
+
+	primask = CanAL_EnterCritical();
+	trace->head = 0;
+	trace->tail = 0;
+	trace->triggered = false;
+	trace->remaining = 0;
+	trace->recorded = 0;
+	trace->dropped = 0;
+	trace->lastTimestamp = traceNow(trace);
+	trace->state = ((trace->triggerId != CANAL_TRACE_NO_TRIGGER) &&
+		(trace->mode == CANAL_TRACE_STOP_ON_FULL)) ? CANAL_TRACE_ARMED : CANAL_TRACE_RECORDING;
+	CanAL_ExitCritical(primask);
+
+	return CANAL_OK;
+}
+
+TeCanALRet CanAL_Trace_Stop(TsCanALTrace* trace) {
+	if (trace == NULL) return CANAL_NULL_REF;
+
+	trace->state = CANAL_TRACE_STOPPED;
+
+	return CANAL_OK;
+}
+
+void CanAL_Trace_Record(TsCanALTrace* trace, const TsCanALRawFrame* frame,
+		uint8_t bus, bool tx) {
+	TsCanALTraceRecord record;
+	uint8_t bytes[CANAL_TRACE_MAX_RECORD];
+	uint32_t primask;
+	uint32_t now;
+	uint32_t len;
+	uint32_t carried;
+	bool isTrigger;
+
+	if (trace->state == CANAL_TRACE_STOPPED) return;
+
+	// Both directions on every instance may record, from main loop and interrupts
+	primask = CanAL_EnterCritical();
+
+	isTrigger = !trace->triggered && (frame->id == trace->triggerId) &&
+		(frame->ide == trace->triggerIde);
+
+	if ((trace->state == CANAL_TRACE_STOPPED) ||
+		((trace->state == CANAL_TRACE_ARMED) && !isTrigger)) {
+		CanAL_ExitCritical(primask);
+		return;
+	}
+
+	if (isTrigger) {
+		trace->state = CANAL_TRACE_RECORDING;
+		trace->triggered = true;
+		trace->remaining = trace->postTrigger;
+	}
+
+	now = traceNow(trace);
+	record.deltaUs = now - trace->lastTimestamp;
+	record.frame = *frame;
+	record.bus = bus;
+	record.tx = tx;
+	len = CanAL_Trace_EncodeRecord(&record, bytes);
+
+	if (!makeRoom(trace, len, &carried)) {
+		trace->dropped++;
+		if (trace->mode == CANAL_TRACE_STOP_ON_FULL) trace->state = CANAL_TRACE_STOPPED;
+		CanAL_ExitCritical(primask);
+		return;
+	}
+
+	// Everything was evicted, so the record now starts the ring and carries
+	// their time. The ring is empty, so the longer record fits.
+	if (carried != 0U) {
+		record.deltaUs += carried;
+		len = CanAL_Trace_EncodeRecord(&record, bytes);
+	}
+
+	// The delta of the next record is measured from the last one kept
+	trace->lastTimestamp = now;
+
+	writeBytes(trace, trace->head, bytes, len);
+	trace->head += len;
+	trace->recorded++;
+
+	if (trace->triggered && (trace->remaining != 0U) && (--trace->remaining == 0U)) {
+		trace->state = CANAL_TRACE_STOPPED;
+	}
+
+	CanAL_ExitCritical(primask);
+}
+
+TeCanALRet CanAL_Trace_Drain(TsCanALTrace* trace, CanALTraceSink* sink, void* ctx,
+		uint16_t maxBytes, uint16_t* drained) {
+	TeCanALRet ret = CANAL_OK;
+	uint32_t primask;
+	uint32_t start;
+	uint32_t end;
+	uint32_t len;
+	uint32_t first;
+
+	if (trace == NULL) return CANAL_NULL_REF;
+
+	if ((sink == NULL) || (maxBytes < CANAL_TRACE_MAX_RECORD)) return CANAL_ERROR;
+
+	if (drained != NULL) *drained = 0;
+
+	// Pick whole records so tail stays on a record boundary, and stop overwrite
+	// mode from evicting them while sink runs
+	primask = CanAL_EnterCritical();
+	start = trace->tail;
+	end = start;
+	while (end != trace->head) {
+		len = recordLength(trace, end);
+		if ((end - start + len) > maxBytes) break;
+		end += len;
+	}
+	trace->draining = (end != start);
+	CanAL_ExitCritical(primask);
+
+	if (end == start) return CANAL_OK;
+
+	len = end - start;
+	first = CANAL_TRACE_SIZE - (start & TRACE_MASK);
+	if (first > len) first = len;
+
+	ret = sink(ctx, &trace->buffer[start & TRACE_MASK], (uint16_t)first);
+	if ((ret == CANAL_OK) && (len > first)) {
+		ret = sink(ctx, trace->buffer, (uint16_t)(len - first));
+	}
+
+	// A failed sink leaves the records to be sent again
+	primask = CanAL_EnterCritical();
+	if (ret == CANAL_OK) trace->tail = end;
+	trace->draining = false;
+	CanAL_ExitCritical(primask);
+
+	if ((ret == CANAL_OK) && (drained != NULL)) *drained = (uint16_t)len;
+
+	return ret;
+}
+
+TeCanALRet CanAL_Trace_UartSink(void* ctx, const uint8_t* data, uint16_t len) {
+	if (ctx == NULL) return CANAL_ERROR;
+
+	if (HAL_UART_Transmit((UART_HandleTypeDef*)ctx, (uint8_t*)data, len,
+		CANAL_TRACE_UART_TIMEOUT_MS) != HAL_OK) {
+		return CANAL_ERROR;
+	}
+
+	return CANAL_OK;
+}
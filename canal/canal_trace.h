@@ -0,0 +1,149 @@
+/*
+ * canal_trace.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_TRACE_H_
+#define INC_CANAL_TRACE_H_
+
+// canal_trace records every frame a TsCanAL sends or receives into a RAM ring
+// of compact binary records. Recording is cheap enough for the rx interrupt;
+// CanAL_Trace_Drain streams the ring out later from a low priority context.
+//
+// The record layout is described in canal_trace_codec.h. The first delta is
+// measured from CanAL_Trace_Start; when overwrite mode evicts records their
+// deltas are folded into the oldest record kept, so the deltas of a drained
+// stream always add up to the time since the start. tools/canal_trace_dump.c
+// turns a captured stream into candump or Vector ASC text.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+#include "canal_trace_codec.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// CANAL_TRACE_SIZE is the ring size in bytes. It must be a power of 2.
+#ifndef CANAL_TRACE_SIZE
+#define CANAL_TRACE_SIZE				(4096U)
+#endif // CANAL_TRACE_SIZE
+
+#if (CANAL_TRACE_SIZE & (CANAL_TRACE_SIZE - 1U)) != 0U
+#error "CANAL_TRACE_SIZE must be a power of 2"
+#endif
+
+#define CANAL_TRACE_NO_TRIGGER			(0xFFFFFFFFU)
+
+#ifndef CANAL_TRACE_UART_TIMEOUT_MS
+#define CANAL_TRACE_UART_TIMEOUT_MS		(100U)
+#endif // CANAL_TRACE_UART_TIMEOUT_MS
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// TeCanALTraceMode selects what happens when a record does not fit
+typedef enum {
+	// CANAL_TRACE_STOP_ON_FULL keeps the oldest records and stops recording
+	CANAL_TRACE_STOP_ON_FULL = 0,
+	// CANAL_TRACE_OVERWRITE drops the oldest records to make room. While a drain
+	// is in progress the new record is dropped instead.
+	CANAL_TRACE_OVERWRITE,
+}TeCanALTraceMode;
+
+typedef enum {
+	CANAL_TRACE_STOPPED = 0,
+	// CANAL_TRACE_ARMED waits for the trigger ID before recording anything
+	CANAL_TRACE_ARMED,
+	CANAL_TRACE_RECORDING,
+}TeCanALTraceState;
+
+// CanALTraceSink receives drained bytes. Returning anything other than CANAL_OK
+// leaves the bytes in the ring to be drained again.
+typedef TeCanALRet CanALTraceSink(void* ctx, const uint8_t* data, uint16_t len);
+
+typedef struct {
+	uint8_t buffer[CANAL_TRACE_SIZE];
+	// head and tail are free running byte counts, tail is always on a record
+	// boundary
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile TeCanALTraceState state;
+	volatile bool draining;
+	TeCanALTraceMode mode;
+	// triggerId, triggerIde and postTrigger are set with CanAL_Trace_SetTrigger
+	uint32_t triggerId;
+	uint8_t triggerIde;
+	uint32_t postTrigger;
+	uint32_t remaining;
+	bool triggered;
+	CanALClockUs* clockUs;
+	uint32_t lastTimestamp;
+	uint32_t recorded;
+	uint32_t dropped;
+}TsCanALTrace;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Trace_Init empties trace and leaves it stopped. clockUs provides the
+// record timestamps; NULL falls back to HAL_GetTick, which only has millisecond
+// resolution.
+TeCanALRet CanAL_Trace_Init(TsCanALTrace* trace, TeCanALTraceMode mode,
+		CanALClockUs* clockUs);
+// CanAL_Trace_SetTrigger makes recording revolve around the first frame with
+// ID and ide (CAN_ID_STD or CAN_ID_EXT). In CANAL_TRACE_STOP_ON_FULL mode nothing is recorded before it; in
+// CANAL_TRACE_OVERWRITE mode the ring keeps the history leading up to it.
+// Recording stops postTrigger records after it (counting the trigger frame),
+// or never if postTrigger is 0. Pass CANAL_TRACE_NO_TRIGGER to record freely.
+TeCanALRet CanAL_Trace_SetTrigger(TsCanALTrace* trace, uint32_t ID, uint8_t ide,
+		uint32_t postTrigger);
+// CanAL_Trace_Start empties the ring, rearms the trigger and starts recording
+TeCanALRet CanAL_Trace_Start(TsCanALTrace* trace);
+TeCanALRet CanAL_Trace_Stop(TsCanALTrace* trace);
+// CanAL_Trace_Record appends frame to the ring. It is called by canal for every
+// frame of a TsCanAL the trace is attached to with CanAL_SetTrace; bus is the
+// TeCanALInstance of that TsCanAL.
+void CanAL_Trace_Record(TsCanALTrace* trace, const TsCanALRawFrame* frame,
+		uint8_t bus, bool tx);
+// CanAL_Trace_Drain hands up to maxBytes of whole records to sink. maxBytes must
+// be at least CANAL_TRACE_MAX_RECORD. The ring is not locked while sink runs,
+// so it may block (e.g. on a UART). drained is optional.
+TeCanALRet CanAL_Trace_Drain(TsCanALTrace* trace, CanALTraceSink* sink, void* ctx,
+		uint16_t maxBytes, uint16_t* drained);
+// CanAL_Trace_UartSink is a CanALTraceSink that writes to the
+// UART_HandleTypeDef passed as ctx
+TeCanALRet CanAL_Trace_UartSink(void* ctx, const uint8_t* data, uint16_t len);
+
+#endif /* INC_CANAL_TRACE_H_ */
@@ -0,0 +1,107 @@
+/*
+ * canal_trace_codec.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stddef.h>
+#include <string.h>
+#include "canal_trace_codec.h"
+
+/*********************************************************
+*              PUBLIC FUNCTION DEFINITIONS
+*********************************************************/
+
+uint32_t CanAL_Trace_EncodeRecord(const TsCanALTraceRecord* record, uint8_t* out) {
+	const TsCanALRawFrame* frame = &record->frame;
+	bool ext = (frame->ide == CAN_ID_EXT);
+	uint8_t dlc = (frame->dlc > 8U) ? 8U : frame->dlc;
+	uint32_t delta = record->deltaUs;
+	uint32_t len = 0;
+
+	out[len++] = dlc | (record->tx ? CANAL_TRACE_FLAG_TX : 0U) |
+		(ext ? CANAL_TRACE_FLAG_EXT : 0U) |
+		(uint8_t)(((record->bus - 1U) & 0x3U) << CANAL_TRACE_BUS_POS);
+
+	while (delta >= 0x80U) {
+		out[len++] = (uint8_t)(delta | 0x80U);
+		delta >>= 7;
+	}
+	out[len++] = (uint8_t)delta;
+
+	out[len++] = (uint8_t)frame->id;
+	out[len++] = (uint8_t)(frame->id >> 8);
+	if (ext) {
+		out[len++] = (uint8_t)(frame->id >> 16);
+		out[len++] = (uint8_t)(frame->id >> 24);
+	}
+
+	memcpy(&out[len], frame->data, dlc);
+
+	return len + dlc;
+}
+
+uint32_t CanAL_Trace_DecodeRecord(const uint8_t* data, uint32_t len,
+		TsCanALTraceRecord* record) {
+	uint32_t pos = 1U;
+	uint32_t shift = 0;
+	uint8_t header;
+	uint8_t idLen;
+
+	if ((data == NULL) || (record == NULL) || (len == 0U)) return 0;
+
+	header = data[0];
+	record->frame.dlc = header & CANAL_TRACE_DLC_MASK;
+	if (record->frame.dlc > 8U) record->frame.dlc = 8U;
+	record->frame.ide = ((header & CANAL_TRACE_FLAG_EXT) != 0U) ? CAN_ID_EXT : CAN_ID_STD;
+	record->tx = (header & CANAL_TRACE_FLAG_TX) != 0U;
+	record->bus = (uint8_t)((header >> CANAL_TRACE_BUS_POS) + 1U);
+
+	record->deltaUs = 0;
+	do {
+		if (pos >= len) return 0;
+		if (shift < 32U) record->deltaUs |= (uint32_t)(data[pos] & 0x7FU) << shift;
+		shift += 7U;
+	} while ((data[pos++] & 0x80U) != 0U);
+
+	idLen = (record->frame.ide == CAN_ID_EXT) ? 4U : 2U;
+	if ((len - pos) < ((uint32_t)idLen + record->frame.dlc)) return 0;
+
+	record->frame.id = 0;
+	for (uint8_t i = 0; i < idLen; i++) {
+		record->frame.id |= (uint32_t)data[pos++] << (8U * i);
+	}
+
+	record->frame.timestamp = 0;
+	memset(record->frame.data, 0, sizeof(record->frame.data));
+	memcpy(record->frame.data, &data[pos], record->frame.dlc);
+
+	return pos + record->frame.dlc;
+}
@@ -0,0 +1,97 @@
+/*
+ * canal_trace_codec.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+#ifndef INC_CANAL_TRACE_CODEC_H_
+#define INC_CANAL_TRACE_CODEC_H_
+
+// canal_trace_codec encodes and decodes the binary records of canal_trace.
+// Each record is laid out as:
+//   byte 0    bits 0-3 DLC, bit 4 tx, bit 5 extended ID, bits 6-7 CAN instance - 1
+//   delta     microseconds since the previous record, LEB128 (1 to 5 bytes)
+//   ID        2 bytes (standard) or 4 bytes (extended), little endian
+//   payload   DLC bytes
+// It only depends on canal_types.h so tools/canal_trace_dump.c and the host
+// tests can build it without the HAL.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canal_types.h"
+
+/*********************************************************
+*                       MACROS
+*********************************************************/
+
+// Host builds have no HAL, so give the codec the HAL values of the IDE field
+#ifndef CAN_ID_STD
+#define CAN_ID_STD						(0x00000000U)
+#endif // CAN_ID_STD
+#ifndef CAN_ID_EXT
+#define CAN_ID_EXT						(0x00000004U)
+#endif // CAN_ID_EXT
+
+#define CANAL_TRACE_DLC_MASK			(0x0FU)
+#define CANAL_TRACE_FLAG_TX				(0x10U)
+#define CANAL_TRACE_FLAG_EXT			(0x20U)
+#define CANAL_TRACE_BUS_POS				(6U)
+
+// CANAL_TRACE_MAX_RECORD is the longest record: header, 5 byte delta, extended
+// ID and 8 bytes of payload
+#define CANAL_TRACE_MAX_RECORD			(18U)
+
+/*********************************************************
+*                       TYPES
+*********************************************************/
+
+// TsCanALTraceRecord is a record decoded by CanAL_Trace_DecodeRecord
+typedef struct {
+	uint32_t deltaUs;
+	TsCanALRawFrame frame;
+	// bus is the TeCanALInstance the frame was recorded on
+	uint8_t bus;
+	bool tx;
+}TsCanALTraceRecord;
+
+/*********************************************************
+*               PUBLIC FUNCTION DECLARATIONS
+*********************************************************/
+
+// CanAL_Trace_EncodeRecord writes record to out, which must hold
+// CANAL_TRACE_MAX_RECORD bytes, and returns its length
+uint32_t CanAL_Trace_EncodeRecord(const TsCanALTraceRecord* record, uint8_t* out);
+// CanAL_Trace_DecodeRecord decodes the record at the start of data, which holds
+// len bytes of a drained stream. It returns the length of the record, or 0 if
+// data ends inside it.
+uint32_t CanAL_Trace_DecodeRecord(const uint8_t* data, uint32_t len,
+		TsCanALTraceRecord* record);
+
+#endif /* INC_CANAL_TRACE_CODEC_H_ */
@@ -30,7 +30,14 @@
 #ifndef INC_CANAL_TYPES_H_
 #define INC_CANAL_TYPES_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
+// Enable CANAL_DEBUG_MODE to print through CANAL_PRINT and to have every
+// decoded message printed with Print_Message
+#ifndef CANAL_DEBUG_MODE
 #define CANAL_DEBUG_MODE 0
+#endif // CANAL_DEBUG_MODE
 
 #if CANAL_DEBUG_MODE
 #define CANAL_PRINT printf
@@ -38,6 +45,19 @@
 #define CANAL_PRINT // Enable CANAL_DEBUG_MODE to print
 #endif // CANAL_DEBUG_MODE
 
+// Enable CANAL_STATS_MODE to keep the counters and cycle histograms returned by
+// CanAL_GetStats. With it disabled the hooks compile to nothing.
+#ifndef CANAL_STATS_MODE
+#define CANAL_STATS_MODE 0
+#endif // CANAL_STATS_MODE
+
+// Enable CANAL_TIMESTAMP_MODE to run the bxCAN in time triggered mode and stamp
+// every frame with its bus time, see canal_timestamp.h. Like CANAL_STATS_MODE,
+// its latencies are counted with CANAL_STATS_CYCLES().
+#ifndef CANAL_TIMESTAMP_MODE
+#define CANAL_TIMESTAMP_MODE 0
+#endif // CANAL_TIMESTAMP_MODE
+
 typedef enum {
 	// CANAL_UNKNOWN_RETURN indicates an initialized return code
 	CANAL_UNKOWN_RETURN = 0,
@@ -54,9 +74,9 @@ typedef enum {
 	// CANAL_UNSUPPORTED_MODE indicates that the selected can mode is not supported
 	// by the canal library
 	CANAL_UNSUPPORTED_MODE,
-	// CANAL_UNSUPPORTED_PCLK1_FREQ indicates that the Peripheral Clock 1 frequency
-	// is not in the CAN_BITRATE_TABLE (this is the clock that supports CAN 1-3).
-	// To add entries for the a given freq go to: http://www.bittiming.can-wiki.info/
+	// CANAL_UNSUPPORTED_PCLK1_FREQ indicates that the baud rate cannot be reached
+	// exactly from the Peripheral Clock 1 frequency (this is the clock that
+	// supports CAN 1-3). See http://www.bittiming.can-wiki.info/ for the options.
 	CANAL_UNSUPPORTED_PCLK1_FREQ,
 	// CANAL_UNSUPPORTED_RX_MESSAGE indicates that the message is not classified for
 	// receiving
@@ -76,6 +96,24 @@ typedef enum {
 	CANAL_CONFIG_FILTER_FAILED,
 	// CAN_GET_RXMESSAGE_FAILED indicates the HAL_CAN_GetRxMessage returned !OK
 	CANAL_GET_RXMESSAGE_FAILED,
+	// CANAL_RX_RING_FULL indicates that a received frame was dropped because the
+	// rx ring had no free slots (CanAL_ProcessRx is not being called often enough)
+	CANAL_RX_RING_FULL,
+	// CANAL_TX_QUEUE_FULL indicates that a frame was not accepted because every
+	// tx mailbox was busy and the software tx queue was full
+	CANAL_TX_QUEUE_FULL,
+	// CANAL_FILTER_TABLE_FULL indicates that there is no room left for another
+	// receive ID or filter bank
+	CANAL_FILTER_TABLE_FULL,
+	// CANAL_STORE_EMPTY indicates that the message has not been received yet
+	CANAL_STORE_EMPTY,
+	// CANAL_BUSY indicates that a transfer is already in progress
+	CANAL_BUSY,
+	// CANAL_TIMEOUT indicates that the other node did not answer in time
+	CANAL_TIMEOUT,
+	// CANAL_BUFFER_OVERFLOW indicates that the data does not fit the buffer it
+	// is meant for
+	CANAL_BUFFER_OVERFLOW,
 	// CAN_ERROR indicates a generic error has occurred
 	CANAL_ERROR,
 }TeCanALRet;
@@ -87,6 +125,18 @@ typedef enum {
     CANAL_LITTLE_ENDIAN,
 } TeCanALEndianness;
 
+// TsCanALRawFrame is a received or to-be-transmitted frame before any decoding.
+// ide holds CAN_ID_STD or CAN_ID_EXT.
+typedef struct {
+	uint32_t id;
+	uint8_t data[8];
+	uint8_t ide;
+	uint8_t dlc;
+	// timestamp is the bus time of the start of frame in bit times when
+	// CANAL_TIMESTAMP_MODE is enabled, 0 otherwise
+	uint32_t timestamp;
+}TsCanALRawFrame;
+
 // BinaryUnmarshaller gets raw bytes from CAN Rx and updates the
 // global struct instance with the associated CAN ID
 typedef TeCanALRet BinaryUnmarshaller(uint8_t*);
@@ -95,6 +145,15 @@ typedef TeCanALRet BinaryUnmarshaller(uint8_t*);
 // to prepare it for transmission
 typedef TeCanALRet BinaryMarshaller(uint8_t*);
 
+// CanALRxHook sees every accepted frame in the rx interrupt before it is decoded.
+// It returns true when it has passed the frame on (e.g. to another bus). Every
+// hook of an instance sees the frame; if any of them passed it on, the frame is
+// only decoded if this board has a codec for it.
+typedef bool CanALRxHook(void* ctx, const TsCanALRawFrame* frame);
+
+// CanALClockUs returns a free running microsecond count
+typedef uint32_t CanALClockUs(void);
+
 // CanALPrinter will print the message associated wiht the CAN ID
 typedef void CanALPrinter(void);
 
@@ -10,6 +10,8 @@
 #include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
 #include "printf.h"
 
 #if !defined(OS_USE_SEMIHOSTING)
@@ -21,6 +23,103 @@
 // Must be global
 UART_st* Printer;
 
+#if (PRINTF_BUFFER_SIZE & (PRINTF_BUFFER_SIZE - 1U)) != 0U
+#error "PRINTF_BUFFER_SIZE must be a power of 2"
+#endif
+
+#define PRINTF_BUFFER_MASK (PRINTF_BUFFER_SIZE - 1U)
+
+static TePrintf_Flush Flush_Policy = PRINTF_UNBUFFERED;
+
+// The stdout ring runs on free-running byte counts. Writers claim space by
+// moving Reserved and add what they copied to Committed once done, so the bytes
+// before Reserved are complete whenever the two are equal. Drained is only
+// moved by the one context that holds Draining.
+static uint8_t Stdout_Buf[PRINTF_BUFFER_SIZE];
+static atomic_uint Reserved;
+static atomic_uint Committed;
+static atomic_uint Drained;
+static atomic_flag Draining = ATOMIC_FLAG_INIT;
+static atomic_uint Dropped;
+static atomic_uint High_Water;
+
+// Printf_Drain hands the complete bytes of the ring to the uart tx ring. A
+// context that finds another one draining leaves its bytes to it.
+static void Printf_Drain(void) {
+
+  unsigned int committed;
+  unsigned int reserved;
+  unsigned int drained;
+  unsigned int chunk;
+
+  if (atomic_flag_test_and_set(&Draining))
+    return;
+
+  drained = atomic_load(&Drained);
+
+  for (;;) {
+    // Committed is read first, so equal counts mean no writer is mid-copy
+    committed = atomic_load(&Committed);
+    reserved = atomic_load(&Reserved);
+
+    if (committed != reserved || drained == reserved)
+      break;
+
+    // One contiguous span at a time
+    chunk = reserved - drained;
+    if (chunk > PRINTF_BUFFER_SIZE - (drained & PRINTF_BUFFER_MASK))
+      chunk = PRINTF_BUFFER_SIZE - (drained & PRINTF_BUFFER_MASK);
+
+    (void) UART_Transmit_Async(Printer, &Stdout_Buf[drained & PRINTF_BUFFER_MASK], chunk);
+
+    drained += chunk;
+    atomic_store(&Drained, drained);
+  }
+
+  atomic_flag_clear(&Draining);
+}
+
+// Printf_Write copies as much of ptr as fits into the ring and never waits
+static void Printf_Write(const char* ptr, unsigned int len) {
+
+  unsigned int reserved = atomic_load(&Reserved);
+  unsigned int pending;
+  unsigned int offset;
+  unsigned int first;
+  unsigned int n;
+  unsigned int high_water;
+
+  do {
+    n = PRINTF_BUFFER_SIZE - (reserved - atomic_load(&Drained));
+    if (n > len)
+      n = len;
+  } while (n != 0U && !atomic_compare_exchange_weak(&Reserved, &reserved, reserved + n));
+
+  if (n < len)
+    atomic_fetch_add(&Dropped, len - n);
+
+  offset = reserved & PRINTF_BUFFER_MASK;
+  first = PRINTF_BUFFER_SIZE - offset;
+  if (first > n)
+    first = n;
+
+  memcpy(&Stdout_Buf[offset], ptr, first);
+  memcpy(Stdout_Buf, &ptr[first], n - first);
+
+  atomic_fetch_add(&Committed, n);
+
+  pending = reserved + n - atomic_load(&Drained);
+  high_water = atomic_load(&High_Water);
+  while (pending > high_water) {
+    if (atomic_compare_exchange_weak(&High_Water, &high_water, pending))
+      break;
+  }
+
+  if ((Flush_Policy == PRINTF_FLUSH_NEWLINE && memchr(ptr, '\n', len) != NULL) ||
+      (Flush_Policy == PRINTF_FLUSH_THRESHOLD && pending >= PRINTF_FLUSH_THRESHOLD_BYTES))
+    Printf_Drain();
+}
+
 
 TeUART_Return Printf_Init(UART_st* uart) {
 
@@ -42,6 +141,45 @@ TeUART_Return Printf_Init(UART_st* uart) {
   return UART_OK;
 }
 
+TeUART_Return Printf_Init_Buffered(UART_st* uart, TePrintf_Flush flush) {
+
+  TeUART_Return response;
+  UART_Tx_Ring_st* ring;
+
+  if (flush > PRINTF_FLUSH_THRESHOLD)
+    return UART_INVALID_MODE;
+
+  // The drain needs the tx ring of the uart, and must never wait for it since
+  // it also runs in interrupts
+  ring = UART_Get_Tx_Ring(uart);
+  if (ring == NULL || ring->overflow == UART_OVERFLOW_BLOCK)
+    return UART_INVALID_MODE;
+
+  // Unlike Printf_Init, stdio keeps its own buffering so that a printf reaches
+  // the ring in whole writes rather than one call per fragment
+  Printer = uart;
+  response = UART_Init(uart);
+  if (response != UART_OK)
+    return response;
+
+  Flush_Policy = flush;
+
+  return UART_OK;
+}
+
+void Printf_Flush(void) {
+
+  if (Flush_Policy != PRINTF_UNBUFFERED)
+    Printf_Drain();
+}
+
+void Printf_Get_Stats(TsPrintf_Stats* stats) {
+
+  stats->pending = atomic_load(&Reserved) - atomic_load(&Drained);
+  stats->high_water = atomic_load(&High_Water);
+  stats->dropped = atomic_load(&Dropped);
+}
+
 int _isatty(int fd) {
 
   if (fd >= STDIN_FILENO && fd <= STDERR_FILENO)
@@ -56,6 +194,11 @@ int _write(int fd, char* ptr, int len) {
   TeUART_Return response;
 
   if (fd == STDOUT_FILENO || fd == STDERR_FILENO) {
+    if (Flush_Policy != PRINTF_UNBUFFERED) {
+      Printf_Write(ptr, (unsigned int) len);
+      return len;
+    }
+
     response = UART_Transmit(Printer, (uint8_t*) ptr, len);
 
     if (response == UART_OK)
@@ -8,7 +8,42 @@
 #include <sys/stat.h>
 #include "uart_lib.h"
 
+// Size of the buffered stdout ring, must be a power of two
+#ifndef PRINTF_BUFFER_SIZE
+#define PRINTF_BUFFER_SIZE (1024U)
+#endif
+
+// Waiting bytes that start a drain under PRINTF_FLUSH_THRESHOLD
+#ifndef PRINTF_FLUSH_THRESHOLD_BYTES
+#define PRINTF_FLUSH_THRESHOLD_BYTES (64U)
+#endif
+
+// Decides when buffered stdout hands its bytes to the uart
+typedef enum {
+  PRINTF_UNBUFFERED,      // Every write blocks in UART_Transmit
+  PRINTF_FLUSH_NEWLINE,   // Drain when a write ends a line
+  PRINTF_FLUSH_THRESHOLD  // Drain when PRINTF_FLUSH_THRESHOLD_BYTES are waiting
+} TePrintf_Flush;
+
+typedef struct {
+  uint32_t pending;
+  uint32_t high_water;
+  // Bytes dropped because the stdout ring was full. Bytes the uart tx ring
+  // drops are counted in its own statistics.
+  uint32_t dropped;
+} TsPrintf_Stats;
+
 TeUART_Return Printf_Init(UART_st* uart);
+// Printf_Init_Buffered makes stdout non-blocking. Writes are copied into a
+// lock-free ring that may be written from threads and interrupts alike, and
+// drained into the uart tx ring, which UART_Tx_Ring_Init must have set up with
+// UART_OVERFLOW_DROP or UART_OVERFLOW_OVERWRITE. stdio buffering is left as it
+// is, unlike Printf_Init which turns it off.
+TeUART_Return Printf_Init_Buffered(UART_st* uart, TePrintf_Flush flush);
+// Printf_Flush hands everything written so far to the uart. Call it from the
+// main loop so that partial lines and bytes below the threshold go out too.
+void Printf_Flush(void);
+void Printf_Get_Stats(TsPrintf_Stats* stats);
 int _isatty(int fd);
 int _write(int fd, char* ptr, int len);
 int _close(int fd);
@@ -10,6 +10,8 @@
 
 /*---------------------- MACROS ----------------------*/
 #define TIMEOUT (uint8_t)100
+// Largest transfer a single HAL call takes
+#define SPI_MAX_CHUNK (0xFFFFU)
 
 /*---------------------- PRIVATE FUNCTIONS ----------------------*/
 // SPI_Select configures the corresponding SPI number from a SPI_st
@@ -122,6 +124,50 @@ static TeSPI_Status SPI_MSB_Select(TsSPI* spi)
 	return SPI_OK;
 }
 
+// SPI_Timeout allows TIMEOUT plus the time len frames of up to 16 bits take at
+// the baud rate (in kHz, so bits per ms)
+static uint32_t SPI_Timeout(TsSPI* spi, uint32_t len)
+{
+	return TIMEOUT + ((len * 16U) / spi->baudrate);
+}
+
+// SPI_Transfer_Segment clocks one segment in HAL sized chunks without touching CS
+static TeSPI_Status SPI_Transfer_Segment(TsSPI* spi, const TsSPI_Iovec* seg)
+{
+	uint8_t* tx_buf = seg->tx_buf;
+	uint8_t* rx_buf = seg->rx_buf;
+	uint32_t len = seg->len;
+	uint32_t frame_size = (spi->hspi->Init.DataSize > SPI_DATASIZE_8BIT) ? 2U : 1U;
+	uint32_t chunk;
+	HAL_StatusTypeDef response;
+
+	while (len > 0U) {
+		chunk = (len > SPI_MAX_CHUNK) ? SPI_MAX_CHUNK : len;
+
+		if (rx_buf == NULL) {
+			response = HAL_SPI_Transmit(spi->hspi, tx_buf, (uint16_t)chunk, SPI_Timeout(spi, chunk));
+		} else if (tx_buf == NULL) {
+			response = HAL_SPI_Receive(spi->hspi, rx_buf, (uint16_t)chunk, SPI_Timeout(spi, chunk));
+		} else {
+			response = HAL_SPI_TransmitReceive(spi->hspi, tx_buf, rx_buf, (uint16_t)chunk, SPI_Timeout(spi, chunk));
+		}
+
+		if (response != HAL_OK) {
+			return (rx_buf == NULL) ? SPI_TRANSMIT_FAILED : SPI_RECEIVE_FAILED;
+		}
+
+		if (tx_buf != NULL) {
+			tx_buf += chunk * frame_size;
+		}
+		if (rx_buf != NULL) {
+			rx_buf += chunk * frame_size;
+		}
+		len -= chunk;
+	}
+
+	return SPI_OK;
+}
+
 // Current configurations that are not being modified
 static void SPI_Default_Configs(TsSPI* spi)
 {
@@ -180,30 +226,37 @@ TeSPI_Status SPI_Init(TsSPI* spi)
 	return SPI_OK;
 }
 
-TeSPI_Status SPI_Transmit(TsSPI* spi, uint8_t *tx_buf, uint8_t buf_len)
+TeSPI_Status SPI_Transmit(TsSPI* spi, uint8_t *tx_buf, uint32_t buf_len)
 {
-	HAL_StatusTypeDef tx_response;
+	TsSPI_Iovec seg = {.tx_buf = tx_buf, .rx_buf = NULL, .len = buf_len};
 
-	HAL_GPIO_WritePin(spi->cs_port, spi->pin, GPIO_PIN_RESET);
-	tx_response = HAL_SPI_Transmit(spi->hspi, (uint8_t *)tx_buf, buf_len, TIMEOUT);
-	HAL_GPIO_WritePin(spi->cs_port, spi->pin, GPIO_PIN_SET);
-	if (tx_response != HAL_OK) {
-		return SPI_TRANSMIT_FAILED;
-	}
-	return SPI_OK;
+	return SPI_Transfer_Vec(spi, &seg, 1U);
+}
+
+TeSPI_Status SPI_Transmit_Receive(TsSPI* spi, uint8_t *tx_buf, uint8_t *rx_buf, uint32_t buf_len)
+{
+	TsSPI_Iovec seg = {.tx_buf = tx_buf, .rx_buf = rx_buf, .len = buf_len};
+
+	return SPI_Transfer_Vec(spi, &seg, 1U);
 }
 
-TeSPI_Status SPI_Transmit_Receive(TsSPI* spi, uint8_t *tx_buf, uint8_t *rx_buf, uint8_t buf_len)
+TeSPI_Status SPI_Transfer_Vec(TsSPI* spi, const TsSPI_Iovec* iov, uint8_t iov_cnt)
 {
-	HAL_StatusTypeDef rx_response;
+	TeSPI_Status response = SPI_OK;
+
+	for (uint8_t i = 0; i < iov_cnt; i++) {
+		if ((iov[i].tx_buf == NULL) && (iov[i].rx_buf == NULL)) {
+			return SPI_INVALID_BUFFER;
+		}
+	}
 
 	HAL_GPIO_WritePin(spi->cs_port, spi->pin, GPIO_PIN_RESET);
-	rx_response = HAL_SPI_TransmitReceive(spi->hspi, (uint8_t *)tx_buf, (uint8_t *)rx_buf, buf_len, TIMEOUT);
-	HAL_GPIO_WritePin(spi->cs_port, spi->pin, GPIO_PIN_SET);
-	if (rx_response != HAL_OK) {
-		return SPI_RECEIVE_FAILED;
+	for (uint8_t i = 0; (i < iov_cnt) && (response == SPI_OK); i++) {
+		response = SPI_Transfer_Segment(spi, &iov[i]);
 	}
-	return SPI_OK;
+	HAL_GPIO_WritePin(spi->cs_port, spi->pin, GPIO_PIN_SET);
+
+	return response;
 }
 
 TeSPI_Status SPI_Deinit(TsSPI* spi)
@@ -81,15 +81,28 @@ typedef enum {
 	SPI_TRANSMIT_FAILED,
 	SPI_RECEIVE_FAILED,
 	SPI_DEINIT_FAILED,
-	SPI_INIT_FAILED
+	SPI_INIT_FAILED,
+	SPI_INVALID_BUFFER
 }TeSPI_Status;
 
+// TsSPI_Iovec is one segment of a scatter-gather transaction. A NULL rx_buf only
+// transmits and a NULL tx_buf only receives. len counts data frames, which take
+// two bytes each above 8 bits.
+typedef struct {
+	uint8_t* tx_buf;
+	uint8_t* rx_buf;
+	uint32_t len;
+}TsSPI_Iovec;
+
 /*------------- PUBLIC FUNCTION DEFINITIONS ------------- */
 
 TeSPI_Status SPI_Init(TsSPI* spi);
-TeSPI_Status SPI_Transmit(TsSPI* spi, uint8_t *Tx_buf, uint8_t buf_len);
+TeSPI_Status SPI_Transmit(TsSPI* spi, uint8_t *Tx_buf, uint32_t buf_len);
 TeSPI_Status SPI_Deinit(TsSPI* spi);
-TeSPI_Status SPI_Transmit_Receive(TsSPI* spi, uint8_t *tx_buf, uint8_t *rx_buf, uint8_t buf_len);
+TeSPI_Status SPI_Transmit_Receive(TsSPI* spi, uint8_t *tx_buf, uint8_t *rx_buf, uint32_t buf_len);
+// SPI_Transfer_Vec runs the segments of iov as one transaction, keeping CS
+// asserted from the first frame to the last
+TeSPI_Status SPI_Transfer_Vec(TsSPI* spi, const TsSPI_Iovec* iov, uint8_t iov_cnt);
 
 
 #endif /* INC_SPI_LIB_H_ */
@@ -0,0 +1,50 @@
+/*
+ * canal_fixture.h
+ *
+ * Helpers shared by the canal tests: bring up a TsCanAL on a fake instance and
+ * put frames on its bus.
+ */
+
+#ifndef TEST_CANAL_FIXTURE_H_
+#define TEST_CANAL_FIXTURE_H_
+
+#include <string.h>
+#include "canal.h"
+#include "hal_stub.h"
+
+// Test_InitCan resets the fake peripherals and initializes can on canNum at
+// 500k with the given rx mode
+static inline TeCanALRet Test_InitCan(TsCanAL* can, CAN_HandleTypeDef* hcan,
+		TeCanALInstance canNum, TeCanALRxMode rxMode) {
+	memset((void*)can, 0, sizeof(*can));
+	memset((void*)hcan, 0, sizeof(*hcan));
+	can->hcan = hcan;
+	can->canNum = canNum;
+	can->baud = CANAL_BAUD_500K;
+	can->mode = CANAL_MODE_NORMAL;
+	can->rxMode = rxMode;
+
+	return CanAL_Init(can);
+}
+
+// Test_BusFrame puts a frame carrying seq in its first four bytes on the fifo
+// of can. It returns false if the FIFO overran.
+static inline bool Test_BusFrame(TsCanAL* can, uint32_t fifo, uint32_t id, uint32_t ide,
+		uint32_t seq) {
+	TsStubCanFrame frame;
+
+	memset(&frame, 0, sizeof(frame));
+	frame.id = id;
+	frame.ide = ide;
+	frame.dlc = 8;
+	memcpy(frame.data, &seq, sizeof(seq));
+
+	return Stub_CanPushRx(can->hcan->Instance, fifo, &frame);
+}
+
+// Test_RxIsr runs the rx interrupt of fifo the way the HAL callbacks do
+static inline TeCanALRet Test_RxIsr(TsCanAL* can, uint32_t fifo) {
+	return (fifo == CAN_RX_FIFO0) ? CanAL_Receive(can) : CanAL_ReceiveFifo1(can);
+}
+
+#endif /* TEST_CANAL_FIXTURE_H_ */
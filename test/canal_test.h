@@ -0,0 +1,59 @@
+/*
+ * canal_test.h
+ *
+ * A minimal test runner for the host tests. Each test is a void function that
+ * stops at its first failed TEST_ASSERT; main runs them with TEST_RUN and
+ * returns TEST_RESULT(), which ctest reads as pass or fail.
+ */
+
+#ifndef TEST_CANAL_TEST_H_
+#define TEST_CANAL_TEST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+static int testFailures;
+static int testCount;
+static int testFailed;
+
+#define TEST_ASSERT(__cond__) do { \
+	if (!(__cond__)) { \
+		printf("  %s:%d: %s\n", __FILE__, __LINE__, #__cond__); \
+		testFailed = 1; \
+		return; \
+	} \
+} while (0)
+
+#define TEST_ASSERT_EQUAL(__expected__, __actual__) do { \
+	long long __e__ = (long long)(__expected__); \
+	long long __a__ = (long long)(__actual__); \
+	if (__e__ != __a__) { \
+		printf("  %s:%d: %s == %s (expected %lld, got %lld)\n", __FILE__, __LINE__, \
+			#__expected__, #__actual__, __e__, __a__); \
+		testFailed = 1; \
+		return; \
+	} \
+} while (0)
+
+#define TEST_RUN(__test__) do { \
+	testFailed = 0; \
+	testCount++; \
+	__test__(); \
+	printf("%s %s\n", testFailed ? "FAIL" : "ok  ", #__test__); \
+	testFailures += testFailed; \
+} while (0)
+
+#define TEST_RESULT() \
+	(printf("%d/%d passed\n", testCount - testFailures, testCount), testFailures != 0)
+
+// Test_NowNs is a monotonic clock for the benchmarks
+static inline uint64_t Test_NowNs(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+#endif /* TEST_CANAL_TEST_H_ */
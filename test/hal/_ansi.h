@@ -0,0 +1 @@
+// newlib header, empty on the host
@@ -0,0 +1,58 @@
+/*
+ * canal_messages.c
+ *
+ * Codecs of the test bus described in canal_messages.h
+ */
+
+#include <string.h>
+#include "canal_messages.h"
+
+TsTestMessage Test_Rx_A, Test_Rx_B, Test_Rx_C, Test_Rx_D;
+TsTestMessage Test_Tx_A, Test_Tx_T;
+void (*Test_MarshalHook)(void);
+
+static TeCanALRet unmarshal(TsTestMessage* msg, const uint8_t* data) {
+	memcpy(msg->data, data, sizeof(msg->data));
+	msg->count++;
+
+	return CANAL_OK;
+}
+
+static TeCanALRet marshal(TsTestMessage* msg, uint8_t* data) {
+	if (Test_MarshalHook != NULL) Test_MarshalHook();
+
+	memcpy(data, msg->data, sizeof(msg->data));
+	msg->count++;
+
+	return CANAL_OK;
+}
+
+TeCanALRet Unmarshal_A(uint8_t* data) {
+	return unmarshal(&Test_Rx_A, data);
+}
+
+TeCanALRet Unmarshal_B(uint8_t* data) {
+	return unmarshal(&Test_Rx_B, data);
+}
+
+TeCanALRet Unmarshal_C(uint8_t* data) {
+	return unmarshal(&Test_Rx_C, data);
+}
+
+TeCanALRet Unmarshal_D(uint8_t* data) {
+	return unmarshal(&Test_Rx_D, data);
+}
+
+TeCanALRet Marshal_A(uint8_t* data) {
+	return marshal(&Test_Tx_A, data);
+}
+
+TeCanALRet Marshal_T(uint8_t* data) {
+	return marshal(&Test_Tx_T, data);
+}
+
+TeCanALRet Print_Message(uint32_t* ID) {
+	(void)ID;
+
+	return CANAL_OK;
+}
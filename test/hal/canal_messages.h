@@ -0,0 +1,47 @@
+/*
+ * canal_messages.h
+ *
+ * Stand-in for the file canalgen generates from a DBC. The tests use a small
+ * bus: 0x100 is sent and received, 0x101, 0x18FF0001 and the extended 0x0F0 are
+ * only received and 0x200 is only sent. Every unmarshaller copies the frame into Test_Rx and
+ * every marshaller fills the frame from Test_Tx.
+ */
+
+#ifndef TEST_CANAL_MESSAGES_H_
+#define TEST_CANAL_MESSAGES_H_
+
+#include <stdint.h>
+#include "canal_types.h"
+
+typedef enum {
+	MSG_A = 0x100,
+	MSG_B = 0x101,
+	MSG_C = 0x18FF0001,
+	MSG_D = 0x0F0,
+	MSG_T = 0x200,
+}TeMessageID;
+
+#define CANAL_MESSAGE_LIST(X) \
+	X(MSG_A, CAN_ID_STD, 8, 1, Unmarshal_A, Marshal_A) \
+	X(MSG_B, CAN_ID_STD, 4, 1, Unmarshal_B, NULL) \
+	X(MSG_C, CAN_ID_EXT, 8, 1, Unmarshal_C, NULL) \
+	X(MSG_D, CAN_ID_EXT, 8, 1, Unmarshal_D, NULL) \
+	X(MSG_T, CAN_ID_STD, 2, 0, NULL, Marshal_T)
+
+// TsTestMessage is the global struct every test message decodes into
+typedef struct {
+	uint8_t data[8];
+	uint32_t count;
+}TsTestMessage;
+
+extern TsTestMessage Test_Rx_A, Test_Rx_B, Test_Rx_C, Test_Rx_D;
+extern TsTestMessage Test_Tx_A, Test_Tx_T;
+// Test_MarshalHook, when set, runs at the start of every marshaller
+extern void (*Test_MarshalHook)(void);
+
+BinaryUnmarshaller Unmarshal_A, Unmarshal_B, Unmarshal_C, Unmarshal_D;
+BinaryMarshaller Marshal_A, Marshal_T;
+
+TeCanALRet Print_Message(uint32_t* ID);
+
+#endif /* TEST_CANAL_MESSAGES_H_ */
@@ -0,0 +1,74 @@
+/*
+ * hal_stub.h
+ *
+ * Controls for the fake peripherals in hal_stub.c. A test drives a bus by
+ * pushing frames into a CAN rx FIFO and calling the library's ISR entry points
+ * itself, and checks what the library put on the bus through the tx log.
+ */
+
+#ifndef TEST_HAL_STUB_H_
+#define TEST_HAL_STUB_H_
+
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STUB_CAN_INSTANCES				(3U)
+#define STUB_CAN_FIFO_DEPTH				(3U)
+#define STUB_CAN_MAILBOXES				(3U)
+#define STUB_CAN_TX_LOG_SIZE			(4096U)
+
+// TsStubCanFrame is a frame on the fake bus
+typedef struct {
+	uint32_t id;
+	uint32_t ide;
+	uint32_t dlc;
+	uint8_t data[8];
+	uint16_t time;
+}TsStubCanFrame;
+
+// Stub_Tick is returned by HAL_GetTick, HAL_Delay advances it. Reading the
+// tick also lets every bxCAN acknowledge a change of MCR.INRQ in MSR.INAK.
+extern volatile uint32_t Stub_Tick;
+// Stub_Pclk1 is returned by HAL_RCC_GetPCLK1Freq
+extern uint32_t Stub_Pclk1;
+// Stub_DelayHook, when set, runs once for every millisecond HAL_Delay waits
+extern void (*Stub_DelayHook)(void);
+
+// Stub_Reset clears every fake peripheral and the tick
+void Stub_Reset(void);
+
+// Stub_CanIndex returns 0..2 for CAN1..CAN3
+uint32_t Stub_CanIndex(const CAN_TypeDef* can);
+// Stub_CanPushRx queues frame in fifo. It returns false and flags an overrun in
+// ErrorCode of the handle last started on that instance if the FIFO is full.
+bool Stub_CanPushRx(CAN_TypeDef* can, uint32_t fifo, const TsStubCanFrame* frame);
+// Stub_CanRxLevel is the number of frames still waiting in fifo
+uint32_t Stub_CanRxLevel(const CAN_TypeDef* can, uint32_t fifo);
+// Stub_CanTxCount is the number of frames handed to HAL_CAN_AddTxMessage
+uint32_t Stub_CanTxCount(const CAN_TypeDef* can);
+// Stub_CanTx returns the i'th frame handed to HAL_CAN_AddTxMessage
+const TsStubCanFrame* Stub_CanTx(const CAN_TypeDef* can, uint32_t i);
+// Stub_CanTxMailbox returns the CAN_TX_MAILBOXx the i'th frame was loaded into
+uint32_t Stub_CanTxMailbox(const CAN_TypeDef* can, uint32_t i);
+// Stub_CanBusyMailboxes returns the CAN_TX_MAILBOXx bits that hold a frame
+uint32_t Stub_CanBusyMailboxes(const CAN_TypeDef* can);
+// Stub_CanReleaseMailbox frees a CAN_TX_MAILBOXx, as sending or losing the frame
+// does. The test then calls the matching canal callback.
+void Stub_CanReleaseMailbox(CAN_TypeDef* can, uint32_t mailbox);
+// Stub_CanSetTxTime sets the capture HAL_CAN_GetTxTimestamp returns for a
+// CAN_TX_MAILBOXx, the start of frame of the frame it sent
+void Stub_CanSetTxTime(CAN_TypeDef* can, uint32_t mailbox, uint16_t time);
+// Stub_CanFilters returns the filters configured on any instance so far
+const CAN_FilterTypeDef* Stub_CanFilters(uint32_t* count);
+
+// Stub_CycleCount advances DWT->CYCCNT by cycles
+void Stub_CycleCount(uint32_t cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_HAL_STUB_H_ */
@@ -0,0 +1,345 @@
+/*
+ * main.h
+ *
+ * Host stand-in for the CubeMX main.h and the parts of the STM32F7 HAL and
+ * CMSIS that the libraries use. Register layouts and constants match the
+ * STM32F7 headers; the peripherals behind them are faked in hal_stub.c.
+ */
+
+#ifndef TEST_HAL_MAIN_H_
+#define TEST_HAL_MAIN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __IO volatile
+#define ENABLE 1U
+#define DISABLE 0U
+
+typedef enum { HAL_OK, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+
+#define SET_BIT(REG, BIT) ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT) ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT) ((REG) & (BIT))
+#define WRITE_REG(REG, VAL) ((REG) = (VAL))
+#define READ_REG(REG) ((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) \
+	WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+/*********************************************************
+*                       CMSIS
+*********************************************************/
+
+// Interrupts are never masked on the host, tests call the ISR entry points
+// directly. Stub_Primask records what the library asked for so tests can check
+// that a path ran unmasked.
+extern uint32_t Stub_Primask;
+extern uint32_t Stub_PrimaskEntries;
+
+static inline uint32_t __get_PRIMASK(void) { return Stub_Primask; }
+static inline void __set_PRIMASK(uint32_t primask) { Stub_Primask = primask; }
+static inline void __disable_irq(void) { Stub_Primask = 1U; Stub_PrimaskEntries++; }
+static inline void __enable_irq(void) { Stub_Primask = 0U; }
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline uint32_t __get_IPSR(void) { return 0U; }
+
+typedef struct { __IO uint32_t CTRL, CYCCNT; } DWT_Type;
+typedef struct { __IO uint32_t DEMCR; } CoreDebug_Type;
+typedef struct { __IO uint32_t CCR; } SCB_Type;
+extern DWT_Type* DWT;
+extern CoreDebug_Type* CoreDebug;
+extern SCB_Type* SCB;
+extern uint32_t SystemCoreClock;
+
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL)
+#define SCB_CCR_DC_Msk (1UL << 16)
+#define __DCACHE_PRESENT 1U
+
+void SCB_CleanDCache_by_Addr(uint32_t* addr, int32_t size);
+void SCB_InvalidateDCache_by_Addr(uint32_t* addr, int32_t size);
+
+/*********************************************************
+*                       SYSTEM
+*********************************************************/
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t ms);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetSysClockFreq(void);
+void Error_Handler(void);
+
+/*********************************************************
+*                       CAN
+*********************************************************/
+
+typedef struct { __IO uint32_t TIR, TDTR, TDLR, TDHR; } CAN_TxMailBox_TypeDef;
+typedef struct { __IO uint32_t RIR, RDTR, RDLR, RDHR; } CAN_FIFOMailBox_TypeDef;
+typedef struct {
+	__IO uint32_t MCR, MSR, TSR, RF0R, RF1R, IER, ESR, BTR;
+	uint32_t RESERVED0[88];
+	CAN_TxMailBox_TypeDef sTxMailBox[3];
+	CAN_FIFOMailBox_TypeDef sFIFOMailBox[2];
+} CAN_TypeDef;
+extern CAN_TypeDef *CAN1, *CAN2, *CAN3;
+
+typedef struct {
+	uint32_t Prescaler, Mode, SyncJumpWidth, TimeSeg1, TimeSeg2;
+	uint32_t TimeTriggeredMode, AutoBusOff, AutoWakeUp, AutoRetransmission;
+	uint32_t ReceiveFifoLocked, TransmitFifoPriority;
+} CAN_InitTypeDef;
+typedef struct {
+	CAN_TypeDef* Instance;
+	CAN_InitTypeDef Init;
+	__IO uint32_t State;
+	__IO uint32_t ErrorCode;
+} CAN_HandleTypeDef;
+typedef struct {
+	uint32_t FilterIdHigh, FilterIdLow, FilterMaskIdHigh, FilterMaskIdLow;
+	uint32_t FilterFIFOAssignment, FilterBank, FilterMode, FilterScale;
+	uint32_t FilterActivation, SlaveStartFilterBank;
+} CAN_FilterTypeDef;
+typedef struct { uint32_t StdId, ExtId, IDE, RTR, DLC, Timestamp, FilterMatchIndex; } CAN_RxHeaderTypeDef;
+typedef struct { uint32_t StdId, ExtId, IDE, RTR, DLC; uint32_t TransmitGlobalTime; } CAN_TxHeaderTypeDef;
+
+#define HAL_CAN_STATE_RESET 0x00U
+#define HAL_CAN_STATE_READY 0x01U
+#define HAL_CAN_STATE_LISTENING 0x02U
+
+#define CAN_MODE_NORMAL 0x0U
+#define CAN_MODE_LOOPBACK (1U << 30)
+#define CAN_MODE_SILENT (1U << 31)
+#define CAN_MODE_SILENT_LOOPBACK (3U << 30)
+#define CAN_BTR_SJW_Pos 24U
+#define CAN_BTR_TS2_Pos 20U
+#define CAN_BTR_TS1_Pos 16U
+#define CAN_BTR_BRP_Pos 0U
+#define CAN_BTR_BRP 0x3FFU
+#define CAN_BTR_LBKM (1U << 30)
+#define CAN_BTR_SILM (1U << 31)
+#define CAN_SJW_1TQ 0U
+#define CAN_BS1_6TQ (5U << 16)
+#define CAN_BS1_13TQ (12U << 16)
+#define CAN_BS2_1TQ 0U
+#define CAN_BS2_2TQ (1U << 20)
+
+#define CAN_RX_FIFO0 0U
+#define CAN_RX_FIFO1 1U
+#define CAN_FILTERMODE_IDMASK 0U
+#define CAN_FILTERMODE_IDLIST 1U
+#define CAN_FILTERSCALE_16BIT 0U
+#define CAN_FILTERSCALE_32BIT 1U
+#define CAN_FILTER_FIFO0 0U
+#define CAN_FILTER_FIFO1 1U
+#define CAN_ID_STD 0U
+#define CAN_ID_EXT 4U
+#define CAN_RTR_DATA 0U
+#define CAN_RTR_REMOTE 2U
+#define CAN_TX_MAILBOX0 1U
+#define CAN_TX_MAILBOX1 2U
+#define CAN_TX_MAILBOX2 4U
+
+#define CAN_IT_TX_MAILBOX_EMPTY (1U << 0)
+#define CAN_IT_RX_FIFO0_MSG_PENDING (1U << 1)
+#define CAN_IT_RX_FIFO0_FULL (1U << 2)
+#define CAN_IT_RX_FIFO0_OVERRUN (1U << 3)
+#define CAN_IT_RX_FIFO1_MSG_PENDING (1U << 4)
+#define CAN_IT_RX_FIFO1_FULL (1U << 5)
+#define CAN_IT_RX_FIFO1_OVERRUN (1U << 6)
+#define CAN_IT_ERROR_WARNING (1U << 8)
+#define CAN_IT_ERROR_PASSIVE (1U << 9)
+#define CAN_IT_BUSOFF (1U << 10)
+#define CAN_IT_LAST_ERROR_CODE (1U << 11)
+#define CAN_IT_ERROR (1U << 15)
+
+#define HAL_CAN_ERROR_NONE 0x00000000U
+#define HAL_CAN_ERROR_EWG 0x00000001U
+#define HAL_CAN_ERROR_EPV 0x00000002U
+#define HAL_CAN_ERROR_BOF 0x00000004U
+#define HAL_CAN_ERROR_STF 0x00000008U
+#define HAL_CAN_ERROR_FOR 0x00000010U
+#define HAL_CAN_ERROR_ACK 0x00000020U
+#define HAL_CAN_ERROR_BR 0x00000040U
+#define HAL_CAN_ERROR_BD 0x00000080U
+#define HAL_CAN_ERROR_CRC 0x00000100U
+#define HAL_CAN_ERROR_RX_FOV0 0x00000200U
+#define HAL_CAN_ERROR_RX_FOV1 0x00000400U
+#define HAL_CAN_ERROR_TX_ALST0 0x00000800U
+#define HAL_CAN_ERROR_TX_TERR0 0x00001000U
+#define HAL_CAN_ERROR_TX_ALST1 0x00002000U
+#define HAL_CAN_ERROR_TX_TERR1 0x00004000U
+#define HAL_CAN_ERROR_TX_ALST2 0x00008000U
+#define HAL_CAN_ERROR_TX_TERR2 0x00010000U
+
+#define CAN_RI0R_IDE (1U << 2)
+#define CAN_RI0R_RTR (1U << 1)
+#define CAN_RI0R_STID_Pos 21U
+#define CAN_RI0R_EXID_Pos 3U
+#define CAN_RDT0R_DLC 0xFU
+#define CAN_RDT0R_FMI_Pos 8U
+#define CAN_RDT0R_TIME_Pos 16U
+#define CAN_RDT0R_TIME (0xFFFFU << CAN_RDT0R_TIME_Pos)
+#define CAN_RF0R_FMP0 3U
+#define CAN_RF0R_FULL0 (1U << 3)
+#define CAN_RF0R_FOVR0 (1U << 4)
+#define CAN_RF0R_RFOM0 (1U << 5)
+#define CAN_RF1R_RFOM1 (1U << 5)
+#define CAN_ESR_LEC_Pos 4U
+#define CAN_ESR_LEC (7U << CAN_ESR_LEC_Pos)
+#define CAN_ESR_TEC_Pos 16U
+#define CAN_ESR_REC_Pos 24U
+#define CAN_ESR_REC (0xFFU << CAN_ESR_REC_Pos)
+#define CAN_MCR_INRQ 1U
+#define CAN_MSR_INAK 1U
+#define CAN_TSR_TME0 (1U << 26)
+#define CAN_TDT0R_TIME_Pos 16U
+
+#define IS_CAN_STDID(x) ((x) <= 0x7FFU)
+#define IS_CAN_EXTID(x) ((x) <= 0x1FFFFFFFU)
+
+HAL_StatusTypeDef HAL_CAN_Init(CAN_HandleTypeDef* hcan);
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef* hcan);
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef* hcan);
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef* hcan, CAN_FilterTypeDef* filter);
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef* hcan, uint32_t its);
+HAL_StatusTypeDef HAL_CAN_DeactivateNotification(CAN_HandleTypeDef* hcan, uint32_t its);
+HAL_StatusTypeDef HAL_CAN_GetRxMessage(CAN_HandleTypeDef* hcan, uint32_t fifo,
+	CAN_RxHeaderTypeDef* header, uint8_t* data);
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef* hcan, CAN_TxHeaderTypeDef* header,
+	uint8_t* data, uint32_t* mailbox);
+HAL_StatusTypeDef HAL_CAN_AbortTxRequest(CAN_HandleTypeDef* hcan, uint32_t mailboxes);
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(CAN_HandleTypeDef* hcan);
+uint32_t HAL_CAN_GetRxFifoFillLevel(CAN_HandleTypeDef* hcan, uint32_t fifo);
+uint32_t HAL_CAN_GetTxTimestamp(CAN_HandleTypeDef* hcan, uint32_t mailbox);
+uint32_t HAL_CAN_GetError(CAN_HandleTypeDef* hcan);
+HAL_StatusTypeDef HAL_CAN_ResetError(CAN_HandleTypeDef* hcan);
+
+/*********************************************************
+*                       UART
+*********************************************************/
+
+typedef struct {
+	uint32_t BaudRate, WordLength, StopBits, Parity, Mode, HwFlowCtl;
+	uint32_t OverSampling, OneBitSampling;
+} UART_InitTypeDef;
+typedef struct { uint32_t AdvFeatureInit, MSBFirst; } UART_AdvFeatureInitTypeDef;
+typedef struct { uint32_t Mode; } DMA_InitTypeDef;
+typedef struct { DMA_InitTypeDef Init; } DMA_HandleTypeDef;
+typedef struct {
+	void* Instance;
+	UART_InitTypeDef Init;
+	UART_AdvFeatureInitTypeDef AdvancedInit;
+	DMA_HandleTypeDef* hdmatx;
+	DMA_HandleTypeDef* hdmarx;
+	__IO uint32_t ErrorCode;
+	__IO uint32_t gState;
+	__IO uint32_t RxState;
+} UART_HandleTypeDef;
+extern void *USART1, *USART2, *USART3, *UART4, *UART5, *USART6, *UART7, *UART8;
+
+#define HAL_UART_STATE_READY 0x20U
+#define UART_WORDLENGTH_7B 0x10000000U
+#define UART_WORDLENGTH_8B 0x00000000U
+#define UART_WORDLENGTH_9B 0x00001000U
+#define UART_MODE_RX 0x04U
+#define UART_MODE_TX 0x08U
+#define UART_MODE_TX_RX 0x0CU
+#define UART_ADVFEATURE_NO_INIT 0U
+#define UART_ADVFEATURE_MSBFIRST_INIT 0x80U
+#define UART_ADVFEATURE_MSBFIRST_ENABLE 0x80000U
+#define UART_STOPBITS_1 0U
+#define UART_PARITY_NONE 0U
+#define UART_HWCONTROL_NONE 0U
+#define UART_OVERSAMPLING_16 0U
+#define UART_ONE_BIT_SAMPLE_DISABLE 0U
+#define HAL_UART_ERROR_NONE 0x00U
+#define HAL_UART_ERROR_PE 0x01U
+#define HAL_UART_ERROR_NE 0x02U
+#define HAL_UART_ERROR_FE 0x04U
+#define HAL_UART_ERROR_ORE 0x08U
+#define HAL_UART_ERROR_DMA 0x10U
+#define DMA_CIRCULAR 0x100U
+#define DMA_IT_HT 0x08U
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef* huart);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef* huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* data,
+	uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size,
+	uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data,
+	uint16_t size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* data,
+	uint16_t size);
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef* huart);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart);
+
+/*********************************************************
+*                       SPI / GPIO
+*********************************************************/
+
+typedef struct {
+	uint32_t Mode, Direction, DataSize, CLKPolarity, CLKPhase, NSS, BaudRatePrescaler;
+	uint32_t FirstBit, TIMode, CRCCalculation, CRCPolynomial, CRCLength, NSSPMode;
+} SPI_InitTypeDef;
+typedef struct { void* Instance; SPI_InitTypeDef Init; } SPI_HandleTypeDef;
+typedef struct { uint32_t ODR; } GPIO_TypeDef;
+typedef enum { GPIO_PIN_RESET, GPIO_PIN_SET } GPIO_PinState;
+extern void *SPI1, *SPI2, *SPI3, *SPI4, *SPI5, *SPI6;
+
+#define SPI_DATASIZE_4BIT 0x0300U
+#define SPI_DATASIZE_5BIT 0x0400U
+#define SPI_DATASIZE_6BIT 0x0500U
+#define SPI_DATASIZE_7BIT 0x0600U
+#define SPI_DATASIZE_8BIT 0x0700U
+#define SPI_DATASIZE_9BIT 0x0800U
+#define SPI_DATASIZE_10BIT 0x0900U
+#define SPI_DATASIZE_11BIT 0x0A00U
+#define SPI_DATASIZE_12BIT 0x0B00U
+#define SPI_DATASIZE_13BIT 0x0C00U
+#define SPI_DATASIZE_14BIT 0x0D00U
+#define SPI_DATASIZE_15BIT 0x0E00U
+#define SPI_DATASIZE_16BIT 0x0F00U
+#define SPI_BAUDRATEPRESCALER_2 0x00U
+#define SPI_BAUDRATEPRESCALER_4 0x08U
+#define SPI_BAUDRATEPRESCALER_8 0x10U
+#define SPI_BAUDRATEPRESCALER_16 0x18U
+#define SPI_BAUDRATEPRESCALER_32 0x20U
+#define SPI_BAUDRATEPRESCALER_64 0x28U
+#define SPI_BAUDRATEPRESCALER_128 0x30U
+#define SPI_BAUDRATEPRESCALER_256 0x38U
+#define SPI_PHASE_1EDGE 0U
+#define SPI_PHASE_2EDGE 1U
+#define SPI_POLARITY_LOW 0U
+#define SPI_POLARITY_HIGH 2U
+#define SPI_FIRSTBIT_MSB 0U
+#define SPI_FIRSTBIT_LSB 0x80U
+#define SPI_MODE_MASTER 0x104U
+#define SPI_DIRECTION_2LINES 0U
+#define SPI_NSS_SOFT 0x200U
+#define SPI_TIMODE_DISABLE 0U
+#define SPI_CRCCALCULATION_DISABLE 0U
+#define SPI_CRC_LENGTH_DATASIZE 0U
+#define SPI_NSS_PULSE_ENABLE 0x08U
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi);
+HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef* hspi);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* data, uint16_t size,
+	uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef* hspi, uint8_t* data, uint16_t size,
+	uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi, uint8_t* tx, uint8_t* rx,
+	uint16_t size, uint32_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_HAL_MAIN_H_ */
@@ -0,0 +1,36 @@
+/*
+ * canal_messages.c
+ *
+ * Codecs of the legacy bus described in canal_messages.h
+ */
+
+#include "canal_messages.h"
+
+uint32_t Legacy_Rx, Legacy_Tx;
+
+TeCanALRet UnmarshalBinary(uint32_t* ID, uint8_t* data) {
+	(void)data;
+
+	if (*ID != LEGACY_RX) return CANAL_UNSUPPORTED_RX_MESSAGE;
+
+	Legacy_Rx++;
+
+	return CANAL_OK;
+}
+
+TeCanALRet MarshalBinary(uint32_t* ID, uint8_t* data) {
+	if (*ID != LEGACY_TX) return CANAL_UNSUPPORTED_TX_MESSAGE;
+
+	data[0] = 0xA5;
+	Legacy_Tx++;
+
+	return CANAL_OK;
+}
+
+TeCanALRet GetTxDataLength(uint32_t* ID, uint32_t* len) {
+	if (*ID != LEGACY_TX) return CANAL_UNSUPPORTED_TX_MESSAGE;
+
+	*len = 1;
+
+	return CANAL_OK;
+}
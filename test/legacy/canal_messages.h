@@ -0,0 +1,29 @@
+/*
+ * canal_messages.h
+ *
+ * A canal_messages.h as canalgen generated it before CANAL_MESSAGE_LIST: only
+ * the ID-keyed UnmarshalBinary, MarshalBinary and GetTxDataLength. 0x123 is
+ * received and 0x18FF0002 is sent.
+ */
+
+#ifndef TEST_LEGACY_CANAL_MESSAGES_H_
+#define TEST_LEGACY_CANAL_MESSAGES_H_
+
+#include <stdint.h>
+#include "canal_types.h"
+
+typedef enum {
+	LEGACY_RX = 0x123,
+	LEGACY_TX = 0x18FF0002,
+}TeMessageID;
+
+// Legacy_Rx and Legacy_Tx count the frames the codecs handled
+extern uint32_t Legacy_Rx, Legacy_Tx;
+
+TeCanALRet UnmarshalBinary(uint32_t* ID, uint8_t* data);
+TeCanALRet MarshalBinary(uint32_t* ID, uint8_t* data);
+TeCanALRet GetTxDataLength(uint32_t* ID, uint32_t* len);
+
+TeCanALRet Print_Message(uint32_t* ID);
+
+#endif /* TEST_LEGACY_CANAL_MESSAGES_H_ */
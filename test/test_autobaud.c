@@ -0,0 +1,118 @@
+/*
+ * test_autobaud.c
+ *
+ * CanAL_InitAutobaud against a simulated bus that HAL_Delay advances a
+ * millisecond at a time: frames are only received at the bus bitrate and show
+ * up as stuff errors at any other, and the decision logic locks a bitrate by
+ * its dwell time, not by how often it is polled.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+#define BUS_PERIOD_MS					(3U)
+#define SEARCH_TIMEOUT_MS				(1000U)
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+static uint32_t busKbit;
+
+// controllerKbit decodes the bitrate the bit timing register is set to
+static uint32_t controllerKbit(void) {
+	uint32_t btr = CAN1->BTR;
+	uint32_t tq = 3U + ((btr >> CAN_BTR_TS1_Pos) & 0xFU) + ((btr >> CAN_BTR_TS2_Pos) & 0x7U);
+
+	return Stub_Pclk1 / (((btr & CAN_BTR_BRP) + 1U) * tq) / 1000U;
+}
+
+// busTick is the bus for one millisecond. Every BUS_PERIOD_MS a frame goes by,
+// every other one of them an ID that the filters do not pass.
+static void busTick(void) {
+	if ((busKbit == 0U) || ((Stub_Tick % BUS_PERIOD_MS) != 0U)) return;
+
+	if (controllerKbit() != busKbit) {
+		CAN1->ESR = (CAN1->ESR & ~CAN_ESR_LEC) | (1U << CAN_ESR_LEC_Pos);
+		CAN1->ESR += 1U << CAN_ESR_REC_Pos;
+		return;
+	}
+
+	if (((Stub_Tick / BUS_PERIOD_MS) % 2U) == 0U) {
+		Test_BusFrame(&can, CAN_RX_FIFO0, MSG_A, CAN_ID_STD, Stub_Tick);
+		Test_RxIsr(&can, CAN_RX_FIFO0);
+	}
+
+	CAN1->ESR &= ~CAN_ESR_LEC;
+}
+
+static void setUp(uint32_t kbit) {
+	Stub_Reset();
+	memset((void*)&can, 0, sizeof(can));
+	memset((void*)&hcan, 0, sizeof(hcan));
+	can.hcan = &hcan;
+	can.canNum = CANAL_INST_CAN_1;
+	can.mode = CANAL_MODE_NORMAL;
+	can.rxMode = CANAL_RX_MODE_IMMEDIATE;
+
+	busKbit = kbit;
+	Stub_DelayHook = busTick;
+}
+
+static void test_locks_every_bitrate(void) {
+	static const uint32_t BUS_KBIT[] = { 100, 250, 500, 1000 };
+
+	for (uint32_t i = 0; i < sizeof(BUS_KBIT) / sizeof(BUS_KBIT[0]); i++) {
+		setUp(BUS_KBIT[i]);
+
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_InitAutobaud(&can, SEARCH_TIMEOUT_MS));
+		printf("  %u kbit/s locked in %u ms\n", BUS_KBIT[i], Stub_Tick);
+
+		TEST_ASSERT_EQUAL(BUS_KBIT[i], can.baud);
+		TEST_ASSERT_EQUAL(BUS_KBIT[i], controllerKbit());
+		TEST_ASSERT_EQUAL(0, CAN1->BTR & CAN_BTR_SILM);
+		// Wrong bitrates are rejected by their errors, only the right one dwells
+		TEST_ASSERT(Stub_Tick >= CANAL_AUTOBAUD_DWELL_MS);
+		TEST_ASSERT(Stub_Tick <= 2U * CANAL_AUTOBAUD_DWELL_MS);
+	}
+}
+
+static void test_idle_bus_times_out(void) {
+	setUp(0);
+
+	TEST_ASSERT_EQUAL(CANAL_TIMEOUT, CanAL_InitAutobaud(&can, SEARCH_TIMEOUT_MS));
+	TEST_ASSERT_EQUAL(SEARCH_TIMEOUT_MS, Stub_Tick);
+	TEST_ASSERT(CAN1->BTR & CAN_BTR_SILM);
+}
+
+static void test_lock_waits_for_dwell(void) {
+	static const uint16_t CANDIDATES[] = { 500, 250 };
+	TsCanALAutobaud autobaud;
+	TsCanALAutobaudSample frame = { .rxFrames = 1 };
+	TsCanALAutobaudSample glitch = { .rxFrames = 0, .rxError = true };
+	TsCanALAutobaudSample quiet = {0};
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Autobaud_Start(&autobaud, CANDIDATES, 2, 50, 1000, 0));
+
+	// Plenty of clean frames and a glitch, judged only once the dwell is up
+	for (uint32_t ms = 1; ms < 50U; ms++) {
+		const TsCanALAutobaudSample* sample = ((ms % 5U) == 0U) ? &frame : &quiet;
+
+		if (ms == 20U) sample = &glitch;
+		TEST_ASSERT_EQUAL(CANAL_AUTOBAUD_LISTEN, CanAL_Autobaud_Step(&autobaud, ms, sample));
+	}
+	TEST_ASSERT_EQUAL(CANAL_AUTOBAUD_LOCKED, CanAL_Autobaud_Step(&autobaud, 50, &quiet));
+	TEST_ASSERT_EQUAL(500, CanAL_Autobaud_Current(&autobaud));
+
+	// A second sample with errors rejects the candidate at once
+	CanAL_Autobaud_Start(&autobaud, CANDIDATES, 2, 50, 1000, 0);
+	TEST_ASSERT_EQUAL(CANAL_AUTOBAUD_LISTEN, CanAL_Autobaud_Step(&autobaud, 1, &glitch));
+	TEST_ASSERT_EQUAL(CANAL_AUTOBAUD_SWITCH, CanAL_Autobaud_Step(&autobaud, 2, &glitch));
+	TEST_ASSERT_EQUAL(250, CanAL_Autobaud_Current(&autobaud));
+}
+
+int main(void) {
+	TEST_RUN(test_locks_every_bitrate);
+	TEST_RUN(test_idle_bus_times_out);
+	TEST_RUN(test_lock_waits_for_dwell);
+
+	return TEST_RESULT();
+}
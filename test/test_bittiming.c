@@ -0,0 +1,78 @@
+/*
+ * test_bittiming.c
+ *
+ * CanAL_SolveBitTiming and CANAL_BT_TIMING checked against the bxCAN tables of
+ * bittiming.can-wiki.info for an 87.5% sample point.
+ */
+
+#include "canal_test.h"
+#include "canal_bittiming.h"
+
+// TsReference is one can-wiki row: the prescaler and segments it lists first
+typedef struct {
+	uint32_t clkMhz;
+	uint32_t kbit;
+	uint16_t prescaler;
+	uint8_t bs1;
+	uint8_t bs2;
+}TsReference;
+
+static const TsReference REFERENCES[] = {
+	{16, 1000,  1, 13, 2},
+	{16,  500,  2, 13, 2},
+	{16,  250,  4, 13, 2},
+	{16,  100, 10, 13, 2},
+	{ 8, 1000,  1,  6, 1},
+	{ 8,  500,  1, 13, 2},
+	{ 8,  250,  2, 13, 2},
+	{ 8,  100,  5, 13, 2},
+	{36,  500,  4, 15, 2},
+	{42,  500,  6, 11, 2},
+	{54, 1000,  3, 15, 2},
+	{54,  500,  6, 15, 2},
+	{54,  250, 12, 15, 2},
+};
+
+static const TsCanALBitTiming CONST_TIMING = CANAL_BT_TIMING(54000000U, 500000U, 875U);
+
+static void test_matches_can_wiki(void) {
+	for (uint32_t i = 0; i < sizeof(REFERENCES) / sizeof(REFERENCES[0]); i++) {
+		const TsReference* ref = &REFERENCES[i];
+		TsCanALBitTiming timing = {0};
+
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_SolveBitTiming(ref->clkMhz * 1000000U,
+			ref->kbit * 1000U, 875, &timing));
+		TEST_ASSERT_EQUAL(ref->prescaler, timing.prescaler);
+		TEST_ASSERT_EQUAL(ref->bs1, timing.bs1);
+		TEST_ASSERT_EQUAL(ref->bs2, timing.bs2);
+		TEST_ASSERT_EQUAL(1U + ref->bs1 + ref->bs2, timing.tq);
+		TEST_ASSERT(timing.sjw <= timing.bs2);
+	}
+}
+
+static void test_unreachable_bitrate(void) {
+	TsCanALBitTiming timing;
+
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_PCLK1_FREQ,
+		CanAL_SolveBitTiming(54000000U, 800000U, 875, &timing));
+	TEST_ASSERT_EQUAL(0, CANAL_BT_TQ(54000000U, 800000U, 875U));
+}
+
+static void test_macro_matches_solver(void) {
+	TsCanALBitTiming timing;
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_SolveBitTiming(54000000U, 500000U, 875, &timing));
+	TEST_ASSERT_EQUAL(timing.prescaler, CONST_TIMING.prescaler);
+	TEST_ASSERT_EQUAL(timing.tq, CONST_TIMING.tq);
+	TEST_ASSERT_EQUAL(timing.bs1, CONST_TIMING.bs1);
+	TEST_ASSERT_EQUAL(timing.bs2, CONST_TIMING.bs2);
+	TEST_ASSERT_EQUAL(timing.sjw, CONST_TIMING.sjw);
+}
+
+int main(void) {
+	TEST_RUN(test_matches_can_wiki);
+	TEST_RUN(test_unreachable_bitrate);
+	TEST_RUN(test_macro_matches_solver);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,159 @@
+/*
+ * test_cpp.cpp
+ *
+ * The C++ layer of canal.hpp: send<ID> builds the same frame as CanAL_Transmit,
+ * typed handlers run through the canal_handler registry, and a benchmark of
+ * both against the C calls they wrap.
+ */
+
+#include "canal_test.h"
+
+extern "C" {
+#include "canal_fixture.h"
+}
+
+#include "canal.hpp"
+
+#define BENCH_CALLS						(1000000U)
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+
+struct Counter {
+	uint32_t calls;
+	float last;
+};
+
+static void count(Counter& counter, float value) {
+	counter.calls++;
+	counter.last = value;
+}
+
+static void countC(void* ctx, uint32_t ID, float value) {
+	(void)ID;
+
+	count(*static_cast<Counter*>(ctx), value);
+}
+
+static void setUp(void) {
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+}
+
+// sendComplete frees the mailbox the last frame went into
+static void sendComplete(void) {
+	uint32_t mailbox = Stub_CanTxMailbox(CAN1, Stub_CanTxCount(CAN1) - 1U);
+
+	Stub_CanReleaseMailbox(CAN1, mailbox);
+	CanAL_TxMailboxComplete(&can, mailbox);
+}
+
+static void test_send_matches_transmit(void) {
+	setUp();
+	Test_Tx_A.data[0] = 0x5A;
+
+	TEST_ASSERT_EQUAL(CANAL_OK, canal::send<MSG_A>(can));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Transmit(&can, MSG_A));
+
+	TEST_ASSERT_EQUAL(2, Stub_CanTxCount(CAN1));
+	TEST_ASSERT_EQUAL(Stub_CanTx(CAN1, 1)->id, Stub_CanTx(CAN1, 0)->id);
+	TEST_ASSERT_EQUAL(Stub_CanTx(CAN1, 1)->ide, Stub_CanTx(CAN1, 0)->ide);
+	TEST_ASSERT_EQUAL(Stub_CanTx(CAN1, 1)->dlc, Stub_CanTx(CAN1, 0)->dlc);
+	TEST_ASSERT_EQUAL(0x5A, Stub_CanTx(CAN1, 0)->data[0]);
+}
+
+static void test_typed_handler_uses_registry(void) {
+	static const TsCanALSignal firstByte = { 0, 8, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f };
+	Counter counter = {};
+
+	setUp();
+	{
+		canal::Handler<MSG_B, Counter> handler(counter, count);
+
+		TEST_ASSERT_EQUAL(CANAL_OK, handler.watch(firstByte, 0.0f));
+		TEST_ASSERT_EQUAL(CANAL_OK, canal::on(handler));
+
+		Test_BusFrame(&can, CAN_RX_FIFO0, MSG_B, CAN_ID_STD, 3);
+		Test_RxIsr(&can, CAN_RX_FIFO0);
+		Test_BusFrame(&can, CAN_RX_FIFO0, MSG_B, CAN_ID_STD, 3);
+		Test_RxIsr(&can, CAN_RX_FIFO0);
+		Test_BusFrame(&can, CAN_RX_FIFO0, MSG_B, CAN_ID_STD, 9);
+		Test_RxIsr(&can, CAN_RX_FIFO0);
+
+		// The repeated value does not fire
+		TEST_ASSERT_EQUAL(2, counter.calls);
+		TEST_ASSERT_EQUAL(9, counter.last);
+
+		TEST_ASSERT_EQUAL(CANAL_OK, canal::off(handler));
+		Test_BusFrame(&can, CAN_RX_FIFO0, MSG_B, CAN_ID_STD, 4);
+		Test_RxIsr(&can, CAN_RX_FIFO0);
+		TEST_ASSERT_EQUAL(2, counter.calls);
+
+		TEST_ASSERT_EQUAL(CANAL_OK, canal::on(handler));
+	}
+
+	// Leaving the scope unregistered it
+	Test_BusFrame(&can, CAN_RX_FIFO0, MSG_B, CAN_ID_STD, 5);
+	Test_RxIsr(&can, CAN_RX_FIFO0);
+	TEST_ASSERT_EQUAL(2, counter.calls);
+}
+
+static void test_benchmark(void) {
+	uint16_t index = CanAL_FindCodec(MSG_A);
+	uint8_t data[8] = {};
+	Counter cCounter = {};
+	Counter cppCounter = {};
+	TsCanALHandler cHandler;
+	uint64_t start;
+	uint64_t cNs;
+	uint64_t cppNs;
+	uint64_t transmitNs;
+	uint64_t sendNs;
+
+	setUp();
+
+	CanAL_Handler_Init(&cHandler, MSG_A, countC, &cCounter, CANAL_HANDLER_PRIORITY_DEFAULT);
+	CanAL_Handler_Register(&cHandler);
+	start = Test_NowNs();
+	for (uint32_t n = 0; n < BENCH_CALLS; n++) CanAL_Handler_Dispatch(index, data, sizeof(data));
+	cNs = Test_NowNs() - start;
+	CanAL_Handler_Unregister(&cHandler);
+
+	{
+		canal::Handler<MSG_A, Counter> handler(cppCounter, count);
+
+		canal::on(handler);
+		start = Test_NowNs();
+		for (uint32_t n = 0; n < BENCH_CALLS; n++) CanAL_Handler_Dispatch(index, data, sizeof(data));
+		cppNs = Test_NowNs() - start;
+	}
+
+	start = Test_NowNs();
+	for (uint32_t n = 0; n < BENCH_CALLS; n++) {
+		CanAL_Transmit(&can, MSG_A);
+		sendComplete();
+	}
+	transmitNs = Test_NowNs() - start;
+
+	start = Test_NowNs();
+	for (uint32_t n = 0; n < BENCH_CALLS; n++) {
+		canal::send<MSG_A>(can);
+		sendComplete();
+	}
+	sendNs = Test_NowNs() - start;
+
+	printf("  handler: C %.1f ns, typed %.1f ns; transmit: C %.1f ns, send<ID> %.1f ns\n",
+		(double)cNs / BENCH_CALLS, (double)cppNs / BENCH_CALLS,
+		(double)transmitNs / BENCH_CALLS, (double)sendNs / BENCH_CALLS);
+
+	TEST_ASSERT_EQUAL(BENCH_CALLS, cCounter.calls);
+	TEST_ASSERT_EQUAL(BENCH_CALLS, cppCounter.calls);
+}
+
+int main(void) {
+	TEST_RUN(test_send_matches_transmit);
+	TEST_RUN(test_typed_handler_uses_registry);
+	TEST_RUN(test_benchmark);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,102 @@
+/*
+ * test_dispatch.c
+ *
+ * Frames are matched to their codec by ID and IDE: the extended MSG_D at 0x0F0
+ * gets an extended filter and is decoded, a standard frame with the same ID is
+ * a different message.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+
+static void setUp(void) {
+	memset(&Test_Rx_D, 0, sizeof(Test_Rx_D));
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+}
+
+// filterAcceptsExt checks the active 32-bit banks configured since the first'th
+// HAL_CAN_ConfigFilter call for an extended frame with id
+static bool filterAcceptsExt(uint32_t id, uint32_t first) {
+	uint32_t count;
+	const CAN_FilterTypeDef* filters = Stub_CanFilters(&count);
+	uint32_t r = (id << 3) | 0x4U;
+
+	for (uint32_t i = first; i < count; i++) {
+		const CAN_FilterTypeDef* f = &filters[i];
+		uint32_t fr1 = (f->FilterIdHigh << 16) | f->FilterIdLow;
+		uint32_t fr2 = (f->FilterMaskIdHigh << 16) | f->FilterMaskIdLow;
+
+		if ((f->FilterActivation != ENABLE) || (f->FilterScale != CAN_FILTERSCALE_32BIT)) continue;
+
+		if (f->FilterMode == CAN_FILTERMODE_IDLIST) {
+			if ((r == fr1) || (r == fr2)) return true;
+		} else if (((r ^ fr1) & fr2) == 0U) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void test_low_extended_id_is_subscribed_as_extended(void) {
+	bool found = false;
+
+	setUp();
+
+	for (uint16_t i = 0; i < can.numRxIds; i++) {
+		if (can.rxIds[i] != MSG_D) continue;
+
+		TEST_ASSERT_EQUAL(CAN_ID_EXT, can.rxIdIde[i]);
+		found = true;
+	}
+
+	TEST_ASSERT(found);
+	TEST_ASSERT(filterAcceptsExt(MSG_D, 0));
+}
+
+static void test_frames_match_on_ide(void) {
+	setUp();
+
+	TEST_ASSERT(Test_BusFrame(&can, CAN_RX_FIFO0, MSG_D, CAN_ID_EXT, 1));
+	TEST_ASSERT_EQUAL(CANAL_OK, Test_RxIsr(&can, CAN_RX_FIFO0));
+	TEST_ASSERT_EQUAL(1, Test_Rx_D.count);
+
+	TEST_ASSERT(Test_BusFrame(&can, CAN_RX_FIFO0, MSG_D, CAN_ID_STD, 2));
+	Test_RxIsr(&can, CAN_RX_FIFO0);
+	TEST_ASSERT_EQUAL(1, Test_Rx_D.count);
+
+	TEST_ASSERT_EQUAL(CANAL_NO_CODEC, CanAL_FindFrameCodec(MSG_D, CAN_ID_STD));
+	TEST_ASSERT(CanAL_FindFrameCodec(MSG_D, CAN_ID_EXT) != CANAL_NO_CODEC);
+}
+
+static void test_subscribe_keeps_ides_apart(void) {
+	uint16_t numRxIds;
+	uint32_t numFilters;
+
+	setUp();
+	numRxIds = can.numRxIds;
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Subscribe(&can, MSG_D, CAN_ID_STD, DEFAULT_RX_FIFO));
+	TEST_ASSERT_EQUAL(numRxIds + 1, can.numRxIds);
+
+	TEST_ASSERT_EQUAL(CANAL_UNKOWN_IDE, CanAL_Subscribe(&can, MSG_D, 0x7, DEFAULT_RX_FIFO));
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_RX_MESSAGE,
+		CanAL_Subscribe(&can, 0x800, CAN_ID_STD, DEFAULT_RX_FIFO));
+
+	Stub_CanFilters(&numFilters);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Unsubscribe(&can, MSG_D, CAN_ID_STD));
+	TEST_ASSERT_EQUAL(numRxIds, can.numRxIds);
+	TEST_ASSERT(filterAcceptsExt(MSG_D, numFilters));
+}
+
+int main(void) {
+	TEST_RUN(test_low_extended_id_is_subscribed_as_extended);
+	TEST_RUN(test_frames_match_on_ide);
+	TEST_RUN(test_subscribe_keeps_ides_apart);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,78 @@
+/*
+ * test_dispatch_bench.c
+ *
+ * Lookup cost of the codec index against a linear scan of CANAL_CODEC_TABLE,
+ * which is what the ID-keyed if/else chains of the old generated
+ * UnmarshalBinary cost per frame. It is built once per message count with a
+ * canal_messages.h generated by CMakeLists.txt.
+ */
+
+#include "canal_test.h"
+#include "canal.h"
+#include "canal_dispatch.h"
+
+#define BENCH_LOOKUPS					(200000U)
+
+TeCanALRet Bench_Unmarshal(uint8_t* data) {
+	(void)data;
+
+	return CANAL_OK;
+}
+
+static uint16_t linearFind(uint32_t ID, uint8_t ide) {
+	for (uint16_t i = 0; i < CANAL_NUM_MESSAGES; i++) {
+		if ((CANAL_CODEC_TABLE[i].id == ID) && (CANAL_CODEC_TABLE[i].ide == ide)) return i;
+	}
+
+	return CANAL_NO_CODEC;
+}
+
+static void test_every_message_is_found(void) {
+	CanAL_InitDispatch();
+
+	for (uint16_t i = 0; i < CANAL_NUM_MESSAGES; i++) {
+		const TsCanALCodec* codec = &CANAL_CODEC_TABLE[i];
+
+		TEST_ASSERT_EQUAL(i, CanAL_FindFrameCodec(codec->id, codec->ide));
+		TEST_ASSERT_EQUAL(i, linearFind(codec->id, codec->ide));
+	}
+
+	TEST_ASSERT_EQUAL(CANAL_NO_CODEC, CanAL_FindFrameCodec(0x7FF, CAN_ID_STD));
+	TEST_ASSERT_EQUAL(CANAL_NO_CODEC, CanAL_FindFrameCodec(0x1FFFFFFF, CAN_ID_EXT));
+}
+
+// bench times BENCH_LOOKUPS lookups that walk the table, with every eighth one
+// an ID that is not in it
+static uint64_t bench(uint16_t (*find)(uint32_t, uint8_t), uint32_t* hits) {
+	uint64_t start = Test_NowNs();
+
+	*hits = 0;
+
+	for (uint32_t n = 0; n < BENCH_LOOKUPS; n++) {
+		const TsCanALCodec* codec = &CANAL_CODEC_TABLE[n % CANAL_NUM_MESSAGES];
+		uint32_t ID = ((n & 7U) == 7U) ? 0x7FFU : codec->id;
+
+		if (find(ID, codec->ide) != CANAL_NO_CODEC) (*hits)++;
+	}
+
+	return Test_NowNs() - start;
+}
+
+static void test_lookup_cost(void) {
+	uint32_t indexHits;
+	uint32_t linearHits;
+	uint64_t indexNs = bench(CanAL_FindFrameCodec, &indexHits);
+	uint64_t linearNs = bench(linearFind, &linearHits);
+
+	printf("  %4d messages: index %.1f ns, linear %.1f ns per lookup\n", CANAL_NUM_MESSAGES,
+		(double)indexNs / BENCH_LOOKUPS, (double)linearNs / BENCH_LOOKUPS);
+
+	TEST_ASSERT_EQUAL(linearHits, indexHits);
+}
+
+int main(void) {
+	TEST_RUN(test_every_message_is_found);
+	TEST_RUN(test_lookup_cost);
+
+	return TEST_RESULT();
+}
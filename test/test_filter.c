@@ -0,0 +1,152 @@
+/*
+ * test_filter.c
+ *
+ * CanAL_CompileFilters and CanAL_CompileListFilters checked against a model of
+ * the bxCAN acceptance logic: every subscribed ID must get through and, when
+ * there are enough banks, nothing else may.
+ */
+
+#include <stdlib.h>
+#include "canal_test.h"
+#include "canal_filter.h"
+
+#define MAX_BANKS						(14U)
+
+static TsCanALFilterBank banks[MAX_BANKS];
+static uint8_t numBanks;
+
+// image32 and image16 are a frame's identifier as the filter registers see it
+static uint32_t image32(uint32_t id, bool extended) {
+	if (extended) return (id << 3) | 0x4U;
+
+	return id << 21;
+}
+
+static uint32_t image16(uint32_t id, bool extended) {
+	if (extended) return ((id >> 18) << 5) | 0x8U | ((id >> 15) & 0x7U);
+
+	return id << 5;
+}
+
+static bool bankAccepts(const TsCanALFilterBank* bank, uint32_t id, bool extended) {
+	if (bank->scale == CANAL_FILTER_SCALE_32) {
+		uint32_t r = image32(id, extended);
+
+		if (bank->mode == CANAL_FILTER_MODE_LIST) return (r == bank->fr1) || (r == bank->fr2);
+
+		return ((r ^ bank->fr1) & bank->fr2) == 0U;
+	}
+
+	uint32_t r = image16(id, extended);
+	uint32_t halves[4] = {
+		bank->fr1 & 0xFFFFU, bank->fr1 >> 16, bank->fr2 & 0xFFFFU, bank->fr2 >> 16,
+	};
+
+	if (bank->mode == CANAL_FILTER_MODE_LIST) {
+		for (uint32_t i = 0; i < 4; i++) if (r == halves[i]) return true;
+		return false;
+	}
+
+	return (((r ^ halves[0]) & halves[1]) == 0U) || (((r ^ halves[2]) & halves[3]) == 0U);
+}
+
+static bool accepts(uint32_t id, bool extended) {
+	for (uint8_t i = 0; i < numBanks; i++) {
+		if (bankAccepts(&banks[i], id, extended)) return true;
+	}
+
+	return false;
+}
+
+static bool contains(const uint32_t* ids, uint16_t n, uint32_t id) {
+	for (uint16_t i = 0; i < n; i++) if (ids[i] == id) return true;
+
+	return false;
+}
+
+static void test_lone_ids_pack_densely(void) {
+	static const uint32_t std[] = { 0x010, 0x234, 0x5A5, 0x7FF };
+	static const uint32_t ext[] = { 0x18FF0001, 0x0CF00400 };
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_CompileFilters(std, NULL, 4, banks, MAX_BANKS, &numBanks));
+	TEST_ASSERT_EQUAL(1, numBanks);
+	TEST_ASSERT_EQUAL(CANAL_FILTER_SCALE_16, banks[0].scale);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_CompileFilters(ext, NULL, 2, banks, MAX_BANKS, &numBanks));
+	TEST_ASSERT_EQUAL(1, numBanks);
+	TEST_ASSERT(accepts(ext[0], true) && accepts(ext[1], true));
+	TEST_ASSERT(!accepts(ext[0] ^ 1U, true));
+}
+
+static void test_runs_merge_without_extra_ids(void) {
+	uint32_t ids[16];
+
+	for (uint32_t i = 0; i < 16; i++) ids[i] = 0x300 + i;
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_CompileFilters(ids, NULL, 16, banks, MAX_BANKS, &numBanks));
+	TEST_ASSERT_EQUAL(1, numBanks);
+	for (uint32_t id = 0; id <= 0x7FFU; id++) {
+		TEST_ASSERT_EQUAL(contains(ids, 16, id), accepts(id, false));
+	}
+}
+
+// Random ID sets: exact when the banks suffice, a superset when they do not
+static void test_random_sets(void) {
+	uint32_t ids[CANAL_FILTER_MAX_IDS];
+
+	srand(7);
+	for (uint32_t round = 0; round < 200U; round++) {
+		uint16_t n = (uint16_t)(1 + (rand() % CANAL_FILTER_MAX_IDS));
+		uint8_t maxBanks = (uint8_t)(1 + (rand() % MAX_BANKS));
+
+		for (uint16_t i = 0; i < n; i++) {
+			ids[i] = ((rand() % 4) == 0) ? (0x800U + ((uint32_t)rand() & 0x1FFFF7FFU)) :
+				((uint32_t)rand() & 0x7FFU);
+		}
+
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_CompileFilters(ids, NULL, n, banks, maxBanks, &numBanks));
+		TEST_ASSERT(numBanks <= maxBanks);
+
+		for (uint16_t i = 0; i < n; i++) TEST_ASSERT(accepts(ids[i], ids[i] > 0x7FFU));
+
+		if (maxBanks == MAX_BANKS && n <= 8U) {
+			for (uint32_t id = 0; id <= 0x7FFU; id++) {
+				TEST_ASSERT_EQUAL(contains(ids, n, id), accepts(id, false));
+			}
+		}
+	}
+}
+
+static void test_list_filters_are_exact(void) {
+	static const uint32_t ids[] = { 0x100, 0x18FF0001, 0x101 };
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_CompileListFilters(ids, NULL, 3, banks, MAX_BANKS, &numBanks));
+	TEST_ASSERT_EQUAL(2, numBanks);
+	TEST_ASSERT(accepts(0x100, false) && accepts(0x101, false) && accepts(0x18FF0001, true));
+	TEST_ASSERT(!accepts(0x102, false) && !accepts(0x100, true));
+
+	TEST_ASSERT_EQUAL(CANAL_FILTER_TABLE_FULL, CanAL_CompileListFilters(ids, NULL, 3, banks, 1, &numBanks));
+}
+
+static void test_low_extended_ids_follow_ide(void) {
+	static const uint32_t ids[] = { 0x123, 0x123, 0x456 };
+	static const bool extended[] = { false, true, true };
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_CompileFilters(ids, extended, 3, banks, MAX_BANKS, &numBanks));
+	TEST_ASSERT(accepts(0x123, false) && accepts(0x123, true) && accepts(0x456, true));
+	TEST_ASSERT(!accepts(0x456, false));
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_CompileListFilters(&ids[2], &extended[2], 1, banks,
+		MAX_BANKS, &numBanks));
+	TEST_ASSERT(accepts(0x456, true) && !accepts(0x456, false));
+}
+
+int main(void) {
+	TEST_RUN(test_lone_ids_pack_densely);
+	TEST_RUN(test_runs_merge_without_extra_ids);
+	TEST_RUN(test_random_sets);
+	TEST_RUN(test_list_filters_are_exact);
+	TEST_RUN(test_low_extended_ids_follow_ide);
+
+	return TEST_RESULT();
+}
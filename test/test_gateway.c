@@ -0,0 +1,214 @@
+/*
+ * test_gateway.c
+ *
+ * Frames received on CAN1 are forwarded to CAN2 by route ID and IDE, with
+ * remapping and rate limiting. The gateway shares its source with other rx
+ * hooks and only ever removes its own hook and the IDs it subscribed itself.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+#include "canal_gateway.h"
+#include "canal_isotp.h"
+#include "canal_slcan.h"
+
+static TsCanAL src;
+static TsCanAL dest;
+static CAN_HandleTypeDef hsrc;
+static CAN_HandleTypeDef hdest;
+static TsCanALGateway gw;
+
+// countHook counts the frames it sees in the uint32_t at ctx
+static bool countHook(void* ctx, const TsCanALRawFrame* frame) {
+	(void)frame;
+
+	(*(uint32_t*)ctx)++;
+
+	return false;
+}
+
+static TsCanALRxHookNode hookNodes[3];
+
+// removeFirstTwo removes the first node, itself included, from its callback
+static bool removeFirstTwo(void* ctx, const TsCanALRawFrame* frame) {
+	countHook(ctx, frame);
+	CanAL_RemoveRxHook(&src, &hookNodes[0]);
+	CanAL_RemoveRxHook(&src, &hookNodes[1]);
+
+	return false;
+}
+
+static void setUp(void) {
+	Stub_Reset();
+	Test_InitCan(&src, &hsrc, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+	Test_InitCan(&dest, &hdest, CANAL_INST_CAN_2, CANAL_RX_MODE_IMMEDIATE);
+	CanAL_Gateway_Init(&gw);
+}
+
+static void receive(uint32_t id, uint32_t ide) {
+	Test_BusFrame(&src, CAN_RX_FIFO0, id, ide, 0);
+	Test_RxIsr(&src, CAN_RX_FIFO0);
+}
+
+static void test_routes_match_id_and_ide(void) {
+	setUp();
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_AddRoute(&gw, 0x300, CAN_ID_STD, &dest,
+		0x18FF0300, 0));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_AddRoute(&gw, 0x300, CAN_ID_EXT, &dest,
+		CANAL_GATEWAY_NO_REMAP, 0));
+	TEST_ASSERT_EQUAL(CANAL_UNKOWN_IDE, CanAL_Gateway_AddRoute(&gw, 0x300, 0x7, &dest,
+		CANAL_GATEWAY_NO_REMAP, 0));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_Attach(&gw, &src));
+
+	receive(0x300, CAN_ID_STD);
+	receive(0x300, CAN_ID_EXT);
+	receive(0x301, CAN_ID_STD);
+
+	TEST_ASSERT_EQUAL(2, Stub_CanTxCount(CAN2));
+	TEST_ASSERT_EQUAL(0x18FF0300, Stub_CanTx(CAN2, 0)->id);
+	TEST_ASSERT_EQUAL(CAN_ID_EXT, Stub_CanTx(CAN2, 0)->ide);
+	TEST_ASSERT_EQUAL(0x300, Stub_CanTx(CAN2, 1)->id);
+	TEST_ASSERT_EQUAL(CAN_ID_EXT, Stub_CanTx(CAN2, 1)->ide);
+}
+
+static void test_rate_limit(void) {
+	TsCanALRouteStats stats;
+
+	setUp();
+	CanAL_Gateway_AddRoute(&gw, 0x100, CAN_ID_STD, &dest, CANAL_GATEWAY_NO_REMAP, 10);
+	CanAL_Gateway_Attach(&gw, &src);
+
+	receive(0x100, CAN_ID_STD);
+	receive(0x100, CAN_ID_STD);
+	Stub_Tick += 10;
+	receive(0x100, CAN_ID_STD);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_GetRouteStats(&gw, 0x100, CAN_ID_STD, &dest, &stats));
+	TEST_ASSERT_EQUAL(2, stats.forwarded);
+	TEST_ASSERT_EQUAL(1, stats.limited);
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_RX_MESSAGE,
+		CanAL_Gateway_GetRouteStats(&gw, 0x100, CAN_ID_EXT, &dest, &stats));
+}
+
+static void test_detach_leaves_other_hooks(void) {
+	TsCanALRxHookNode other = {0};
+	uint32_t seen = 0;
+
+	setUp();
+	CanAL_AddRxHook(&src, &other, countHook, &seen);
+	CanAL_Gateway_AddRoute(&gw, 0x300, CAN_ID_STD, &dest, CANAL_GATEWAY_NO_REMAP, 0);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_Attach(&gw, &src));
+	// Attaching again is harmless, attaching the same gateway elsewhere is not
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_Attach(&gw, &src));
+	TEST_ASSERT_EQUAL(CANAL_ERROR, CanAL_Gateway_Attach(&gw, &dest));
+
+	receive(0x300, CAN_ID_STD);
+	TEST_ASSERT_EQUAL(1, Stub_CanTxCount(CAN2));
+	TEST_ASSERT_EQUAL(1, seen);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_Detach(&gw));
+	TEST_ASSERT(src.rxHooks == &other);
+	TEST_ASSERT(other.next == NULL);
+
+	receive(0x300, CAN_ID_STD);
+	TEST_ASSERT_EQUAL(1, Stub_CanTxCount(CAN2));
+	TEST_ASSERT_EQUAL(2, seen);
+}
+
+static void test_hook_removes_hooks_from_callback(void) {
+	uint32_t seen[3] = {0};
+
+	setUp();
+	memset(hookNodes, 0, sizeof(hookNodes));
+	CanAL_AddRxHook(&src, &hookNodes[0], removeFirstTwo, &seen[0]);
+	CanAL_AddRxHook(&src, &hookNodes[1], countHook, &seen[1]);
+	CanAL_AddRxHook(&src, &hookNodes[2], countHook, &seen[2]);
+
+	receive(MSG_B, CAN_ID_STD);
+	receive(MSG_B, CAN_ID_STD);
+	TEST_ASSERT_EQUAL(1, seen[0]);
+	TEST_ASSERT_EQUAL(0, seen[1]);
+	TEST_ASSERT_EQUAL(2, seen[2]);
+	TEST_ASSERT(src.rxHooks == &hookNodes[2]);
+}
+
+// The gateway, ISO-TP and SLCAN each add their own hook to the same instance
+// and all of them see every frame
+static void test_shares_source_with_isotp_and_slcan(void) {
+	static TsCanALIsoTp isotp;
+	static TsCanALIsoTpSession session;
+	static TsCanALSlcan slcan;
+	static UART_st uart;
+	TsCanALIsoTpConfig config = { .txId = 0x7E0, .rxId = 0x7E8 };
+	uint8_t rxBuf[8];
+	TsCanALRawFrame single = { .id = 0x7E8, .ide = CAN_ID_STD, .dlc = 8,
+		.data = { 0x02, 0xAA, 0xBB } };
+	TsCanALRawFrame routed = { .id = 0x300, .ide = CAN_ID_STD, .dlc = 8 };
+
+	setUp();
+	CanAL_Gateway_AddRoute(&gw, 0x300, CAN_ID_STD, &dest, CANAL_GATEWAY_NO_REMAP, 0);
+	CanAL_IsoTp_Init(&isotp, NULL);
+	CanAL_IsoTp_Open(&isotp, &session, &config, rxBuf, sizeof(rxBuf), NULL, NULL, NULL);
+	CanAL_Slcan_Init(&slcan, &uart);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_Attach(&gw, &src));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Attach(&isotp, &src));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Slcan_Attach(&slcan, &src));
+	CanAL_Slcan_Input(&slcan, (const uint8_t*)"O\r", 2);
+
+	CanAL_InjectRx(&src, CAN_RX_FIFO0, &routed);
+	CanAL_InjectRx(&src, CAN_RX_FIFO0, &single);
+	TEST_ASSERT_EQUAL(1, Stub_CanTxCount(CAN2));
+	TEST_ASSERT_EQUAL(CANAL_ISOTP_RX_DONE, session.rxState);
+	TEST_ASSERT_EQUAL(2, slcan.stats.rxFrames);
+
+	// Taking out the hook in the middle leaves the others running
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Detach(&isotp));
+	CanAL_InjectRx(&src, CAN_RX_FIFO0, &routed);
+	TEST_ASSERT_EQUAL(2, Stub_CanTxCount(CAN2));
+	TEST_ASSERT_EQUAL(3, slcan.stats.rxFrames);
+
+	CanAL_Slcan_Detach(&slcan);
+	CanAL_Gateway_Detach(&gw);
+	TEST_ASSERT(src.rxHooks == NULL);
+}
+
+static void test_detach_unsubscribes_own_ids(void) {
+	uint16_t numRxIds;
+	uint32_t countB;
+
+	setUp();
+	numRxIds = src.numRxIds;
+	CanAL_Gateway_AddRoute(&gw, 0x300, CAN_ID_STD, &dest, CANAL_GATEWAY_NO_REMAP, 0);
+	// MSG_B was already subscribed by CanAL_Init, the gateway must not drop it
+	CanAL_Gateway_AddRoute(&gw, MSG_B, CAN_ID_STD, &dest, CANAL_GATEWAY_NO_REMAP, 0);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_Attach(&gw, &src));
+	TEST_ASSERT_EQUAL(numRxIds + 1U, src.numRxIds);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_AddRoute(&gw, 0x301, CAN_ID_STD, &dest,
+		CANAL_GATEWAY_NO_REMAP, 0));
+	TEST_ASSERT_EQUAL(numRxIds + 2U, src.numRxIds);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_Detach(&gw));
+	TEST_ASSERT_EQUAL(numRxIds, src.numRxIds);
+	countB = Test_Rx_B.count;
+	receive(MSG_B, CAN_ID_STD);
+	TEST_ASSERT_EQUAL(countB + 1U, Test_Rx_B.count);
+
+	// Attaching again subscribes the routes again
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Gateway_Attach(&gw, &src));
+	TEST_ASSERT_EQUAL(numRxIds + 2U, src.numRxIds);
+	CanAL_Gateway_Detach(&gw);
+	TEST_ASSERT_EQUAL(numRxIds, src.numRxIds);
+}
+
+int main(void) {
+	TEST_RUN(test_routes_match_id_and_ide);
+	TEST_RUN(test_rate_limit);
+	TEST_RUN(test_detach_leaves_other_hooks);
+	TEST_RUN(test_hook_removes_hooks_from_callback);
+	TEST_RUN(test_shares_source_with_isotp_and_slcan);
+	TEST_RUN(test_detach_unsubscribes_own_ids);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,138 @@
+/*
+ * test_handler.c
+ *
+ * The handler registry: priority order, callbacks that unregister themselves
+ * or the handler after them, deadbands, and signals that a short frame does
+ * not carry.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+static TsCanALHandler handlers[3];
+static char order[8];
+static uint32_t calls;
+static float lastValue;
+
+static void record(void* ctx, uint32_t ID, float value) {
+	(void)ID;
+
+	order[calls++] = *(const char*)ctx;
+	lastValue = value;
+}
+
+static void removeSelf(void* ctx, uint32_t ID, float value) {
+	record(ctx, ID, value);
+	CanAL_Handler_Unregister(&handlers[0]);
+}
+
+static void removeNext(void* ctx, uint32_t ID, float value) {
+	record(ctx, ID, value);
+	CanAL_Handler_Unregister(&handlers[1]);
+}
+
+static void setUp(void) {
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+	for (uint32_t i = 0; i < 3U; i++) CanAL_Handler_Unregister(&handlers[i]);
+	memset(order, 0, sizeof(order));
+	calls = 0;
+}
+
+static void inject(uint32_t id, uint8_t dlc, uint8_t firstByte, uint8_t lastByte) {
+	TsCanALRawFrame frame = { .id = id, .ide = CAN_ID_STD, .dlc = dlc };
+
+	frame.data[0] = firstByte;
+	frame.data[7] = lastByte;
+	CanAL_InjectRx(&can, CAN_RX_FIFO0, &frame);
+}
+
+static void test_priority_order(void) {
+	setUp();
+	CanAL_Handler_Init(&handlers[0], MSG_A, record, "c", 200);
+	CanAL_Handler_Init(&handlers[1], MSG_A, record, "a", CANAL_HANDLER_PRIORITY_HIGHEST);
+	CanAL_Handler_Init(&handlers[2], MSG_A, record, "b", 200);
+	for (uint32_t i = 0; i < 3U; i++) TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Handler_Register(&handlers[i]));
+
+	inject(MSG_A, 8, 0, 0);
+	TEST_ASSERT_EQUAL(0, strcmp("acb", order));
+
+	CanAL_Handler_Unregister(&handlers[0]);
+	CanAL_Handler_Init(&handlers[0], MSG_T, record, "t", 0);
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_RX_MESSAGE, CanAL_Handler_Register(&handlers[0]));
+}
+
+static void test_callback_unregisters_itself(void) {
+	setUp();
+	CanAL_Handler_Init(&handlers[0], MSG_A, removeSelf, "a", 0);
+	CanAL_Handler_Init(&handlers[1], MSG_A, record, "b", 1);
+	CanAL_Handler_Register(&handlers[0]);
+	CanAL_Handler_Register(&handlers[1]);
+
+	inject(MSG_A, 8, 0, 0);
+	inject(MSG_A, 8, 0, 0);
+	TEST_ASSERT_EQUAL(0, strcmp("abb", order));
+}
+
+static void test_callback_unregisters_next(void) {
+	setUp();
+	CanAL_Handler_Init(&handlers[0], MSG_A, removeNext, "a", 0);
+	CanAL_Handler_Init(&handlers[1], MSG_A, record, "b", 1);
+	CanAL_Handler_Init(&handlers[2], MSG_A, record, "c", 2);
+	for (uint32_t i = 0; i < 3U; i++) CanAL_Handler_Register(&handlers[i]);
+
+	inject(MSG_A, 8, 0, 0);
+	TEST_ASSERT_EQUAL(0, strcmp("ac", order));
+}
+
+static void test_deadband(void) {
+	static const TsCanALSignal firstByte = { 0, 8, CANAL_LITTLE_ENDIAN, false, 0.5f, 0.0f };
+
+	setUp();
+	CanAL_Handler_Init(&handlers[0], MSG_A, record, "a", 0);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Handler_WatchSignal(&handlers[0], &firstByte, 1.0f));
+	CanAL_Handler_Register(&handlers[0]);
+
+	inject(MSG_A, 8, 10, 0);
+	inject(MSG_A, 8, 12, 0);
+	inject(MSG_A, 8, 11, 0);
+	inject(MSG_A, 8, 7, 0);
+
+	// 5.0 fires, 6.0 and 5.5 are within 1.0 of it, 3.5 is not
+	TEST_ASSERT_EQUAL(2, calls);
+	TEST_ASSERT_EQUAL(7, lastValue * 2);
+}
+
+static void test_signal_beyond_dlc(void) {
+	static const TsCanALSignal lastByte = { 56, 8, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f };
+	static const TsCanALSignal motorola = { 7, 16, CANAL_BIG_ENDIAN, false, 1.0f, 0.0f };
+
+	setUp();
+	CanAL_Handler_Init(&handlers[0], MSG_B, record, "a", 0);
+	CanAL_Handler_WatchSignal(&handlers[0], &lastByte, 0.0f);
+	CanAL_Handler_Register(&handlers[0]);
+	TEST_ASSERT_EQUAL(8, handlers[0].signalBytes);
+
+	// MSG_B frames carry 4 bytes, so byte 7 holds nothing of this frame
+	inject(MSG_B, 4, 0, 0x55);
+	TEST_ASSERT_EQUAL(0, calls);
+	inject(MSG_B, 8, 0, 0x55);
+	TEST_ASSERT_EQUAL(1, calls);
+	TEST_ASSERT_EQUAL(0x55, lastValue);
+
+	CanAL_Handler_Init(&handlers[1], MSG_B, record, "b", 0);
+	CanAL_Handler_WatchSignal(&handlers[1], &motorola, 0.0f);
+	TEST_ASSERT_EQUAL(2, handlers[1].signalBytes);
+}
+
+int main(void) {
+	TEST_RUN(test_priority_order);
+	TEST_RUN(test_callback_unregisters_itself);
+	TEST_RUN(test_callback_unregisters_next);
+	TEST_RUN(test_deadband);
+	TEST_RUN(test_signal_beyond_dlc);
+
+	return TEST_RESULT();
+}
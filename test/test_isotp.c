@@ -0,0 +1,435 @@
+/*
+ * test_isotp.c
+ *
+ * Two nodes on a simulated bus exchange ISO-TP payloads in both directions at
+ * once, with block sizes and both first frame length formats. Consecutive
+ * frames are capped per poll and leave the application its share of the tx
+ * queue. ISO-TP shares the instance with other rx hooks and detaching only
+ * removes its own hook and the IDs it subscribed. A timed run reports the
+ * payload throughput per block size and STmin. Flow control waits, receiver
+ * overflow, a skipped sequence number and the N_Bs and N_Cr timeouts end a
+ * transfer with the matching result.
+ */
+
+#include <stdlib.h>
+#include "canal_test.h"
+#include "canal_fixture.h"
+#include "canal_isotp.h"
+
+#define NODE_A_ID						(0x7E0U)
+#define NODE_B_ID						(0x7E8U)
+#define MAX_PAYLOAD						(5000U)
+
+typedef struct {
+	TsCanAL can;
+	CAN_HandleTypeDef hcan;
+	TsCanALIsoTp isotp;
+	TsCanALIsoTpSession session;
+	uint8_t rxBuf[MAX_PAYLOAD];
+	uint32_t rxLen;
+	TeCanALRet rxResult;
+	uint32_t rxCount;
+	TeCanALRet txResult;
+	uint32_t txCount;
+	// delivered counts the frames of the tx log already put on the bus
+	uint32_t delivered;
+}TsNode;
+
+static TsNode nodeA;
+static TsNode nodeB;
+static uint8_t payloadA[MAX_PAYLOAD];
+static uint8_t payloadB[MAX_PAYLOAD];
+
+static void onRx(void* ctx, TeCanALRet result, const uint8_t* data, uint32_t len) {
+	TsNode* node = (TsNode*)ctx;
+
+	(void)data;
+
+	node->rxResult = result;
+	node->rxLen = len;
+	node->rxCount++;
+}
+
+static void onTx(void* ctx, TeCanALRet result) {
+	TsNode* node = (TsNode*)ctx;
+
+	node->txResult = result;
+	node->txCount++;
+}
+
+// countHook counts the frames it sees in the uint32_t at ctx
+static bool countHook(void* ctx, const TsCanALRawFrame* frame) {
+	(void)frame;
+
+	(*(uint32_t*)ctx)++;
+
+	return false;
+}
+
+static void openNode(TsNode* node, TeCanALInstance canNum, uint32_t txId, uint32_t rxId,
+		uint8_t blockSize) {
+	TsCanALIsoTpConfig config = { .txId = txId, .rxId = rxId, .blockSize = blockSize };
+
+	memset(node, 0, sizeof(*node));
+	Test_InitCan(&node->can, &node->hcan, canNum, CANAL_RX_MODE_IMMEDIATE);
+	CanAL_IsoTp_Init(&node->isotp, NULL);
+	CanAL_IsoTp_Open(&node->isotp, &node->session, &config, node->rxBuf, sizeof(node->rxBuf),
+		onRx, onTx, node);
+}
+
+static void setUp(uint8_t blockSizeA, uint8_t blockSizeB) {
+	Stub_Reset();
+	openNode(&nodeA, CANAL_INST_CAN_1, NODE_A_ID, NODE_B_ID, blockSizeA);
+	openNode(&nodeB, CANAL_INST_CAN_2, NODE_B_ID, NODE_A_ID, blockSizeB);
+	CanAL_IsoTp_Attach(&nodeA.isotp, &nodeA.can);
+	CanAL_IsoTp_Attach(&nodeB.isotp, &nodeB.can);
+
+	srand(7);
+	for (uint32_t i = 0; i < MAX_PAYLOAD; i++) {
+		payloadA[i] = (uint8_t)rand();
+		payloadB[i] = (uint8_t)rand();
+	}
+}
+
+// wire puts every frame that from has sent on the bus for to to receive, and
+// frees its mailbox the way the tx complete interrupt would
+static uint32_t wire(TsNode* from, TsNode* to) {
+	CAN_TypeDef* instance = from->hcan.Instance;
+	uint32_t moved = 0;
+
+	while (from->delivered < Stub_CanTxCount(instance)) {
+		uint32_t mailbox = Stub_CanTxMailbox(instance, from->delivered);
+
+		Stub_CanPushRx(to->hcan.Instance, CAN_RX_FIFO0, Stub_CanTx(instance, from->delivered));
+		from->delivered++;
+		Test_RxIsr(&to->can, CAN_RX_FIFO0);
+
+		Stub_CanReleaseMailbox(instance, mailbox);
+		CanAL_TxMailboxComplete(&from->can, mailbox);
+		moved++;
+	}
+
+	return moved;
+}
+
+// run polls both nodes and moves their frames until the bus stays quiet
+static void run(void) {
+	for (uint32_t idle = 0; idle < 3U; ) {
+		CanAL_IsoTp_Poll(&nodeA.isotp);
+		CanAL_IsoTp_Poll(&nodeB.isotp);
+
+		idle = ((wire(&nodeA, &nodeB) + wire(&nodeB, &nodeA)) == 0U) ? idle + 1U : 0U;
+		Stub_Tick++;
+	}
+}
+
+// simUs is the microsecond clock of the timed runs
+static uint32_t simUs;
+
+static uint32_t simClockUs(void) {
+	return simUs;
+}
+
+// runUntilDone moves nodeA's payload to nodeB, advancing the simulated clock by
+// stepUs per pass, until nodeB has received rxCount payloads
+static bool runUntilDone(uint32_t rxCount, uint32_t stepUs) {
+	for (uint32_t pass = 0; pass < 1000000U; pass++) {
+		CanAL_IsoTp_Poll(&nodeA.isotp);
+		CanAL_IsoTp_Poll(&nodeB.isotp);
+		wire(&nodeA, &nodeB);
+		wire(&nodeB, &nodeA);
+
+		if ((nodeB.rxCount == rxCount) && (nodeA.txCount == rxCount)) return true;
+
+		simUs += stepUs;
+		Stub_Tick = simUs / 1000U;
+	}
+
+	return false;
+}
+
+// inject hands node a frame from its peer
+static void inject(TsNode* node, uint32_t id, const uint8_t* data) {
+	TsCanALRawFrame frame = { .id = id, .ide = CAN_ID_STD, .dlc = 8 };
+
+	memcpy(frame.data, data, 8);
+	CanAL_InjectRx(&node->can, CAN_RX_FIFO0, &frame);
+}
+
+// discard frees the mailboxes of every frame node has sent without putting
+// them on the bus
+static void discard(TsNode* node) {
+	CAN_TypeDef* instance = node->hcan.Instance;
+
+	while (node->delivered < Stub_CanTxCount(instance)) {
+		uint32_t mailbox = Stub_CanTxMailbox(instance, node->delivered++);
+
+		Stub_CanReleaseMailbox(instance, mailbox);
+		CanAL_TxMailboxComplete(&node->can, mailbox);
+	}
+}
+
+static void test_both_directions_at_once(void) {
+	static const uint32_t lengths[] = { 1, 7, 8, 62, 4095, MAX_PAYLOAD };
+	static const uint8_t blockSizes[] = { 0, 1, 3 };
+
+	for (uint32_t b = 0; b < sizeof(blockSizes); b++) {
+		for (uint32_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+			uint32_t lenA = lengths[l];
+			uint32_t lenB = lengths[(l + 1U) % (sizeof(lengths) / sizeof(lengths[0]))];
+
+			setUp(blockSizes[b], blockSizes[(b + 1U) % sizeof(blockSizes)]);
+
+			TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Send(&nodeA.session, payloadA, lenA));
+			TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Send(&nodeB.session, payloadB, lenB));
+			TEST_ASSERT_EQUAL(CANAL_BUSY, CanAL_IsoTp_Send(&nodeA.session, payloadA, lenA));
+			run();
+
+			TEST_ASSERT_EQUAL(1, nodeA.txCount);
+			TEST_ASSERT_EQUAL(CANAL_OK, nodeA.txResult);
+			TEST_ASSERT_EQUAL(1, nodeB.rxCount);
+			TEST_ASSERT_EQUAL(CANAL_OK, nodeB.rxResult);
+			TEST_ASSERT_EQUAL(lenA, nodeB.rxLen);
+			TEST_ASSERT_EQUAL(0, memcmp(payloadA, nodeB.rxBuf, lenA));
+
+			TEST_ASSERT_EQUAL(1, nodeB.txCount);
+			TEST_ASSERT_EQUAL(1, nodeA.rxCount);
+			TEST_ASSERT_EQUAL(lenB, nodeA.rxLen);
+			TEST_ASSERT_EQUAL(0, memcmp(payloadB, nodeA.rxBuf, lenB));
+		}
+	}
+}
+
+static void test_consecutive_frames_capped_per_poll(void) {
+	uint32_t before;
+
+	setUp(0, 0);
+	CanAL_IsoTp_Send(&nodeA.session, payloadA, 200);
+	// First frame out, flow control back
+	wire(&nodeA, &nodeB);
+	wire(&nodeB, &nodeA);
+
+	// Frames beyond the three mailboxes wait in the tx queue
+	before = Stub_CanTxCount(CAN1) + nodeA.can.txQueue.count;
+	CanAL_IsoTp_Poll(&nodeA.isotp);
+	TEST_ASSERT_EQUAL(CANAL_ISOTP_MAX_CF_PER_POLL,
+		Stub_CanTxCount(CAN1) + nodeA.can.txQueue.count - before);
+}
+
+static void test_tx_reserve_left_to_application(void) {
+	uint32_t before;
+
+	setUp(0, 0);
+	CanAL_IsoTp_Send(&nodeA.session, payloadA, 200);
+	wire(&nodeA, &nodeB);
+	wire(&nodeB, &nodeA);
+
+	// Three frames in the mailboxes and the queue filled up to the reserve
+	for (uint32_t i = 0; i < 3U + CANAL_TX_QUEUE_SIZE - CANAL_ISOTP_TX_RESERVE; i++) {
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Transmit(&nodeA.can, MSG_A));
+	}
+
+	before = Stub_CanTxCount(CAN1);
+	CanAL_IsoTp_Poll(&nodeA.isotp);
+	TEST_ASSERT_EQUAL(before, Stub_CanTxCount(CAN1));
+	TEST_ASSERT_EQUAL(CANAL_TX_QUEUE_SIZE - CANAL_ISOTP_TX_RESERVE, nodeA.can.txQueue.count);
+
+	// The application still has the reserve
+	for (uint32_t i = 0; i < CANAL_ISOTP_TX_RESERVE; i++) {
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Transmit(&nodeA.can, MSG_A));
+	}
+}
+
+// The receiver's block size and STmin pace the sender. Every run moves
+// THROUGHPUT_RUNS payloads and reports the host time spent in the stack and
+// the simulated bus time.
+#define THROUGHPUT_RUNS					(10U)
+#define THROUGHPUT_STEP_US				(100U)
+
+static void test_throughput(void) {
+	static const uint8_t blockSizes[] = { 0, 8, 32 };
+	static const uint8_t stMins[] = { 0x00, 0xF5, 0x01 };
+
+	for (uint32_t b = 0; b < sizeof(blockSizes); b++) {
+		for (uint32_t s = 0; s < sizeof(stMins); s++) {
+			uint64_t start;
+			uint64_t hostNs;
+			uint32_t startUs;
+			uint32_t busUs;
+
+			setUp(0, blockSizes[b]);
+			nodeA.isotp.clockUs = simClockUs;
+			nodeB.isotp.clockUs = simClockUs;
+			nodeB.session.config.stMin = stMins[s];
+			simUs = Stub_Tick * 1000U;
+			startUs = simUs;
+
+			start = Test_NowNs();
+			for (uint32_t run = 1; run <= THROUGHPUT_RUNS; run++) {
+				TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Send(&nodeA.session, payloadA, MAX_PAYLOAD));
+				TEST_ASSERT(runUntilDone(run, THROUGHPUT_STEP_US));
+			}
+			hostNs = Test_NowNs() - start;
+			busUs = simUs - startUs;
+
+			TEST_ASSERT_EQUAL(CANAL_OK, nodeB.rxResult);
+			TEST_ASSERT_EQUAL(0, memcmp(payloadA, nodeB.rxBuf, MAX_PAYLOAD));
+			TEST_ASSERT_EQUAL(THROUGHPUT_RUNS * MAX_PAYLOAD, nodeB.session.stats.rxBytes);
+
+			printf("  BS %2u STmin 0x%02X: host %7.1f MB/s, simulated bus %7.1f kB/s\n",
+				blockSizes[b], stMins[s],
+				(double)(THROUGHPUT_RUNS * MAX_PAYLOAD) * 1000.0 / (double)hostNs,
+				(double)(THROUGHPUT_RUNS * MAX_PAYLOAD) * 1000.0 / (double)busUs);
+		}
+	}
+}
+
+static void test_flow_control_wait(void) {
+	static const uint8_t wait[8] = { 0x31 };
+	static const uint8_t cts[8] = { 0x30 };
+
+	// CANAL_ISOTP_MAX_WAIT waits in a row are accepted, each one restarting N_Bs
+	setUp(0, 0);
+	CanAL_IsoTp_Send(&nodeA.session, payloadA, 20);
+	for (uint32_t i = 0; i < CANAL_ISOTP_MAX_WAIT; i++) {
+		Stub_Tick += CANAL_ISOTP_TIMEOUT_MS - 1U;
+		inject(&nodeA, NODE_B_ID, wait);
+		CanAL_IsoTp_Poll(&nodeA.isotp);
+		TEST_ASSERT_EQUAL(CANAL_ISOTP_TX_WAIT_FC, nodeA.session.txState);
+	}
+	inject(&nodeA, NODE_B_ID, cts);
+	CanAL_IsoTp_Poll(&nodeA.isotp);
+	discard(&nodeA);
+	CanAL_IsoTp_Poll(&nodeA.isotp);
+	TEST_ASSERT_EQUAL(1, nodeA.txCount);
+	TEST_ASSERT_EQUAL(CANAL_OK, nodeA.txResult);
+
+	// One more aborts the transfer
+	setUp(0, 0);
+	CanAL_IsoTp_Send(&nodeA.session, payloadA, 20);
+	for (uint32_t i = 0; i <= CANAL_ISOTP_MAX_WAIT; i++) inject(&nodeA, NODE_B_ID, wait);
+	CanAL_IsoTp_Poll(&nodeA.isotp);
+	TEST_ASSERT_EQUAL(1, nodeA.txCount);
+	TEST_ASSERT_EQUAL(CANAL_TIMEOUT, nodeA.txResult);
+	TEST_ASSERT_EQUAL(1, nodeA.session.stats.txErrors);
+}
+
+static void test_flow_control_overflow(void) {
+	setUp(0, 0);
+	nodeB.session.rxSize = 100;
+
+	CanAL_IsoTp_Send(&nodeA.session, payloadA, 101);
+	run();
+	TEST_ASSERT_EQUAL(1, nodeA.txCount);
+	TEST_ASSERT_EQUAL(CANAL_BUFFER_OVERFLOW, nodeA.txResult);
+	TEST_ASSERT_EQUAL(0, nodeB.rxCount);
+	TEST_ASSERT_EQUAL(1, nodeB.session.stats.rxErrors);
+
+	// A payload that fits still goes through
+	CanAL_IsoTp_Send(&nodeA.session, payloadA, 100);
+	run();
+	TEST_ASSERT_EQUAL(1, nodeB.rxCount);
+	TEST_ASSERT_EQUAL(CANAL_OK, nodeB.rxResult);
+}
+
+static void test_wrong_sequence_number(void) {
+	static const uint8_t first[8] = { 0x10, 20, 1, 2, 3, 4, 5, 6 };
+	static const uint8_t skipped[8] = { 0x22, 7, 8, 9, 10, 11, 12, 13 };
+
+	setUp(0, 0);
+	inject(&nodeB, NODE_A_ID, first);
+	inject(&nodeB, NODE_A_ID, skipped);
+	CanAL_IsoTp_Poll(&nodeB.isotp);
+
+	TEST_ASSERT_EQUAL(1, nodeB.rxCount);
+	TEST_ASSERT_EQUAL(CANAL_ERROR, nodeB.rxResult);
+	TEST_ASSERT_EQUAL(6, nodeB.rxLen);
+	TEST_ASSERT_EQUAL(1, nodeB.session.stats.rxErrors);
+}
+
+static void test_timeouts(void) {
+	static const uint8_t first[8] = { 0x10, 20, 1, 2, 3, 4, 5, 6 };
+	static const uint8_t next[8] = { 0x21, 7, 8, 9, 10, 11, 12, 13 };
+
+	// N_Bs: no flow control after the first frame
+	setUp(0, 0);
+	CanAL_IsoTp_Send(&nodeA.session, payloadA, 20);
+	Stub_Tick += CANAL_ISOTP_TIMEOUT_MS - 1U;
+	CanAL_IsoTp_Poll(&nodeA.isotp);
+	TEST_ASSERT_EQUAL(0, nodeA.txCount);
+	Stub_Tick++;
+	CanAL_IsoTp_Poll(&nodeA.isotp);
+	TEST_ASSERT_EQUAL(1, nodeA.txCount);
+	TEST_ASSERT_EQUAL(CANAL_TIMEOUT, nodeA.txResult);
+
+	// N_Cr: the next consecutive frame does not come, each one restarts it
+	setUp(0, 0);
+	inject(&nodeB, NODE_A_ID, first);
+	Stub_Tick += CANAL_ISOTP_TIMEOUT_MS - 1U;
+	inject(&nodeB, NODE_A_ID, next);
+	Stub_Tick += CANAL_ISOTP_TIMEOUT_MS - 1U;
+	CanAL_IsoTp_Poll(&nodeB.isotp);
+	TEST_ASSERT_EQUAL(0, nodeB.rxCount);
+	Stub_Tick++;
+	CanAL_IsoTp_Poll(&nodeB.isotp);
+	TEST_ASSERT_EQUAL(1, nodeB.rxCount);
+	TEST_ASSERT_EQUAL(CANAL_TIMEOUT, nodeB.rxResult);
+	TEST_ASSERT_EQUAL(13, nodeB.rxLen);
+}
+
+static void test_attach_keeps_other_hooks(void) {
+	TsCanALRxHookNode other = {0};
+	uint32_t seen = 0;
+
+	setUp(0, 0);
+	CanAL_IsoTp_Detach(&nodeA.isotp);
+	CanAL_AddRxHook(&nodeA.can, &other, countHook, &seen);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Attach(&nodeA.isotp, &nodeA.can));
+
+	// Both hooks see the transfer
+	CanAL_IsoTp_Send(&nodeB.session, payloadB, 3);
+	run();
+	TEST_ASSERT_EQUAL(1, nodeA.rxCount);
+	TEST_ASSERT_EQUAL(3, nodeA.rxLen);
+	TEST_ASSERT_EQUAL(1, seen);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Detach(&nodeA.isotp));
+	TEST_ASSERT(nodeA.can.rxHooks == &other);
+	TEST_ASSERT(other.next == NULL);
+	CanAL_RemoveRxHook(&nodeA.can, &other);
+}
+
+static void test_detach_unsubscribes_own_ids(void) {
+	TsCanALIsoTpSession second;
+	uint8_t rxBuf[8];
+	TsCanALIsoTpConfig config = { .txId = NODE_A_ID + 1U, .rxId = NODE_B_ID + 1U };
+	uint16_t numRxIds;
+
+	setUp(0, 0);
+	CanAL_IsoTp_Detach(&nodeA.isotp);
+	numRxIds = nodeA.can.numRxIds;
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Attach(&nodeA.isotp, &nodeA.can));
+	TEST_ASSERT_EQUAL(numRxIds + 1U, nodeA.can.numRxIds);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Open(&nodeA.isotp, &second, &config, rxBuf,
+		sizeof(rxBuf), NULL, NULL, NULL));
+	TEST_ASSERT_EQUAL(numRxIds + 2U, nodeA.can.numRxIds);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_IsoTp_Detach(&nodeA.isotp));
+	TEST_ASSERT_EQUAL(numRxIds, nodeA.can.numRxIds);
+}
+
+int main(void) {
+	TEST_RUN(test_both_directions_at_once);
+	TEST_RUN(test_consecutive_frames_capped_per_poll);
+	TEST_RUN(test_tx_reserve_left_to_application);
+	TEST_RUN(test_throughput);
+	TEST_RUN(test_flow_control_wait);
+	TEST_RUN(test_flow_control_overflow);
+	TEST_RUN(test_wrong_sequence_number);
+	TEST_RUN(test_timeouts);
+	TEST_RUN(test_attach_keeps_other_hooks);
+	TEST_RUN(test_detach_unsubscribes_own_ids);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,59 @@
+/*
+ * test_legacy_codecs.c
+ *
+ * canal built against a canal_messages.h without CANAL_MESSAGE_LIST still
+ * receives through UnmarshalBinary and sends through GetTxDataLength and
+ * MarshalBinary.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+
+static void setUp(void) {
+	Legacy_Rx = 0;
+	Legacy_Tx = 0;
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+}
+
+static void test_accepts_every_frame(void) {
+	setUp();
+
+	TEST_ASSERT_EQUAL(0, can.numRxIds);
+
+	TEST_ASSERT(Test_BusFrame(&can, CAN_RX_FIFO0, LEGACY_RX, CAN_ID_STD, 0));
+	TEST_ASSERT_EQUAL(CANAL_OK, Test_RxIsr(&can, CAN_RX_FIFO0));
+	TEST_ASSERT_EQUAL(1, Legacy_Rx);
+
+	TEST_ASSERT(Test_BusFrame(&can, CAN_RX_FIFO0, LEGACY_RX + 1U, CAN_ID_STD, 0));
+	Test_RxIsr(&can, CAN_RX_FIFO0);
+	TEST_ASSERT_EQUAL(1, Legacy_Rx);
+}
+
+static void test_transmit_uses_data_length(void) {
+	const TsStubCanFrame* frame;
+
+	setUp();
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Transmit(&can, LEGACY_TX));
+	TEST_ASSERT_EQUAL(1, Stub_CanTxCount(hcan.Instance));
+
+	frame = Stub_CanTx(hcan.Instance, 0);
+	TEST_ASSERT_EQUAL(LEGACY_TX, frame->id);
+	TEST_ASSERT_EQUAL(CAN_ID_EXT, frame->ide);
+	TEST_ASSERT_EQUAL(1, frame->dlc);
+	TEST_ASSERT_EQUAL(0xA5, frame->data[0]);
+
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_TX_MESSAGE, CanAL_Transmit(&can, LEGACY_RX));
+	TEST_ASSERT_EQUAL(1, Legacy_Tx);
+}
+
+int main(void) {
+	TEST_RUN(test_accepts_every_frame);
+	TEST_RUN(test_transmit_uses_data_length);
+
+	return TEST_RESULT();
+}
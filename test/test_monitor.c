@@ -0,0 +1,185 @@
+/*
+ * test_monitor.c
+ *
+ * The stale message monitor: handlers that fire once per stale event, lazy
+ * re-keying of deadlines, revival when a message comes back, and the limits
+ * of the watch table.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+#include "canal_monitor.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+static TsCanALMonitor mon;
+static uint32_t staleCalls;
+static uint32_t staleId;
+
+static void onStale(uint32_t ID) {
+	staleCalls++;
+	staleId = ID;
+}
+
+static void inject(uint32_t id, uint8_t dlc) {
+	TsCanALRawFrame frame = { .id = id, .ide = CAN_ID_STD, .dlc = dlc };
+
+	CanAL_InjectRx(&can, CAN_RX_FIFO0, &frame);
+}
+
+// pollAt polls the monitor with the tick set to now
+static void pollAt(uint32_t now) {
+	Stub_Tick = now;
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Monitor_Poll(&mon));
+}
+
+// setUp receives MSG_A and MSG_B at base so every test starts from known update
+// ticks, whatever earlier tests left behind
+static void setUp(uint32_t base) {
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+	Stub_Tick = base;
+	inject(MSG_A, 8);
+	inject(MSG_B, 4);
+	CanAL_Monitor_Init(&mon);
+	staleCalls = 0;
+	staleId = 0;
+}
+
+static void test_handler_fires_once(void) {
+	uint8_t handle;
+
+	setUp(0);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Monitor_Watch(&mon, MSG_A, 100, onStale, &handle));
+
+	pollAt(99);
+	TEST_ASSERT(!CanAL_Monitor_IsStale(&mon, handle));
+	TEST_ASSERT_EQUAL(0, staleCalls);
+
+	pollAt(100);
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, handle));
+	TEST_ASSERT_EQUAL(1, staleCalls);
+	TEST_ASSERT_EQUAL(MSG_A, staleId);
+
+	pollAt(101);
+	pollAt(500);
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, handle));
+	TEST_ASSERT_EQUAL(1, staleCalls);
+}
+
+static void test_lazy_rekey(void) {
+	uint8_t a;
+	uint8_t b;
+
+	setUp(0);
+	CanAL_Monitor_Watch(&mon, MSG_A, 100, onStale, &a);
+	CanAL_Monitor_Watch(&mon, MSG_B, 120, onStale, &b);
+
+	// MSG_A arrives after its deadline was stored, so the heap still says 100
+	Stub_Tick = 60;
+	inject(MSG_A, 8);
+
+	pollAt(100);
+	TEST_ASSERT(!CanAL_Monitor_IsStale(&mon, a));
+	TEST_ASSERT_EQUAL(0, staleCalls);
+
+	// The re-keyed deadline of MSG_A (160) now sorts after MSG_B (120)
+	pollAt(120);
+	TEST_ASSERT(!CanAL_Monitor_IsStale(&mon, a));
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, b));
+	TEST_ASSERT_EQUAL(1, staleCalls);
+	TEST_ASSERT_EQUAL(MSG_B, staleId);
+
+	pollAt(159);
+	TEST_ASSERT(!CanAL_Monitor_IsStale(&mon, a));
+
+	pollAt(160);
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, a));
+	TEST_ASSERT_EQUAL(2, staleCalls);
+	TEST_ASSERT_EQUAL(MSG_A, staleId);
+}
+
+static void test_revival(void) {
+	uint8_t handle;
+
+	setUp(0);
+	CanAL_Monitor_Watch(&mon, MSG_A, 100, onStale, &handle);
+	pollAt(100);
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, handle));
+
+	// Polling again without the message does not revive it
+	pollAt(250);
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, handle));
+
+	Stub_Tick = 300;
+	inject(MSG_A, 8);
+	pollAt(301);
+	TEST_ASSERT(!CanAL_Monitor_IsStale(&mon, handle));
+	TEST_ASSERT_EQUAL(1, staleCalls);
+
+	// The revived watch is timed from the frame that brought it back
+	pollAt(399);
+	TEST_ASSERT(!CanAL_Monitor_IsStale(&mon, handle));
+	pollAt(400);
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, handle));
+	TEST_ASSERT_EQUAL(2, staleCalls);
+}
+
+static void test_deadline_across_tick_wrap(void) {
+	uint8_t handle;
+
+	setUp(0xFFFFFFC0U);
+	CanAL_Monitor_Watch(&mon, MSG_A, 100, onStale, &handle);
+
+	pollAt(0xFFFFFFFFU);
+	pollAt(0x23);
+	TEST_ASSERT(!CanAL_Monitor_IsStale(&mon, handle));
+
+	pollAt(0x24);
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, handle));
+	TEST_ASSERT_EQUAL(1, staleCalls);
+}
+
+static void test_is_stale_out_of_range(void) {
+	uint8_t handle;
+
+	setUp(0);
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, 0));
+
+	CanAL_Monitor_Watch(&mon, MSG_A, 100, NULL, &handle);
+	TEST_ASSERT(!CanAL_Monitor_IsStale(&mon, handle));
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, handle + 1U));
+	TEST_ASSERT(CanAL_Monitor_IsStale(&mon, 0xFF));
+	TEST_ASSERT(CanAL_Monitor_IsStale(NULL, handle));
+}
+
+static void test_watch_table_full(void) {
+	uint8_t handle;
+
+	setUp(0);
+	TEST_ASSERT_EQUAL(CANAL_NULL_REF, CanAL_Monitor_Watch(&mon, MSG_A, 100, NULL, NULL));
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_RX_MESSAGE, CanAL_Monitor_Watch(&mon, MSG_T, 100, NULL, &handle));
+
+	for (uint32_t i = 0; i < CANAL_MONITOR_MAX_WATCHES; i++) {
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Monitor_Watch(&mon, MSG_A, 10 + i, onStale, &handle));
+		TEST_ASSERT_EQUAL(i, handle);
+	}
+	TEST_ASSERT_EQUAL(CANAL_ERROR, CanAL_Monitor_Watch(&mon, MSG_B, 100, onStale, &handle));
+	TEST_ASSERT_EQUAL(CANAL_MONITOR_MAX_WATCHES - 1U, handle);
+
+	// Every watch in the full table still goes stale exactly once
+	pollAt(10 + CANAL_MONITOR_MAX_WATCHES);
+	pollAt(1000);
+	TEST_ASSERT_EQUAL(CANAL_MONITOR_MAX_WATCHES, staleCalls);
+}
+
+int main(void) {
+	TEST_RUN(test_handler_fires_once);
+	TEST_RUN(test_lazy_rekey);
+	TEST_RUN(test_revival);
+	TEST_RUN(test_deadline_across_tick_wrap);
+	TEST_RUN(test_is_stale_out_of_range);
+	TEST_RUN(test_watch_table_full);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,196 @@
+/*
+ * test_printf.c
+ *
+ * Buffered stdout over the uart tx ring and a tx DMA model. Lines written
+ * from the main loop reach the wire in order, an interrupt that prints in the
+ * middle of a write or drain loses nothing, and every byte is either sent or
+ * counted as dropped under both flush policies. A uart without a tx ring, or
+ * with one that blocks when full, is refused.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "canal_test.h"
+#include "printf.h"
+
+#define LINES							(200000U)
+#define TX_RING_SIZE					(4096U)
+
+static UART_HandleTypeDef huart;
+static DMA_HandleTypeDef hdmatx;
+static UART_st uart;
+static UART_Tx_Ring_st ring;
+static uint8_t txBuf[TX_RING_SIZE];
+
+static const uint8_t* dmaSrc;
+static uint32_t dmaLeft;
+static bool dmaBusy;
+static bool inIsr;
+static char wire[1U << 23];
+static uint32_t wireLen;
+static uint32_t isrLines;
+static uint64_t isrBytes;
+
+// isrPrint is an interrupt that prints while the main loop is inside stdout
+static void isrPrint(void) {
+	char line[32];
+	int len = snprintf(line, sizeof(line), "<isr %u>\n", isrLines++);
+
+	inIsr = true;
+	_write(1, line, len);
+	isrBytes += (uint64_t)len;
+	inIsr = false;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* h, const uint8_t* data, uint16_t size) {
+	(void)h;
+
+	if (dmaBusy) return HAL_BUSY;
+
+	dmaSrc = data;
+	dmaLeft = size;
+	dmaBusy = true;
+
+	if (!inIsr && ((rand() % 4) == 0)) isrPrint();
+
+	return HAL_OK;
+}
+
+static void dmaStep(uint32_t bytes) {
+	while ((bytes-- > 0U) && dmaBusy) {
+		wire[wireLen++] = (char)*dmaSrc++;
+
+		if (--dmaLeft == 0U) {
+			dmaBusy = false;
+			UART_Tx_Complete(&huart);
+		}
+	}
+}
+
+static void drainAll(void) {
+	do {
+		Printf_Flush();
+		dmaStep(TX_RING_SIZE);
+	} while (dmaBusy);
+}
+
+static void setUp(TePrintf_Flush flush) {
+	memset(&huart, 0, sizeof(huart));
+	huart.hdmatx = &hdmatx;
+	uart = (UART_st){ .huart = &huart, .uart_num = 1, .baudrate = UART_115200,
+		.datasize = UART_Datasize_8, .mode = UART_TX };
+	dmaBusy = false;
+	wireLen = 0;
+	isrLines = 0;
+	isrBytes = 0;
+	srand(5);
+
+	TEST_ASSERT_EQUAL(UART_OK, UART_Tx_Ring_Init(&uart, &ring, txBuf, TX_RING_SIZE, UART_OVERFLOW_DROP));
+	TEST_ASSERT_EQUAL(UART_OK, Printf_Init_Buffered(&uart, flush));
+}
+
+// stream writes LINES lines, some of them unterminated, while the DMA sends
+// up to dmaPace bytes per line, and checks that every byte is accounted for
+static void stream(TePrintf_Flush flush, uint32_t flushEvery, uint32_t dmaPace) {
+	TsPrintf_Stats before;
+	TsPrintf_Stats stats;
+	UART_Tx_Stats_st txStats;
+	uint64_t written = 0;
+	long last = -1;
+	char* p;
+
+	setUp(flush);
+	Printf_Get_Stats(&before);
+
+	for (uint32_t i = 0; i < LINES; i++) {
+		char line[32];
+		int len = snprintf(line, sizeof(line), "line %u%s", i, ((rand() % 3) != 0) ? "\n" : " ");
+
+		TEST_ASSERT_EQUAL(len, _write(1, line, len));
+		written += (uint64_t)len;
+
+		dmaStep((uint32_t)rand() % dmaPace);
+		if ((i % flushEvery) == 0U) Printf_Flush();
+	}
+	drainAll();
+
+	Printf_Get_Stats(&stats);
+	UART_Tx_Get_Stats(&uart, &txStats);
+	printf("  %u lines and %u from interrupts, %u dropped by stdout, %u by the uart, high water %u\n",
+		LINES, isrLines, stats.dropped - before.dropped, txStats.dropped, stats.high_water);
+
+	TEST_ASSERT_EQUAL(0, stats.pending);
+	TEST_ASSERT(isrLines > 0U);
+	TEST_ASSERT_EQUAL(written + isrBytes,
+		(uint64_t)wireLen + (stats.dropped - before.dropped) + txStats.dropped);
+
+	// Lines from the main loop stay in order around the interrupt's lines.
+	// Dropping cuts lines short, so only a lossless run is checked.
+	if ((uint64_t)wireLen != written + isrBytes) return;
+
+	wire[wireLen] = '\0';
+	for (p = wire; (p = strstr(p, "line ")) != NULL; ) {
+		long n = strtol(p + 5, &p, 10);
+
+		TEST_ASSERT(n > last);
+		last = n;
+	}
+}
+
+static void test_flush_on_newline(void) {
+	stream(PRINTF_FLUSH_NEWLINE, 100, 30);
+}
+
+static void test_flush_on_threshold(void) {
+	// A DMA slower than the writer, so the rings overflow
+	stream(PRINTF_FLUSH_THRESHOLD, 500, 16);
+}
+
+static void test_full_ring_drops_and_never_waits(void) {
+	static char text[PRINTF_BUFFER_SIZE];
+	TsPrintf_Stats before;
+	TsPrintf_Stats stats;
+
+	setUp(PRINTF_FLUSH_NEWLINE);
+	memset(text, 'x', sizeof(text));
+	Printf_Get_Stats(&before);
+
+	// No newline, so nothing drains until the main loop flushes
+	TEST_ASSERT_EQUAL(PRINTF_BUFFER_SIZE, _write(1, text, PRINTF_BUFFER_SIZE));
+	TEST_ASSERT_EQUAL(100, _write(1, text, 100));
+
+	Printf_Get_Stats(&stats);
+	TEST_ASSERT_EQUAL(PRINTF_BUFFER_SIZE, stats.pending);
+	TEST_ASSERT_EQUAL(PRINTF_BUFFER_SIZE, stats.high_water);
+	TEST_ASSERT_EQUAL(100, stats.dropped - before.dropped);
+	TEST_ASSERT_EQUAL(0, wireLen);
+
+	drainAll();
+	Printf_Get_Stats(&stats);
+	TEST_ASSERT_EQUAL(0, stats.pending);
+	TEST_ASSERT_EQUAL(PRINTF_BUFFER_SIZE, wireLen);
+}
+
+static void test_init_refuses_blocking_ring(void) {
+	UART_st noRing = { .huart = &huart, .uart_num = 2, .baudrate = UART_115200,
+		.datasize = UART_Datasize_8, .mode = UART_TX };
+
+	setUp(PRINTF_FLUSH_NEWLINE);
+	TEST_ASSERT_EQUAL(UART_INVALID_MODE, Printf_Init_Buffered(&noRing, PRINTF_FLUSH_NEWLINE));
+	TEST_ASSERT_EQUAL(UART_INVALID_MODE, Printf_Init_Buffered(&uart, (TePrintf_Flush)3));
+
+	TEST_ASSERT_EQUAL(UART_OK, UART_Tx_Ring_Init(&uart, &ring, txBuf, TX_RING_SIZE, UART_OVERFLOW_BLOCK));
+	TEST_ASSERT_EQUAL(UART_INVALID_MODE, Printf_Init_Buffered(&uart, PRINTF_FLUSH_NEWLINE));
+
+	TEST_ASSERT_EQUAL(UART_OK, UART_Tx_Ring_Init(&uart, &ring, txBuf, TX_RING_SIZE, UART_OVERFLOW_OVERWRITE));
+	TEST_ASSERT_EQUAL(UART_OK, Printf_Init_Buffered(&uart, PRINTF_FLUSH_NEWLINE));
+}
+
+int main(void) {
+	TEST_RUN(test_flush_on_newline);
+	TEST_RUN(test_flush_on_threshold);
+	TEST_RUN(test_full_ring_drops_and_never_waits);
+	TEST_RUN(test_init_refuses_blocking_ring);
+
+	return TEST_RESULT();
+}
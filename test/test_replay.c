@@ -0,0 +1,131 @@
+/*
+ * test_replay.c
+ *
+ * Captures played back through CanAL_InjectRx: real-time pacing starts at the
+ * first record however long the trace waited for it, frames go to the target
+ * of their bus, and tx records and unknown IDs are counted.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+#include "canal_replay.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+static TsCanALReplay replay;
+static uint8_t capture[256];
+static uint32_t captureLen;
+static uint32_t simUs;
+
+static uint32_t clockUs(void) {
+	return simUs;
+}
+
+static void setUp(TeCanALRxMode rxMode) {
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, rxMode);
+	memset(&Test_Rx_A, 0, sizeof(Test_Rx_A));
+	memset(&Test_Rx_B, 0, sizeof(Test_Rx_B));
+	captureLen = 0;
+	simUs = 1000;
+}
+
+static void record(uint32_t deltaUs, uint32_t id, uint8_t bus, bool tx) {
+	TsCanALTraceRecord rec;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.deltaUs = deltaUs;
+	rec.frame.id = id;
+	rec.frame.ide = CAN_ID_STD;
+	rec.frame.dlc = 8;
+	rec.bus = bus;
+	rec.tx = tx;
+
+	captureLen += CanAL_Trace_EncodeRecord(&rec, &capture[captureLen]);
+}
+
+static void test_real_time_starts_at_first_record(void) {
+	setUp(CANAL_RX_MODE_IMMEDIATE);
+	// The trace waited five seconds for its trigger
+	record(5000000, MSG_A, CANAL_INST_CAN_1, false);
+	record(1000, MSG_A, CANAL_INST_CAN_1, false);
+	record(1000, MSG_B, CANAL_INST_CAN_1, false);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Replay_Init(&replay, capture, captureLen, &can,
+		CAN_RX_FIFO0, CANAL_REPLAY_REAL_TIME, clockUs));
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Replay_Poll(&replay, 0));
+	TEST_ASSERT_EQUAL(1, Test_Rx_A.count);
+
+	simUs += 999;
+	CanAL_Replay_Poll(&replay, 0);
+	TEST_ASSERT_EQUAL(1, Test_Rx_A.count);
+
+	simUs += 1;
+	CanAL_Replay_Poll(&replay, 0);
+	TEST_ASSERT_EQUAL(2, Test_Rx_A.count);
+	TEST_ASSERT(!CanAL_Replay_Finished(&replay));
+
+	simUs += 1000;
+	CanAL_Replay_Poll(&replay, 0);
+	TEST_ASSERT_EQUAL(1, Test_Rx_B.count);
+	TEST_ASSERT(CanAL_Replay_Finished(&replay));
+}
+
+static void test_speed_scales_gaps(void) {
+	setUp(CANAL_RX_MODE_IMMEDIATE);
+	record(300, MSG_A, CANAL_INST_CAN_1, false);
+	record(4000, MSG_A, CANAL_INST_CAN_1, false);
+
+	CanAL_Replay_Init(&replay, capture, captureLen, &can, CAN_RX_FIFO0, 4, clockUs);
+	CanAL_Replay_Poll(&replay, 0);
+	TEST_ASSERT_EQUAL(1, Test_Rx_A.count);
+
+	simUs += 1000;
+	CanAL_Replay_Poll(&replay, 0);
+	TEST_ASSERT_EQUAL(2, Test_Rx_A.count);
+}
+
+static void test_targets_tx_and_failures(void) {
+	TsCanALReplayReport report;
+
+	setUp(CANAL_RX_MODE_DEFERRED);
+	record(10, MSG_A, CANAL_INST_CAN_1, false);
+	record(10, MSG_A, CANAL_INST_CAN_1, true);
+	record(10, MSG_B, CANAL_INST_CAN_2, false);
+	record(10, 0x7AB, CANAL_INST_CAN_1, false);
+	record(10, MSG_B, CANAL_INST_CAN_1, false);
+
+	CanAL_Replay_Init(&replay, capture, captureLen, &can, CAN_RX_FIFO0,
+		CANAL_REPLAY_AS_FAST_AS_POSSIBLE, NULL);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Replay_SetTarget(&replay, CANAL_INST_CAN_2, NULL));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Replay_Run(&replay));
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Replay_GetReport(&replay, &report));
+	TEST_ASSERT_EQUAL(3, report.frames);
+	TEST_ASSERT_EQUAL(1, report.failed);
+	TEST_ASSERT_EQUAL(2, report.skipped);
+	TEST_ASSERT_EQUAL(1, Test_Rx_A.count);
+	TEST_ASSERT_EQUAL(1, Test_Rx_B.count);
+}
+
+static void test_truncated_capture(void) {
+	setUp(CANAL_RX_MODE_IMMEDIATE);
+	record(10, MSG_A, CANAL_INST_CAN_1, false);
+	record(10, MSG_A, CANAL_INST_CAN_1, false);
+
+	CanAL_Replay_Init(&replay, capture, captureLen - 1U, &can, CAN_RX_FIFO0,
+		CANAL_REPLAY_AS_FAST_AS_POSSIBLE, NULL);
+	TEST_ASSERT_EQUAL(CANAL_ERROR, CanAL_Replay_Run(&replay));
+	TEST_ASSERT_EQUAL(1, Test_Rx_A.count);
+	TEST_ASSERT(CanAL_Replay_Finished(&replay));
+}
+
+int main(void) {
+	TEST_RUN(test_real_time_starts_at_first_record);
+	TEST_RUN(test_speed_scales_gaps);
+	TEST_RUN(test_targets_tx_and_failures);
+	TEST_RUN(test_truncated_capture);
+
+	return TEST_RESULT();
+}
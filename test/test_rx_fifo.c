@@ -0,0 +1,169 @@
+/*
+ * test_rx_fifo.c
+ *
+ * The hardware rx FIFOs, built with MSG_A and MSG_C as CANAL_PRIORITY_RX_IDS:
+ * the priority IDs get exact 32-bit list banks on FIFO1 ahead of the FIFO0
+ * banks, where runs of IDs merge into masks, and the full, overrun and burst
+ * counters are kept per FIFO.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+
+static void setUp(void) {
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+}
+
+// image32 is a frame's identifier as a 32-bit filter register sees it
+static uint32_t image32(uint32_t id, uint32_t ide) {
+	if (ide == CAN_ID_EXT) return (id << 3) | 0x4U;
+
+	return id << 21;
+}
+
+static uint8_t rxIdFifo(uint32_t id) {
+	for (uint16_t i = 0; i < can.numRxIds; i++) {
+		if (can.rxIds[i] == id) return can.rxIdFifo[i];
+	}
+
+	return 0xFF;
+}
+
+// TsBankLayout sums up the last CANAL_FILTER_BANKS_PER_INSTANCE banks written
+typedef struct {
+	uint32_t listed[4];
+	uint32_t numListed;
+	uint32_t fifo0Banks;
+	uint32_t fifo0MaskBanks;
+}TsBankLayout;
+
+static void bankLayout(TsBankLayout* layout) {
+	uint32_t count;
+	const CAN_FilterTypeDef* filters = Stub_CanFilters(&count);
+
+	memset(layout, 0, sizeof(*layout));
+	TEST_ASSERT(count >= CANAL_FILTER_BANKS_PER_INSTANCE);
+	filters += count - CANAL_FILTER_BANKS_PER_INSTANCE;
+
+	for (uint32_t i = 0; i < CANAL_FILTER_BANKS_PER_INSTANCE; i++) {
+		const CAN_FilterTypeDef* f = &filters[i];
+
+		TEST_ASSERT_EQUAL(i, f->FilterBank);
+		if (f->FilterActivation != ENABLE) continue;
+
+		if (f->FilterFIFOAssignment == CAN_FILTER_FIFO1) {
+			// The priority banks come before any FIFO0 bank
+			TEST_ASSERT_EQUAL(0, layout->fifo0Banks);
+			TEST_ASSERT_EQUAL(CAN_FILTERMODE_IDLIST, f->FilterMode);
+			TEST_ASSERT_EQUAL(CAN_FILTERSCALE_32BIT, f->FilterScale);
+			if (layout->numListed < 3U) {
+				layout->listed[layout->numListed++] = (f->FilterIdHigh << 16) | f->FilterIdLow;
+				layout->listed[layout->numListed++] = (f->FilterMaskIdHigh << 16) | f->FilterMaskIdLow;
+			}
+		} else {
+			layout->fifo0Banks++;
+			if (f->FilterMode == CAN_FILTERMODE_IDMASK) layout->fifo0MaskBanks++;
+		}
+	}
+}
+
+static void test_priority_ids_get_list_banks(void) {
+	TsBankLayout layout;
+
+	setUp();
+	TEST_ASSERT_EQUAL(CANAL_PRIORITY_RX_FIFO, rxIdFifo(MSG_A));
+	TEST_ASSERT_EQUAL(CANAL_PRIORITY_RX_FIFO, rxIdFifo(MSG_C));
+	TEST_ASSERT_EQUAL(DEFAULT_RX_FIFO, rxIdFifo(MSG_B));
+	TEST_ASSERT_EQUAL(DEFAULT_RX_FIFO, rxIdFifo(MSG_D));
+
+	// Two IDs share one list bank
+	bankLayout(&layout);
+	TEST_ASSERT_EQUAL(2, layout.numListed);
+	TEST_ASSERT_EQUAL(image32(MSG_A, CAN_ID_STD), layout.listed[0]);
+	TEST_ASSERT_EQUAL(image32(MSG_C, CAN_ID_EXT), layout.listed[1]);
+	TEST_ASSERT(layout.fifo0Banks > 0U);
+
+	// A run next to MSG_A on FIFO0 is merged into mask banks, while MSG_A keeps
+	// its exact list entry on FIFO1
+	for (uint32_t id = 0x102; id < 0x110U; id++) {
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Subscribe(&can, id, CAN_ID_STD, DEFAULT_RX_FIFO));
+	}
+	bankLayout(&layout);
+	TEST_ASSERT_EQUAL(2, layout.numListed);
+	TEST_ASSERT_EQUAL(image32(MSG_A, CAN_ID_STD), layout.listed[0]);
+	TEST_ASSERT(layout.fifo0MaskBanks > 0U);
+}
+
+static void test_full_and_overrun_per_fifo(void) {
+	TsCanALRxFifoStats stats[CANAL_NUM_RX_FIFOS];
+
+	setUp();
+	for (uint32_t i = 0; i < 3U; i++) {
+		TEST_ASSERT(Test_BusFrame(&can, CAN_RX_FIFO1, MSG_A, CAN_ID_STD, i));
+	}
+	// The HAL raises the full interrupt on the third frame
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_RxFifoFull(&can, CAN_RX_FIFO1));
+	TEST_ASSERT(!Test_BusFrame(&can, CAN_RX_FIFO1, MSG_A, CAN_ID_STD, 3));
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Error(&can));
+	TEST_ASSERT_EQUAL(0, hcan.ErrorCode & HAL_CAN_ERROR_RX_FOV1);
+	// The error was cleared, so a second callback does not count it again
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Error(&can));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_ReceiveFifo1(&can));
+
+	CanAL_GetRxFifoStats(&can, CAN_RX_FIFO0, &stats[0]);
+	CanAL_GetRxFifoStats(&can, CAN_RX_FIFO1, &stats[1]);
+	TEST_ASSERT_EQUAL(1, stats[1].full);
+	TEST_ASSERT_EQUAL(1, stats[1].overrun);
+	TEST_ASSERT_EQUAL(3, stats[1].frames);
+	TEST_ASSERT_EQUAL(1, stats[1].interrupts);
+	TEST_ASSERT_EQUAL(3, stats[1].maxBurst);
+	TEST_ASSERT_EQUAL(0, stats[0].full);
+	TEST_ASSERT_EQUAL(0, stats[0].overrun);
+	TEST_ASSERT_EQUAL(0, stats[0].frames);
+
+	// Overrunning both FIFOs before the error callback counts one on each
+	for (uint32_t i = 0; i < 4U; i++) {
+		Test_BusFrame(&can, CAN_RX_FIFO0, MSG_B, CAN_ID_STD, i);
+		Test_BusFrame(&can, CAN_RX_FIFO1, MSG_A, CAN_ID_STD, i);
+	}
+	CanAL_Error(&can);
+	CanAL_Receive(&can);
+
+	CanAL_GetRxFifoStats(&can, CAN_RX_FIFO0, &stats[0]);
+	CanAL_GetRxFifoStats(&can, CAN_RX_FIFO1, &stats[1]);
+	TEST_ASSERT_EQUAL(1, stats[0].overrun);
+	TEST_ASSERT_EQUAL(2, stats[1].overrun);
+	TEST_ASSERT_EQUAL(3, stats[0].frames);
+	TEST_ASSERT_EQUAL(1, stats[0].interrupts);
+	TEST_ASSERT_EQUAL(3, stats[1].frames);
+}
+
+static void test_fifo_arguments(void) {
+	TsCanALRxFifoStats stats;
+
+	setUp();
+	TEST_ASSERT_EQUAL(CANAL_NULL_REF, CanAL_RxFifoFull(NULL, CAN_RX_FIFO0));
+	TEST_ASSERT_EQUAL(CANAL_ERROR, CanAL_RxFifoFull(&can, CANAL_NUM_RX_FIFOS));
+	TEST_ASSERT_EQUAL(CANAL_NULL_REF, CanAL_GetRxFifoStats(NULL, CAN_RX_FIFO0, &stats));
+	TEST_ASSERT_EQUAL(CANAL_ERROR, CanAL_GetRxFifoStats(&can, CANAL_NUM_RX_FIFOS, &stats));
+	TEST_ASSERT_EQUAL(CANAL_ERROR, CanAL_GetRxFifoStats(&can, CAN_RX_FIFO0, NULL));
+
+	// CanAL_Init starts the counters over
+	CanAL_RxFifoFull(&can, CAN_RX_FIFO0);
+	setUp();
+	CanAL_GetRxFifoStats(&can, CAN_RX_FIFO0, &stats);
+	TEST_ASSERT_EQUAL(0, stats.full);
+}
+
+int main(void) {
+	TEST_RUN(test_priority_ids_get_list_banks);
+	TEST_RUN(test_full_and_overrun_per_fifo);
+	TEST_RUN(test_fifo_arguments);
+
+	return TEST_RESULT();
+}
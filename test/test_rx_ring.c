@@ -0,0 +1,131 @@
+/*
+ * test_rx_ring.c
+ *
+ * Deferred rx mode: the rx interrupt only copies frames into the SPSC ring and
+ * CanAL_ProcessRx decodes them later, in order and within its budget.
+ */
+
+#include <stdlib.h>
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+
+// Every decoded MSG_A appends its sequence number here
+static uint32_t decoded[4096];
+static uint32_t numDecoded;
+// misordered counts frames that did not carry the next sequence number
+static uint32_t misordered;
+
+static void onA(uint32_t ID) {
+	uint32_t seq;
+
+	(void)ID;
+	memcpy(&seq, Test_Rx_A.data, sizeof(seq));
+	if (seq != numDecoded) misordered++;
+	decoded[numDecoded++ % 4096] = seq;
+}
+
+static void setUp(void) {
+	numDecoded = 0;
+	misordered = 0;
+	memset(&Test_Rx_A, 0, sizeof(Test_Rx_A));
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_DEFERRED);
+	CanAL_OnMessage(MSG_A, onA);
+}
+
+static void test_isr_only_queues(void) {
+	TsCanALRxRingStats stats;
+
+	setUp();
+	for (uint32_t i = 0; i < 3; i++) Test_BusFrame(&can, CAN_RX_FIFO0, MSG_A, CAN_ID_STD, i);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Receive(&can));
+	TEST_ASSERT_EQUAL(0, Stub_CanRxLevel(CAN1, CAN_RX_FIFO0));
+	TEST_ASSERT_EQUAL(0, Test_Rx_A.count);
+
+	CanAL_GetRxRingStats(&can, CAN_RX_FIFO0, &stats);
+	TEST_ASSERT_EQUAL(3, stats.pending);
+	TEST_ASSERT_EQUAL(3, stats.highWaterMark);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_ProcessRx(&can, 2));
+	TEST_ASSERT_EQUAL(2, numDecoded);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_ProcessRx(&can, 0));
+	TEST_ASSERT_EQUAL(3, numDecoded);
+	for (uint32_t i = 0; i < 3; i++) TEST_ASSERT_EQUAL(i, decoded[i]);
+}
+
+static void test_full_ring_drops_and_releases_fifo(void) {
+	TsCanALRxRingStats stats;
+	uint32_t seq = 0;
+
+	setUp();
+	// Keep the ISR fed without ever running the consumer
+	while (seq < CANAL_RX_RING_SIZE + 10U) {
+		Test_BusFrame(&can, CAN_RX_FIFO0, MSG_A, CAN_ID_STD, seq++);
+		CanAL_Receive(&can);
+	}
+
+	// Frames that found the ring full are still released from the FIFO
+	TEST_ASSERT_EQUAL(0, Stub_CanRxLevel(CAN1, CAN_RX_FIFO0));
+	CanAL_GetRxRingStats(&can, CAN_RX_FIFO0, &stats);
+	TEST_ASSERT_EQUAL(CANAL_RX_RING_SIZE, stats.pending);
+	TEST_ASSERT_EQUAL(CANAL_RX_RING_SIZE, stats.highWaterMark);
+	TEST_ASSERT_EQUAL(10, stats.dropped);
+
+	CanAL_ProcessRx(&can, 0);
+	TEST_ASSERT_EQUAL(CANAL_RX_RING_SIZE, numDecoded);
+	// The oldest frames are kept, the newest ones were dropped
+	for (uint32_t i = 0; i < CANAL_RX_RING_SIZE; i++) TEST_ASSERT_EQUAL(i, decoded[i]);
+}
+
+static void test_priority_fifo_first(void) {
+	setUp();
+	Test_BusFrame(&can, CAN_RX_FIFO0, MSG_A, CAN_ID_STD, 1);
+	Test_BusFrame(&can, CAN_RX_FIFO1, MSG_A, CAN_ID_STD, 0);
+	CanAL_Receive(&can);
+	CanAL_ReceiveFifo1(&can);
+
+	CanAL_ProcessRx(&can, 1);
+	TEST_ASSERT_EQUAL(1, numDecoded);
+	TEST_ASSERT_EQUAL(0, decoded[0]);
+}
+
+// The ISR and the main loop interleave at random; with a consumer that keeps up
+// every frame comes out exactly once and in order
+static void test_interleaved_producer_consumer(void) {
+	TsCanALRxRingStats stats;
+	uint32_t seq = 0;
+
+	setUp();
+	srand(1);
+	for (uint32_t step = 0; step < 20000U; step++) {
+		uint32_t burst = (uint32_t)rand() % 4U;
+
+		for (uint32_t i = 0; i < burst; i++) {
+			if (!Test_BusFrame(&can, CAN_RX_FIFO0, MSG_A, CAN_ID_STD, seq)) break;
+			seq++;
+		}
+		if ((rand() % 2) == 0) CanAL_Receive(&can);
+		if ((rand() % 2) == 0) CanAL_ProcessRx(&can, (uint16_t)(1 + (rand() % 8)));
+	}
+	CanAL_Receive(&can);
+	CanAL_ProcessRx(&can, 0);
+
+	CanAL_GetRxRingStats(&can, CAN_RX_FIFO0, &stats);
+	TEST_ASSERT_EQUAL(0, stats.dropped);
+	TEST_ASSERT_EQUAL(0, stats.pending);
+	TEST_ASSERT_EQUAL(seq, numDecoded);
+	TEST_ASSERT_EQUAL(0, misordered);
+}
+
+int main(void) {
+	TEST_RUN(test_isr_only_queues);
+	TEST_RUN(test_full_ring_drops_and_releases_fifo);
+	TEST_RUN(test_priority_fifo_first);
+	TEST_RUN(test_interleaved_producer_consumer);
+
+	return TEST_RESULT();
+}
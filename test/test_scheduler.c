@@ -0,0 +1,109 @@
+/*
+ * test_scheduler.c
+ *
+ * A simulated second of the cyclic scheduler on a 1 ms tick: automatic phases
+ * spread the releases so no tick bursts into the mailboxes, and the jitter
+ * statistics track a clock that runs a few microseconds off the tick.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+#include "canal_scheduler.h"
+
+#define SIM_TICKS						(1000U)
+#define SIM_MESSAGES					(6U)
+#define SIM_PERIOD						(10U)
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+static TsCanALScheduler sched;
+static uint32_t simUs;
+
+static uint32_t clockUs(void) {
+	return simUs;
+}
+
+static void setUp(void) {
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+	CanAL_Scheduler_Init(&sched, &can, 1000, clockUs);
+}
+
+static uint32_t totalReleases(void) {
+	uint32_t releases = 0;
+
+	for (uint8_t i = 0; i < sched.numEntries; i++) releases += sched.entries[i].releases;
+
+	return releases;
+}
+
+// simulate runs SIM_TICKS ticks, sending whatever is in the mailboxes between
+// two ticks, and returns the most releases a single tick made
+static uint32_t simulate(uint32_t jitterUs) {
+	uint32_t peak = 0;
+
+	for (uint32_t t = 0; t < SIM_TICKS; t++) {
+		uint32_t before = totalReleases();
+
+		simUs = (t * 1000U) + (t % (jitterUs + 1U));
+		CanAL_Scheduler_Tick(&sched);
+
+		if ((totalReleases() - before) > peak) peak = totalReleases() - before;
+
+		for (uint32_t mailbox = CAN_TX_MAILBOX0; mailbox <= CAN_TX_MAILBOX2; mailbox <<= 1) {
+			if ((Stub_CanBusyMailboxes(CAN1) & mailbox) == 0U) continue;
+
+			Stub_CanReleaseMailbox(CAN1, mailbox);
+			CanAL_TxMailboxComplete(&can, mailbox);
+		}
+	}
+
+	return peak;
+}
+
+static void test_auto_phase_smooths_bus_load(void) {
+	uint32_t aligned;
+	uint32_t staggered;
+
+	setUp();
+	for (uint32_t i = 0; i < SIM_MESSAGES; i++) {
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Scheduler_Add(&sched, MSG_A, SIM_PERIOD, 0));
+	}
+	aligned = simulate(0);
+
+	setUp();
+	for (uint32_t i = 0; i < SIM_MESSAGES; i++) {
+		TEST_ASSERT_EQUAL(CANAL_OK,
+			CanAL_Scheduler_Add(&sched, MSG_A, SIM_PERIOD, CANAL_SCHED_AUTO_PHASE));
+	}
+	staggered = simulate(0);
+
+	printf("  peak releases per tick: aligned %u, auto phase %u\n", aligned, staggered);
+
+	TEST_ASSERT_EQUAL(SIM_MESSAGES, aligned);
+	TEST_ASSERT_EQUAL(1, staggered);
+	TEST_ASSERT_EQUAL(SIM_MESSAGES * (SIM_TICKS / SIM_PERIOD), totalReleases());
+}
+
+static void test_jitter_follows_clock(void) {
+	TsCanALJitterStats stats;
+
+	setUp();
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Scheduler_Add(&sched, MSG_T, SIM_PERIOD, 3));
+	simulate(6);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Scheduler_GetJitter(&sched, MSG_T, &stats));
+	TEST_ASSERT_EQUAL(SIM_TICKS / SIM_PERIOD, stats.releases);
+	TEST_ASSERT_EQUAL(0, stats.failures);
+	TEST_ASSERT(stats.minUs >= -6);
+	TEST_ASSERT(stats.maxUs <= 6);
+	TEST_ASSERT(stats.minUs < stats.maxUs);
+	TEST_ASSERT((stats.meanUs >= -1) && (stats.meanUs <= 1));
+}
+
+int main(void) {
+	TEST_RUN(test_auto_phase_smooths_bus_load);
+	TEST_RUN(test_jitter_follows_clock);
+
+	return TEST_RESULT();
+}
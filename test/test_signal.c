@@ -0,0 +1,191 @@
+/*
+ * test_signal.c
+ *
+ * The word-level signal kernel against a bit-by-bit reference of the DBC
+ * layout for every start bit and length in both byte orders, physical value
+ * round trips, and a benchmark against the byte loop the generated
+ * unmarshallers use.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "canal_test.h"
+#include "canal_signal.h"
+
+#define BENCH_FRAMES					(1000000U)
+
+// refGet reads a signal one bit at a time the way the DBC defines it: Intel
+// signals grow upwards from startBit, Motorola signals run from startBit down
+// to bit 0 of each byte and continue at bit 7 of the next byte
+static uint64_t refGet(const uint8_t* data, uint8_t start, uint8_t length, bool bigEndian) {
+	uint64_t value = 0;
+	uint32_t bit = start;
+
+	for (uint32_t i = 0; i < length; i++) {
+		uint32_t b = bigEndian ? bit : (uint32_t)(start + length - 1U - i);
+
+		value = (value << 1) | ((data[b / 8U] >> (b % 8U)) & 1U);
+
+		if (bigEndian) bit = ((bit % 8U) == 0U) ? (bit + 15U) : (bit - 1U);
+	}
+
+	return value;
+}
+
+static uint64_t randomWord(void) {
+	return ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+}
+
+static void test_every_position_round_trips(void) {
+	uint32_t checked = 0;
+
+	srand(1);
+
+	for (uint32_t order = 0; order < 2U; order++) {
+		for (uint8_t start = 0; start < 64U; start++) {
+			for (uint8_t length = 1; length <= 64U; length++) {
+				TsCanALSignal sig = {
+					.startBit = start,
+					.length = length,
+					.endianness = order ? CANAL_BIG_ENDIAN : CANAL_LITTLE_ENDIAN,
+					.scale = 1.0f,
+				};
+				uint64_t mask = (length == 64U) ? UINT64_MAX : ((1ULL << length) - 1U);
+				uint8_t data[8];
+				uint8_t out[8];
+				uint64_t raw = randomWord() & mask;
+				TsCanALPayload payload;
+
+				if (CanAL_Signal_Validate(&sig) != CANAL_OK) continue;
+
+				for (uint32_t i = 0; i < 8U; i++) data[i] = (uint8_t)rand();
+				CanAL_Signal_Load(data, &payload);
+				TEST_ASSERT_EQUAL(refGet(data, start, length, order),
+					(uint64_t)CanAL_Signal_GetRaw(&sig, &payload) & mask);
+
+				// Only the bits of the signal may change
+				CanAL_Signal_SetRaw(&sig, &payload, (int64_t)raw);
+				if (order) payload.le = 0; else payload.be = 0;
+				CanAL_Signal_Store(&payload, out);
+				TEST_ASSERT_EQUAL(raw, refGet(out, start, length, order));
+
+				for (uint32_t b = 0; b < 64U; b++) {
+					bool inside = false;
+
+					for (uint32_t k = 0, bit = start; k < length; k++) {
+						if ((order ? bit : (uint32_t)(start + k)) == b) inside = true;
+						if (order) bit = ((bit % 8U) == 0U) ? (bit + 15U) : (bit - 1U);
+					}
+
+					if (inside) continue;
+					TEST_ASSERT_EQUAL((data[b / 8U] >> (b % 8U)) & 1U, (out[b / 8U] >> (b % 8U)) & 1U);
+				}
+
+				checked++;
+			}
+		}
+	}
+
+	// 2080 start and length pairs fit in 64 bits in each byte order
+	TEST_ASSERT_EQUAL(2U * 2080U, checked);
+}
+
+static void test_signed_values_sign_extend(void) {
+	TsCanALSignal sig = { .startBit = 12, .length = 12, .endianness = CANAL_LITTLE_ENDIAN,
+		.isSigned = true, .scale = 1.0f };
+	TsCanALPayload payload = {0};
+
+	CanAL_Signal_SetRaw(&sig, &payload, -5);
+	TEST_ASSERT_EQUAL(-5, CanAL_Signal_GetRaw(&sig, &payload));
+	CanAL_Signal_SetRaw(&sig, &payload, -2048);
+	TEST_ASSERT_EQUAL(-2048, CanAL_Signal_GetRaw(&sig, &payload));
+}
+
+static void test_physical_round_trip_and_saturation(void) {
+	static const TsCanALSignal sigs[] = {
+		{ 0, 16, CANAL_LITTLE_ENDIAN, true, 0.1f, 0.0f },
+		{ 23, 12, CANAL_BIG_ENDIAN, false, 0.5f, -40.0f },
+		{ 40, 8, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+	};
+	float in[] = { -123.4f, 100.5f, 300.0f };
+	float out[3];
+	uint8_t data[8];
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Signal_Pack(sigs, 3, in, data));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Signal_Unpack(sigs, 3, data, out));
+
+	TEST_ASSERT((out[0] > -123.45f) && (out[0] < -123.35f));
+	TEST_ASSERT_EQUAL(100.5f * 2, out[1] * 2);
+	// 300 does not fit in 8 bits and saturates
+	TEST_ASSERT_EQUAL(255, out[2]);
+}
+
+// byteGet is how a generated unmarshaller reads an Intel signal: OR in every
+// byte the signal touches, then shift and mask
+static uint64_t byteGet(const uint8_t* data, uint8_t start, uint8_t length) {
+	uint64_t value = 0;
+	uint32_t first = start / 8U;
+	uint32_t last = (start + length - 1U) / 8U;
+
+	for (uint32_t i = last + 1U; i-- > first; ) value = (value << 8) | data[i];
+
+	value >>= start % 8U;
+
+	return (length == 64U) ? value : (value & ((1ULL << length) - 1U));
+}
+
+static void test_benchmark(void) {
+	static const TsCanALSignal sigs[] = {
+		{ 0, 12, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+		{ 12, 12, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+		{ 24, 8, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+		{ 32, 4, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+		{ 36, 4, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+		{ 40, 16, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+		{ 56, 7, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+		{ 63, 1, CANAL_LITTLE_ENDIAN, false, 1.0f, 0.0f },
+	};
+	uint8_t data[8];
+	volatile uint64_t sink = 0;
+	uint64_t kernelSum = 0;
+	uint64_t byteSum = 0;
+	uint64_t start;
+	uint64_t kernelNs;
+	uint64_t byteNs;
+
+	for (uint32_t i = 0; i < 8U; i++) data[i] = (uint8_t)(0x5A + (i * 37U));
+
+	start = Test_NowNs();
+	for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+		TsCanALPayload payload;
+
+		data[0] = (uint8_t)n;
+		CanAL_Signal_Load(data, &payload);
+		for (uint32_t i = 0; i < 8U; i++) kernelSum += (uint64_t)CanAL_Signal_GetRaw(&sigs[i], &payload);
+	}
+	kernelNs = Test_NowNs() - start;
+
+	start = Test_NowNs();
+	for (uint32_t n = 0; n < BENCH_FRAMES; n++) {
+		data[0] = (uint8_t)n;
+		for (uint32_t i = 0; i < 8U; i++) byteSum += byteGet(data, sigs[i].startBit, sigs[i].length);
+	}
+	byteNs = Test_NowNs() - start;
+
+	sink = kernelSum + byteSum;
+	(void)sink;
+
+	printf("  8 signals per frame: kernel %.1f ns, byte loop %.1f ns per frame\n",
+		(double)kernelNs / BENCH_FRAMES, (double)byteNs / BENCH_FRAMES);
+
+	TEST_ASSERT_EQUAL(byteSum, kernelSum);
+}
+
+int main(void) {
+	TEST_RUN(test_every_position_round_trips);
+	TEST_RUN(test_signed_values_sign_extend);
+	TEST_RUN(test_physical_round_trip_and_saturation);
+	TEST_RUN(test_benchmark);
+
+	return TEST_RESULT();
+}
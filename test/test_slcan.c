@@ -0,0 +1,223 @@
+/*
+ * test_slcan.c
+ *
+ * The SLCAN codec against hand-written Lawicel lines, its rejection of
+ * malformed ones, attaching the bridge next to another rx hook, and polling
+ * into a uart tx ring smaller than what is queued for the host.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+#include "canal_slcan.h"
+
+#define UART_RING_SIZE					(64U)
+
+static UART_HandleTypeDef huart;
+static DMA_HandleTypeDef hdmatx;
+static const uint8_t* dmaSrc;
+static uint16_t dmaLen;
+static uint8_t wire[1024];
+static uint32_t wireLen;
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* h, const uint8_t* data, uint16_t size) {
+	(void)h;
+
+	if (dmaLen != 0U) return HAL_BUSY;
+
+	dmaSrc = data;
+	dmaLen = size;
+
+	return HAL_OK;
+}
+
+// dmaComplete finishes the running transfer the way the tx complete interrupt
+// does
+static void dmaComplete(void) {
+	memcpy(&wire[wireLen], dmaSrc, dmaLen);
+	wireLen += dmaLen;
+	dmaLen = 0;
+	UART_Tx_Complete(&huart);
+}
+
+// countHook counts the frames it sees in the uint32_t at ctx
+static bool countHook(void* ctx, const TsCanALRawFrame* frame) {
+	(void)frame;
+
+	(*(uint32_t*)ctx)++;
+
+	return false;
+}
+
+static TeCanALRet decode(const char* line, TsCanALRawFrame* frame) {
+	return CanAL_Slcan_DecodeFrame((const uint8_t*)line, (uint8_t)strlen(line), frame);
+}
+
+static void test_encode(void) {
+	TsCanALRawFrame std = { .id = 0x12A, .ide = CAN_ID_STD, .dlc = 3, .data = {0x01, 0xAB, 0xFF} };
+	TsCanALRawFrame ext = { .id = 0x18FF0001, .ide = CAN_ID_EXT, .dlc = 0 };
+	uint8_t line[CANAL_SLCAN_MAX_LINE];
+	uint8_t len;
+
+	len = CanAL_Slcan_EncodeFrame(&std, false, 0, line);
+	TEST_ASSERT_EQUAL(12, len);
+	TEST_ASSERT_EQUAL(0, memcmp("t12A301ABFF\r", line, len));
+
+	len = CanAL_Slcan_EncodeFrame(&ext, true, 59999, line);
+	TEST_ASSERT_EQUAL(15, len);
+	TEST_ASSERT_EQUAL(0, memcmp("T18FF00010EA5F\r", line, len));
+
+	// The longest line fits CANAL_SLCAN_MAX_LINE
+	ext.dlc = 8;
+	TEST_ASSERT_EQUAL(CANAL_SLCAN_MAX_LINE, CanAL_Slcan_EncodeFrame(&ext, true, 0, line));
+}
+
+static void test_decode(void) {
+	TsCanALRawFrame frame;
+
+	TEST_ASSERT_EQUAL(CANAL_OK, decode("t7FF2beef", &frame));
+	TEST_ASSERT_EQUAL(0x7FF, frame.id);
+	TEST_ASSERT_EQUAL(CAN_ID_STD, frame.ide);
+	TEST_ASSERT_EQUAL(2, frame.dlc);
+	TEST_ASSERT_EQUAL(0xBE, frame.data[0]);
+	TEST_ASSERT_EQUAL(0xEF, frame.data[1]);
+	TEST_ASSERT_EQUAL(0, frame.data[2]);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, decode("T1FFFFFFF81122334455667788", &frame));
+	TEST_ASSERT_EQUAL(0x1FFFFFFF, frame.id);
+	TEST_ASSERT_EQUAL(CAN_ID_EXT, frame.ide);
+	TEST_ASSERT_EQUAL(0x88, frame.data[7]);
+}
+
+static void test_decode_rejects_malformed(void) {
+	static const char* const lines[] = {
+		"",				// empty
+		"x1230",		// unknown command
+		"t800",			// standard ID above 0x7FF
+		"T200000000",	// extended ID above 0x1FFFFFFF
+		"t1239",		// DLC above 8
+		"t12",			// ends inside the ID
+		"t1232AB",		// payload shorter than the DLC
+		"t1231ABCD",	// payload longer than the DLC
+		"t1231G0",		// not hex
+	};
+	TsCanALRawFrame frame;
+
+	for (uint32_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+		TEST_ASSERT_EQUAL(CANAL_ERROR, decode(lines[i], &frame));
+	}
+}
+
+static void test_round_trip(void) {
+	uint8_t line[CANAL_SLCAN_MAX_LINE];
+
+	for (uint8_t dlc = 0; dlc <= 8U; dlc++) {
+		TsCanALRawFrame in = { .id = (dlc & 1U) ? 0x0ABCDEF1U : 0x5A5U,
+			.ide = (dlc & 1U) ? CAN_ID_EXT : CAN_ID_STD, .dlc = dlc };
+		TsCanALRawFrame out;
+		uint8_t len;
+
+		for (uint8_t i = 0; i < dlc; i++) in.data[i] = (uint8_t)(0x3CU * (i + 1U));
+
+		len = CanAL_Slcan_EncodeFrame(&in, false, 0, line);
+		// Without the trailing '\r'
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Slcan_DecodeFrame(line, len - 1U, &out));
+		TEST_ASSERT_EQUAL(in.id, out.id);
+		TEST_ASSERT_EQUAL(in.ide, out.ide);
+		TEST_ASSERT_EQUAL(in.dlc, out.dlc);
+		TEST_ASSERT_EQUAL(0, memcmp(in.data, out.data, 8));
+	}
+}
+
+static void test_attach_keeps_other_hooks(void) {
+	static TsCanAL can;
+	static CAN_HandleTypeDef hcan;
+	static TsCanALSlcan slcan;
+	static UART_st uart;
+	TsCanALRxHookNode other = {0};
+	TsCanALRawFrame frame = { .id = MSG_B, .ide = CAN_ID_STD, .dlc = 4 };
+	uint32_t seen = 0;
+
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Slcan_Init(&slcan, &uart));
+
+	CanAL_AddRxHook(&can, &other, countHook, &seen);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Slcan_Attach(&slcan, &can));
+	CanAL_Slcan_Input(&slcan, (const uint8_t*)"O\r", 2);
+
+	CanAL_InjectRx(&can, CAN_RX_FIFO0, &frame);
+	TEST_ASSERT_EQUAL(1, slcan.stats.rxFrames);
+	TEST_ASSERT_EQUAL(1, seen);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Slcan_Detach(&slcan));
+	TEST_ASSERT(can.rxHooks == &other);
+	CanAL_InjectRx(&can, CAN_RX_FIFO0, &frame);
+	TEST_ASSERT_EQUAL(1, slcan.stats.rxFrames);
+	TEST_ASSERT_EQUAL(2, seen);
+}
+
+static void test_poll_feeds_uart_tx_ring(void) {
+	static TsCanAL can;
+	static CAN_HandleTypeDef hcan;
+	static TsCanALSlcan slcan;
+	static UART_st uart;
+	static UART_Tx_Ring_st ring;
+	static uint8_t ringBuf[UART_RING_SIZE];
+	UART_st noRing = { .huart = &huart, .uart_num = 4 };
+	TsCanALRawFrame frame = { .id = MSG_B, .ide = CAN_ID_STD, .dlc = 4 };
+	UART_Tx_Stats_st stats;
+	uint32_t queued;
+
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+	huart.hdmatx = &hdmatx;
+	uart = (UART_st){ .huart = &huart, .uart_num = 2, .baudrate = UART_115200,
+		.datasize = UART_Datasize_8, .mode = UART_TX_RX };
+	TEST_ASSERT_EQUAL(UART_OK, UART_Tx_Ring_Init(&uart, &ring, ringBuf, UART_RING_SIZE, UART_OVERFLOW_DROP));
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Slcan_Init(&slcan, &uart));
+	CanAL_Slcan_Attach(&slcan, &can);
+	CanAL_Slcan_Input(&slcan, (const uint8_t*)"O\r", 2);
+	for (uint32_t i = 0; i < 10U; i++) {
+		frame.data[0] = (uint8_t)i;
+		CanAL_InjectRx(&can, CAN_RX_FIFO0, &frame);
+	}
+	queued = slcan.txHead;
+	TEST_ASSERT(queued > UART_RING_SIZE);
+
+	// The poll returns at once, leaving what the ring had no room for queued
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Slcan_Poll(&slcan));
+	TEST_ASSERT_EQUAL(UART_RING_SIZE, slcan.txTail);
+	TEST_ASSERT_EQUAL(0, wireLen);
+
+	while (slcan.txTail != queued) {
+		dmaComplete();
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Slcan_Poll(&slcan));
+	}
+	while (dmaLen != 0U) dmaComplete();
+
+	TEST_ASSERT_EQUAL(queued, wireLen);
+	TEST_ASSERT_EQUAL(0, memcmp(wire, slcan.tx, queued));
+	UART_Tx_Get_Stats(&uart, &stats);
+	TEST_ASSERT_EQUAL(0, stats.dropped);
+	TEST_ASSERT_EQUAL(0, slcan.stats.uartErrors);
+
+	// A uart without a tx ring is an error and keeps everything queued
+	CanAL_InjectRx(&can, CAN_RX_FIFO0, &frame);
+	slcan.uart = &noRing;
+	TEST_ASSERT_EQUAL(CANAL_ERROR, CanAL_Slcan_Poll(&slcan));
+	TEST_ASSERT_EQUAL(queued, slcan.txTail);
+	TEST_ASSERT_EQUAL(1, slcan.stats.uartErrors);
+	CanAL_Slcan_Detach(&slcan);
+}
+
+int main(void) {
+	TEST_RUN(test_encode);
+	TEST_RUN(test_decode);
+	TEST_RUN(test_decode_rejects_malformed);
+	TEST_RUN(test_round_trip);
+	TEST_RUN(test_attach_keeps_other_hooks);
+	TEST_RUN(test_poll_feeds_uart_tx_ring);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,96 @@
+/*
+ * test_stats.c
+ *
+ * CANAL_STATS_MODE counters: worst case frame lengths, bus load and per
+ * message rates over a window, mailbox-full counting and tx timing that
+ * includes marshalling.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+
+static void slowMarshal(void) {
+	Stub_CycleCount(500);
+}
+
+static void setUp(void) {
+	Test_MarshalHook = NULL;
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+}
+
+static void test_frame_bits(void) {
+	// Worst case lengths from Davis et al., 3 bit interframe space included
+	TEST_ASSERT_EQUAL(135, CanAL_Stats_FrameBits(CAN_ID_STD, 8));
+	TEST_ASSERT_EQUAL(160, CanAL_Stats_FrameBits(CAN_ID_EXT, 8));
+	TEST_ASSERT_EQUAL(55, CanAL_Stats_FrameBits(CAN_ID_STD, 0));
+}
+
+static void test_bus_load_and_rate(void) {
+	TsCanALStats stats;
+	TsCanALIdRate rate;
+
+	setUp();
+	for (uint32_t i = 0; i < 100; i++) {
+		Test_BusFrame(&can, CAN_RX_FIFO0, MSG_A, CAN_ID_STD, i);
+		Test_RxIsr(&can, CAN_RX_FIFO0);
+	}
+	Stub_Tick += 250;
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_GetStats(&can, &stats));
+	TEST_ASSERT_EQUAL(100, stats.rxFrames);
+	TEST_ASSERT_EQUAL(800, stats.rxBytes);
+	TEST_ASSERT_EQUAL(250, stats.windowMs);
+	// 13500 bits in 250 ms at 500 kbit/s
+	TEST_ASSERT_EQUAL(108, stats.busLoad);
+	TEST_ASSERT_EQUAL(108, can.stats.totals.busLoad);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_GetIdStats(&can, MSG_A, &rate));
+	TEST_ASSERT_EQUAL(100, rate.frames);
+	TEST_ASSERT_EQUAL(400, rate.rateHz);
+
+	// An idle window reports an idle bus
+	Stub_Tick += 100;
+	CanAL_GetStats(&can, &stats);
+	TEST_ASSERT_EQUAL(0, stats.busLoad);
+	TEST_ASSERT_EQUAL(100, stats.windowMs);
+}
+
+static void test_mailbox_full_only_when_all_busy(void) {
+	TsCanALStats stats;
+
+	setUp();
+	for (uint32_t i = 0; i < 3; i++) CanAL_Transmit(&can, MSG_A);
+	CanAL_GetStats(&can, &stats);
+	TEST_ASSERT_EQUAL(0, stats.mailboxFull);
+
+	CanAL_Transmit(&can, MSG_T);
+	CanAL_GetStats(&can, &stats);
+	TEST_ASSERT_EQUAL(1, stats.mailboxFull);
+	TEST_ASSERT_EQUAL(3, stats.txFrames);
+}
+
+static void test_tx_cycles_include_marshalling(void) {
+	TsCanALStats stats;
+
+	setUp();
+	Test_MarshalHook = slowMarshal;
+	CanAL_Transmit(&can, MSG_A);
+	Test_MarshalHook = NULL;
+
+	CanAL_GetStats(&can, &stats);
+	TEST_ASSERT_EQUAL(1, stats.txCycles.count);
+	TEST_ASSERT(stats.txCycles.min >= 500);
+}
+
+int main(void) {
+	TEST_RUN(test_frame_bits);
+	TEST_RUN(test_bus_load_and_rate);
+	TEST_RUN(test_mailbox_full_only_when_all_busy);
+	TEST_RUN(test_tx_cycles_include_marshalling);
+
+	return TEST_RESULT();
+}
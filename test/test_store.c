@@ -0,0 +1,124 @@
+/*
+ * test_store.c
+ *
+ * The message store: the rx interrupt fills a slot straight from the FIFO
+ * mailbox without masking interrupts, tx-only messages have no slot, and a
+ * reader racing a writer thread never sees a torn payload.
+ */
+
+#include <pthread.h>
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+#define RACE_WRITES						(2000000U)
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+static volatile bool writerDone;
+
+static void setUp(void) {
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+}
+
+static void test_isr_fills_slot_unmasked(void) {
+	TsCanALStoreSnapshot snapshot;
+	uint32_t seq;
+	uint32_t entries;
+
+	setUp();
+	TEST_ASSERT_EQUAL(CANAL_STORE_EMPTY, CanAL_Store_Read(MSG_C, &snapshot));
+
+	Stub_Tick = 42;
+	Test_BusFrame(&can, CAN_RX_FIFO0, MSG_C, CAN_ID_EXT, 7);
+	entries = Stub_PrimaskEntries;
+	Test_RxIsr(&can, CAN_RX_FIFO0);
+	TEST_ASSERT_EQUAL(entries, Stub_PrimaskEntries);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Store_Read(MSG_C, &snapshot));
+	memcpy(&seq, snapshot.data, sizeof(seq));
+	TEST_ASSERT_EQUAL(7, seq);
+	TEST_ASSERT_EQUAL(8, snapshot.dlc);
+	TEST_ASSERT_EQUAL(42, snapshot.tick);
+	TEST_ASSERT_EQUAL(1, snapshot.generation);
+}
+
+static void test_tx_only_has_no_slot(void) {
+	TsCanALStoreSnapshot snapshot;
+
+	setUp();
+	TEST_ASSERT_EQUAL(4, CANAL_NUM_RX_MESSAGES);
+	TEST_ASSERT(CanAL_Store_BeginWrite(CanAL_FindCodec(MSG_T)) == NULL);
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_RX_MESSAGE, CanAL_Store_Read(MSG_T, &snapshot));
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_RX_MESSAGE, CanAL_Store_Read(0x7FF, &snapshot));
+}
+
+static void test_injected_frames_are_stored(void) {
+	TsCanALRawFrame frame = { .id = MSG_B, .ide = CAN_ID_STD, .dlc = 4, .data = {1, 2, 3, 4} };
+	TsCanALStoreSnapshot before;
+	TsCanALStoreSnapshot after;
+
+	setUp();
+	CanAL_Store_Read(MSG_B, &before);
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_InjectRx(&can, CAN_RX_FIFO0, &frame));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Store_Read(MSG_B, &after));
+	TEST_ASSERT_EQUAL(before.generation + 1U, after.generation);
+	TEST_ASSERT_EQUAL(0, memcmp(frame.data, after.data, 4));
+}
+
+// writer fills every byte of the MSG_D slot with the same value, the way the
+// rx interrupt would with frames arriving back to back
+static void* writer(void* arg) {
+	uint16_t index = CanAL_FindCodec(MSG_D);
+
+	(void)arg;
+
+	for (uint32_t n = 0; n < RACE_WRITES; n++) {
+		TsCanALStoreEntry* entry = CanAL_Store_BeginWrite(index);
+
+		memset(entry->data, (int)(n & 0xFFU), sizeof(entry->data));
+		entry->dlc = 8;
+		CanAL_Store_EndWrite(entry, n, n);
+	}
+
+	writerDone = true;
+
+	return NULL;
+}
+
+static void test_reader_never_sees_torn_slot(void) {
+	TsCanALStoreSnapshot snapshot;
+	pthread_t thread;
+	uint32_t reads = 0;
+	uint32_t lastGeneration = 0;
+
+	setUp();
+	writerDone = false;
+	TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, writer, NULL));
+
+	while (!writerDone) {
+		if (CanAL_Store_Read(MSG_D, &snapshot) != CANAL_OK) continue;
+
+		for (uint32_t i = 1; i < 8U; i++) TEST_ASSERT_EQUAL(snapshot.data[0], snapshot.data[i]);
+		TEST_ASSERT_EQUAL(snapshot.timestamp & 0xFFU, snapshot.data[0]);
+		TEST_ASSERT(snapshot.generation >= lastGeneration);
+
+		lastGeneration = snapshot.generation;
+		reads++;
+	}
+
+	pthread_join(thread, NULL);
+
+	printf("  %u consistent reads during %u writes\n", reads, RACE_WRITES);
+
+	TEST_ASSERT(reads > 0U);
+}
+
+int main(void) {
+	TEST_RUN(test_isr_fills_slot_unmasked);
+	TEST_RUN(test_tx_only_has_no_slot);
+	TEST_RUN(test_injected_frames_are_stored);
+	TEST_RUN(test_reader_never_sees_torn_slot);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,192 @@
+/*
+ * test_timestamp.c
+ *
+ * CANAL_TIMESTAMP_MODE bus times and latencies: 16-bit captures extended
+ * across counter wraps, long idle gaps, tick wraps and tick jitter, and the
+ * rx ISR, tx queue, tx bus and tx ISR histograms for a known sequence of
+ * frames, both on the timestamp state and through canal.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+// At 500 kbit/s and the stub's 216 MHz core every bit time is 432 cycles
+#define CORE_HZ							(216000000U)
+#define CYCLES_PER_BIT					(432U)
+// Unstuffed frame lengths from start of frame to the end of EOF
+#define STD_DLC8_BITS					(108U)
+#define STD_DLC4_BITS					(76U)
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+
+static void setUp(void) {
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+}
+
+// extendRun feeds frames gapBits apart, plus a varying few hundred bits, to a
+// fresh state and checks every capture comes back as the full bus time. With
+// jitter the tick each capture is taken at is off by -1, 0 or +1 ms.
+static void extendRun(uint32_t baudKbps, uint32_t tick0, uint32_t frames, uint32_t gapBits,
+		bool jitter) {
+	TsCanALTimestampState state;
+	uint32_t bus = 0xFFF0U;
+
+	CanAL_Timestamp_Reset(&state, baudKbps, CORE_HZ);
+
+	for (uint32_t i = 0; i < frames; i++) {
+		uint32_t tick = tick0 + ((bus - 0xFFF0U) / baudKbps);
+
+		if (jitter) tick += (i % 3U) - 1U;
+
+		TEST_ASSERT_EQUAL(bus, CanAL_Timestamp_Extend(&state, (uint16_t)bus, tick));
+		bus += gapBits + ((i * 37U) % 1000U);
+	}
+}
+
+static void test_extend_across_wraps(void) {
+	// A frame every millisecond wraps the counter every 131 frames
+	extendRun(500, 0, 1000, 500, false);
+	// The tick wraps too
+	extendRun(500, 0xFFFFFF00U, 1000, 500, true);
+	// Gaps of 20 ms are more than a counter period at 1 Mbit/s
+	extendRun(1000, 0, 200, 20000, true);
+}
+
+static void test_extend_after_idle(void) {
+	// A minute between frames is hundreds of counter periods
+	extendRun(500, 0, 10, 30000000U, true);
+	extendRun(1000, 0xFFFF0000U, 10, 60000000U, true);
+}
+
+static void test_rx_latency(void) {
+	TsCanALTimestampState state;
+	TsCanALRawFrame frame = { .id = MSG_A, .ide = CAN_ID_STD, .dlc = 8 };
+	const uint32_t ref = 100000U;
+
+	CanAL_Timestamp_Reset(&state, 500, CORE_HZ);
+
+	// The first frame becomes the reference
+	frame.timestamp = 1000;
+	CanAL_Timestamp_Rx(&state, &frame, 0, ref);
+	TEST_ASSERT_EQUAL(1000, frame.timestamp);
+
+	// 1000 bits later and read 300 cycles slower
+	frame.timestamp = 2000;
+	CanAL_Timestamp_Rx(&state, &frame, 2, ref + (1000U * CYCLES_PER_BIT) + 300U);
+
+	// 2000 bits later and read 50 cycles quicker, the new reference
+	frame.timestamp = 3000;
+	CanAL_Timestamp_Rx(&state, &frame, 4, ref + (2000U * CYCLES_PER_BIT) - 50U);
+	TEST_ASSERT_EQUAL(3000U + STD_DLC8_BITS, state.refBits);
+
+	TEST_ASSERT_EQUAL(3, state.latency.rxIsrDelay.count);
+	TEST_ASSERT_EQUAL(0, state.latency.rxIsrDelay.min);
+	TEST_ASSERT_EQUAL(300, state.latency.rxIsrDelay.max);
+	TEST_ASSERT_EQUAL(2, state.latency.rxIsrDelay.buckets[0]);
+	TEST_ASSERT_EQUAL(1, state.latency.rxIsrDelay.buckets[8]);
+}
+
+static void test_tx_latency(void) {
+	TsCanALTimestampState state;
+	TsCanALRawFrame rx = { .id = MSG_A, .ide = CAN_ID_STD, .dlc = 8, .timestamp = 1000 };
+	TsCanALRawFrame tx = { .id = MSG_T, .ide = CAN_ID_STD, .dlc = 4 };
+	const uint32_t ref = 100000U;
+	uint32_t end;
+	uint32_t ID;
+	uint32_t timestamp;
+
+	CanAL_Timestamp_Reset(&state, 500, CORE_HZ);
+
+	// Without a received frame the bus time is kept but no latency is recorded
+	CanAL_Timestamp_TxLoaded(&state, CAN_TX_MAILBOX2, &tx, 0, 100);
+	TEST_ASSERT(CanAL_Timestamp_TxComplete(&state, CAN_TX_MAILBOX2, 900, 0, 200, &ID, &timestamp));
+	TEST_ASSERT_EQUAL(MSG_T, ID);
+	TEST_ASSERT_EQUAL(900, timestamp);
+	TEST_ASSERT_EQUAL(0, state.latency.txBusTime.count);
+	TEST_ASSERT_EQUAL(0, state.latency.txIsrDelay.count);
+
+	// ref is the cycle count at the end of the received frame
+	CanAL_Timestamp_Rx(&state, &rx, 0, ref);
+
+	// Queued 200 cycles, on the bus from 1500 bits and completed 700 cycles
+	// after the end of the frame
+	CanAL_Timestamp_TxLoaded(&state, CAN_TX_MAILBOX0, &tx, ref, ref + 200U);
+	end = ref + ((1500U + STD_DLC4_BITS - (1000U + STD_DLC8_BITS)) * CYCLES_PER_BIT);
+	TEST_ASSERT(CanAL_Timestamp_TxComplete(&state, CAN_TX_MAILBOX0, 1500, 1, end + 700U,
+		&ID, &timestamp));
+	TEST_ASSERT_EQUAL(MSG_T, ID);
+	TEST_ASSERT_EQUAL(1500, timestamp);
+
+	TEST_ASSERT_EQUAL(2, state.latency.txQueueDelay.count);
+	TEST_ASSERT_EQUAL(200, state.latency.txQueueDelay.max);
+	TEST_ASSERT_EQUAL(1, state.latency.txBusTime.count);
+	TEST_ASSERT_EQUAL(end - (ref + 200U), state.latency.txBusTime.max);
+	TEST_ASSERT_EQUAL(1, state.latency.txIsrDelay.count);
+	TEST_ASSERT_EQUAL(700, state.latency.txIsrDelay.max);
+
+	// The mailbox is free again, and an aborted frame records nothing
+	TEST_ASSERT(!CanAL_Timestamp_TxComplete(&state, CAN_TX_MAILBOX0, 1600, 1, end, &ID, &timestamp));
+	CanAL_Timestamp_TxLoaded(&state, CAN_TX_MAILBOX1, &tx, ref, ref);
+	CanAL_Timestamp_TxAbort(&state, CAN_TX_MAILBOX1);
+	TEST_ASSERT(!CanAL_Timestamp_TxComplete(&state, CAN_TX_MAILBOX1, 1600, 1, end, &ID, &timestamp));
+	TEST_ASSERT_EQUAL(3, state.latency.txQueueDelay.count);
+	TEST_ASSERT_EQUAL(1, state.latency.txBusTime.count);
+	TEST_ASSERT_EQUAL(1, state.latency.txIsrDelay.count);
+}
+
+static void test_latency_through_canal(void) {
+	TsStubCanFrame rx = { .id = MSG_A, .ide = CAN_ID_STD, .dlc = 8, .time = 1000 };
+	TsCanALRawFrame tx = { .id = MSG_T, .ide = CAN_ID_STD, .dlc = 8 };
+	TsCanALLatency latency;
+	TsCanALTxIdStats stats;
+	uint32_t mailbox;
+
+	setUp();
+	TEST_ASSERT_EQUAL(ENABLE, hcan.Init.TimeTriggeredMode);
+
+	Stub_CanPushRx(CAN1, CAN_RX_FIFO0, &rx);
+	CanAL_Receive(&can);
+	rx.time = 2000;
+	Stub_Tick = 2;
+	Stub_CanPushRx(CAN1, CAN_RX_FIFO0, &rx);
+	Stub_CycleCount((1000U * CYCLES_PER_BIT) + 300U);
+	CanAL_Receive(&can);
+
+	// The fourth frame waits 500 cycles for the first mailbox to free up
+	for (uint32_t i = 0; i < 4U; i++) TEST_ASSERT_EQUAL(CANAL_OK, CanAL_TransmitRaw(&can, &tx));
+	Stub_CycleCount(500);
+	mailbox = Stub_CanTxMailbox(CAN1, 0);
+	Stub_CanSetTxTime(CAN1, mailbox, 3000);
+	Stub_CanReleaseMailbox(CAN1, mailbox);
+	CanAL_TxMailboxComplete(&can, mailbox);
+
+	// An aborted frame gets no bus time
+	mailbox = Stub_CanTxMailbox(CAN1, 1);
+	Stub_CanReleaseMailbox(CAN1, mailbox);
+	CanAL_TxMailboxAbort(&can, mailbox);
+	CanAL_TxMailboxComplete(&can, mailbox);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_GetLatency(&can, &latency));
+	TEST_ASSERT_EQUAL(2, latency.rxIsrDelay.count);
+	TEST_ASSERT_EQUAL(300, latency.rxIsrDelay.max);
+	TEST_ASSERT_EQUAL(4, latency.txQueueDelay.count);
+	TEST_ASSERT_EQUAL(0, latency.txQueueDelay.min);
+	TEST_ASSERT_EQUAL(500, latency.txQueueDelay.max);
+	TEST_ASSERT_EQUAL(1, latency.txBusTime.count);
+	TEST_ASSERT_EQUAL(1, latency.txIsrDelay.count);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_GetTxStats(&can, MSG_T, &stats));
+	TEST_ASSERT_EQUAL(3000, stats.timestamp);
+}
+
+int main(void) {
+	TEST_RUN(test_extend_across_wraps);
+	TEST_RUN(test_extend_after_idle);
+	TEST_RUN(test_rx_latency);
+	TEST_RUN(test_tx_latency);
+	TEST_RUN(test_latency_through_canal);
+
+	return TEST_RESULT();
+}
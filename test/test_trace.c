@@ -0,0 +1,152 @@
+/*
+ * test_trace.c
+ *
+ * The trace record codec round trips every field, and overwrite mode folds the
+ * deltas of evicted records into the oldest one kept so a drained stream still
+ * carries the absolute time of every frame since CanAL_Trace_Start.
+ */
+
+#include <string.h>
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+#define SIM_FRAMES						(2000U)
+
+static TsCanALTrace trace;
+static uint32_t simUs;
+static uint8_t stream[2U * CANAL_TRACE_SIZE];
+static uint32_t streamLen;
+
+static uint32_t clockUs(void) {
+	return simUs;
+}
+
+static TeCanALRet collect(void* ctx, const uint8_t* data, uint16_t len) {
+	(void)ctx;
+
+	memcpy(&stream[streamLen], data, len);
+	streamLen += len;
+
+	return CANAL_OK;
+}
+
+static void test_codec_round_trip(void) {
+	static const uint32_t deltas[] = { 0, 127, 128, 16383, 16384, 1U << 21, 1U << 28, 0xFFFFFFFFU };
+	TsCanALTraceRecord in;
+	TsCanALTraceRecord out;
+	uint8_t bytes[CANAL_TRACE_MAX_RECORD];
+
+	for (uint32_t d = 0; d < sizeof(deltas) / sizeof(deltas[0]); d++) {
+		for (uint8_t dlc = 0; dlc <= 8U; dlc++) {
+			uint32_t len;
+
+			memset(&in, 0, sizeof(in));
+			in.deltaUs = deltas[d];
+			in.frame.id = (dlc & 1U) ? 0x1ABCDEF0U : 0x7FFU;
+			in.frame.ide = (dlc & 1U) ? CAN_ID_EXT : CAN_ID_STD;
+			in.frame.dlc = dlc;
+			for (uint8_t i = 0; i < dlc; i++) in.frame.data[i] = (uint8_t)(0xA0U + i);
+			in.bus = (uint8_t)(1U + (dlc % 3U));
+			in.tx = (d & 1U) != 0U;
+
+			len = CanAL_Trace_EncodeRecord(&in, bytes);
+			TEST_ASSERT(len <= CANAL_TRACE_MAX_RECORD);
+
+			// Every prefix of the record is incomplete
+			for (uint32_t cut = 0; cut < len; cut++) {
+				TEST_ASSERT_EQUAL(0, CanAL_Trace_DecodeRecord(bytes, cut, &out));
+			}
+
+			TEST_ASSERT_EQUAL(len, CanAL_Trace_DecodeRecord(bytes, len, &out));
+			TEST_ASSERT_EQUAL(in.deltaUs, out.deltaUs);
+			TEST_ASSERT_EQUAL(in.frame.id, out.frame.id);
+			TEST_ASSERT_EQUAL(in.frame.ide, out.frame.ide);
+			TEST_ASSERT_EQUAL(in.frame.dlc, out.frame.dlc);
+			TEST_ASSERT_EQUAL(0, memcmp(in.frame.data, out.frame.data, 8));
+			TEST_ASSERT_EQUAL(in.bus, out.bus);
+			TEST_ASSERT_EQUAL(in.tx, out.tx);
+		}
+	}
+}
+
+static void test_overwrite_keeps_absolute_time(void) {
+	static uint32_t sentUs[SIM_FRAMES];
+	TsCanALRawFrame frame = { .id = 0x100, .ide = CAN_ID_STD, .dlc = 4 };
+	TsCanALTraceRecord record;
+	uint32_t startUs = 5000;
+	uint32_t timeUs;
+	uint32_t pos = 0;
+	uint32_t seq = 0;
+	uint16_t drained;
+
+	Stub_Reset();
+	streamLen = 0;
+	simUs = startUs;
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Trace_Init(&trace, CANAL_TRACE_OVERWRITE, clockUs));
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Trace_Start(&trace));
+
+	// Mostly 1 byte deltas with long gaps, so folding a gap into the oldest
+	// record often needs a longer encoding
+	for (uint32_t i = 0; i < SIM_FRAMES; i++) {
+		simUs += ((i % 7U) == 0U) ? 250000U : 100U;
+		sentUs[i] = simUs;
+		memcpy(frame.data, &i, sizeof(i));
+		CanAL_Trace_Record(&trace, &frame, CANAL_INST_CAN_1, false);
+	}
+
+	TEST_ASSERT_EQUAL(SIM_FRAMES, trace.recorded);
+
+	do {
+		TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Trace_Drain(&trace, collect, NULL, 256, &drained));
+	} while (drained != 0U);
+
+	timeUs = startUs;
+	while (pos < streamLen) {
+		uint32_t len = CanAL_Trace_DecodeRecord(&stream[pos], streamLen - pos, &record);
+
+		TEST_ASSERT(len != 0U);
+		memcpy(&seq, record.frame.data, sizeof(seq));
+		timeUs += record.deltaUs;
+		TEST_ASSERT_EQUAL(sentUs[seq], timeUs);
+		pos += len;
+	}
+
+	// The newest frame survived and the oldest ones were evicted
+	TEST_ASSERT_EQUAL(SIM_FRAMES - 1U, seq);
+	TEST_ASSERT_EQUAL(simUs, timeUs);
+	TEST_ASSERT(streamLen <= CANAL_TRACE_SIZE);
+}
+
+static void test_stop_on_full_keeps_oldest(void) {
+	TsCanALRawFrame frame = { .id = 0x18FF0001, .ide = CAN_ID_EXT, .dlc = 8 };
+	TsCanALTraceRecord record;
+
+	Stub_Reset();
+	streamLen = 0;
+	simUs = 0;
+	CanAL_Trace_Init(&trace, CANAL_TRACE_STOP_ON_FULL, clockUs);
+	CanAL_Trace_Start(&trace);
+
+	for (uint32_t i = 0; i < SIM_FRAMES; i++) {
+		simUs += 130;
+		CanAL_Trace_Record(&trace, &frame, CANAL_INST_CAN_2, true);
+	}
+
+	TEST_ASSERT_EQUAL(CANAL_TRACE_STOPPED, trace.state);
+	TEST_ASSERT_EQUAL(1, trace.dropped);
+	TEST_ASSERT(trace.recorded < SIM_FRAMES);
+
+	CanAL_Trace_Drain(&trace, collect, NULL, 64, NULL);
+	TEST_ASSERT(CanAL_Trace_DecodeRecord(stream, streamLen, &record) != 0U);
+	TEST_ASSERT_EQUAL(130, record.deltaUs);
+	TEST_ASSERT_EQUAL(CANAL_INST_CAN_2, record.bus);
+	TEST_ASSERT(record.tx);
+}
+
+int main(void) {
+	TEST_RUN(test_codec_round_trip);
+	TEST_RUN(test_overwrite_keeps_absolute_time);
+	TEST_RUN(test_stop_on_full_keeps_oldest);
+
+	return TEST_RESULT();
+}
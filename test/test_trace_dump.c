@@ -0,0 +1,120 @@
+/*
+ * test_trace_dump.c
+ *
+ * tools/canal_trace_dump run on a known trace stream: its candump and ASC
+ * output line by line, and the error for a stream cut inside a record. The
+ * path of the tool is the first argument.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include "canal_test.h"
+#include "canal_trace_codec.h"
+
+#define TRACE_PATH						"test_trace_dump.bin"
+
+static const char* toolPath;
+static char output[4096];
+
+static const TsCanALTraceRecord RECORDS[] = {
+	{ .deltaUs = 1500, .bus = 1, .tx = false,
+		.frame = { .id = 0x123, .ide = CAN_ID_STD, .dlc = 3, .data = { 0x01, 0xAB, 0xFF } } },
+	{ .deltaUs = 2000000, .bus = 2, .tx = true,
+		.frame = { .id = 0x18FF0001, .ide = CAN_ID_EXT, .dlc = 8,
+			.data = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 } } },
+	{ .deltaUs = 250, .bus = 1, .tx = false,
+		.frame = { .id = 0x7FF, .ide = CAN_ID_STD, .dlc = 0 } },
+};
+
+// writeTrace encodes RECORDS into TRACE_PATH, leaving off the last cut bytes
+static void writeTrace(uint32_t cut) {
+	uint8_t stream[sizeof(RECORDS) / sizeof(RECORDS[0]) * CANAL_TRACE_MAX_RECORD];
+	uint32_t len = 0;
+	FILE* out = fopen(TRACE_PATH, "wb");
+
+	for (uint32_t i = 0; i < sizeof(RECORDS) / sizeof(RECORDS[0]); i++) {
+		len += CanAL_Trace_EncodeRecord(&RECORDS[i], &stream[len]);
+	}
+
+	fwrite(stream, 1, len - cut, out);
+	fclose(out);
+}
+
+// runTool runs the tool with flags on TRACE_PATH, collects its stdout into
+// output and returns its exit status
+static int runTool(const char* flags) {
+	char command[1024];
+	size_t len;
+	FILE* pipe;
+	int status;
+
+	snprintf(command, sizeof(command), "\"%s\" %s %s 2>/dev/null", toolPath, flags, TRACE_PATH);
+	pipe = popen(command, "r");
+	len = fread(output, 1, sizeof(output) - 1U, pipe);
+	output[len] = '\0';
+	status = pclose(pipe);
+
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// skipLines returns text after its first n lines
+static const char* skipLines(const char* text, uint32_t n) {
+	for (uint32_t i = 0; (i < n) && (text != NULL); i++) {
+		text = strchr(text, '\n');
+		if (text != NULL) text++;
+	}
+
+	return (text != NULL) ? text : "";
+}
+
+static void test_candump(void) {
+	writeTrace(0);
+	TEST_ASSERT_EQUAL(0, runTool(""));
+	TEST_ASSERT_EQUAL(0, strcmp(output,
+		"(0.001500) can0 123#01ABFF\n"
+		"(2.001500) can1 18FF0001#0001020304050607\n"
+		"(2.001750) can0 7FF#\n"));
+}
+
+static void test_asc(void) {
+	writeTrace(0);
+	TEST_ASSERT_EQUAL(0, runTool("-a"));
+
+	// The header carries the time the tool ran
+	TEST_ASSERT_EQUAL(0, strncmp(output, "date ", 5));
+	TEST_ASSERT_EQUAL(0, strncmp(skipLines(output, 1), "base hex  timestamps absolute\n", 30));
+	TEST_ASSERT_EQUAL(0, strcmp(skipLines(output, 4),
+		"   0.001500 1  123             Rx   d 3 01 AB FF\n"
+		"   2.001500 2  18FF0001x       Tx   d 8 00 01 02 03 04 05 06 07\n"
+		"   2.001750 1  7FF             Rx   d 0\n"
+		"End TriggerBlock\n"));
+}
+
+static void test_truncated_stream(void) {
+	// Cut inside the ID of the last record
+	writeTrace(1);
+	TEST_ASSERT_EQUAL(1, runTool(""));
+	TEST_ASSERT_EQUAL(0, strcmp(output,
+		"(0.001500) can0 123#01ABFF\n"
+		"(2.001500) can1 18FF0001#0001020304050607\n"));
+
+	TEST_ASSERT_EQUAL(2, runTool("-x"));
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <canal_trace_dump>\n", argv[0]);
+		return 2;
+	}
+	toolPath = argv[1];
+
+	TEST_RUN(test_candump);
+	TEST_RUN(test_asc);
+	TEST_RUN(test_truncated_stream);
+
+	remove(TRACE_PATH);
+
+	return TEST_RESULT();
+}
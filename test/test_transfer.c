@@ -0,0 +1,162 @@
+/*
+ * test_transfer.c
+ *
+ * Large and scatter-gather transfers against a model of the bus: an SPI
+ * transaction keeps CS low from its first frame to its last with no toggles
+ * between segments or chunks, and UART and SPI transfers longer than a HAL
+ * call walk the buffer by whole data frames.
+ */
+
+#include <string.h>
+#include "canal_test.h"
+#include "spi_lib.h"
+#include "uart_lib.h"
+
+#define BIG_FRAMES						(70000U)
+
+static SPI_HandleTypeDef hspi;
+static GPIO_TypeDef csPort;
+static TsSPI spi;
+static UART_HandleTypeDef huart;
+static UART_st uart;
+
+static bool csHigh;
+static uint32_t csEdges;
+static uint32_t clockedHigh;
+static uint32_t calls;
+static uint8_t wire[2U * BIG_FRAMES + 64U];
+static uint32_t wireLen;
+static uint8_t rxNext;
+static uint8_t big[2U * BIG_FRAMES];
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state) {
+	(void)port;
+	(void)pin;
+
+	if ((state == GPIO_PIN_SET) != csHigh) csEdges++;
+	csHigh = (state == GPIO_PIN_SET);
+}
+
+// clockFrames moves size frames over the wire, counting any that go out while CS is high
+static HAL_StatusTypeDef clockFrames(const uint8_t* tx, uint8_t* rx, uint16_t size, uint32_t frameSize) {
+	calls++;
+	if (csHigh) clockedHigh += size;
+
+	for (uint32_t i = 0; i < (uint32_t)size * frameSize; i++) {
+		wire[wireLen++] = (tx != NULL) ? tx[i] : 0xFFU;
+		if (rx != NULL) rx[i] = rxNext++;
+	}
+
+	return HAL_OK;
+}
+
+static uint32_t spiFrameSize(const SPI_HandleTypeDef* h) {
+	return (h->Init.DataSize > SPI_DATASIZE_8BIT) ? 2U : 1U;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* h, uint8_t* data, uint16_t size, uint32_t timeout) {
+	(void)timeout;
+
+	return clockFrames(data, NULL, size, spiFrameSize(h));
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef* h, uint8_t* data, uint16_t size, uint32_t timeout) {
+	(void)timeout;
+
+	return clockFrames(NULL, data, size, spiFrameSize(h));
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* h, uint8_t* tx, uint8_t* rx,
+		uint16_t size, uint32_t timeout) {
+	(void)timeout;
+
+	return clockFrames(tx, rx, size, spiFrameSize(h));
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* h, const uint8_t* data, uint16_t size,
+		uint32_t timeout) {
+	(void)timeout;
+
+	return clockFrames(data, NULL, size, (h->Init.WordLength == UART_WORDLENGTH_9B) ? 2U : 1U);
+}
+
+static void setUp(uint32_t dataSize) {
+	memset(&hspi, 0, sizeof(hspi));
+	hspi.Init.DataSize = dataSize;
+	spi = (TsSPI){ .hspi = &hspi, .baudrate = 1000, .cs_port = &csPort, .pin = 1 };
+	csHigh = true;
+	csEdges = 0;
+	clockedHigh = 0;
+	calls = 0;
+	wireLen = 0;
+	rxNext = 0;
+
+	for (uint32_t i = 0; i < sizeof(big); i++) big[i] = (uint8_t)(i + 3U);
+}
+
+static void test_cs_held_across_segments(void) {
+	uint8_t head[3] = { 0, 1, 2 };
+	uint8_t tail[5];
+	uint8_t rx[6];
+	TsSPI_Iovec iov[] = {
+		{ head, NULL, sizeof(head) },
+		{ big, NULL, BIG_FRAMES },
+		{ tail, NULL, sizeof(tail) },
+		{ NULL, rx, sizeof(rx) },
+	};
+
+	setUp(SPI_DATASIZE_8BIT);
+	for (uint32_t i = 0; i < sizeof(tail); i++) tail[i] = (uint8_t)(BIG_FRAMES + 3U + i);
+
+	TEST_ASSERT_EQUAL(SPI_OK, SPI_Transfer_Vec(&spi, iov, 4));
+
+	// One falling and one rising edge, and nothing clocked with CS high
+	TEST_ASSERT_EQUAL(2, csEdges);
+	TEST_ASSERT(csHigh);
+	TEST_ASSERT_EQUAL(0, clockedHigh);
+	// The large segment takes two HAL calls
+	TEST_ASSERT_EQUAL(5, calls);
+
+	TEST_ASSERT_EQUAL(3U + BIG_FRAMES + 5U + 6U, wireLen);
+	for (uint32_t i = 0; i < 3U + BIG_FRAMES + 5U; i++) TEST_ASSERT_EQUAL((uint8_t)i, wire[i]);
+	for (uint32_t i = 0; i < sizeof(rx); i++) TEST_ASSERT_EQUAL(i, rx[i]);
+}
+
+static void test_bad_segment_leaves_cs_alone(void) {
+	uint8_t data[2] = {0};
+	TsSPI_Iovec iov[] = { { data, NULL, 2 }, { NULL, NULL, 2 } };
+
+	setUp(SPI_DATASIZE_8BIT);
+	TEST_ASSERT_EQUAL(SPI_INVALID_BUFFER, SPI_Transfer_Vec(&spi, iov, 2));
+	TEST_ASSERT_EQUAL(0, csEdges);
+	TEST_ASSERT_EQUAL(0, calls);
+}
+
+static void test_wide_frames_advance_by_two_bytes(void) {
+	setUp(SPI_DATASIZE_16BIT);
+	TEST_ASSERT_EQUAL(SPI_OK, SPI_Transmit(&spi, big, BIG_FRAMES));
+	TEST_ASSERT_EQUAL(2, calls);
+	TEST_ASSERT_EQUAL(2U * BIG_FRAMES, wireLen);
+	TEST_ASSERT_EQUAL(0, memcmp(big, wire, wireLen));
+
+	// 9 bit uart frames are 16 bit items too
+	setUp(SPI_DATASIZE_8BIT);
+	memset(&huart, 0, sizeof(huart));
+	huart.Init.WordLength = UART_WORDLENGTH_9B;
+	huart.Init.Parity = UART_PARITY_NONE;
+	uart = (UART_st){ .huart = &huart, .uart_num = 1, .baudrate = UART_115200,
+		.datasize = UART_Datasize_9 };
+
+	TEST_ASSERT_EQUAL(UART_OK, UART_Transmit(&uart, big, BIG_FRAMES));
+	TEST_ASSERT_EQUAL(2, calls);
+	TEST_ASSERT_EQUAL(2U * BIG_FRAMES, wireLen);
+	TEST_ASSERT_EQUAL(0, memcmp(big, wire, wireLen));
+}
+
+int main(void) {
+	TEST_RUN(test_cs_held_across_segments);
+	TEST_RUN(test_bad_segment_leaves_cs_alone);
+	TEST_RUN(test_wide_frames_advance_by_two_bytes);
+
+	return TEST_RESULT();
+}
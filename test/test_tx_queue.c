@@ -0,0 +1,179 @@
+/*
+ * test_tx_queue.c
+ *
+ * The software tx queue behind the three mailboxes: arbitration order, a full
+ * queue rejecting new frames instead of dropping accepted ones, mailboxes
+ * freed by a failed frame being refilled from CanAL_Error, and batches that
+ * are queued whole, in arbitration order and with no other frame in between,
+ * or not at all.
+ */
+
+#include "canal_test.h"
+#include "canal_fixture.h"
+
+static TsCanAL can;
+static CAN_HandleTypeDef hcan;
+
+static TeCanALRet send(uint32_t id, uint32_t ide) {
+	TsCanALRawFrame frame = { .id = id, .ide = (uint8_t)ide, .dlc = 8 };
+
+	return CanAL_TransmitRaw(&can, &frame);
+}
+
+// complete finishes the frame in mailbox the way the tx complete interrupt does
+static void complete(uint32_t mailbox) {
+	Stub_CanReleaseMailbox(CAN1, mailbox);
+	CanAL_TxMailboxComplete(&can, mailbox);
+}
+
+static bool foreignSent;
+
+// sendForeign is a marshal hook that sends 0x050 once, like an interrupt
+// transmitting in the middle of a batch being marshalled
+static void sendForeign(void) {
+	if (foreignSent) return;
+
+	foreignSent = true;
+	send(0x050, CAN_ID_STD);
+}
+
+static void setUp(void) {
+	Test_MarshalHook = NULL;
+	foreignSent = false;
+	Stub_Reset();
+	Test_InitCan(&can, &hcan, CANAL_INST_CAN_1, CANAL_RX_MODE_IMMEDIATE);
+}
+
+static void test_queue_drains_in_arbitration_order(void) {
+	static const uint32_t queued[] = { 0x300, 0x050, 0x200, 0x050 };
+
+	setUp();
+	for (uint32_t i = 0; i < 3; i++) TEST_ASSERT_EQUAL(CANAL_OK, send(0x400 + i, CAN_ID_STD));
+	for (uint32_t i = 0; i < 4; i++) TEST_ASSERT_EQUAL(CANAL_OK, send(queued[i], CAN_ID_STD));
+	// An extended frame loses to a standard frame with the same base ID
+	TEST_ASSERT_EQUAL(CANAL_OK, send(0x200U << 18, CAN_ID_EXT));
+	TEST_ASSERT_EQUAL(3, Stub_CanTxCount(CAN1));
+
+	for (uint32_t i = 0; i < 5; i++) complete(Stub_CanTxMailbox(CAN1, i));
+
+	TEST_ASSERT_EQUAL(8, Stub_CanTxCount(CAN1));
+	TEST_ASSERT_EQUAL(0x050, Stub_CanTx(CAN1, 3)->id);
+	TEST_ASSERT_EQUAL(0x050, Stub_CanTx(CAN1, 4)->id);
+	TEST_ASSERT_EQUAL(0x200, Stub_CanTx(CAN1, 5)->id);
+	TEST_ASSERT_EQUAL(CAN_ID_EXT, Stub_CanTx(CAN1, 6)->ide);
+	TEST_ASSERT_EQUAL(0x300, Stub_CanTx(CAN1, 7)->id);
+}
+
+static void test_full_queue_rejects_new_frame(void) {
+	TsCanALTxIdStats stats;
+
+	setUp();
+	for (uint32_t i = 0; i < 3U + CANAL_TX_QUEUE_SIZE; i++) {
+		TEST_ASSERT_EQUAL(CANAL_OK, send(0x500, CAN_ID_STD));
+	}
+
+	// Even a higher priority frame may not push out one that was accepted
+	TEST_ASSERT_EQUAL(CANAL_TX_QUEUE_FULL, send(0x001, CAN_ID_STD));
+	CanAL_GetTxStats(&can, 0x001, &stats);
+	TEST_ASSERT_EQUAL(1, stats.dropped);
+
+	// Every accepted frame still goes out
+	for (uint32_t i = 0; i < 3U + CANAL_TX_QUEUE_SIZE; i++) complete(Stub_CanTxMailbox(CAN1, i));
+	TEST_ASSERT_EQUAL(3U + CANAL_TX_QUEUE_SIZE, Stub_CanTxCount(CAN1));
+	CanAL_GetTxStats(&can, 0x500, &stats);
+	TEST_ASSERT_EQUAL(3U + CANAL_TX_QUEUE_SIZE, stats.sent);
+	TEST_ASSERT_EQUAL(0, stats.dropped);
+}
+
+static void test_failed_frame_refills_mailbox(void) {
+	TsCanALTxIdStats stats;
+	uint32_t mailbox;
+
+	setUp();
+	for (uint32_t i = 0; i < 3; i++) send(0x100 + i, CAN_ID_STD);
+	send(0x123, CAN_ID_STD);
+	TEST_ASSERT_EQUAL(3, Stub_CanTxCount(CAN1));
+
+	// The frame in the second mailbox loses arbitration and is not retried, the
+	// HAL reports it only through the error callback
+	mailbox = Stub_CanTxMailbox(CAN1, 1);
+	TEST_ASSERT_EQUAL(CAN_TX_MAILBOX1, mailbox);
+	Stub_CanReleaseMailbox(CAN1, mailbox);
+	hcan.ErrorCode |= HAL_CAN_ERROR_TX_ALST1;
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_Error(&can));
+
+	TEST_ASSERT_EQUAL(4, Stub_CanTxCount(CAN1));
+	TEST_ASSERT_EQUAL(0x123, Stub_CanTx(CAN1, 3)->id);
+	TEST_ASSERT_EQUAL(HAL_CAN_ERROR_NONE, hcan.ErrorCode);
+
+	CanAL_GetTxStats(&can, 0x101, &stats);
+	TEST_ASSERT_EQUAL(1, stats.sent);
+	TEST_ASSERT_EQUAL(1, stats.failed);
+	CanAL_GetTxStats(&can, 0x100, &stats);
+	TEST_ASSERT_EQUAL(0, stats.failed);
+}
+
+static void test_batch_whole_or_nothing(void) {
+	TeMessageID ids[CANAL_TX_BATCH_MAX + 1U];
+	static const TeMessageID noMarshaller[] = { MSG_A, MSG_B, MSG_T };
+	TsCanALTxIdStats stats;
+
+	for (uint32_t i = 0; i < CANAL_TX_BATCH_MAX + 1U; i++) ids[i] = ((i % 2U) == 0U) ? MSG_T : MSG_A;
+
+	// A full batch takes every mailbox and the whole queue
+	setUp();
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_TransmitBatch(&can, ids, CANAL_TX_BATCH_MAX));
+	TEST_ASSERT_EQUAL(3, Stub_CanTxCount(CAN1));
+	TEST_ASSERT_EQUAL(CANAL_TX_QUEUE_SIZE, can.txQueue.count);
+	TEST_ASSERT_EQUAL(CANAL_TX_QUEUE_FULL, send(0x001, CAN_ID_STD));
+
+	// Too many at once is refused outright
+	setUp();
+	TEST_ASSERT_EQUAL(CANAL_ERROR, CanAL_TransmitBatch(&can, ids, CANAL_TX_BATCH_MAX + 1U));
+	TEST_ASSERT_EQUAL(0, Stub_CanTxCount(CAN1));
+
+	// So is a batch with a message that has no marshaller
+	TEST_ASSERT_EQUAL(CANAL_UNSUPPORTED_TX_MESSAGE, CanAL_TransmitBatch(&can, noMarshaller, 3));
+	TEST_ASSERT_EQUAL(0, Stub_CanTxCount(CAN1));
+	TEST_ASSERT_EQUAL(0, can.txQueue.count);
+
+	// Two free queue entries do not take three frames, not even the first two
+	for (uint32_t i = 0; i < 1U + CANAL_TX_QUEUE_SIZE; i++) send(0x500, CAN_ID_STD);
+	TEST_ASSERT_EQUAL(CANAL_TX_QUEUE_SIZE - 2U, can.txQueue.count);
+	TEST_ASSERT_EQUAL(CANAL_TX_QUEUE_FULL, CanAL_TransmitBatch(&can, ids, 3));
+	TEST_ASSERT_EQUAL(CANAL_TX_QUEUE_SIZE - 2U, can.txQueue.count);
+	CanAL_GetTxStats(&can, MSG_T, &stats);
+	TEST_ASSERT_EQUAL(2, stats.dropped);
+	TEST_ASSERT_EQUAL(0, stats.enqueued);
+
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_TransmitBatch(&can, ids, 2));
+	TEST_ASSERT_EQUAL(CANAL_TX_QUEUE_SIZE, can.txQueue.count);
+}
+
+static void test_batch_arbitration_order(void) {
+	static const TeMessageID ids[] = { MSG_T, MSG_A, MSG_T, MSG_A, MSG_T };
+	static const uint32_t order[] = { 0x050, MSG_A, MSG_A, MSG_T, MSG_T, MSG_T, 0x7FF };
+
+	// A frame sent while the batch is being marshalled goes out before all of
+	// it, one sent afterwards after all of it
+	setUp();
+	Test_MarshalHook = sendForeign;
+	TEST_ASSERT_EQUAL(CANAL_OK, CanAL_TransmitBatch(&can, ids, 5));
+	Test_MarshalHook = NULL;
+	TEST_ASSERT_EQUAL(CANAL_OK, send(0x7FF, CAN_ID_STD));
+
+	for (uint32_t i = 0; i < 4U; i++) complete(Stub_CanTxMailbox(CAN1, i));
+
+	TEST_ASSERT_EQUAL(7, Stub_CanTxCount(CAN1));
+	for (uint32_t i = 0; i < 7U; i++) TEST_ASSERT_EQUAL(order[i], Stub_CanTx(CAN1, i)->id);
+}
+
+int main(void) {
+	TEST_RUN(test_queue_drains_in_arbitration_order);
+	TEST_RUN(test_full_queue_rejects_new_frame);
+	TEST_RUN(test_failed_frame_refills_mailbox);
+	TEST_RUN(test_batch_whole_or_nothing);
+	TEST_RUN(test_batch_arbitration_order);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,144 @@
+/*
+ * test_uart_rx.c
+ *
+ * The uart rx ring against a model of the circular rx DMA that raises
+ * UART_Rx_Event at half transfer, transfer complete and idle line: a reader
+ * that peeks and consumes at its own pace sees every byte in order or counts
+ * it as dropped, and an overrun restarts reception.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "canal_test.h"
+#include "uart_lib.h"
+
+#define RING_SIZE						(256U)
+#define ROUNDS							(100000U)
+
+static UART_HandleTypeDef huart;
+static DMA_HandleTypeDef hdmarx;
+static UART_st uart;
+static UART_Rx_Ring_st ring;
+static uint8_t buf[RING_SIZE] __attribute__((aligned(32)));
+
+static uint8_t* dmaBuf;
+static uint16_t dmaSize;
+static uint16_t dmaPos;
+static uint32_t lineSeq;
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* h, uint8_t* data, uint16_t size) {
+	(void)h;
+
+	dmaBuf = data;
+	dmaSize = size;
+	dmaPos = 0;
+
+	return HAL_OK;
+}
+
+// lineRx receives n bytes of a running sequence, raising the events the
+// application's HAL_UARTEx_RxEventCallback passes on
+static void lineRx(uint32_t n, bool idle) {
+	while (n-- > 0U) {
+		dmaBuf[dmaPos++] = (uint8_t)lineSeq++;
+
+		if (dmaPos == (dmaSize / 2U)) UART_Rx_Event(&huart, dmaPos);
+		if (dmaPos == dmaSize) {
+			UART_Rx_Event(&huart, dmaSize);
+			dmaPos = 0;
+		}
+	}
+
+	if (idle) UART_Rx_Event(&huart, dmaPos);
+}
+
+static void setUp(void) {
+	memset(&huart, 0, sizeof(huart));
+	hdmarx.Init.Mode = DMA_CIRCULAR;
+	huart.hdmarx = &hdmarx;
+	uart = (UART_st){ .huart = &huart, .uart_num = 2, .baudrate = UART_115200,
+		.datasize = UART_Datasize_8, .mode = UART_TX_RX };
+	lineSeq = 0;
+	srand(3);
+
+	TEST_ASSERT_EQUAL(UART_OK, UART_Rx_Ring_Init(&uart, &ring, buf, RING_SIZE));
+}
+
+static void test_init_needs_circular_dma(void) {
+	setUp();
+
+	hdmarx.Init.Mode = 0;
+	TEST_ASSERT_EQUAL(UART_INVALID_MODE, UART_Rx_Ring_Init(&uart, &ring, buf, RING_SIZE));
+
+	hdmarx.Init.Mode = DMA_CIRCULAR;
+	huart.hdmarx = NULL;
+	TEST_ASSERT_EQUAL(UART_INVALID_MODE, UART_Rx_Ring_Init(&uart, &ring, buf, RING_SIZE));
+}
+
+static void test_reader_sees_every_byte_or_drops_it(void) {
+	UART_Rx_Stats_st stats;
+	UART_Span_st span;
+	uint32_t got = 0;
+
+	setUp();
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		uint32_t pending;
+		uint32_t take;
+		uint32_t expect;
+
+		lineRx((uint32_t)rand() % 50U, (rand() % 2) != 0);
+
+		pending = UART_Peek(&uart, &span);
+		TEST_ASSERT_EQUAL(pending, span.len[0] + span.len[1]);
+		UART_Rx_Get_Stats(&uart, &stats);
+		expect = got + stats.dropped;
+
+		// The reader stalls now and then, so the DMA laps it
+		take = (((i / 20U) % 50U) == 0U) ? 0U : ((uint32_t)rand() % (pending + 1U));
+		for (uint32_t k = 0; k < take; k++) {
+			uint8_t byte = (k < span.len[0]) ? span.data[0][k] : span.data[1][k - span.len[0]];
+
+			TEST_ASSERT_EQUAL((uint8_t)(expect + k), byte);
+		}
+
+		UART_Consume(&uart, take);
+		got += take;
+	}
+	lineRx(0, true);
+
+	UART_Rx_Get_Stats(&uart, &stats);
+	TEST_ASSERT(stats.dropped > 0U);
+	TEST_ASSERT(stats.high_water <= RING_SIZE);
+	TEST_ASSERT_EQUAL(lineSeq, got + stats.dropped + stats.pending);
+}
+
+static void test_overrun_restarts_reception(void) {
+	UART_Rx_Stats_st stats;
+	UART_Span_st span;
+
+	setUp();
+	lineRx(37, true);
+
+	// The HAL aborts reception on an overrun before the error callback
+	huart.ErrorCode = HAL_UART_ERROR_ORE | HAL_UART_ERROR_FE;
+	huart.RxState = HAL_UART_STATE_READY;
+	UART_Error(&huart);
+	lineRx(10, true);
+
+	TEST_ASSERT_EQUAL(10, UART_Peek(&uart, &span));
+	TEST_ASSERT_EQUAL((uint8_t)(lineSeq - 10U), span.data[0][0]);
+
+	UART_Rx_Get_Stats(&uart, &stats);
+	TEST_ASSERT_EQUAL(37, stats.dropped);
+	TEST_ASSERT_EQUAL(1, stats.overruns);
+	TEST_ASSERT_EQUAL(1, stats.framing_errors);
+	TEST_ASSERT_EQUAL(1, stats.restarts);
+}
+
+int main(void) {
+	TEST_RUN(test_init_needs_circular_dma);
+	TEST_RUN(test_reader_sees_every_byte_or_drops_it);
+	TEST_RUN(test_overrun_restarts_reception);
+
+	return TEST_RESULT();
+}
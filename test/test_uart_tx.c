@@ -0,0 +1,162 @@
+/*
+ * test_uart_tx.c
+ *
+ * The uart tx ring against a model of the tx DMA that moves a few bytes per
+ * step and completes like the transfer complete interrupt: every byte that is
+ * not dropped reaches the wire in order, overwritten bytes are accounted for,
+ * a failed transfer is given up, and rings the DMA cannot serve are refused.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "canal_test.h"
+#include "uart_lib.h"
+
+#define RING_SIZE						(256U)
+#define WRITES							(20000U)
+
+static UART_HandleTypeDef huart;
+static DMA_HandleTypeDef hdmatx;
+static UART_st uart;
+static UART_Tx_Ring_st ring;
+static uint8_t buf[RING_SIZE];
+
+static const uint8_t* dmaSrc;
+static uint32_t dmaLeft;
+static bool dmaBusy;
+static uint8_t wire[1U << 20];
+static uint32_t wireLen;
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* h, const uint8_t* data, uint16_t size) {
+	(void)h;
+
+	if (dmaBusy) return HAL_BUSY;
+
+	dmaSrc = data;
+	dmaLeft = size;
+	dmaBusy = true;
+
+	return HAL_OK;
+}
+
+// dmaStep sends up to bytes and raises the complete callback at the end of a
+// transfer, the way the application's HAL_UART_TxCpltCallback does
+static void dmaStep(uint32_t bytes) {
+	while ((bytes-- > 0U) && dmaBusy) {
+		wire[wireLen++] = *dmaSrc++;
+
+		if (--dmaLeft == 0U) {
+			dmaBusy = false;
+			UART_Tx_Complete(&huart);
+		}
+	}
+}
+
+static void setUp(TeUART_Overflow overflow) {
+	memset(&huart, 0, sizeof(huart));
+	huart.hdmatx = &hdmatx;
+	uart = (UART_st){ .huart = &huart, .uart_num = 3, .baudrate = UART_115200,
+		.datasize = UART_Datasize_8, .mode = UART_TX_RX };
+	dmaBusy = false;
+	wireLen = 0;
+	srand(1);
+
+	TEST_ASSERT_EQUAL(UART_OK, UART_Tx_Ring_Init(&uart, &ring, buf, RING_SIZE, overflow));
+}
+
+static void test_init_rejects_what_the_dma_cannot_send(void) {
+	setUp(UART_OVERFLOW_DROP);
+
+	TEST_ASSERT_EQUAL(UART_INVALID_BUFFER, UART_Tx_Ring_Init(&uart, &ring, buf, 100, UART_OVERFLOW_DROP));
+
+	uart.datasize = UART_Datasize_9;
+	TEST_ASSERT_EQUAL(UART_INVALID_DATASIZE, UART_Tx_Ring_Init(&uart, &ring, buf, RING_SIZE, UART_OVERFLOW_DROP));
+
+	uart.datasize = UART_Datasize_8;
+	huart.hdmatx = NULL;
+	TEST_ASSERT_EQUAL(UART_INVALID_MODE, UART_Tx_Ring_Init(&uart, &ring, buf, RING_SIZE, UART_OVERFLOW_DROP));
+}
+
+static void test_drop_keeps_order(void) {
+	UART_Tx_Stats_st stats;
+	uint8_t msg[40];
+	uint8_t seq = 0;
+
+	setUp(UART_OVERFLOW_DROP);
+	for (uint32_t i = 0; i < WRITES; i++) {
+		uint32_t len = (uint32_t)rand() % sizeof(msg);
+		uint32_t dropped = ring.dropped;
+
+		for (uint32_t k = 0; k < len; k++) msg[k] = (uint8_t)(seq + k);
+		UART_Transmit_Async(&uart, msg, len);
+		// Dropping keeps the start of the write
+		seq = (uint8_t)(seq + len - (ring.dropped - dropped));
+
+		dmaStep(12);
+	}
+	while (dmaBusy) dmaStep(RING_SIZE);
+
+	for (uint32_t i = 0; i < wireLen; i++) TEST_ASSERT_EQUAL((uint8_t)i, wire[i]);
+
+	TEST_ASSERT_EQUAL(UART_OK, UART_Tx_Get_Stats(&uart, &stats));
+	TEST_ASSERT_EQUAL(wireLen, stats.sent);
+	TEST_ASSERT_EQUAL(0, stats.pending);
+	TEST_ASSERT(stats.dropped > 0U);
+	TEST_ASSERT(stats.high_water <= RING_SIZE);
+}
+
+static void test_overwrite_accounts_for_every_byte(void) {
+	UART_Tx_Stats_st stats;
+	uint8_t msg[60];
+	uint32_t written = 0;
+
+	setUp(UART_OVERFLOW_OVERWRITE);
+	for (uint32_t i = 0; i < WRITES; i++) {
+		uint32_t len = (uint32_t)rand() % sizeof(msg);
+
+		for (uint32_t k = 0; k < len; k++) msg[k] = (uint8_t)written++;
+		UART_Transmit_Async(&uart, msg, len);
+
+		dmaStep(10);
+	}
+	while (dmaBusy) dmaStep(RING_SIZE);
+
+	UART_Tx_Get_Stats(&uart, &stats);
+	TEST_ASSERT(stats.overwritten > 0U);
+	TEST_ASSERT_EQUAL(written, wireLen + stats.overwritten);
+}
+
+static void test_dma_error_moves_on(void) {
+	UART_Tx_Stats_st stats;
+	uint8_t msg[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+	setUp(UART_OVERFLOW_DROP);
+	UART_Transmit_Async(&uart, msg, 4);
+	UART_Transmit_Async(&uart, &msg[4], 4);
+
+	// The first chunk fails and the HAL aborts it without a complete callback
+	dmaBusy = false;
+	huart.ErrorCode = HAL_UART_ERROR_DMA;
+	huart.gState = HAL_UART_STATE_READY;
+	UART_Error(&huart);
+
+	TEST_ASSERT(dmaBusy);
+	dmaStep(RING_SIZE);
+	TEST_ASSERT_EQUAL(4, wireLen);
+	TEST_ASSERT_EQUAL(0, memcmp(&msg[4], wire, 4));
+
+	UART_Tx_Get_Stats(&uart, &stats);
+	TEST_ASSERT_EQUAL(1, stats.dma_errors);
+	TEST_ASSERT_EQUAL(4, stats.dropped);
+	TEST_ASSERT_EQUAL(4, stats.sent);
+	TEST_ASSERT_EQUAL(UART_OK, UART_Tx_Flush(&uart, 0));
+}
+
+int main(void) {
+	TEST_RUN(test_init_rejects_what_the_dma_cannot_send);
+	TEST_RUN(test_drop_keeps_order);
+	TEST_RUN(test_overwrite_accounts_for_every_byte);
+	TEST_RUN(test_dma_error_moves_on);
+
+	return TEST_RESULT();
+}
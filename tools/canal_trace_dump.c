@@ -0,0 +1,187 @@
+/*
+ * canal_trace_dump.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: MAC Formula Electric
+ *
+ *                    ..::^~~~!!~~~^^:..
+ *                .:^!7??JJJJJJJJJJJJ??7!~:.
+ *              :~7?JJJ???????????????JJJJ??!^.
+ *           .^7?JJJ???JJJJJJ??????????????JJJ?~:
+ *          ^7JJ???????777777???JJJJJJJ???????JJ?~.
+ *        .!JJ???????????7!~^::::^~!!7??JJ???????J7:
+ *       :7JJJ??????????JJJJ??7~:    ..:~7?J??????J?^
+ *      .7J???????????????????JJ?!.       :7J??????J?^
+ *     .~J??????????????????JJJJ?!.       .7J???????J7.
+ *     :?J?????????????JJJJ??7!^.      .:~???????????J~
+ *     ^???????????JJJ??7~^:..      .:~7?JJ??????????J!.
+ *     ^????????JJ?7~^:.        .:~!?JJJ?????????????J!.
+ *     ^????????!^.          .:~7?JJJ????????????????J!.
+ *     .7J????!.            :7?JJ?????????????????????^
+ *      ~JJ?J7.             ~JJJJ???????????????????J!.
+ *      .!J???^.            .^!7?JJJJJJ????????????J7:
+ *       .!?J??7^.              .:^~!7???JJJJJ????J7:
+ *        .^?JJJJ?7~.                 ..:^~~!7????!.
+ *          .!?JJJJ?:                         ..::
+ *            :~??!:
+ *              ..
+ */
+
+// canal_trace_dump converts a stream drained from a TsCanALTrace (see
+// canal/canal_trace.h) into candump log or Vector ASC text. It is a host tool:
+//
+//   cc -I canal -o canal_trace_dump tools/canal_trace_dump.c canal/canal_trace_codec.c
+//   canal_trace_dump [-a] [trace.bin]
+//
+// With no file the trace is read from stdin. -a selects ASC output, the default
+// is the candump -l format that can-utils canplayer accepts.
+
+/*********************************************************
+*                       INCLUDES
+*********************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "canal_trace_codec.h"
+
+/*********************************************************
+*                       HELPERS
+*********************************************************/
+
+// TRACE_CHUNK is how much of the stream is read at a time
+#define TRACE_CHUNK						(4096U)
+
+typedef struct {
+	FILE* in;
+	uint8_t buffer[TRACE_CHUNK];
+	uint32_t pos;
+	uint32_t len;
+	uint64_t timestampUs;
+}TsTraceReader;
+
+// readRecord decodes the next record. It returns false at the end of the
+// stream and sets truncated if the stream ended inside a record.
+static bool readRecord(TsTraceReader* reader, TsCanALTraceRecord* record, bool* truncated) {
+	uint32_t len;
+
+	*truncated = false;
+
+	while ((len = CanAL_Trace_DecodeRecord(&reader->buffer[reader->pos],
+		reader->len - reader->pos, record)) == 0U) {
+		size_t got;
+
+		// Keep the partial record and read the rest of it
+		memmove(reader->buffer, &reader->buffer[reader->pos], reader->len - reader->pos);
+		reader->len -= reader->pos;
+		reader->pos = 0;
+
+		got = fread(&reader->buffer[reader->len], 1, TRACE_CHUNK - reader->len, reader->in);
+		if (got == 0U) {
+			*truncated = (reader->len != 0U);
+			return false;
+		}
+		reader->len += (uint32_t)got;
+	}
+
+	reader->pos += len;
+	reader->timestampUs += record->deltaUs;
+
+	return true;
+}
+
+static void printCandump(const TsCanALTraceRecord* record, uint64_t timestampUs) {
+	const TsCanALRawFrame* frame = &record->frame;
+
+	printf("(%llu.%06llu) can%u %0*X#",
+		(unsigned long long)(timestampUs / 1000000U),
+		(unsigned long long)(timestampUs % 1000000U),
+		record->bus - 1U, (frame->ide == CAN_ID_EXT) ? 8 : 3, frame->id);
+
+	for (uint8_t i = 0; i < frame->dlc; i++) printf("%02X", frame->data[i]);
+
+	printf("\n");
+}
+
+static void printAscHeader(void) {
+	char date[64];
+	time_t now = time(NULL);
+
+	strftime(date, sizeof(date), "%a %b %d %I:%M:%S.000 %p %Y", localtime(&now));
+
+	printf("date %s\n", date);
+	printf("base hex  timestamps absolute\n");
+	printf("no internal events logged\n");
+	printf("Begin Triggerblock %s\n", date);
+}
+
+static void printAsc(const TsCanALTraceRecord* record, uint64_t timestampUs) {
+	const TsCanALRawFrame* frame = &record->frame;
+	char id[16];
+
+	snprintf(id, sizeof(id), (frame->ide == CAN_ID_EXT) ? "%Xx" : "%X", frame->id);
+
+	printf("%4llu.%06llu %u  %-15s %s   d %u",
+		(unsigned long long)(timestampUs / 1000000U),
+		(unsigned long long)(timestampUs % 1000000U),
+		record->bus, id, record->tx ? "Tx" : "Rx", frame->dlc);
+
+	for (uint8_t i = 0; i < frame->dlc; i++) printf(" %02X", frame->data[i]);
+
+	printf("\n");
+}
+
+/*********************************************************
+*                       MAIN
+*********************************************************/
+
+int main(int argc, char** argv) {
+	static TsTraceReader reader;
+	TsCanALTraceRecord record;
+	const char* path = NULL;
+	bool asc = false;
+	bool truncated = false;
+	unsigned long count = 0;
+	FILE* in = stdin;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-a") == 0) {
+			asc = true;
+		} else if ((argv[i][0] == '-') || (path != NULL)) {
+			fprintf(stderr, "usage: %s [-a] [trace.bin]\n", argv[0]);
+			return 2;
+		} else {
+			path = argv[i];
+		}
+	}
+
+	if ((path != NULL) && ((in = fopen(path, "rb")) == NULL)) {
+		perror(path);
+		return 1;
+	}
+
+	if (asc) printAscHeader();
+
+	reader.in = in;
+	while (readRecord(&reader, &record, &truncated)) {
+		if (asc) {
+			printAsc(&record, reader.timestampUs);
+		} else {
+			printCandump(&record, reader.timestampUs);
+		}
+		count++;
+	}
+
+	if (asc) printf("End TriggerBlock\n");
+
+	if (in != stdin) fclose(in);
+
+	if (truncated) {
+		fprintf(stderr, "trace ends inside record %lu\n", count + 1U);
+		return 1;
+	}
+
+	return 0;
+}
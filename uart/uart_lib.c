@@ -7,8 +7,16 @@
 
 /*---------------------- INCLUDES ----------------------*/
 
+#include <string.h>
+#include <stdbool.h>
 #include "uart_lib.h"
 
+/*------------------- PRIVATE VARIABLES ------------------ */
+
+// Tx and rx rings by uart_num - 1, so the DMA callbacks can find theirs
+static UART_Tx_Ring_st* tx_rings[UART_NUM_PORTS];
+static UART_Rx_Ring_st* rx_rings[UART_NUM_PORTS];
+
 /*------------- PRIVATE FUNCTION DEFINITIONS ------------ */
 
 // UART_Select configures the corresponding UART number from a UART_st
@@ -42,7 +50,7 @@ static TeUART_Return UART_Select(UART_st* uart)
 			uart->huart -> Instance = UART8;
 			break;
 		default:
-			return INVALID_UART_NUM;
+			return UART_INVALID_UART_NUM;
 	}
 
 	return UART_OK;
@@ -51,9 +59,10 @@ static TeUART_Return UART_Select(UART_st* uart)
 // UART_Baud_Rate_Select configures the baud rate from the one specified in baudrate
 static TeUART_Return UART_Baud_Rate_Select(UART_st* uart)
 {
-	// Baud rate must be between 123 Bits/s and 500 KBits/s, stated in .ioc requirements
+	// Baud rate must be between 123 Bits/s and 2 MBits/s. With oversampling by 16,
+	// 2 MBits/s needs a USART kernel clock of at least 32 MHz.
 	if(uart->baudrate < MIN_UART_BAUDRATE || uart->baudrate > MAX_UART_BAUDRATE){
-		return BAUDRATE_OUT_OF_BOUNDS;
+		return UART_BAUDRATE_OUT_OF_BOUNDS;
 	}
 
 	uart->huart->Init.BaudRate = uart->baudrate;
@@ -76,7 +85,7 @@ static TeUART_Return UART_Datasize_Select(UART_st* uart)
 			uart->huart -> Init.WordLength = UART_WORDLENGTH_9B;
 			break;
 		default:
-			return INVALID_DATASIZE;
+			return UART_INVALID_DATASIZE;
 	}
 
 	return UART_OK;
@@ -97,7 +106,7 @@ static TeUART_Return UART_Mode_Select(UART_st* uart)
 			uart->huart -> Init.Mode = UART_MODE_TX_RX;
 			break;
 		default:
-			return INVALID_MODE;
+			return UART_INVALID_MODE;
 	}
 
 	return UART_OK;
@@ -115,7 +124,7 @@ static TeUART_Return UART_MSB_Select(UART_st* uart)
 			uart->huart -> AdvancedInit.MSBFirst = UART_ADVFEATURE_MSBFIRST_ENABLE;
 			break;
 		default:
-			return INVALID_BIT_POSITION;
+			return UART_INVALID_BIT_POSITION;
 	}
 
 	return UART_OK;
@@ -131,6 +140,267 @@ static void UART_Default_Configs(UART_st* uart)
 	uart->huart -> Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
 }
 
+// UART_Timeout allows TIMEOUT plus the time len bytes of 10 bits take on the line,
+// so that large transfers at low baud rates do not time out
+static uint32_t UART_Timeout(UART_st* uart, uint32_t len)
+{
+	return TIMEOUT + ((len * 10U * 1000U) / uart->baudrate);
+}
+
+// UART_Frame_Size is how many bytes of a buffer the HAL takes per data frame.
+// 9 bit frames without parity are sent from and received into 16 bit items.
+static uint32_t UART_Frame_Size(UART_st* uart)
+{
+	return ((uart->huart->Init.WordLength == UART_WORDLENGTH_9B) &&
+		(uart->huart->Init.Parity == UART_PARITY_NONE)) ? 2U : 1U;
+}
+
+// UART_Find_Tx_Ring returns the tx ring bound to a HAL handle, or NULL
+static UART_Tx_Ring_st* UART_Find_Tx_Ring(UART_HandleTypeDef* huart)
+{
+	for (uint8_t i = 0; i < UART_NUM_PORTS; i++) {
+		if ((tx_rings[i] != NULL) && (tx_rings[i]->uart->huart == huart)) {
+			return tx_rings[i];
+		}
+	}
+
+	return NULL;
+}
+
+UART_Tx_Ring_st* UART_Get_Tx_Ring(UART_st* uart)
+{
+	if ((uart == NULL) || (uart->uart_num < 1U) || (uart->uart_num > UART_NUM_PORTS)) {
+		return NULL;
+	}
+
+	return tx_rings[uart->uart_num - 1U];
+}
+
+// UART_Find_Rx_Ring returns the rx ring bound to a HAL handle, or NULL
+static UART_Rx_Ring_st* UART_Find_Rx_Ring(UART_HandleTypeDef* huart)
+{
+	for (uint8_t i = 0; i < UART_NUM_PORTS; i++) {
+		if ((rx_rings[i] != NULL) && (rx_rings[i]->uart->huart == huart)) {
+			return rx_rings[i];
+		}
+	}
+
+	return NULL;
+}
+
+static UART_Rx_Ring_st* UART_Get_Rx_Ring(UART_st* uart)
+{
+	if ((uart == NULL) || (uart->uart_num < 1U) || (uart->uart_num > UART_NUM_PORTS)) {
+		return NULL;
+	}
+
+	return rx_rings[uart->uart_num - 1U];
+}
+
+// UART_Clean_DCache writes the cache lines holding a DMA source back to memory,
+// since the DMA does not see data still sitting in the D-cache
+static void UART_Clean_DCache(const uint8_t* data, uint32_t len)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	uintptr_t start = (uintptr_t)data & ~(uintptr_t)31U;
+	uintptr_t end = ((uintptr_t)data + len + 31U) & ~(uintptr_t)31U;
+
+	if ((SCB->CCR & SCB_CCR_DC_Msk) != 0U) {
+		SCB_CleanDCache_by_Addr((uint32_t*)start, (int32_t)(end - start));
+	}
+#else
+	(void)data;
+	(void)len;
+#endif
+}
+
+// UART_Invalidate_DCache drops the cache lines holding a DMA destination, so
+// that the CPU reads what the DMA wrote instead of stale cached data
+static void UART_Invalidate_DCache(const uint8_t* data, uint32_t len)
+{
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	uintptr_t start = (uintptr_t)data & ~(uintptr_t)31U;
+	uintptr_t end = ((uintptr_t)data + len + 31U) & ~(uintptr_t)31U;
+
+	if ((len != 0U) && ((SCB->CCR & SCB_CCR_DC_Msk) != 0U)) {
+		SCB_InvalidateDCache_by_Addr((uint32_t*)start, (int32_t)(end - start));
+	}
+#else
+	(void)data;
+	(void)len;
+#endif
+}
+
+// UART_Tx_Start_Chunk hands the longest contiguous run of waiting bytes to the
+// DMA unless a transfer is running. Must be called with interrupts masked.
+static void UART_Tx_Start_Chunk(UART_Tx_Ring_st* ring)
+{
+	uint32_t pending = ring->head - ring->tail;
+	uint32_t offset = ring->tail & (ring->size - 1U);
+	uint32_t len = ring->size - offset;
+
+	if ((ring->dma_len != 0U) || (pending == 0U)) {
+		return;
+	}
+
+	if (len > pending) {
+		len = pending;
+	}
+	if (len > UART_MAX_CHUNK) {
+		len = UART_MAX_CHUNK;
+	}
+
+	UART_Clean_DCache(&ring->buf[offset], len);
+
+	// A blocking transfer may own the uart, the next write or flush retries
+	if (HAL_UART_Transmit_DMA(ring->uart->huart, &ring->buf[offset], (uint16_t)len) != HAL_OK) {
+		return;
+	}
+
+	ring->dma_len = len;
+	ring->tail += len;
+	ring->chunks++;
+}
+
+// UART_Tx_Enqueue copies as much of the buffer as the overflow policy allows and
+// returns the number of bytes consumed from it. Must be called with interrupts masked.
+static uint32_t UART_Tx_Enqueue(UART_Tx_Ring_st* ring, const uint8_t* data, uint32_t len, bool can_block)
+{
+	uint32_t space = ring->size - (ring->head - ring->tail) - ring->dma_len;
+	uint32_t consumed = len;
+	uint32_t discard;
+	uint32_t offset;
+	uint32_t first;
+
+	if (len > space) {
+		if (ring->overflow == UART_OVERFLOW_OVERWRITE) {
+			// Make room from the oldest waiting bytes, then from the oldest of this write
+			discard = len - space;
+			if (discard > (ring->head - ring->tail)) {
+				discard = ring->head - ring->tail;
+			}
+			ring->tail += discard;
+			space += discard;
+			ring->overwritten += discard;
+
+			if (len > space) {
+				ring->overwritten += len - space;
+				data += len - space;
+				len = space;
+			}
+		} else if ((ring->overflow == UART_OVERFLOW_BLOCK) && can_block) {
+			len = space;
+			consumed = space;
+		} else {
+			ring->dropped += len - space;
+			len = space;
+		}
+	}
+
+	offset = ring->head & (ring->size - 1U);
+	first = ring->size - offset;
+	if (first > len) {
+		first = len;
+	}
+
+	memcpy(&ring->buf[offset], data, first);
+	memcpy(ring->buf, &data[first], len - first);
+	ring->head += len;
+
+	if ((ring->head - ring->tail + ring->dma_len) > ring->high_water) {
+		ring->high_water = ring->head - ring->tail + ring->dma_len;
+	}
+
+	UART_Tx_Start_Chunk(ring);
+
+	return consumed;
+}
+
+// UART_Rx_Start (re)starts the circular DMA at the beginning of the buffer
+static TeUART_Return UART_Rx_Start(UART_Rx_Ring_st* ring)
+{
+	uint32_t offset = ring->head & (ring->size - 1U);
+
+	// The free-running indices only meet the beginning of the buffer again at
+	// the next multiple of size, so the unread bytes before that are given up
+	if (offset != 0U) {
+		ring->head += ring->size - offset;
+		ring->resync = ring->head;
+		ring->resync_skipped += ring->size - offset;
+	}
+	ring->dma_pos = 0U;
+
+	if (HAL_UARTEx_ReceiveToIdle_DMA(ring->uart->huart, ring->buf, (uint16_t)ring->size) != HAL_OK) {
+		return UART_RECEIVE_FAILED;
+	}
+
+	return UART_OK;
+}
+
+// UART_Rx_Catch_Up moves tail past bytes the DMA overwrote or a restart gave up.
+// Must be called with interrupts masked.
+static void UART_Rx_Catch_Up(UART_Rx_Ring_st* ring)
+{
+	if ((int32_t)(ring->resync - ring->tail) > 0) {
+		ring->dropped += ring->resync - ring->tail - ring->resync_skipped;
+		ring->tail = ring->resync;
+	}
+	ring->resync_skipped = 0U;
+
+	if ((ring->head - ring->tail) > ring->size) {
+		ring->dropped += ring->head - ring->tail - ring->size;
+		ring->tail = ring->head - ring->size;
+	}
+}
+
+// UART_Tx_Error gives up a tx chunk whose DMA failed. The transfer is aborted
+// without a complete callback, so the ring has to move on by itself.
+static void UART_Tx_Error(UART_HandleTypeDef* huart)
+{
+	UART_Tx_Ring_st* ring = UART_Find_Tx_Ring(huart);
+
+	if ((ring == NULL) || (ring->dma_len == 0U) || ((huart->ErrorCode & HAL_UART_ERROR_DMA) == 0U) ||
+		(huart->gState != HAL_UART_STATE_READY)) {
+		return;
+	}
+
+	ring->dma_errors++;
+	ring->dropped += ring->dma_len;
+	ring->dma_len = 0U;
+
+	UART_Tx_Start_Chunk(ring);
+}
+
+// UART_Rx_Error counts the errors flagged during reception. Overruns and DMA
+// errors abort the reception, which is then started again.
+static void UART_Rx_Error(UART_HandleTypeDef* huart)
+{
+	UART_Rx_Ring_st* ring = UART_Find_Rx_Ring(huart);
+	uint32_t error = huart->ErrorCode;
+
+	if (ring == NULL) {
+		return;
+	}
+
+	if ((error & HAL_UART_ERROR_ORE) != 0U) {
+		ring->overruns++;
+	}
+	if ((error & HAL_UART_ERROR_FE) != 0U) {
+		ring->framing_errors++;
+	}
+	if ((error & HAL_UART_ERROR_NE) != 0U) {
+		ring->noise_errors++;
+	}
+	if ((error & HAL_UART_ERROR_PE) != 0U) {
+		ring->parity_errors++;
+	}
+
+	if (huart->RxState == HAL_UART_STATE_READY) {
+		ring->restarts++;
+		(void)UART_Rx_Start(ring);
+	}
+}
+
 /*------------- PUBLIC FUNCTION DEFINITIONS ------------- */
 
 TeUART_Return UART_Init(UART_st* uart)
@@ -170,26 +440,55 @@ TeUART_Return UART_Init(UART_st* uart)
 }
 
 // Uses the HAL UART Transmit to transmit a buffer's contents over the channel specified in the uart struct
-TeUART_Return UART_Transmit(UART_st* uart, uint8_t tx_buf[], uint8_t buf_len)
+TeUART_Return UART_Transmit(UART_st* uart, uint8_t tx_buf[], uint32_t buf_len)
 {
-	HAL_StatusTypeDef tx_response;
+	uint32_t frame_size = UART_Frame_Size(uart);
+	uint32_t chunk;
+
+	while (buf_len > 0U) {
+		chunk = (buf_len > UART_MAX_CHUNK) ? UART_MAX_CHUNK : buf_len;
+
+		if (HAL_UART_Transmit(uart->huart, tx_buf, (uint16_t)chunk, UART_Timeout(uart, chunk)) != HAL_OK) {
+			return UART_TRANSMIT_FAILED;
+		}
+
+		tx_buf += chunk * frame_size;
+		buf_len -= chunk;
+	}
+
+	return UART_OK;
+}
+
+// Transmits the buffers of iov back to back as one stream
+TeUART_Return UART_Transmit_Vec(UART_st* uart, const UART_Iovec_st* iov, uint8_t iov_cnt)
+{
+	TeUART_Return response;
 
-	tx_response = HAL_UART_Transmit(uart->huart, tx_buf, buf_len, TIMEOUT);
-	if (tx_response != HAL_OK) {
-		return TRANSMIT_FAILED;
+	for (uint8_t i = 0; i < iov_cnt; i++) {
+		response = UART_Transmit(uart, iov[i].buf, iov[i].len);
+		if (response != UART_OK) {
+			return response;
+		}
 	}
 
 	return UART_OK;
 }
 
 // TODO: check the rx_buf dataframe being sent (casting currently)
-TeUART_Return UART_Receive(UART_st* uart, uint8_t rx_buf[], uint8_t buf_len)
+TeUART_Return UART_Receive(UART_st* uart, uint8_t rx_buf[], uint32_t buf_len)
 {
-	HAL_StatusTypeDef rx_response;
+	uint32_t frame_size = UART_Frame_Size(uart);
+	uint32_t chunk;
 
-	rx_response = HAL_UART_Receive(uart->huart, rx_buf, buf_len, TIMEOUT);
-	if (rx_response != HAL_OK) {
-		return RECEIVE_FAILED;
+	while (buf_len > 0U) {
+		chunk = (buf_len > UART_MAX_CHUNK) ? UART_MAX_CHUNK : buf_len;
+
+		if (HAL_UART_Receive(uart->huart, rx_buf, (uint16_t)chunk, UART_Timeout(uart, chunk)) != HAL_OK) {
+			return UART_RECEIVE_FAILED;
+		}
+
+		rx_buf += chunk * frame_size;
+		buf_len -= chunk;
 	}
 
 	return UART_OK;
@@ -201,8 +500,333 @@ TeUART_Return UART_Deinit(UART_st* uart)
 
 	deinit_response = HAL_UART_DeInit(uart->huart);
 	if (deinit_response != HAL_OK) {
-		return DEINIT_FAILED;
+		return UART_DEINIT_FAILED;
 	}
 
 	return UART_OK;
-}
\ No newline at end of file
+}
+
+TeUART_Return UART_Tx_Ring_Init(UART_st* uart, UART_Tx_Ring_st* ring, uint8_t* buf, uint32_t size, TeUART_Overflow overflow)
+{
+	if ((uart == NULL) || (uart->uart_num < 1U) || (uart->uart_num > UART_NUM_PORTS)) {
+		return UART_INVALID_UART_NUM;
+	}
+
+	if ((ring == NULL) || (buf == NULL) || (size == 0U) || ((size & (size - 1U)) != 0U)) {
+		return UART_INVALID_BUFFER;
+	}
+
+	if (overflow > UART_OVERFLOW_OVERWRITE) {
+		return UART_INVALID_MODE;
+	}
+
+	// Without a tx DMA the complete callback never comes and the ring stalls
+	if ((uart->huart == NULL) || (uart->huart->hdmatx == NULL)) {
+		return UART_INVALID_MODE;
+	}
+
+	// 9 bit frames are sent from 16 bit items, the ring counts bytes
+	if (uart->datasize == UART_Datasize_9) {
+		return UART_INVALID_DATASIZE;
+	}
+
+	*ring = (UART_Tx_Ring_st){
+		.uart = uart,
+		.buf = buf,
+		.size = size,
+		.overflow = overflow,
+	};
+
+	tx_rings[uart->uart_num - 1U] = ring;
+
+	return UART_OK;
+}
+
+// Queues the buffer for the DMA. Blocking is only possible in thread mode with
+// interrupts enabled, since the DMA callbacks are what make room.
+TeUART_Return UART_Transmit_Async(UART_st* uart, const uint8_t* tx_buf, uint32_t buf_len)
+{
+	UART_Tx_Ring_st* ring = UART_Get_Tx_Ring(uart);
+	uint32_t primask = __get_PRIMASK();
+	bool can_block = (primask == 0U) && (__get_IPSR() == 0U);
+	uint32_t start = HAL_GetTick();
+	uint32_t dropped;
+	uint32_t consumed;
+
+	if (ring == NULL) {
+		return UART_INVALID_MODE;
+	}
+
+	__disable_irq();
+	dropped = ring->dropped + ring->overwritten;
+	consumed = UART_Tx_Enqueue(ring, tx_buf, buf_len, can_block);
+	__set_PRIMASK(primask);
+
+	while (consumed < buf_len) {
+		if ((HAL_GetTick() - start) > TIMEOUT) {
+			__disable_irq();
+			ring->dropped += buf_len - consumed;
+			__set_PRIMASK(primask);
+			return UART_TX_OVERFLOW;
+		}
+
+		__disable_irq();
+		consumed += UART_Tx_Enqueue(ring, &tx_buf[consumed], buf_len - consumed, true);
+		__set_PRIMASK(primask);
+	}
+
+	return (ring->dropped + ring->overwritten != dropped) ? UART_TX_OVERFLOW : UART_OK;
+}
+
+TeUART_Return UART_Tx_Flush(UART_st* uart, uint32_t timeout)
+{
+	UART_Tx_Ring_st* ring = UART_Get_Tx_Ring(uart);
+	uint32_t start = HAL_GetTick();
+	uint32_t primask;
+
+	if (ring == NULL) {
+		return UART_INVALID_MODE;
+	}
+
+	while ((ring->head != ring->tail) || (ring->dma_len != 0U)) {
+		if ((HAL_GetTick() - start) > timeout) {
+			return UART_TRANSMIT_FAILED;
+		}
+
+		primask = __get_PRIMASK();
+		__disable_irq();
+		UART_Tx_Start_Chunk(ring);
+		__set_PRIMASK(primask);
+	}
+
+	return UART_OK;
+}
+
+TeUART_Return UART_Tx_Space(UART_st* uart, uint32_t* space)
+{
+	UART_Tx_Ring_st* ring = UART_Get_Tx_Ring(uart);
+	uint32_t primask;
+
+	if ((ring == NULL) || (space == NULL)) {
+		return UART_INVALID_MODE;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	*space = ring->size - (ring->head - ring->tail) - ring->dma_len;
+	__set_PRIMASK(primask);
+
+	return UART_OK;
+}
+
+TeUART_Return UART_Tx_Get_Stats(UART_st* uart, UART_Tx_Stats_st* stats)
+{
+	UART_Tx_Ring_st* ring = UART_Get_Tx_Ring(uart);
+	uint32_t primask;
+
+	if ((ring == NULL) || (stats == NULL)) {
+		return UART_INVALID_MODE;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	*stats = (UART_Tx_Stats_st){
+		.pending = ring->head - ring->tail + ring->dma_len,
+		.high_water = ring->high_water,
+		.dropped = ring->dropped,
+		.overwritten = ring->overwritten,
+		.chunks = ring->chunks,
+		.sent = ring->sent,
+		.dma_errors = ring->dma_errors,
+	};
+
+	__set_PRIMASK(primask);
+
+	return UART_OK;
+}
+
+void UART_Tx_Complete(UART_HandleTypeDef* huart)
+{
+	UART_Tx_Ring_st* ring = UART_Find_Tx_Ring(huart);
+
+	if (ring == NULL) {
+		return;
+	}
+
+	ring->sent += ring->dma_len;
+	ring->dma_len = 0U;
+
+	UART_Tx_Start_Chunk(ring);
+}
+
+TeUART_Return UART_Rx_Ring_Init(UART_st* uart, UART_Rx_Ring_st* ring, uint8_t* buf, uint32_t size)
+{
+	if ((uart == NULL) || (uart->uart_num < 1U) || (uart->uart_num > UART_NUM_PORTS)) {
+		return UART_INVALID_UART_NUM;
+	}
+
+	// HAL transfers are limited to 16 bits, so the largest power of two is 0x8000
+	if ((ring == NULL) || (buf == NULL) || (size == 0U) || (size > 0x8000U) || ((size & (size - 1U)) != 0U)) {
+		return UART_INVALID_BUFFER;
+	}
+
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+	if ((((uintptr_t)buf & 31U) != 0U) || (size < 32U)) {
+		return UART_INVALID_BUFFER;
+	}
+#endif
+
+	if ((uart->huart->hdmarx == NULL) || (uart->huart->hdmarx->Init.Mode != DMA_CIRCULAR)) {
+		return UART_INVALID_MODE;
+	}
+
+	*ring = (UART_Rx_Ring_st){
+		.uart = uart,
+		.buf = buf,
+		.size = size,
+	};
+
+	rx_rings[uart->uart_num - 1U] = ring;
+
+	return UART_Rx_Start(ring);
+}
+
+uint32_t UART_Peek(UART_st* uart, UART_Span_st* span)
+{
+	UART_Rx_Ring_st* ring = UART_Get_Rx_Ring(uart);
+	uint32_t primask;
+	uint32_t pending;
+	uint32_t offset;
+
+	if ((ring == NULL) || (span == NULL)) {
+		return 0U;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	UART_Rx_Catch_Up(ring);
+	pending = ring->head - ring->tail;
+	__set_PRIMASK(primask);
+
+	offset = ring->tail & (ring->size - 1U);
+
+	span->data[0] = &ring->buf[offset];
+	span->len[0] = ring->size - offset;
+	if (span->len[0] > pending) {
+		span->len[0] = pending;
+	}
+	span->data[1] = ring->buf;
+	span->len[1] = pending - span->len[0];
+
+	UART_Invalidate_DCache(span->data[0], span->len[0]);
+	UART_Invalidate_DCache(span->data[1], span->len[1]);
+
+	return pending;
+}
+
+// Bytes the DMA overwrote since they were peeked are only accounted for at the
+// next UART_Peek, so consuming what was peeked never skips unread bytes
+TeUART_Return UART_Consume(UART_st* uart, uint32_t len)
+{
+	UART_Rx_Ring_st* ring = UART_Get_Rx_Ring(uart);
+	uint32_t primask;
+
+	if (ring == NULL) {
+		return UART_INVALID_MODE;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (len > (ring->head - ring->tail)) {
+		len = ring->head - ring->tail;
+	}
+	ring->tail += len;
+
+	__set_PRIMASK(primask);
+
+	return UART_OK;
+}
+
+TeUART_Return UART_Rx_Get_Stats(UART_st* uart, UART_Rx_Stats_st* stats)
+{
+	UART_Rx_Ring_st* ring = UART_Get_Rx_Ring(uart);
+	uint32_t primask;
+
+	if ((ring == NULL) || (stats == NULL)) {
+		return UART_INVALID_MODE;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	UART_Rx_Catch_Up(ring);
+
+	*stats = (UART_Rx_Stats_st){
+		.pending = ring->head - ring->tail,
+		.high_water = ring->high_water,
+		.dropped = ring->dropped,
+		.overruns = ring->overruns,
+		.framing_errors = ring->framing_errors,
+		.noise_errors = ring->noise_errors,
+		.parity_errors = ring->parity_errors,
+		.restarts = ring->restarts,
+	};
+
+	__set_PRIMASK(primask);
+
+	return UART_OK;
+}
+
+// pos is where the DMA will write next, counted from the start of the buffer.
+// It equals size at transfer complete.
+void UART_Rx_Event(UART_HandleTypeDef* huart, uint16_t pos)
+{
+	UART_Rx_Ring_st* ring = UART_Find_Rx_Ring(huart);
+	uint32_t pending;
+
+	if ((ring == NULL) || (pos > ring->size)) {
+		return;
+	}
+
+	if (pos >= ring->dma_pos) {
+		ring->head += pos - ring->dma_pos;
+	} else {
+		ring->head += ring->size - ring->dma_pos + pos;
+	}
+	ring->dma_pos = pos & (ring->size - 1U);
+
+	pending = ring->head - ring->tail;
+	if (pending > ring->size) {
+		pending = ring->size;
+	}
+	if (pending > ring->high_water) {
+		ring->high_water = pending;
+	}
+}
+
+void UART_Error(UART_HandleTypeDef* huart)
+{
+	UART_Tx_Error(huart);
+	UART_Rx_Error(huart);
+}
+
+#ifdef UART_HAL_CALLBACKS
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart)
+{
+	UART_Tx_Complete(huart);
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t Size)
+{
+	UART_Rx_Event(huart, Size);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart)
+{
+	UART_Error(huart);
+}
+
+#endif // UART_HAL_CALLBACKS
@@ -16,8 +16,16 @@
 /*---------------------- MACROS ----------------------*/
 
 #define MIN_UART_BAUDRATE (123U)
-#define MAX_UART_BAUDRATE (500000U)
+#define MAX_UART_BAUDRATE (2000000U)
 #define TIMEOUT 		  (5000U)
+#define UART_NUM_PORTS	  (8U)
+// Largest transfer a single HAL call takes
+#define UART_MAX_CHUNK (0xFFFFU)
+
+// Define UART_HAL_CALLBACKS to let uart_lib implement HAL_UART_TxCpltCallback,
+// HAL_UARTEx_RxEventCallback and HAL_UART_ErrorCallback. Otherwise the
+// application's callbacks must call UART_Tx_Complete, UART_Rx_Event and
+// UART_Error for the uarts that have rings.
 
 /*---------------------- TYPEDEFS ----------------------*/
 
@@ -49,6 +57,8 @@ typedef enum {
     UART_115200 =   ((uint32_t) 115200),
     UART_256000 =   ((uint32_t) 256000),
     UART_500000 =   ((uint32_t) 500000),
+    UART_1000000 =  ((uint32_t) 1000000),
+    UART_2000000 =  ((uint32_t) 2000000),
 }TeUART_Std_Baud;
 
 // UART_st holds the user input for a particular UART configuration
@@ -57,7 +67,7 @@ typedef struct {
 	UART_HandleTypeDef* huart;
 	// UART number, from 1-8
 	uint8_t uart_num;
-	// UART baud rate, from 123 Bits/s and 500 KBits/s
+	// UART baud rate, from 123 Bits/s and 2 MBits/s
 	TeUART_Std_Baud baudrate;
 	// UART data frame size, from 7-9
 	TeUART_Datasize datasize;
@@ -79,13 +89,147 @@ typedef enum {
 	UART_TRANSMIT_FAILED,
 	UART_RECEIVE_FAILED,
 	UART_DEINIT_FAILED,
+	UART_INVALID_BUFFER,
+	UART_TX_OVERFLOW,
 }TeUART_Return;
 
+// UART_Iovec_st is one buffer of a scatter-gather transfer, len counted like
+// the buf_len of UART_Transmit
+typedef struct {
+	uint8_t* buf;
+	uint32_t len;
+}UART_Iovec_st;
+
+// Decides what UART_Transmit_Async does with bytes that do not fit in the tx ring
+typedef enum {
+	UART_OVERFLOW_DROP,		// Drop the newest bytes
+	UART_OVERFLOW_BLOCK,	// Wait up to TIMEOUT for the DMA to make room, drop in interrupts
+	UART_OVERFLOW_OVERWRITE	// Discard the oldest bytes not handed to the DMA yet
+}TeUART_Overflow;
+
+// UART_Tx_Ring_st queues bytes that the DMA sends in the background. The buffer
+// is owned by the caller and its size must be a power of two.
+typedef struct {
+	UART_st* uart;
+	uint8_t* buf;
+	uint32_t size;
+	TeUART_Overflow overflow;
+	// head and tail run freely and are masked with size - 1. The bytes from
+	// tail to head are waiting, the dma_len bytes before tail are being sent.
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t dma_len;
+	// Largest number of bytes waiting or being sent at once
+	volatile uint32_t high_water;
+	volatile uint32_t dropped;
+	volatile uint32_t overwritten;
+	// Number of DMA transfers and the bytes they completed
+	volatile uint32_t chunks;
+	volatile uint32_t sent;
+	volatile uint32_t dma_errors;
+}UART_Tx_Ring_st;
+
+// UART_Rx_Ring_st is a circular DMA buffer that receives continuously. The
+// buffer is owned by the caller and its size must be a power of two. On cores
+// with a D-cache it must also be 32 byte aligned and at least 32 bytes long,
+// since its cache lines are invalidated before they are read.
+typedef struct {
+	UART_st* uart;
+	uint8_t* buf;
+	uint32_t size;
+	// head and tail run freely and are masked with size - 1. head is moved by
+	// the DMA events, tail only by UART_Consume.
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	// Position the DMA had reached at the last event
+	uint32_t dma_pos;
+	// Unread bytes before resync are lost, set when reception had to restart
+	volatile uint32_t resync;
+	// Positions that restarts skipped to reach resync, which never held data
+	volatile uint32_t resync_skipped;
+	volatile uint32_t high_water;
+	// Bytes overwritten by the DMA or lost to a restart before they were consumed
+	volatile uint32_t dropped;
+	// Errors flagged by the uart
+	volatile uint32_t overruns;
+	volatile uint32_t framing_errors;
+	volatile uint32_t noise_errors;
+	volatile uint32_t parity_errors;
+	volatile uint32_t restarts;
+}UART_Rx_Ring_st;
+
+// UART_Span_st points into a rx ring. Data that wraps around the end of the
+// buffer is split in two parts, otherwise len[1] is 0.
+typedef struct {
+	const uint8_t* data[2];
+	uint32_t len[2];
+}UART_Span_st;
+
+// UART_Rx_Stats_st is a snapshot of the counters of a rx ring
+typedef struct {
+	uint32_t pending;
+	uint32_t high_water;
+	uint32_t dropped;
+	uint32_t overruns;
+	uint32_t framing_errors;
+	uint32_t noise_errors;
+	uint32_t parity_errors;
+	uint32_t restarts;
+}UART_Rx_Stats_st;
+
+// UART_Tx_Stats_st is a snapshot of the counters of a tx ring
+typedef struct {
+	uint32_t pending;
+	uint32_t high_water;
+	uint32_t dropped;
+	uint32_t overwritten;
+	uint32_t chunks;
+	uint32_t sent;
+	uint32_t dma_errors;
+}UART_Tx_Stats_st;
+
 /*------------ PUBLIC FUNCTION DECLARATIONS ------------- */
 
 TeUART_Return UART_Init(UART_st* uart);
-TeUART_Return UART_Transmit(UART_st* uart, uint8_t* tx_buf, uint8_t buf_len);
-TeUART_Return UART_Receive(UART_st* uart, uint8_t* rx_buf, uint8_t buf_len);
+// Transfers larger than UART_MAX_CHUNK are split into several HAL calls.
+// buf_len counts data frames, which take two bytes each with 9 bit data.
+TeUART_Return UART_Transmit(UART_st* uart, uint8_t* tx_buf, uint32_t buf_len);
+TeUART_Return UART_Transmit_Vec(UART_st* uart, const UART_Iovec_st* iov, uint8_t iov_cnt);
+TeUART_Return UART_Receive(UART_st* uart, uint8_t* rx_buf, uint32_t buf_len);
 TeUART_Return UART_Deinit(UART_st* uart);
 
+// Binds a tx ring of size bytes to an initialized uart, whose tx DMA must be
+// linked. 9 bit data is not supported.
+TeUART_Return UART_Tx_Ring_Init(UART_st* uart, UART_Tx_Ring_st* ring, uint8_t* buf, uint32_t size, TeUART_Overflow overflow);
+// Returns the tx ring UART_Tx_Ring_Init bound to the uart, or NULL
+UART_Tx_Ring_st* UART_Get_Tx_Ring(UART_st* uart);
+// Queues the buffer on the tx ring of the uart and returns without waiting for
+// it to be sent. Returns UART_TX_OVERFLOW if bytes were dropped or overwritten.
+// UART_Transmit must not be used on the same uart while the ring is sending.
+TeUART_Return UART_Transmit_Async(UART_st* uart, const uint8_t* tx_buf, uint32_t buf_len);
+// Waits up to timeout ms until everything queued on the tx ring has been sent
+TeUART_Return UART_Tx_Flush(UART_st* uart, uint32_t timeout);
+// Sets space to the number of bytes UART_Transmit_Async can queue right now
+// without dropping or overwriting any. The DMA only ever adds to it.
+TeUART_Return UART_Tx_Space(UART_st* uart, uint32_t* space);
+TeUART_Return UART_Tx_Get_Stats(UART_st* uart, UART_Tx_Stats_st* stats);
+// Chains the next DMA transfer, called from HAL_UART_TxCpltCallback
+void UART_Tx_Complete(UART_HandleTypeDef* huart);
+
+// Binds a rx ring of size bytes to an initialized uart and starts receiving.
+// The rx DMA of the uart must be linked and set to DMA_CIRCULAR.
+TeUART_Return UART_Rx_Ring_Init(UART_st* uart, UART_Rx_Ring_st* ring, uint8_t* buf, uint32_t size);
+// Points span at the received bytes that have not been consumed and returns
+// their number. The data stays in place until UART_Consume releases it.
+uint32_t UART_Peek(UART_st* uart, UART_Span_st* span);
+// Releases the first len peeked bytes back to the DMA
+TeUART_Return UART_Consume(UART_st* uart, uint32_t len);
+TeUART_Return UART_Rx_Get_Stats(UART_st* uart, UART_Rx_Stats_st* stats);
+// Makes the bytes up to pos in the buffer available, called from
+// HAL_UARTEx_RxEventCallback on half transfer, transfer complete and idle line
+void UART_Rx_Event(UART_HandleTypeDef* huart, uint16_t pos);
+// Drops a tx chunk whose DMA failed and counts rx errors, restarting reception
+// if it was aborted. Called from HAL_UART_ErrorCallback.
+void UART_Error(UART_HandleTypeDef* huart);
+
 #endif /* INC_UART_LIB_H_ */